@@ -621,28 +621,44 @@ void PseudocolorLayerImp::getBoundingBox(int& x1, int& y1, int& x2, int& y2) con
    }
 }
 
-template<class T, class Drawer>
-void fillRegion(T* pData, DataAccessor& da, Drawer drawer, int classValue, unsigned int numRows,
-                unsigned int numColumns)
+template<class T, InterleaveFormatTypeEnum Interleave, class Drawer>
+void fillRegionRows(InterleaveTraits<Interleave>, T* pData, DataAccessor& da, Drawer drawer, int classValue,
+                    unsigned int numRows, unsigned int numColumns)
 {
-   for (unsigned int uiRow = 0; uiRow < numRows; ++uiRow)
+   unsigned int uiRow = 0;
+   while (uiRow < numRows)
    {
-      for (unsigned int uiColumn = 0; uiColumn < numColumns; ++uiColumn)
+      VERIFYNRV(da.isValid());
+      TileView<T, Interleave> tile = da->getTileView<T, Interleave>();
+      if (tile.getRowCount() == 0)
       {
-         VERIFYNRV(da.isValid());
-         int iValue = ModelServices::getDataValue(*((T*)da->getColumn()), COMPLEX_MAGNITUDE);
-         if (classValue == iValue)
+         return;
+      }
+
+      for (size_t tileRow = 0; tileRow < tile.getRowCount() && uiRow < numRows; ++tileRow, ++uiRow)
+      {
+         RowView<T, Interleave> row = tile.getRowView(tileRow);
+         for (unsigned int uiColumn = 0; uiColumn < numColumns; ++uiColumn)
          {
-            drawer(uiColumn, uiRow);
+            int iValue = ModelServices::getDataValue(row[uiColumn], COMPLEX_MAGNITUDE);
+            if (classValue == iValue)
+            {
+               drawer(uiColumn, uiRow);
+            }
          }
-
-         da->nextColumn();
       }
 
-      da->nextRow();
+      da->nextRow(static_cast<int>(tile.getRowCount()));
    }
 }
 
+template<class T, class Drawer>
+void fillRegion(T* pData, DataAccessor& da, Drawer drawer, int classValue, unsigned int numRows,
+                unsigned int numColumns, InterleaveFormatType interleave)
+{
+   switchOnInterleave(interleave, fillRegionRows, pData, da, drawer, classValue, numRows, numColumns);
+}
+
 const BitMask* PseudocolorLayerImp::getSelectedPixels() const
 {
    const RasterElement* pRasterElement = dynamic_cast<const RasterElement*>(getDataElement());
@@ -675,7 +691,8 @@ const BitMask* PseudocolorLayerImp::getSelectedPixels() const
                {
                   int classValue = pClass->getValue();
                   da->toPixel(0, 0);
-                  switchOnEncoding(eEncoding, fillRegion, NULL, da, drawer, classValue, uiNumRows, uiNumColumns);
+                  switchOnEncoding(eEncoding, fillRegion, NULL, da, drawer, classValue, uiNumRows, uiNumColumns,
+                     pDescriptor->getInterleaveFormat());
                }
             }
             ++iter;
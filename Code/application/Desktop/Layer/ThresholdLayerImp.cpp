@@ -740,55 +740,66 @@ template<class T, class Drawer>
 void fillRegion(T* pData, DataAccessor& da, Drawer drawer, double firstThreshold, double secondThreshold,
                 unsigned int numRows, unsigned int numColumns, PassArea passArea, const BadValues* pBadValues)
 {
-   for (unsigned int uiRow = 0; uiRow < numRows; ++uiRow)
+   // Process each block of rows in memory at once since the accessor is always BSQ
+   unsigned int uiRow = 0;
+   while (uiRow < numRows)
    {
-      for (unsigned int uiColumn = 0; uiColumn < numColumns; ++uiColumn)
+      VERIFYNRV(da.isValid());
+      TileView<T, BSQ> tile = da->getTileView<T, BSQ>();
+      if (tile.getRowCount() == 0)
       {
-         double value = ModelServices::getDataValue(*(reinterpret_cast<T*>(da->getColumn())), COMPLEX_MAGNITUDE);
+         return;
+      }
 
-         bool passed = false;
-         switch (passArea)
+      for (size_t tileRow = 0; tileRow < tile.getRowCount() && uiRow < numRows; ++tileRow, ++uiRow)
+      {
+         RowView<T, BSQ> row = tile.getRowView(tileRow);
+         for (unsigned int uiColumn = 0; uiColumn < numColumns; ++uiColumn)
          {
-         case LOWER:
-            if (value <= firstThreshold)
-            {
-               passed = true;
-            }
-            break;
-         case UPPER:
-            if (value >= firstThreshold)
-            {
-               passed = true;
-            }
-            break;
-         case MIDDLE:
-            if ((value >= firstThreshold) && (value <= secondThreshold))
-            {
-               passed = true;
-            }
-            break;
-         case OUTSIDE:
-            if ((value <= firstThreshold) || (value >= secondThreshold))
+            double value = ModelServices::getDataValue(row[uiColumn], COMPLEX_MAGNITUDE);
+
+            bool passed = false;
+            switch (passArea)
             {
-               passed = true;
+            case LOWER:
+               if (value <= firstThreshold)
+               {
+                  passed = true;
+               }
+               break;
+            case UPPER:
+               if (value >= firstThreshold)
+               {
+                  passed = true;
+               }
+               break;
+            case MIDDLE:
+               if ((value >= firstThreshold) && (value <= secondThreshold))
+               {
+                  passed = true;
+               }
+               break;
+            case OUTSIDE:
+               if ((value <= firstThreshold) || (value >= secondThreshold))
+               {
+                  passed = true;
+               }
+               break;
+            default:
+               break;
             }
-            break;
-         default:
-            break;
-         }
 
-         if (passed && pBadValues != NULL)
-         {
-            if (pBadValues->isBadValue(value) == false)
+            if (passed && pBadValues != NULL)
             {
-               drawer(uiColumn, uiRow);
+               if (pBadValues->isBadValue(value) == false)
+               {
+                  drawer(uiColumn, uiRow);
+               }
             }
          }
-
-         da->nextColumn();
       }
 
-      da->nextRow();
+      da->nextRow(static_cast<int>(tile.getRowCount()));
    }
 }
 
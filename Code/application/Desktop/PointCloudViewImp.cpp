@@ -17,9 +17,11 @@
 #include "MessageLogResource.h"
 #include "MouseModeImp.h"
 #include "MultiThreadedAlgorithm.h"
+#include "ObjectResource.h"
 #include "PointCloudAccessor.h"
 #include "PointCloudAccessorImpl.h"
 #include "PointCloudDataDescriptor.h"
+#include "PointCloudDataRequest.h"
 #include "PointCloudElement.h"
 #include "PointCloudViewAdapter.h"
 #include "PointCloudViewImp.h"
@@ -46,6 +48,20 @@ using namespace std;
 namespace
 {
    const string shortcutContext = "View/PointCloud";
+
+   // The decimated points are read from the level of detail subsamples of the element's spatial index
+   // instead of by stepping through every point
+   PointCloudAccessor getDecimatedAccessor(PointCloudElement* pElement, uint32_t decimation)
+   {
+      FactoryResource<PointCloudDataRequest> pRequest;
+      pRequest->setDecimation(decimation);
+      return pElement->getPointCloudAccessor(pRequest.release());
+   }
+
+   int getPercent(uint32_t point, uint32_t pointCount)
+   {
+      return static_cast<int>(static_cast<uint64_t>(point) * 100 / max(pointCount, 1U));
+   }
 }
 
 PointCloudViewImp::PointCloudViewImp(const std::string& id, const std::string& viewName, QGLContext* drawContext,
@@ -750,9 +766,10 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
 
    mta::StatusBarReporter queryReporter("Querying points", "app", "75711F5F-7286-4B5B-8F46-6E1EF33CAA19");
    int oldPercent = 0, curPercent = 0;
-   PointCloudAccessor pAccessor = mpPrimaryPointCloud->getPointCloudAccessor();
    uint32_t validPointCount = 0;
    uint32_t decimation = mDecimation + 1;
+   const uint32_t queriedDecimation = decimation;
+   PointCloudAccessor pAccessor = getDecimatedAccessor(mpPrimaryPointCloud.get(), decimation);
    if (!pAccessor.isValid())
    {
       return;
@@ -761,18 +778,14 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
    {
       pAccessor->nextValidPoint();
    }
-   for (unsigned int i = 0; i < pointCount; i += decimation)
+   while (pAccessor.isValid() && validPointCount < pointCount)
    {
-      curPercent = i * 100 / pointCount;
+      curPercent = getPercent(validPointCount * decimation, pointCount);
       if (curPercent - oldPercent >= 1) 
       {
          queryReporter.reportProgress(min(curPercent, 99));
       }
       oldPercent = curPercent;
-      if (!pAccessor.isValid())
-      {
-         return;
-      }
 
       GLfloat xValue = pAccessor->getXAsDouble();
       minX = std::min(xValue, minX);
@@ -784,10 +797,7 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
       minZ = std::min(zValue, minZ);
       maxZ = std::max(zValue, maxZ);
       validPointCount++;
-      for (unsigned int skip = 0; (skip < decimation) && (i + skip + 1 < pointCount); ++skip)
-      {
-         pAccessor->nextValidPoint();
-      }
+      pAccessor->nextValidPoint();
    }
    queryReporter.reportProgress(100);
 
@@ -826,9 +836,17 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
    mta::StatusBarReporter barReporter("Transferring points", "app", "75711F5F-7286-4B5B-8F46-6E1EF33CAA19");
    oldPercent = 0;
    curPercent = 0;
-   pAccessor->toIndex(0);
+   if (decimation == queriedDecimation)
+   {
+      pAccessor->toIndex(0);
+   }
+   else
+   {
+      pAccessor = getDecimatedAccessor(mpPrimaryPointCloud.get(), decimation);
+   }
    if (!pAccessor.isValid())
    {
+      mpVertexBuffer->unmap();
       return;
    }
    if (!pAccessor->isPointValid())
@@ -837,19 +855,15 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
    }
    GLfloat minZcalc = std::numeric_limits<float>::max();
    GLfloat maxZcalc = -1.0 * minZcalc;
-   for (unsigned int i = 0; i < pointCount; i += decimation)
+   uint32_t transferredPointCount = 0;
+   while (pAccessor.isValid() && transferredPointCount < validPointCount)
    {
-      curPercent = i * 100 / pointCount;
+      curPercent = getPercent(transferredPointCount, validPointCount);
       if (curPercent - oldPercent >= 1) 
       {
          barReporter.reportProgress(min(curPercent, 99));
       }
       oldPercent = curPercent;
-      if (!pAccessor.isValid())
-      {
-         mpVertexBuffer->unmap();
-         return;
-      }
 
       *pBuffer = pAccessor->getXAsDouble() - minX;
       pBuffer++;
@@ -869,10 +883,8 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
       maxZcalc = std::max(zValue, maxZcalc);
       *pBuffer = zValue;
       pBuffer++;
-      for (unsigned int skip = 0; (skip < decimation) && (i + skip + 1 < pointCount); ++skip)
-      {
-         pAccessor->nextValidPoint();
-      }
+      transferredPointCount++;
+      pAccessor->nextValidPoint();
    }
    mpVertexBuffer->unmap();
    mpShaderProg->setAttributeBuffer(MVERTEX_ATTRIB_NUM, GL_FLOAT, 0, 3, 0);
@@ -887,7 +899,7 @@ void PointCloudViewImp::updateVertexBufferIfNeeded()
    // values until we have proper statistics support for point clouds
    //mFrontPlane = std::min(mFrontPlane,mMinZ * 0.8);
    //mBackPlane = std::max(mBackPlane,mMaxZ * 1.5);
-   mTotalPoints = validPointCount;
+   mTotalPoints = transferredPointCount;
    barReporter.reportProgress(100);
    mVertexBufferUpToDate = true;
 }
@@ -950,12 +962,10 @@ void PointCloudViewImp::updateColorizationBufferIfNeeded()
       return;
    }
 
-   uint32_t pointCount = pDesc->getPointCount();
-
+   // The colorization buffer holds a value for each point in the vertex buffer, in the same order
    int oldPercent = 0, curPercent = 0;
-   PointCloudAccessor pAccessor = mpPrimaryPointCloud->getPointCloudAccessor();
-   uint32_t decimation = mDecimation + 1;
-   uint32_t validPointCount = pointCount / decimation;
+   PointCloudAccessor pAccessor = getDecimatedAccessor(mpPrimaryPointCloud.get(), mDecimation + 1);
+   uint32_t validPointCount = mTotalPoints;
    if (!pAccessor.isValid())
    {
       return;
@@ -967,7 +977,7 @@ void PointCloudViewImp::updateColorizationBufferIfNeeded()
 
    mpColorizationBuffer->bind();
    mpColorizationBuffer->allocate(sizeof(GLfloat)*1*validPointCount);
-   GLfloat* pBuffer = reinterpret_cast<GLfloat*>(mpVertexBuffer->map(QGLBuffer::ReadWrite));
+   GLfloat* pBuffer = reinterpret_cast<GLfloat*>(mpColorizationBuffer->map(QGLBuffer::ReadWrite));
    if (pBuffer == NULL)
    {
       return;
@@ -976,29 +986,16 @@ void PointCloudViewImp::updateColorizationBufferIfNeeded()
    mta::StatusBarReporter barReporter("Transferring colorization data", "app", "58AC5F1A-BEFE-44E9-B292-D2E0D390A084");
    oldPercent = 0;
    curPercent = 0;
-   if (!pAccessor.isValid())
-   {
-      return;
-   }
-   if (!pAccessor->isPointValid())
-   {
-      pAccessor->nextValidPoint();
-   }
    GLfloat minCalc = std::numeric_limits<float>::max();
    GLfloat maxCalc = -1.0 * minCalc;
-   for (unsigned int i = 0; i < pointCount; i += decimation)
+   for (uint32_t i = 0; i < validPointCount && pAccessor.isValid(); ++i)
    {
-      curPercent = i * 100 / pointCount;
+      curPercent = getPercent(i, validPointCount);
       if (curPercent - oldPercent >= 1) 
       {
          barReporter.reportProgress(min(curPercent, 99));
       }
       oldPercent = curPercent;
-      if (!pAccessor.isValid())
-      {
-         mpColorizationBuffer->unmap();
-         return;
-      }
 
       GLfloat value;
       switch (mCurrentColorization)
@@ -1017,10 +1014,7 @@ void PointCloudViewImp::updateColorizationBufferIfNeeded()
       maxCalc = std::max(value, maxCalc);
       *pBuffer = value;
       pBuffer++;
-      for (unsigned int skip = 0; (skip < decimation) && (i + skip + 1 < pointCount); ++skip)
-      {
-         pAccessor->nextValidPoint();
-      }
+      pAccessor->nextValidPoint();
    }
    mpColorizationBuffer->unmap();
    mpShaderProg->setAttributeBuffer(MCOLOR_ATTRIB_NUM, GL_FLOAT, 0, 1, 0);
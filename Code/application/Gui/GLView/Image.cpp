@@ -512,6 +512,59 @@ private:
 
    TileThread& operator=(const TileThread& rhs);
 
+   // Reads from the overview matching the reduction factor if it is available,
+   // otherwise from the full resolution data.  The step for nextRow() and nextColumn() is returned in step.
+   static DataAccessor getTileAccessor(RasterElement* pRasterElement, DimensionDescriptor band,
+      unsigned int posX, unsigned int posY, unsigned int geomSizeX, unsigned int geomSizeY,
+      int reductionFactor, int& step)
+   {
+      RasterDataDescriptor* pRasterDescriptor =
+         dynamic_cast<RasterDataDescriptor*>(pRasterElement->getDataDescriptor());
+      VERIFYRV(pRasterDescriptor != NULL, DataAccessor(NULL, NULL));
+
+      unsigned int level = 0;
+      while ((1 << level) < reductionFactor)
+      {
+         ++level;
+      }
+
+      if (level > 0 && posX % reductionFactor == 0 && posY % reductionFactor == 0)
+      {
+         DimensionDescriptor startRow;
+         DimensionDescriptor stopRow;
+         DimensionDescriptor startColumn;
+         DimensionDescriptor stopColumn;
+         startRow.setActiveNumber(posY >> level);
+         stopRow.setActiveNumber((posY + geomSizeY - 1) >> level);
+         startColumn.setActiveNumber(posX >> level);
+         stopColumn.setActiveNumber((posX + geomSizeX - 1) >> level);
+
+         FactoryResource<DataRequest> pRequest;
+         pRequest->setResolutionLevel(level);
+         pRequest->setRows(startRow, stopRow, stopRow.getActiveNumber() - startRow.getActiveNumber() + 1);
+         pRequest->setColumns(startColumn, stopColumn,
+            stopColumn.getActiveNumber() - startColumn.getActiveNumber() + 1);
+         pRequest->setBands(band, band, 1);
+
+         DataAccessor da = pRasterElement->getDataAccessor(pRequest.release());
+         if (da.isValid())
+         {
+            step = 1;
+            return da;
+         }
+      }
+
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setRows(pRasterDescriptor->getActiveRow(posY), 
+         pRasterDescriptor->getActiveRow(posY + geomSizeY - 1), geomSizeY);
+      pRequest->setColumns(pRasterDescriptor->getActiveColumn(posX), 
+         pRasterDescriptor->getActiveColumn(posX + geomSizeX - 1), geomSizeX);
+      pRequest->setBands(band, band, 1);
+
+      step = reductionFactor;
+      return pRasterElement->getDataAccessor(pRequest.release());
+   }
+
    // grayscale, channel specifies the band to display
    template <class T>
    void createGrayscale(T* pData, ComplexComponent component)
@@ -556,26 +609,17 @@ private:
 
             RasterElement* pRasterElement = mInfo.mKey.mpRasterElement[0];
             VERIFYNRV(pRasterElement != NULL);
-            RasterDataDescriptor* pRasterDescriptor =
-               dynamic_cast<RasterDataDescriptor*>(pRasterElement->getDataDescriptor());
-            VERIFYNRV(pRasterDescriptor != NULL);
             VERIFYNRV(mInfo.mKey.mBand1.isValid());
-            FactoryResource<DataRequest> pRequest;
-            pRequest->setRows(pRasterDescriptor->getActiveRow(posY), 
-               pRasterDescriptor->getActiveRow(posY+geomSizeY-1), geomSizeY);
-            pRequest->setColumns(pRasterDescriptor->getActiveColumn(posX), 
-               pRasterDescriptor->getActiveColumn(posX+geomSizeX-1), geomSizeX);
-            pRequest->setBands(mInfo.mKey.mBand1,
-               mInfo.mKey.mBand1, 1);
-
-            DataAccessor da = pRasterElement->getDataAccessor(pRequest.release());
+
+            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
+            int step = reductionFactor;
+            DataAccessor da = getTileAccessor(pRasterElement, mInfo.mKey.mBand1,
+               posX, posY, geomSizeX, geomSizeY, reductionFactor, step);
             if (!da.isValid())
             {
                return;
             }
 
-            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
-
             vector<unsigned char>::iterator targetBase = pTexData.begin();
 
             for (unsigned int y1 = 0;
@@ -625,11 +669,11 @@ private:
                      *target = 0xff;
                   }
 
-                  da->nextColumn(reductionFactor);
+                  da->nextColumn(step);
                   source = static_cast<T*>(da->getColumn());
                }
 
-               da->nextRow(reductionFactor);
+               da->nextRow(step);
             }
 
             SetTileTexture cmd(pTile, &pTexData[0], mTileZoomIndices[tileId]);
@@ -686,26 +730,17 @@ private:
             unsigned int geomSizeY = pTile->getGeomSize().mY;
             RasterElement* pRasterElement = mInfo.mKey.mpRasterElement[0];
             VERIFYNRV(pRasterElement != NULL);
-            RasterDataDescriptor* pRasterDescriptor =
-               dynamic_cast<RasterDataDescriptor*>(pRasterElement->getDataDescriptor());
-            VERIFYNRV(pRasterDescriptor != NULL);
             VERIFYNRV(mInfo.mKey.mBand1.isValid());
-            
-            FactoryResource<DataRequest> pRequest;
-            pRequest->setRows(pRasterDescriptor->getActiveRow(posY), 
-               pRasterDescriptor->getActiveRow(posY + geomSizeY - 1), geomSizeY);
-            pRequest->setColumns(pRasterDescriptor->getActiveColumn(posX), 
-               pRasterDescriptor->getActiveColumn(posX + geomSizeX - 1), geomSizeX);
-            pRequest->setBands(mInfo.mKey.mBand1,
-               mInfo.mKey.mBand1, 1);
-
-            DataAccessor da = pRasterElement->getDataAccessor(pRequest.release());
+
+            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
+            int step = reductionFactor;
+            DataAccessor da = getTileAccessor(pRasterElement, mInfo.mKey.mBand1,
+               posX, posY, geomSizeX, geomSizeY, reductionFactor, step);
             if (!da.isValid())
             {
                return;
             }
 
-            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
             vector<unsigned char>::iterator targetBase = pTexData.begin();
 
             for (unsigned int y1 = 0;
@@ -764,9 +799,9 @@ private:
                      ++target;
                   }
 
-                  da->nextColumn(reductionFactor);
+                  da->nextColumn(step);
                }
-               da->nextRow(reductionFactor);
+               da->nextRow(step);
             }
 
             SetTileTexture cmd(pTile, &pTexData[0], mTileZoomIndices[tileId]);
@@ -846,24 +881,18 @@ private:
             unsigned int geomSizeX = pTile->getGeomSize().mX;
             unsigned int geomSizeY = pTile->getGeomSize().mY;
 
+            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
+
             // Create a data accessor for each band
             RasterElement* pRedRasterElement = mInfo.mKey.mpRasterElement[0];
             DimensionDescriptor redBand = mInfo.mKey.mBand1;
             bool haveRedData = (pRedRasterElement != NULL) && (redBand.isActiveNumberValid());
             DataAccessor daRed(NULL, NULL);
+            int redStep = reductionFactor;
             if (haveRedData)
             {
-               RasterDataDescriptor* pRedRasterDescriptor =
-                  dynamic_cast<RasterDataDescriptor*>(pRedRasterElement->getDataDescriptor());
-               VERIFYNRV(pRedRasterDescriptor != NULL);
-               FactoryResource<DataRequest> pRedRequest;
-               pRedRequest->setRows(pRedRasterDescriptor->getActiveRow(posY), 
-                  pRedRasterDescriptor->getActiveRow(posY+geomSizeY-1), geomSizeY);
-               pRedRequest->setColumns(pRedRasterDescriptor->getActiveColumn(posX), 
-                  pRedRasterDescriptor->getActiveColumn(posX+geomSizeX-1), geomSizeX);
-               pRedRequest->setBands(mInfo.mKey.mBand1, mInfo.mKey.mBand1, 1);
-
-               daRed = pRedRasterElement->getDataAccessor(pRedRequest.release());
+               daRed = getTileAccessor(pRedRasterElement, mInfo.mKey.mBand1,
+                  posX, posY, geomSizeX, geomSizeY, reductionFactor, redStep);
                if (!daRed.isValid())
                {
                   return;
@@ -874,19 +903,11 @@ private:
             DimensionDescriptor greenBand = mInfo.mKey.mBand2;
             bool haveGreenData = (pGreenRasterElement != NULL) && (greenBand.isActiveNumberValid());
             DataAccessor daGreen(NULL, NULL);
+            int greenStep = reductionFactor;
             if (haveGreenData)
             {
-               RasterDataDescriptor* pGreenRasterDescriptor =
-                  dynamic_cast<RasterDataDescriptor*>(pGreenRasterElement->getDataDescriptor());
-               VERIFYNRV(pGreenRasterDescriptor != NULL);
-               FactoryResource<DataRequest> pGreenRequest;
-               pGreenRequest->setRows(pGreenRasterDescriptor->getActiveRow(posY), 
-                  pGreenRasterDescriptor->getActiveRow(posY+geomSizeY-1), geomSizeY);
-               pGreenRequest->setColumns(pGreenRasterDescriptor->getActiveColumn(posX), 
-                  pGreenRasterDescriptor->getActiveColumn(posX+geomSizeX-1), geomSizeX);
-               pGreenRequest->setBands(mInfo.mKey.mBand2, mInfo.mKey.mBand2, 1);
-
-               daGreen = pGreenRasterElement->getDataAccessor(pGreenRequest.release());
+               daGreen = getTileAccessor(pGreenRasterElement, mInfo.mKey.mBand2,
+                  posX, posY, geomSizeX, geomSizeY, reductionFactor, greenStep);
                if (!daGreen.isValid())
                {
                   return;
@@ -897,27 +918,17 @@ private:
             DimensionDescriptor blueBand = mInfo.mKey.mBand3;
             bool haveBlueData = (pBlueRasterElement != NULL) && (blueBand.isActiveNumberValid());
             DataAccessor daBlue(NULL, NULL);
+            int blueStep = reductionFactor;
             if (haveBlueData)
             {
-               RasterDataDescriptor* pBlueRasterDescriptor =
-                  dynamic_cast<RasterDataDescriptor*>(pBlueRasterElement->getDataDescriptor());
-               VERIFYNRV(pBlueRasterDescriptor != NULL);
-               FactoryResource<DataRequest> pBlueRequest;
-               pBlueRequest->setRows(pBlueRasterDescriptor->getActiveRow(posY), 
-                  pBlueRasterDescriptor->getActiveRow(posY+geomSizeY-1), geomSizeY);
-               pBlueRequest->setColumns(pBlueRasterDescriptor->getActiveColumn(posX), 
-                  pBlueRasterDescriptor->getActiveColumn(posX+geomSizeX-1), geomSizeX);
-               pBlueRequest->setBands(mInfo.mKey.mBand3, mInfo.mKey.mBand3, 1);
-
-               daBlue = pBlueRasterElement->getDataAccessor(pBlueRequest.release());
+               daBlue = getTileAccessor(pBlueRasterElement, mInfo.mKey.mBand3,
+                  posX, posY, geomSizeX, geomSizeY, reductionFactor, blueStep);
                if (!daBlue.isValid())
                {
                   return;
                }
             }
 
-            int reductionFactor = Tile::computeReductionFactor(mTileZoomIndices[tileId]);
-
             vector<unsigned char>::iterator targetBase = pTexData.begin();
 
             for (unsigned int y1 = 0;
@@ -952,7 +963,7 @@ private:
                         isRedValueBad = false;
                      }
 
-                     daRed->nextColumn(reductionFactor);
+                     daRed->nextColumn(redStep);
                   }
 
                   if (isRedValueBad == true)
@@ -987,7 +998,7 @@ private:
                         isGreenValueBad = false;
                      }
 
-                     daGreen->nextColumn(reductionFactor);
+                     daGreen->nextColumn(greenStep);
                   }
 
                   if (isGreenValueBad == true)
@@ -1022,7 +1033,7 @@ private:
                         isBlueValueBad = false;
                      }
 
-                     daBlue->nextColumn(reductionFactor);
+                     daBlue->nextColumn(blueStep);
                   }
 
                   if (isBlueValueBad == true)
@@ -1055,17 +1066,17 @@ private:
 
                if (daRed.isValid() == true)
                {
-                  daRed->nextRow(reductionFactor);
+                  daRed->nextRow(redStep);
                }
 
                if (daGreen.isValid() == true)
                {
-                  daGreen->nextRow(reductionFactor);
+                  daGreen->nextRow(greenStep);
                }
 
                if (daBlue.isValid() == true)
                {
-                  daBlue->nextRow(reductionFactor);
+                  daBlue->nextRow(blueStep);
                }
             }
 
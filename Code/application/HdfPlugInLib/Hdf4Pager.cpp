@@ -33,6 +33,7 @@ Hdf4Pager::Hdf4Pager() :
    setName("Hdf4Pager");
    setDescriptorId("{DA5E408C-35CC-4f50-B50D-AD0B05174AEA}");
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setPrefetchEnabled(true);
 }
 
 Hdf4Pager::~Hdf4Pager()
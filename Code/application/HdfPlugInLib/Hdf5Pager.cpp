@@ -8,6 +8,7 @@
  */
 
 #include <hdf5.h> // #include this first so Hdf5Pager class is included properly
+#include <algorithm>
 #include <vector>
 
 #include "ComplexData.h"
@@ -29,12 +30,33 @@
 using namespace HdfUtilities;
 using namespace std;
 
+namespace
+{
+   // HDF5 recommends a prime number of hash slots, about 100 times the number of chunks in the cache
+   size_t getChunkCacheSlotCount(size_t chunkCount)
+   {
+      size_t slotCount = max(chunkCount * 100, static_cast<size_t>(521)) | 1;
+      for (size_t divisor = 3; divisor * divisor <= slotCount; divisor += 2)
+      {
+         if (slotCount % divisor == 0)
+         {
+            // try the next odd number from the first divisor
+            slotCount += 2;
+            divisor = 1;
+         }
+      }
+
+      return slotCount;
+   }
+}
+
 Hdf5Pager::Hdf5Pager() :
    mFileHandle(INVALID_HANDLE), mDataHandle(INVALID_HANDLE), mFileAccessProperties(H5P_DEFAULT)
 {
    setName("Hdf5Pager");
    setDescriptorId("{F3720154-8F3A-43e2-BF36-3A810B59218F}");
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setPrefetchEnabled(true);
 }
 
 Hdf5Pager::~Hdf5Pager()
@@ -109,9 +131,89 @@ bool Hdf5Pager::openFile(const std::string& filename)
    {
       return false;
    }
+
+   // reopen the dataset if its chunks need a larger cache than the file provides
+   hid_t accessProperties = createDatasetAccessProperties();
+   if (accessProperties != INVALID_HANDLE)
+   {
+      hid_t dataHandle = H5Dopen2(mFileHandle, hdfFullPathAndName.c_str(), accessProperties);
+      H5Pclose(accessProperties);
+      if (dataHandle != INVALID_HANDLE)
+      {
+         H5Dclose(mDataHandle);
+         mDataHandle = dataHandle;
+      }
+   }
    return true;
 }
 
+hid_t Hdf5Pager::createDatasetAccessProperties() const
+{
+   hsize_t dimensions[3] = {1, 1, 1};
+   hsize_t chunkDimensions[3] = {1, 1, 1};
+   int rank = 0;
+   hid_t createProperties = H5Dget_create_plist(mDataHandle);
+   if (createProperties >= 0)
+   {
+      if (H5Pget_layout(createProperties) == H5D_CHUNKED)
+      {
+         rank = H5Pget_chunk(createProperties, 3, chunkDimensions);
+      }
+      H5Pclose(createProperties);
+   }
+
+   Hdf5DataSpaceResource dataSpace(H5Dget_space(mDataHandle));
+   Hdf5TypeResource dataType(H5Dget_type(mDataHandle));
+   if (rank < 2 || *dataSpace < 0 || *dataType < 0 || H5Sget_simple_extent_ndims(*dataSpace) != rank)
+   {
+      return INVALID_HANDLE;
+   }
+   H5Sget_simple_extent_dims(*dataSpace, dimensions, NULL);
+
+   // A page holds whole rows, so it reads every chunk across the dimensions after the first.  A BSQ page
+   // holds rows of a single band, so it reads every chunk across the columns.
+   int firstDimensionAcross = 1;
+   const RasterElement* pRaster = getRasterElement();
+   if (rank == 3 && pRaster != NULL)
+   {
+      const RasterFileDescriptor* pFileDescriptor = dynamic_cast<const RasterFileDescriptor*>(
+         pRaster->getDataDescriptor()->getFileDescriptor());
+      if (pFileDescriptor != NULL && pFileDescriptor->getInterleaveFormat() == BSQ)
+      {
+         firstDimensionAcross = 2;
+      }
+   }
+
+   size_t chunkBytes = H5Tget_size(*dataType);
+   size_t chunkCount = 1;
+   for (int dimension = 0; dimension < rank; ++dimension)
+   {
+      chunkBytes *= static_cast<size_t>(chunkDimensions[dimension]);
+      if (dimension >= firstDimensionAcross)
+      {
+         chunkCount *= static_cast<size_t>((dimensions[dimension] + chunkDimensions[dimension] - 1) /
+            chunkDimensions[dimension]);
+      }
+   }
+
+   // Without room for every chunk of a page, each chunk is read and decompressed once for each page
+   // which overlaps it
+   size_t cacheBytes = min(chunkBytes * chunkCount, static_cast<size_t>(Hdf5Pager::getSettingMaximumCacheSize()));
+   if (cacheBytes <= Hdf5Pager::getSettingCacheSize())
+   {
+      return INVALID_HANDLE;
+   }
+
+   hid_t accessProperties = H5Pcreate(H5P_DATASET_ACCESS);
+   if (accessProperties >= 0 && H5Pset_chunk_cache(accessProperties,
+      getChunkCacheSlotCount(cacheBytes / chunkBytes), cacheBytes, H5D_CHUNK_CACHE_W0_DEFAULT) < 0)
+   {
+      H5Pclose(accessProperties);
+      accessProperties = INVALID_HANDLE;
+   }
+   return accessProperties;
+}
+
 void Hdf5Pager::closeFile()
 {
    if (mFileAccessProperties != H5P_DEFAULT)
@@ -31,6 +31,7 @@ class Hdf5Pager : public HdfPager, public Hdf5PagerFileHandle
 public:
    SETTING(CacheSize, Hdf5Pager, unsigned int, 1024 * 1024)
    SETTING(ChunkBufferSize, Hdf5Pager, unsigned int, 64 * 1024)
+   SETTING(MaximumCacheSize, Hdf5Pager, unsigned int, 64 * 1024 * 1024)
 
    /**
     * Creates an RasterPager for HDF5 data.
@@ -68,6 +69,18 @@ private:
     */
    bool openFile(const std::string& filename);
 
+   /**
+    * Creates the access properties of a chunked dataset.
+    *
+    * The chunk cache is sized to hold every chunk read by a page of rows,
+    * up to the MaximumCacheSize setting, when that is larger than the
+    * CacheSize setting used for the whole file.
+    *
+    * @return The dataset access properties, which the caller closes, or
+    *         INVALID_HANDLE if the file's chunk cache is large enough.
+    */
+   hid_t createDatasetAccessProperties() const;
+
    /**
     * Closes the HDF5 dataset and file handles.
     */
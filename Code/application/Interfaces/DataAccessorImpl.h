@@ -16,6 +16,8 @@
 #include "DataRequest.h"
 #include "TypesFile.h"
 #include "ObjectResource.h"
+#include "RowView.h"
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
 
@@ -387,6 +389,58 @@ public:
       return mConcurrentColumns;
    }
 
+   /**
+    *  Gets a typed view of a band in the current row.
+    *
+    *  The view starts at the first column of the accessor, regardless of the
+    *  current column, and contains the columns of the request.  The layout
+    *  of the interleave is resolved at compile time, so algorithms can loop
+    *  over the view without calling nextColumn() for each pixel.
+    *
+    *  @param   band
+    *           The band to view, relative to the first band of the accessor.
+    *           This is ignored for BSQ data.
+    *
+    *  @return  A view of the band.  The template parameters must match the
+    *           data type of the RasterElement and the interleave of the request.
+    *
+    *  @see     RowView, switchOnInterleave
+    */
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   inline RowView<T, Interleave> getRowView(size_t band = 0)
+   {
+      return RowView<T, Interleave>(getBandStart<T, Interleave>(band), getViewColumnCount(), mConcurrentBands);
+   }
+
+   /**
+    *  Gets a typed view of a band in the rows which are currently in memory.
+    *
+    *  The view starts at the current row and the first column of the
+    *  accessor, and ends at the last row in memory or the last row of the
+    *  request, whichever comes first.  Call nextRow() with the number of rows
+    *  in the view to advance to the next block of rows.
+    *
+    *  @param   band
+    *           The band to view, relative to the first band of the accessor.
+    *           This is ignored for BSQ data.
+    *
+    *  @return  A view of the band.  The template parameters must match the
+    *           data type of the RasterElement and the interleave of the request.
+    *
+    *  @see     TileView, switchOnInterleave
+    */
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   inline TileView<T, Interleave> getTileView(size_t band = 0)
+   {
+      size_t rows = mConcurrentRows - mCurrentRow;
+      size_t row = mAccessorRow + mCurrentRow;
+      size_t stopRow = mpRequest->getStopRow().getActiveNumber();
+      rows = (row > stopRow ? 0 : std::min(rows, stopRow - row + 1));
+
+      return TileView<T, Interleave>(getBandStart<T, Interleave>(band), rows, getViewColumnCount(),
+         mConcurrentBands, mRowSize);
+   }
+
 private:
    friend class RasterElementImp;
 
@@ -410,6 +464,24 @@ private:
       }
    }
 
+   /**
+    *  Returns the first column of a band in the current row.
+    */
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   inline T* getBandStart(size_t band)
+   {
+      return reinterpret_cast<T*>(getRow()) + InterleaveTraits<Interleave>::getBandOffset(band, mConcurrentColumns);
+   }
+
+   /**
+    *  Returns the number of requested columns which are available in memory.
+    */
+   inline size_t getViewColumnCount() const
+   {
+      size_t columns = mpRequest->getStopColumn().getActiveNumber() - mAccessorColumn + 1;
+      return std::min(columns, mConcurrentColumns);
+   }
+
    /**
     *  Calculate the column and row size depending on the interleave format
     *  and number of concurrentColumns, concurrentRows and concurrentBands.
@@ -81,7 +81,8 @@ public:
     *        The descriptor to use to determine required version.
     *
     * @return The smallest version number which can properly use this
-    *         DataRequest.  Currently always returns 1.
+    *         DataRequest.  Returns 2 if a resolution level other than 0
+    *         has been requested, and 1 otherwise.
     *
     * @see RasterPager::getSupportedRequestVersion()
     */
@@ -286,6 +287,42 @@ public:
     */
    virtual void setWritable(bool writable) = 0;
 
+   /**
+    * Get the requested resolution level.
+    *
+    * This defaults to 0, which is the full resolution data.
+    *
+    * @return The requested resolution level.
+    *
+    * @see setResolutionLevel()
+    */
+   virtual unsigned int getResolutionLevel() const = 0;
+
+   /**
+    * Set the requested resolution level.
+    *
+    * Level \em n accesses an overview of the data which contains every
+    * 2<sup>n</sup>th row and column, starting with the first.  The rows and
+    * columns of the request are specified by their active numbers within the
+    * overview, which has (count + 2<sup>n</sup> - 1) / 2<sup>n</sup> rows
+    * and columns.  Only the active numbers of the row and column
+    * DimensionDescriptors are used.
+    *
+    * Overview requests are read-only and may only access a single band.
+    * Overviews are built in the background as they are requested, so an
+    * invalid DataAccessor will be returned until the overview for the band
+    * is available.  Callers should then fall back to the full resolution
+    * data by calling DataAccessorImpl::nextRow() and
+    * DataAccessorImpl::nextColumn() with a count of 2<sup>n</sup>, which
+    * produces the same values.
+    *
+    * @param level
+    *        The requested resolution level.
+    *
+    * @see getResolutionLevel(), RasterElement::buildOverviews()
+    */
+   virtual void setResolutionLevel(unsigned int level) = 0;
+
 protected:
    /**
     * This should be destroyed by calling ObjectFactory::destroyObject.
@@ -13,6 +13,7 @@
 #include "LocationType.h"
 
 #include <string>
+#include <vector>
 
 class QWidget;
 class RasterDataDescriptor;
@@ -32,7 +33,8 @@ class RasterDataDescriptor;
  *    <tr><td>Verify that user-specified georeference parameters are acceptable
  *      for georeferencing</td><td>validate()</td></tr>
  *    <tr><td>Perform coordinate transformations</td><td>pixelToGeo()<br>
- *      pixelToGeoQuick()<br>geoToPixel()<br>geoToPixelQuick()</td></tr>
+ *      pixelToGeoQuick()<br>geoToPixel()<br>geoToPixelQuick()<br>
+ *      pixelsToGeocoords()<br>geocoordsToPixels()</td></tr>
  *  </table>
  *
  *  A Georeference plug-in must implement SessionItem::serialize() and
@@ -257,6 +259,56 @@ public:
     */
    virtual LocationType geoToPixelQuick(LocationType geo, bool* pAccurate = NULL) const = 0;
 
+   /**
+    *  Takes multiple scene pixel coordinates and returns the corresponding
+    *  geocoordinate values.
+    *
+    *  This method returns the same values as calling pixelToGeo() or
+    *  pixelToGeoQuick() for each pixel, but allows the plug-in to share work
+    *  between the pixels and to convert large numbers of pixels in multiple
+    *  threads.
+    *
+    *  @param   pixels
+    *           The scene pixel locations.
+    *  @param   geocoords
+    *           Populated with the geocoordinate of each pixel location, in the
+    *           same order as \em pixels.
+    *  @param   quick
+    *           Set this to \c true to convert the pixels with
+    *           pixelToGeoQuick() instead of pixelToGeo().
+    *  @param   pAccurate
+    *           Output indicator of conversion accuracy, which is set to
+    *           \c false if any of the conversions is not accurate.  When
+    *           \c NULL, no accuracy check is performed.
+    */
+   virtual void pixelsToGeocoords(const std::vector<LocationType>& pixels, std::vector<LocationType>& geocoords,
+      bool quick = false, bool* pAccurate = NULL) const = 0;
+
+   /**
+    *  Takes multiple geocoordinates and returns the corresponding scene pixel
+    *  coordinate values.
+    *
+    *  This method returns the same values as calling geoToPixel() or
+    *  geoToPixelQuick() for each geocoordinate, but allows the plug-in to
+    *  share work between the geocoordinates and to convert large numbers of
+    *  geocoordinates in multiple threads.
+    *
+    *  @param   geocoords
+    *           The geocoordinates.
+    *  @param   pixels
+    *           Populated with the scene pixel location of each geocoordinate,
+    *           in the same order as \em geocoords.
+    *  @param   quick
+    *           Set this to \c true to convert the geocoordinates with
+    *           geoToPixelQuick() instead of geoToPixel().
+    *  @param   pAccurate
+    *           Output indicator of conversion accuracy, which is set to
+    *           \c false if any of the conversions is not accurate.  When
+    *           \c NULL, no accuracy check is performed.
+    */
+   virtual void geocoordsToPixels(const std::vector<LocationType>& geocoords, std::vector<LocationType>& pixels,
+      bool quick = false, bool* pAccurate = NULL) const = 0;
+
 protected:
    /**
     *  Since the Georeference interface is usually used in conjunction with the
@@ -25,6 +25,7 @@
 class DataDescriptor;
 class DataElement;
 class ImportDescriptor;
+class RasterCache;
 
 /**
  *  \ingroup ServiceModule
@@ -723,6 +724,15 @@ public:
     */
    virtual void deleteMemoryBlock(char* memory) = 0; 
 
+   /**
+    *  Returns the cache shared by all pagers which cache on-disk raster data.
+    *
+    *  @return  The process-wide raster cache.  This will never be \b NULL.
+    *
+    *  @see     RasterCache
+    */
+   virtual RasterCache* getRasterCache() = 0;
+
    /**
     *  This static method retrieves an individual data value from a block of memory.
     *
@@ -21,6 +21,7 @@
 #include "TypesFile.h"
 #include <exception>
 #include <stdexcept>
+#include <vector>
 
 typedef double (*convertToDoublePC)(const void*, double scale, double offset);
 typedef int64_t (*convertToIntegerPC)(const void*, double scale, double offset);
@@ -84,7 +85,9 @@ public:
       mHdrYScale(0.),
       mHdrYOffset(0.),
       mHdrZScale(0.),
-      mHdrZOffset(0.)
+      mHdrZOffset(0.),
+      mHasSelection(false),
+      mSelectedPoint(0)
    {
       if (mpPointElement == NULL)
       {
@@ -162,12 +165,18 @@ public:
    /**
     * Iterate to the next point in the underlying raw data order.
     *
-    * If there is no next point, the accessor will become invalid.
+    * If the request selected a subset of the points, only the selected points
+    * are visited.  If there is no next point, the accessor will become invalid.
     *
     * @throws std::logic_error if data pointers become corrupted.
     */
    inline void nextPoint()
    {
+      if (mHasSelection)
+      {
+         toSelectedPoint(mSelectedPoint + 1);
+         return;
+      }
       ++mCurrentPoint;
       mPointByteOffset += mPointSize;
       updateIfNeeded();
@@ -182,6 +191,11 @@ public:
     */
    inline void previousPoint()
    {
+      if (mHasSelection)
+      {
+         toSelectedPoint(mSelectedPoint - 1);
+         return;
+      }
       --mCurrentPoint;
       mPointByteOffset -= mPointSize;
       updateIfNeeded();
@@ -193,6 +207,10 @@ public:
     * Bounds checking is not performed on the index so the
     * calling routine should ensure it is a valid index.
     *
+    * If the request selected a subset of the points with a bounding box or a
+    * decimation, the index is the position within the selected points and
+    * the accessor becomes invalid if there is no such position.
+    *
     * @param index
     *        The index (in the underlying raw data order) of the requested point.
     *
@@ -200,9 +218,12 @@ public:
     */
    inline void toIndex(uint32_t index)
    {
-      mCurrentPoint = index - mCurrentPointOfBlockStart;
-      mPointByteOffset = mCurrentPoint * mPointSize;
-      updateIfNeeded();
+      if (mHasSelection)
+      {
+         toSelectedPoint(index);
+         return;
+      }
+      toPoint(index);
    }
 
    /**
@@ -533,6 +554,25 @@ public:
    }
 
 private:
+   inline void toPoint(uint32_t index)
+   {
+      mCurrentPoint = index - mCurrentPointOfBlockStart;
+      mPointByteOffset = mCurrentPoint * mPointSize;
+      updateIfNeeded();
+   }
+
+   inline void toSelectedPoint(uint32_t position)
+   {
+      mSelectedPoint = position;
+      if (position >= mSelectedPoints.size())
+      {
+         mbValid = false;
+         return;
+      }
+      mbValid = mpRawData != NULL;
+      toPoint(mSelectedPoints[position]);
+   }
+
    inline void updateIfNeeded()
    {
       if (mCurrentPoint >= mPointsInBlock)
@@ -611,6 +651,11 @@ private:
    double mHdrZScale;
    double mHdrZOffset;
 
+   // The points which satisfy the request, in ascending order, when the request selects a subset of the points
+   bool mHasSelection;
+   std::vector<uint32_t> mSelectedPoints;
+   uint32_t mSelectedPoint;
+
    friend class PointCloudElementImp;
 };
 
@@ -218,6 +218,33 @@ public:
     */
    virtual void setBoundingBox(double startX, double stopX, double startY, double stopY, double startZ, double stopZ) = 0;
 
+   /**
+    * Get the requested decimation.
+    *
+    * This defaults to 1.
+    *
+    * @return The requested decimation.
+    *
+    * @see setDecimation()
+    */
+   virtual uint32_t getDecimation() const = 0;
+
+   /**
+    * Set the requested decimation.
+    *
+    * A decimation greater than 1 requests a coarse representation of the
+    * point cloud which contains about one of every \em decimation points.
+    * The points are chosen so that they are spread evenly over the area of
+    * the point cloud.  When a subset of the points is requested, either with
+    * a decimation or with a bounding box smaller than the extents of the
+    * PointCloudDataDescriptor, PointCloudAccessor::toIndex() moves to a
+    * position within the requested points instead of to a point index.
+    *
+    * @param decimation
+    *        The requested decimation.  Values less than 1 are treated as 1.
+    */
+   virtual void setDecimation(uint32_t decimation) = 0;
+
    /**
     * Get whether the request is for writable data.
     *
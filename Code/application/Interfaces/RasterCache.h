@@ -0,0 +1,203 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef RASTERCACHE_H
+#define RASTERCACHE_H
+
+#include "ConfigurationSettings.h"
+
+#include <string>
+#include <vector>
+
+/**
+ *  A cache of raster data which shares the process-wide RasterCache budget.
+ *
+ *  Each client keeps its own cached units along with the access stamp obtained
+ *  from RasterCache::getNextAccess() when each unit was last used.  The
+ *  RasterCache uses these stamps to find the least recently used unit across
+ *  all clients when the budget is exceeded.
+ *
+ *  @see     RasterCache
+ */
+class RasterCacheClient
+{
+public:
+   /**
+    *  Returns a name identifying the cached data.
+    *
+    *  @return  A name for the cached data, typically the name of the
+    *           RasterElement being paged.
+    */
+   virtual std::string getCacheName() const = 0;
+
+   /**
+    *  Returns the number of bytes currently held by the client.
+    *
+    *  @return  The number of bytes allocated from the RasterCache budget.
+    */
+   virtual size_t getCacheSize() const = 0;
+
+   /**
+    *  Gets the access stamp of the least recently used unit in the client.
+    *
+    *  @param   access
+    *           Populated with the access stamp of the least recently used unit.
+    *
+    *  @return  \c true if the client contains a unit which can be evicted,
+    *           \c false otherwise.
+    */
+   virtual bool getLeastRecentAccess(size_t& access) const = 0;
+
+   /**
+    *  Removes the least recently used unit from the client.
+    *
+    *  This method is called by the RasterCache and should not call
+    *  RasterCache::deallocate() for the evicted unit.
+    *
+    *  @return  The number of bytes released, or 0 if nothing could be evicted.
+    */
+   virtual size_t evictLeastRecentlyUsed() = 0;
+
+   /**
+    *  Returns the number of requests which were satisfied from the client.
+    *
+    *  @return  The number of cache hits.
+    */
+   virtual size_t getHitCount() const = 0;
+
+   /**
+    *  Returns the number of requests which required data to be fetched.
+    *
+    *  @return  The number of cache misses.
+    */
+   virtual size_t getMissCount() const = 0;
+
+   /**
+    *  Returns the number of units evicted from the client to satisfy the budget.
+    *
+    *  @return  The number of evictions.
+    */
+   virtual size_t getEvictionCount() const = 0;
+
+protected:
+   /**
+    *  Clients must be removed from the RasterCache before they are destroyed.
+    */
+   virtual ~RasterCacheClient() {}
+};
+
+/**
+ *  Manages a single byte budget for all on-disk raster data cached in memory.
+ *
+ *  Pagers such as CachedPager cache blocks of data read from disk.  Rather than
+ *  giving each pager a fixed amount of memory, each pager registers itself as a
+ *  RasterCacheClient and allocates from a budget shared by the entire
+ *  application.  When the budget is exceeded, the least recently used units are
+ *  evicted regardless of which client holds them, so memory goes to the data
+ *  which is actually being accessed.
+ *
+ *  All methods are thread-safe.
+ *
+ *  @see     ModelServices::getRasterCache()
+ */
+class RasterCache
+{
+public:
+   /**
+    *  The maximum amount of memory in megabytes used to cache on-disk raster data.
+    */
+   SETTING(CacheSize, RasterCache, unsigned int, 256)
+
+   /**
+    *  Returns the budget shared by all clients.
+    *
+    *  @return  The maximum number of bytes which may be cached, as
+    *           specified by the CacheSize setting.
+    */
+   virtual size_t getMaximumSize() const = 0;
+
+   /**
+    *  Returns the number of bytes currently allocated by all clients.
+    *
+    *  @return  The number of bytes allocated.
+    */
+   virtual size_t getSize() const = 0;
+
+   /**
+    *  Registers a client with the cache.
+    *
+    *  @param   pClient
+    *           The client to add.  Cannot be \c NULL.
+    */
+   virtual void addClient(RasterCacheClient* pClient) = 0;
+
+   /**
+    *  Unregisters a client from the cache.
+    *
+    *  This must be called before the client is destroyed.  The client remains
+    *  responsible for calling deallocate() for any bytes it still holds.
+    *
+    *  @param   pClient
+    *           The client to remove.
+    */
+   virtual void removeClient(RasterCacheClient* pClient) = 0;
+
+   /**
+    *  Returns the registered clients.
+    *
+    *  This is intended for reporting cache statistics.  The returned
+    *  pointers are only valid until the clients are removed.
+    *
+    *  @return  The registered clients.
+    */
+   virtual std::vector<RasterCacheClient*> getClients() const = 0;
+
+   /**
+    *  Returns a stamp to record when a unit was accessed.
+    *
+    *  Stamps increase across all clients so that units held by different
+    *  clients can be compared to determine which was least recently used.
+    *
+    *  @return  The next access stamp.
+    */
+   virtual size_t getNextAccess() = 0;
+
+   /**
+    *  Adds bytes held by a client to the budget.
+    *
+    *  If the budget is exceeded, units are evicted from the least recently
+    *  used clients until the cache is within budget or nothing else can be
+    *  evicted.  The caller must not hold any locks which are also acquired
+    *  by RasterCacheClient::getLeastRecentAccess() or
+    *  RasterCacheClient::evictLeastRecentlyUsed().
+    *
+    *  @param   pClient
+    *           The client allocating the bytes.
+    *  @param   bytes
+    *           The number of bytes allocated.
+    */
+   virtual void allocate(RasterCacheClient* pClient, size_t bytes) = 0;
+
+   /**
+    *  Removes bytes which a client no longer holds from the budget.
+    *
+    *  @param   bytes
+    *           The number of bytes released.
+    */
+   virtual void deallocate(size_t bytes) = 0;
+
+protected:
+   /**
+    * This will be cleaned up during application close.  Plug-ins do not
+    * need to destroy it.
+    */
+   virtual ~RasterCache() {}
+};
+
+#endif
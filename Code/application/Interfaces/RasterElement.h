@@ -131,6 +131,9 @@ public:
    /**
     *  Notifies all observers of the object that its data has changed.
     *
+    *  Any overviews of the data are discarded and will be rebuilt when
+    *  they are next requested.
+    *
     *  @notify  This method will notify RasterElement::signalDataModified.
     */
    virtual void updateData() = 0;
@@ -152,6 +155,26 @@ public:
     */
    virtual uint64_t sanitizeData(double value = 0.0) = 0;
 
+   /**
+    *  Starts building the overviews of a band in the background.
+    *
+    *  Overviews provide reduced resolution data through a DataRequest with
+    *  a resolution level, and are built automatically the first time they
+    *  are requested.  This method can be called to start building the
+    *  overviews of a band before they are needed.  Overviews are stored in
+    *  a temporary file and are only available for data which is not
+    *  processed in memory.
+    *
+    *  @param   band
+    *           The band for which overviews should be built.
+    *
+    *  @return  Returns \b true if overviews are available or are being
+    *           built for the band; otherwise returns \b false.
+    *
+    *  @see     DataRequest::setResolutionLevel()
+    */
+   virtual bool buildOverviews(DimensionDescriptor band) = 0;
+
    /**
     *  Returns statistics for the given band data.
     *
@@ -246,6 +269,58 @@ public:
       const std::vector<DimensionDescriptor> &selectedBands,
       bool &abort, Progress *pProgress = NULL) const = 0;
 
+   /**
+    * This method will copy data from this RasterElement to the chip RasterElement,
+    * sanitize the copied data, and compute the statistics of the chip in a single
+    * pass over the data.
+    *
+    * The rows of the chip are divided among worker threads.  Each row is read
+    * from this element, written to the chip, and sanitized as described in
+    * sanitizeData() while it is in memory, and the values of each band are added
+    * to the statistics of the corresponding chip band.  When the pass is
+    * complete, the statistics of each band of the chip are set so that they do
+    * not need to be calculated when the chip is displayed.  Statistics are not
+    * set for floating point data if Statistics::getSettingSketchCapacity() is
+    * zero, since the histogram would require another pass over the data.
+    *
+    * The DimensionDescriptor vectors should be created by copying the descriptors
+    * of the desired rows, columns, or bands from the DataDescriptor of the source RasterElement.
+    * These must be in ascending order, without duplication.
+    *
+    *  @param   pRasterChip
+    *           The chip to copy data to.
+    *  @param   selectedRows
+    *           The DimensionDescriptors (unmodified from this object) for the rows
+    *           which should be included in this chip.
+    *  @param   selectedColumns
+    *           The DimensionDescriptors (unmodified from this object) for the columns
+    *           which should be included in this chip.
+    *  @param   selectedBands
+    *           The DimensionDescriptors (unmodified from this object) for the bands
+    *           which should be included in this chip.
+    *  @param   sanitizeValue
+    *           The value to use for all instances of floating point NaNs.
+    *  @param   sanitizedCount
+    *           Populated with the number of data values which were sanitized.
+    *           If this value is non-zero, RasterElement::updateData() is called
+    *           on the chip before its statistics are set.
+    *  @param   abort
+    *           A flag which can be set externally to abort.
+    *           Set this to true when abort is desired.
+    *  @param   pProgress
+    *           The progress object to report the current progress to.
+    *
+    *  @return  True if the operation succeeded, false otherwise
+    *
+    *  @see RasterElement::copyDataToChip(), RasterElement::sanitizeData()
+    */
+   virtual bool importDataToChip(RasterElement* pRasterChip,
+      const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns,
+      const std::vector<DimensionDescriptor>& selectedBands,
+      double sanitizeValue, uint64_t& sanitizedCount,
+      bool& abort, Progress* pProgress = NULL) const = 0;
+
    /**
     *  Creates a new raster element with the same values as this element but without copying the raster data.
     *
@@ -521,8 +596,10 @@ public:
    /**
     *  Returns geocoordinates for multiple pixel locations.
     *
-    *  This method uses the convertPixelToGeocoord() method to perform the
-    *  conversion for each pixel location.
+    *  This method converts all of the pixel locations with a single call to
+    *  Georeference::pixelsToGeocoords(), which returns the same values as
+    *  convertPixelToGeocoord() but may convert the pixel locations in
+    *  multiple threads.
     *
     *  @param   pixels
     *           The pixel locations for which to get their geocoordinates.
@@ -560,8 +637,10 @@ public:
    /**
     *  Returns pixel locations for multiple geocoordinates.
     *
-    *  This method uses the convertGeocoordToPixel() method to perform the
-    *  conversion for each geocoordinate.
+    *  This method converts all of the geocoordinates with a single call to
+    *  Georeference::geocoordsToPixels(), which returns the same values as
+    *  convertGeocoordToPixel() but may convert the geocoordinates in
+    *  multiple threads.
     *
     *  @param   geocoords
     *           The geocoordinates for which to get the pixel locations.
@@ -0,0 +1,339 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef ROWVIEW_H
+#define ROWVIEW_H
+
+#include "TypesFile.h"
+
+#include <stddef.h>
+
+/**
+ * Describes the layout of a single band within a row of data at compile time.
+ *
+ * The specializations allow RowView and TileView to compute the location of
+ * each column without a runtime check of the interleave.  For BIL and BSQ
+ * data, the columns of a band are contiguous, so loops over a view can be
+ * vectorized by the compiler.
+ *
+ * @see DataAccessorImpl::getRowView(), DataAccessorImpl::getTileView()
+ */
+template<InterleaveFormatTypeEnum Interleave>
+struct InterleaveTraits;
+
+/**
+ * The layout of a band within a row of BIP data.
+ */
+template<>
+struct InterleaveTraits<BIP>
+{
+   /**
+    * Returns the number of elements between successive columns of a band.
+    *
+    * @param bands
+    *        The number of bands in the row.
+    *
+    * @return The number of bands in the row.
+    */
+   static size_t getColumnStride(size_t bands)
+   {
+      return bands;
+   }
+
+   /**
+    * Returns the offset in elements of the first column of a band.
+    *
+    * @param band
+    *        The band, relative to the first band in the row.
+    * @param columns
+    *        The number of columns in the row.
+    *
+    * @return The offset of the band from the start of the row.
+    */
+   static size_t getBandOffset(size_t band, size_t columns)
+   {
+      return band;
+   }
+};
+
+/**
+ * The layout of a band within a row of BIL data.
+ */
+template<>
+struct InterleaveTraits<BIL>
+{
+   /**
+    * @copydoc InterleaveTraits<BIP>::getColumnStride()
+    *
+    * @return Always returns 1.
+    */
+   static size_t getColumnStride(size_t bands)
+   {
+      return 1;
+   }
+
+   /**
+    * @copydoc InterleaveTraits<BIP>::getBandOffset()
+    */
+   static size_t getBandOffset(size_t band, size_t columns)
+   {
+      return band * columns;
+   }
+};
+
+/**
+ * The layout of a band within a row of BSQ data.
+ */
+template<>
+struct InterleaveTraits<BSQ>
+{
+   /**
+    * @copydoc InterleaveTraits<BIP>::getColumnStride()
+    *
+    * @return Always returns 1.
+    */
+   static size_t getColumnStride(size_t bands)
+   {
+      return 1;
+   }
+
+   /**
+    * @copydoc InterleaveTraits<BIP>::getBandOffset()
+    *
+    * @return Always returns 0, since a BSQ row contains a single band.
+    */
+   static size_t getBandOffset(size_t band, size_t columns)
+   {
+      return 0;
+   }
+};
+
+/**
+ * Provides typed access to the columns of a single band within a row of data.
+ *
+ * A RowView does not own the data, and is only valid until the DataAccessor
+ * from which it was obtained is advanced.
+ *
+ * @code
+ * RowView<float, BSQ> row = pAccessor->getRowView<float, BSQ>();
+ * for (size_t column = 0; column < row.getColumnCount(); ++column)
+ * {
+ *    sum += row[column];
+ * }
+ * @endcode
+ *
+ * @see DataAccessorImpl::getRowView()
+ */
+template<typename T, InterleaveFormatTypeEnum Interleave>
+class RowView
+{
+public:
+   /**
+    * Creates a view of a band within a row.
+    *
+    * @param pData
+    *        The first column of the band.
+    * @param columns
+    *        The number of columns in the view.
+    * @param bands
+    *        The number of bands in the row.
+    */
+   RowView(T* pData, size_t columns, size_t bands) :
+      mpData(pData),
+      mColumns(columns),
+      mBands(bands)
+   {
+   }
+
+   /**
+    * Returns the first column of the band.
+    *
+    * @return A pointer to the first column.  Successive columns are
+    *         getStride() elements apart.
+    */
+   T* getData() const
+   {
+      return mpData;
+   }
+
+   /**
+    * Returns the number of columns in the view.
+    *
+    * @return The number of columns.
+    */
+   size_t getColumnCount() const
+   {
+      return mColumns;
+   }
+
+   /**
+    * Returns the number of elements between successive columns.
+    *
+    * @return The stride of the view, which is 1 for BIL and BSQ data.
+    */
+   size_t getStride() const
+   {
+      return InterleaveTraits<Interleave>::getColumnStride(mBands);
+   }
+
+   /**
+    * Returns whether the columns of the view are contiguous in memory.
+    *
+    * @return \c true if getStride() is 1, \c false otherwise.
+    */
+   bool isContiguous() const
+   {
+      return getStride() == 1;
+   }
+
+   /**
+    * Accesses a column of the view.
+    *
+    * No bounds checking is performed.
+    *
+    * @param column
+    *        The column, relative to the first column of the view.
+    *
+    * @return The value of the band at the given column.
+    */
+   T& operator[](size_t column) const
+   {
+      return mpData[column * getStride()];
+   }
+
+private:
+   T* mpData;
+   size_t mColumns;
+   size_t mBands;
+};
+
+/**
+ * Provides typed access to a single band within a block of rows of data.
+ *
+ * A TileView covers the rows which are available in memory at once, which
+ * allows an algorithm to process an entire block without advancing the
+ * DataAccessor after each row.  A TileView does not own the data, and is only
+ * valid until the DataAccessor from which it was obtained is advanced.
+ *
+ * @code
+ * while (rowsRemaining > 0)
+ * {
+ *    TileView<float, BSQ> tile = pAccessor->getTileView<float, BSQ>();
+ *    for (size_t row = 0; row < tile.getRowCount(); ++row)
+ *    {
+ *       RowView<float, BSQ> rowView = tile.getRowView(row);
+ *       // process the row
+ *    }
+ *    rowsRemaining -= tile.getRowCount();
+ *    pAccessor->nextRow(static_cast<int>(tile.getRowCount()));
+ * }
+ * @endcode
+ *
+ * @see DataAccessorImpl::getTileView()
+ */
+template<typename T, InterleaveFormatTypeEnum Interleave>
+class TileView
+{
+public:
+   /**
+    * Creates a view of a band within a block of rows.
+    *
+    * @param pData
+    *        The first column of the band in the first row.
+    * @param rows
+    *        The number of rows in the view.
+    * @param columns
+    *        The number of columns in the view.
+    * @param bands
+    *        The number of bands in each row.
+    * @param rowBytes
+    *        The number of bytes between the start of successive rows,
+    *        including any interline bytes.
+    */
+   TileView(T* pData, size_t rows, size_t columns, size_t bands, size_t rowBytes) :
+      mpData(pData),
+      mRows(rows),
+      mColumns(columns),
+      mBands(bands),
+      mRowBytes(rowBytes)
+   {
+   }
+
+   /**
+    * Returns the number of rows in the view.
+    *
+    * @return The number of rows.
+    */
+   size_t getRowCount() const
+   {
+      return mRows;
+   }
+
+   /**
+    * Returns the number of columns in the view.
+    *
+    * @return The number of columns.
+    */
+   size_t getColumnCount() const
+   {
+      return mColumns;
+   }
+
+   /**
+    * Returns the number of bytes between the start of successive rows.
+    *
+    * @return The row stride of the view in bytes.
+    */
+   size_t getRowStride() const
+   {
+      return mRowBytes;
+   }
+
+   /**
+    * Returns a view of the band within a row of the tile.
+    *
+    * No bounds checking is performed.
+    *
+    * @param row
+    *        The row, relative to the first row of the view.
+    *
+    * @return A view of the row.
+    */
+   RowView<T, Interleave> getRowView(size_t row) const
+   {
+      char* pRow = reinterpret_cast<char*>(mpData) + row * mRowBytes;
+      return RowView<T, Interleave>(reinterpret_cast<T*>(pRow), mColumns, mBands);
+   }
+
+   /**
+    * Accesses a pixel of the view.
+    *
+    * No bounds checking is performed.
+    *
+    * @param row
+    *        The row, relative to the first row of the view.
+    * @param column
+    *        The column, relative to the first column of the view.
+    *
+    * @return The value of the band at the given pixel.
+    */
+   T& operator()(size_t row, size_t column) const
+   {
+      return getRowView(row)[column];
+   }
+
+private:
+   T* mpData;
+   size_t mRows;
+   size_t mColumns;
+   size_t mBands;
+   size_t mRowBytes;
+};
+
+#endif
@@ -17,6 +17,7 @@
 #include <vector>
 
 class BadValues;
+class QuantileSketch;
 
 /**
  *  Statistics for raster elements.
@@ -45,6 +46,16 @@ class Statistics : public Serializable
 public:
    SETTING(Resolution, Statistics, int, 0);
 
+   /**
+    *  The capacity of the QuantileSketch built while calculating statistics.
+    *
+    *  Data types with more than 65536 possible values use the sketch to compute
+    *  the histogram and percentiles without a second pass through the data.  A
+    *  larger capacity is more accurate and uses more memory.  A value of 0
+    *  disables the sketch, so an exact histogram is computed in a second pass.
+    */
+   SETTING(SketchCapacity, Statistics, unsigned int, 4096);
+
    /**
     *  Sets the minimum value for the data.
     *
@@ -339,6 +350,65 @@ public:
    virtual void getHistogram(const double*& pBinCenters, const unsigned int*& pHistogramCounts,
       ComplexComponent component) = 0;
 
+   /**
+    *  Sets the distribution of the data.
+    *
+    *  This method is typically called by an importer to restore a sketch that
+    *  was saved with the data.  Setting the sketch does not change the other
+    *  statistics values.
+    *
+    *  @param   sketch
+    *           The sketch of the data values.
+    */
+   virtual void setQuantileSketch(const QuantileSketch& sketch) = 0;
+
+   /**
+    *  Sets the distribution of the data.
+    *
+    *  This method is typically called by an importer to restore a sketch that
+    *  was saved with the data.  Setting the sketch does not change the other
+    *  statistics values.
+    *
+    *  @param   sketch
+    *           The sketch of the data values.
+    *  @param   component
+    *           The complex data component represented by the given sketch.
+    */
+   virtual void setQuantileSketch(const QuantileSketch& sketch, ComplexComponent component) = 0;
+
+   /**
+    *  Returns the distribution of the data.
+    *
+    *  The sketch is built while the statistics are calculated, and can be
+    *  merged with the sketches of other bands or queried for quantiles which
+    *  are not available from getPercentiles().
+    *
+    *  @return  The sketch of the data values, or \c NULL if the statistics
+    *           were set without a sketch or the SketchCapacity setting is 0.
+    *           Data types with few enough values to count each one exactly,
+    *           such as 8-bit and 16-bit integers, are calculated without a
+    *           sketch.
+    */
+   virtual const QuantileSketch* getQuantileSketch() = 0;
+
+   /**
+    *  Returns the distribution of the data.
+    *
+    *  The sketch is built while the statistics are calculated, and can be
+    *  merged with the sketches of other bands or queried for quantiles which
+    *  are not available from getPercentiles().
+    *
+    *  @param   component
+    *           The complex data component for which to get its sketch.
+    *
+    *  @return  The sketch of the data values, or \c NULL if the statistics
+    *           were set without a sketch or the SketchCapacity setting is 0.
+    *           Data types with few enough values to count each one exactly,
+    *           such as 8-bit and 16-bit integers, are calculated without a
+    *           sketch.
+    */
+   virtual const QuantileSketch* getQuantileSketch(ComplexComponent component) = 0;
+
    /**
     *  Sets the step size used when computing the statistics for the data.
     *
@@ -11,6 +11,7 @@
 #include "ConvertToBilPage.h"
 #include "ConvertToBilPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveTranspose.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
@@ -132,28 +133,18 @@ RasterPage* ConvertToBilPager::getPage(DataRequest* pOriginalRequest, DimensionD
       pRequest->setBands(*iter, DimensionDescriptor());
 
       DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
+      unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData());
       for (unsigned int row = 0; row < rows; ++row)
       {
-         for (unsigned int col = 0; col < cols; ++col)
+         if (da.isValid() == false)
          {
-            if (da.isValid() == false)
-            {
-               return NULL;
-            }
-
-            unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData()) +
-               (row * cols * bands + col) * mBytesPerElement;
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getColumn());
-            for (unsigned int band = 0; band < bands; ++band)
-            {
-               memcpy(pDst, pSrc, mBytesPerElement);
-               pDst += cols * mBytesPerElement;
-               pSrc += mBytesPerElement;
-            }
-
-            da->nextColumn();
+            return NULL;
          }
 
+         // Each pixel of the row is a row of the source matrix and each band of the page is a column
+         size_t pixelStride = da->getRowView<unsigned char, BIP>().getStride();
+         InterleaveTranspose::transpose(da->getRow(), cols, bands, pixelStride, pDst, cols, mBytesPerElement);
+         pDst += bands * cols * mBytesPerElement;
          da->nextRow();
       }
    }
@@ -11,11 +11,19 @@
 #include "ConvertToBipPage.h"
 #include "ConvertToBipPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveTranspose.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
 #include <algorithm>
 #include <memory>
+#include <vector>
+
+namespace
+{
+   // The largest number of BSQ bands which are read concurrently and interleaved together
+   const unsigned int BAND_BLOCK_SIZE = 64;
+}
 
 ConvertToBipPager::ConvertToBipPager(RasterElement* pRaster) :
    mpRaster(pRaster),
@@ -101,31 +109,42 @@ RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionD
 
    if (interleave == BSQ)
    {
-      for (unsigned int band = 0; iter <= stopIter; ++iter, ++band)
+      // Read a block of bands at a time so each row of the page is interleaved from the rows of several
+      // bands with a single transpose instead of scattering one band at a time
+      std::vector<DataAccessor> accessors;
+      std::vector<const void*> bandRows;
+      for (unsigned int firstBand = 0; firstBand < bands; firstBand += BAND_BLOCK_SIZE)
       {
-         FactoryResource<DataRequest> pRequest;
-         pRequest->setRows(startRow, stopRow, 1);
-         pRequest->setColumns(startColumn, stopColumn, cols);
-         pRequest->setBands(*iter, *iter, 1);
+         unsigned int blockBands = std::min(BAND_BLOCK_SIZE, bands - firstBand);
+         accessors.clear();
+         for (unsigned int band = 0; band < blockBands; ++band, ++iter)
+         {
+            FactoryResource<DataRequest> pRequest;
+            pRequest->setRows(startRow, stopRow, 1);
+            pRequest->setColumns(startColumn, stopColumn, cols);
+            pRequest->setBands(*iter, *iter, 1);
+            accessors.push_back(mpRaster->getDataAccessor(pRequest.release()));
+         }
 
-         DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
+         bandRows.resize(blockBands);
          for (unsigned int row = 0; row < rows; ++row)
          {
-            if (da.isValid() == false)
+            for (unsigned int band = 0; band < blockBands; ++band)
             {
-               return NULL;
+               if (accessors[band].isValid() == false)
+               {
+                  return NULL;
+               }
+
+               bandRows[band] = accessors[band]->getRow();
             }
 
-            unsigned int cachePos = (row * cols * bands + band) * mBytesPerElement;
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getRow());
-            for (unsigned int col = 0; col < cols; ++col)
+            InterleaveTranspose::transpose(&bandRows[0], blockBands, cols,
+               pDst + (row * cols * bands + firstBand) * mBytesPerElement, bands, mBytesPerElement);
+            for (unsigned int band = 0; band < blockBands; ++band)
             {
-               memcpy(pDst + cachePos, pSrc, mBytesPerElement);
-               cachePos += bands * mBytesPerElement;
-               pSrc += mBytesPerElement;
+               accessors[band]->nextRow();
             }
-
-            da->nextRow();
          }
       }
    }
@@ -145,19 +164,9 @@ RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionD
             return NULL;
          }
 
-         for (unsigned int band = 0; band < bands; ++band)
-         {
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getRow()) +
-               (band * da->getConcurrentColumns() * mBytesPerElement);
-            unsigned int cachePos = (row * cols * bands + band) * mBytesPerElement;
-            for (unsigned int col = 0; col < cols; ++col)
-            {
-               memcpy(pDst + cachePos, pSrc, mBytesPerElement);
-               cachePos += bands * mBytesPerElement;
-               pSrc += mBytesPerElement;
-            }
-         }
-
+         // Each band of the row is a row of the source matrix and each pixel of the page is a column
+         InterleaveTranspose::transpose(da->getRow(), bands, cols, da->getConcurrentColumns(),
+            pDst + row * cols * bands * mBytesPerElement, bands, mBytesPerElement);
          da->nextRow();
       }
    }
@@ -11,6 +11,7 @@
 #include "ConvertToBsqPage.h"
 #include "ConvertToBsqPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveTranspose.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
@@ -102,18 +103,15 @@ RasterPage* ConvertToBsqPager::getPage(DataRequest* pOriginalRequest, DimensionD
    {
       for (unsigned int row = 0; row < concurrentRows; ++row)
       {
-         for (unsigned int col = 0; col < cols; ++col)
+         if (da.isValid() == false)
          {
-            if (da.isValid() == false)
-            {
-               return NULL;
-            }
-
-            memcpy(pDst, da->getColumn(), mBytesPerElement);
-            pDst += mBytesPerElement;
-            da->nextColumn();
+            return NULL;
          }
 
+         // Extracting the band is a transpose of a single column of pixels
+         size_t pixelStride = da->getRowView<unsigned char, BIP>().getStride();
+         InterleaveTranspose::transpose(da->getRow(), cols, 1, pixelStride, pDst, cols, mBytesPerElement);
+         pDst += mBytesPerElement * cols;
          da->nextRow();
       }
    }
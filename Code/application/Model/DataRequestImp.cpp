@@ -18,7 +18,8 @@ DataRequestImp::DataRequestImp() :
    mConcurrentRows(0),
    mConcurrentColumns(0),
    mConcurrentBands(0),
-   mbWritable(false)
+   mbWritable(false),
+   mResolutionLevel(0)
 {
 }
 
@@ -38,7 +39,8 @@ DataRequestImp::DataRequestImp(const DataRequestImp& rhs) :
    mStartBand(rhs.mStartBand),
    mStopBand(rhs.mStopBand),
    mConcurrentBands(rhs.mConcurrentBands),
-   mbWritable(rhs.mbWritable)
+   mbWritable(rhs.mbWritable),
+   mResolutionLevel(rhs.mResolutionLevel)
 {
 }
 
@@ -53,8 +55,8 @@ bool DataRequestImp::validate(const RasterDataDescriptor *pDescriptor) const
    {
       return false;
    }
-   unsigned int numRows = pDescriptor->getRowCount();
-   unsigned int numColumns = pDescriptor->getColumnCount();
+   unsigned int numRows = getOverviewCount(pDescriptor->getRowCount(), mResolutionLevel);
+   unsigned int numColumns = getOverviewCount(pDescriptor->getColumnCount(), mResolutionLevel);
    unsigned int numBands = pDescriptor->getBandCount();
 
    DimensionDescriptor startRow = getStartRow();
@@ -91,15 +93,21 @@ bool DataRequestImp::validate(const RasterDataDescriptor *pDescriptor) const
       return false;
    }
 
-   if (getInterleaveFormat() == BSQ)
+   if (getInterleaveFormat() == BSQ || mResolutionLevel > 0)
    {
-      // Can only get single-band BSQ accessors
+      // Can only get single-band BSQ and overview accessors
       if (startBand != stopBand || concurrentBands != 1)
       {
          return false;
       }
    }
 
+   if (mResolutionLevel > 0 && mbWritable)
+   {
+      // Overviews are read-only
+      return false;
+   }
+
    return true;
 }
 
@@ -121,11 +129,12 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
    // rows
    if (!mStartRow.isValid())
    {
-      mStartRow = pDescriptor->getActiveRow(0);
+      mStartRow = getDefaultDimension(pDescriptor->getActiveRow(0), 0);
    }
    if (!mStopRow.isValid())
    {
-      mStopRow = pDescriptor->getActiveRow(pDescriptor->getRowCount()-1);
+      unsigned int stopRow = getOverviewCount(pDescriptor->getRowCount(), mResolutionLevel) - 1;
+      mStopRow = getDefaultDimension(pDescriptor->getActiveRow(stopRow), stopRow);
    }
    if (mConcurrentRows == 0)
    {
@@ -135,11 +144,12 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
    // columns
    if (!mStartColumn.isValid())
    {
-      mStartColumn = pDescriptor->getActiveColumn(0);
+      mStartColumn = getDefaultDimension(pDescriptor->getActiveColumn(0), 0);
    }
    if (!mStopColumn.isValid())
    {
-      mStopColumn = pDescriptor->getActiveColumn(pDescriptor->getColumnCount()-1);
+      unsigned int stopColumn = getOverviewCount(pDescriptor->getColumnCount(), mResolutionLevel) - 1;
+      mStopColumn = getDefaultDimension(pDescriptor->getActiveColumn(stopColumn), stopColumn);
    }
    if (mConcurrentColumns == 0)
    {
@@ -153,7 +163,7 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
    }
    if (!mStopBand.isValid())
    {
-      if (mInterleave == BIP || mInterleave == BIL)
+      if ((mInterleave == BIP || mInterleave == BIL) && mResolutionLevel == 0)
       {
          mStopBand = pDescriptor->getActiveBand(pDescriptor->getBandCount()-1);
       }
@@ -172,6 +182,11 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
 
 int DataRequestImp::getRequestVersion(const RasterDataDescriptor *pDescriptor) const
 {
+   if (mResolutionLevel > 0)
+   {
+      return 2;
+   }
+
    return 1;
 }
 
@@ -262,3 +277,37 @@ void DataRequestImp::setWritable(bool writable)
 {
    mbWritable = writable;
 }
+
+unsigned int DataRequestImp::getResolutionLevel() const
+{
+   return mResolutionLevel;
+}
+
+void DataRequestImp::setResolutionLevel(unsigned int level)
+{
+   mResolutionLevel = level;
+}
+
+unsigned int DataRequestImp::getOverviewCount(unsigned int count, unsigned int level)
+{
+   if (level >= 32)
+   {
+      return (count > 0 ? 1 : 0);
+   }
+
+   return static_cast<unsigned int>((static_cast<uint64_t>(count) + (1ULL << level) - 1) >> level);
+}
+
+DimensionDescriptor DataRequestImp::getDefaultDimension(DimensionDescriptor fullResolution,
+                                                        unsigned int activeNumber) const
+{
+   if (mResolutionLevel == 0)
+   {
+      return fullResolution;
+   }
+
+   // Only the active number is meaningful within an overview
+   DimensionDescriptor dim;
+   dim.setActiveNumber(activeNumber);
+   return dim;
+}
@@ -49,7 +49,24 @@ public:
    bool getWritable() const;
    void setWritable(bool writable);
 
+   unsigned int getResolutionLevel() const;
+   void setResolutionLevel(unsigned int level);
+
+   /**
+    * Returns the number of rows or columns in an overview.
+    *
+    * @param count
+    *        The number of rows or columns at full resolution.
+    * @param level
+    *        The resolution level of the overview.
+    *
+    * @return The number of rows or columns at the given level.
+    */
+   static unsigned int getOverviewCount(unsigned int count, unsigned int level);
+
 private:
+   DimensionDescriptor getDefaultDimension(DimensionDescriptor fullResolution, unsigned int activeNumber) const;
+
    InterleaveFormatType mInterleave;
    bool mInterleaveDefault;
 
@@ -66,6 +83,7 @@ private:
    unsigned int mConcurrentBands;
 
    bool mbWritable;
+   unsigned int mResolutionLevel;
 
 };
 
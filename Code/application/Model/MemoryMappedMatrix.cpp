@@ -12,6 +12,7 @@
 #include "MemoryMappedMatrix.h"
 #include "MemoryMappedMatrixView.h"
 
+#include <algorithm>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdexcept>
@@ -44,7 +45,8 @@ MemoryMappedMatrix::MemoryMappedMatrix(const string& fileName, unsigned int head
    mInterLineBytes(interLineBytes),
    mInterBandBytes(interBandBytes),
    mHeaderOffset(headerOffset),
-   mReadOnly(readOnly)
+   mReadOnly(readOnly),
+   mpMapping(NULL)
 {
 #if defined(WIN_API)
    // All addresses must align on a page boundary.
@@ -113,6 +115,11 @@ MemoryMappedMatrix::~MemoryMappedMatrix()
    CloseHandle(mHandle);
    CloseHandle(mFileHandle);
 #else
+   if (mpMapping != NULL)
+   {
+      munmap(reinterpret_cast<char*>(mpMapping), static_cast<size_t>(mFileSize));
+   }
+
    close(mHandle);
 #endif
 }
@@ -131,3 +138,102 @@ void MemoryMappedMatrix::release(MemoryMappedMatrixView* pView)
 {
    mViews.erase(pView);
 }
+
+bool MemoryMappedMatrix::mapFile()
+{
+#if defined(WIN_API)
+   return false;
+#else
+   if (mpMapping != NULL)
+   {
+      return true;
+   }
+
+   // A 32-bit address space cannot hold large files, so those are still mapped a segment at a time
+   if (sizeof(void*) < 8 || mFileSize <= 0)
+   {
+      return false;
+   }
+
+   int permissions = PROT_READ;
+   if (mReadOnly == false)
+   {
+      permissions |= PROT_WRITE;
+   }
+
+   void* pMapping = mmap(NULL, static_cast<size_t>(mFileSize), permissions, MAP_SHARED, mHandle, 0);
+   if (pMapping == MAP_FAILED)
+   {
+      return false;
+   }
+
+   mpMapping = reinterpret_cast<unsigned char*>(pMapping);
+   return true;
+#endif
+}
+
+bool MemoryMappedMatrix::isFileMapped() const
+{
+   return mpMapping != NULL;
+}
+
+unsigned char* MemoryMappedMatrix::getMappedSegment(unsigned int row, unsigned int column, unsigned int band) const
+{
+   if (mpMapping == NULL)
+   {
+      return NULL;
+   }
+
+   // The same layout as MemoryMappedMatrixView::getSegment()
+   int64_t start = mHeaderOffset;
+   if (mInterleave == BIP)
+   {
+      int64_t rowSize = static_cast<int64_t>(mBytesPerElement) * mBandNum * mColumnNum + mInterLineBytes;
+      start += row * rowSize + static_cast<int64_t>(column) * mBytesPerElement * mBandNum +
+         static_cast<int64_t>(band) * mBytesPerElement;
+   }
+   else if (mInterleave == BSQ)
+   {
+      int64_t rowSize = static_cast<int64_t>(mBytesPerElement) * mColumnNum + mInterLineBytes;
+      start += band * (rowSize * mRowNum + mInterBandBytes) + row * rowSize +
+         static_cast<int64_t>(column) * mBytesPerElement;
+   }
+   else if (mInterleave == BIL)
+   {
+      int64_t bandSize = static_cast<int64_t>(mBytesPerElement) * mColumnNum;
+      start += row * (bandSize * mBandNum + mInterLineBytes) + band * bandSize +
+         static_cast<int64_t>(column) * mBytesPerElement;
+   }
+
+   if (start >= mFileSize)
+   {
+      return NULL;
+   }
+
+   return mpMapping + start;
+}
+
+unsigned char* MemoryMappedMatrix::getEndOfMapping() const
+{
+   return (mpMapping == NULL) ? NULL : (mpMapping + mFileSize);
+}
+
+void MemoryMappedMatrix::advise(const unsigned char* pStart, size_t size, bool sequential) const
+{
+#if !defined(WIN_API)
+   if (mpMapping == NULL || pStart < mpMapping || pStart >= mpMapping + mFileSize)
+   {
+      return;
+   }
+
+   // madvise() requires an address which is aligned to a page, and the granularity is a multiple of the page size
+   int64_t offset = pStart - mpMapping;
+   int64_t start = (offset / mGranularity) * mGranularity;
+   int64_t stop = min(offset + static_cast<int64_t>(size), mFileSize);
+   if (stop > start)
+   {
+      madvise(reinterpret_cast<char*>(mpMapping + start), static_cast<size_t>(stop - start),
+         sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+   }
+#endif
+}
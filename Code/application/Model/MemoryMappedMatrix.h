@@ -40,6 +40,42 @@ public:
 
    void release(MemoryMappedMatrixView* pView);
 
+   /**
+    * Maps the entire file once so that segments can be accessed without
+    * creating a view for each one.
+    *
+    * This is only supported on 64-bit systems other than Windows, where the
+    * address space is large enough for any file.
+    *
+    * @return True if the file is mapped, false otherwise.
+    */
+   bool mapFile();
+
+   bool isFileMapped() const;
+
+   /**
+    * Gets a pointer into the mapping created by mapFile().
+    *
+    * @return The address of the element, or NULL if the file is not mapped
+    *         or the element is past the end of the file.
+    */
+   unsigned char* getMappedSegment(unsigned int row, unsigned int column, unsigned int band) const;
+
+   unsigned char* getEndOfMapping() const;
+
+   /**
+    * Tells the operating system how part of the mapping will be accessed.
+    *
+    * @param pStart
+    *        The first byte of the range, which does not need to be aligned.
+    * @param size
+    *        The number of bytes in the range, which is clipped to the mapping.
+    * @param sequential
+    *        True if the range will be read once from start to end, false if
+    *        the range will be needed soon and should be read ahead.
+    */
+   void advise(const unsigned char* pStart, size_t size, bool sequential) const;
+
 private:
    std::string mFileName;
 
@@ -70,6 +106,8 @@ private:
 
    unsigned int mHeaderOffset;
    bool mReadOnly;
+
+   unsigned char* mpMapping;
 };
 
 #endif
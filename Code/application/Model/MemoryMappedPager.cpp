@@ -278,13 +278,21 @@ bool MemoryMappedPager::execute(PlugInArgList* pInputArgList, PlugInArgList* pOu
    } 
    VERIFY(!mMatrices.empty());
 
+   // A matrix which cannot be mapped at once is still mapped a segment at a time
+   if (MemoryMappedPager::getSettingMapEntireFile())
+   {
+      for (vector<MemoryMappedMatrix*>::iterator iter = mMatrices.begin(); iter != mMatrices.end(); ++iter)
+      {
+         (*iter)->mapFile();
+      }
+   }
+
    return true;
 }
 
 RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
                                        DimensionDescriptor startColumn, DimensionDescriptor startBand)
 {
-   //ensure only one thread enters this code at a time
    VERIFYRV((mpDataDescriptor != NULL) && (!mMatrices.empty()) && pOriginalRequest != NULL, NULL);
 
    unsigned int bandIndex = startBand.getActiveNumber();
@@ -294,8 +302,6 @@ RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionD
       return NULL;
    }
 
-   mta::MutexLock mutex(mMutex);
-
    InterleaveFormatType interleave;
    unsigned int numBands = 0;
    unsigned int numColumns = 0;
@@ -389,24 +395,37 @@ RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionD
    segmentSize = concurrentRows * rowSize;
    numRows = concurrentRows;
 
-   //get the MemoryMappedMatrixView of a let segmentSize large
-   MemoryMappedMatrixView* pView = NULL;
    MemoryMappedMatrix* pMatrix = mMatrices.front();
    if (mMatrices.size() > 1)
    {
       VERIFYRV(bandIndex < mMatrices.size(), NULL);
       pMatrix = mMatrices[bandIndex];
+      bandIndex = 0;
    }
    VERIFYRV(pMatrix != NULL, NULL);
-   pView = pMatrix->getView(segmentSize);
+
+   if (pMatrix->isFileMapped())
+   {
+      unsigned char* pSegment = pMatrix->getMappedSegment(startRow.getActiveNumber() + offsetRow,
+         startColumn.getActiveNumber() + offsetCol, bandIndex);
+      if (pSegment == NULL)
+      {
+         return NULL;
+      }
+
+      return getMappedPage(pOriginalRequest, pMatrix, pSegment, startRow, numRows, numColumns, rowSize,
+         interlineBytes);
+   }
+
+   //ensure only one thread creates or releases views at a time
+   mta::MutexLock mutex(mMutex);
+
+   //get the MemoryMappedMatrixView of a let segmentSize large
+   MemoryMappedMatrixView* pView = pMatrix->getView(segmentSize);
    VERIFYRV(pView != NULL, NULL);
 
    //ask the MemoryMappedMatrixView for a pointer starting
    //at the given location
-   if (mMatrices.size() > 1)
-   {
-      bandIndex = 0;
-   }
    char* pRawCubePointer = reinterpret_cast<char*>(pView->getSegment(startRow.getActiveNumber() + offsetRow,
                                                    startColumn.getActiveNumber() + offsetCol, bandIndex));
    if (pRawCubePointer == NULL)
@@ -441,13 +460,52 @@ RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionD
    return pPage;
 }
 
+RasterPage* MemoryMappedPager::getMappedPage(DataRequest* pOriginalRequest, MemoryMappedMatrix* pMatrix,
+                                             unsigned char* pRawCubePointer, DimensionDescriptor pageRow,
+                                             unsigned int numRows, unsigned int numColumns, unsigned long rowSize,
+                                             unsigned int interlineBytes)
+{
+   size_t segmentSize = static_cast<size_t>(numRows) * rowSize;
+   size_t availableSize = static_cast<size_t>(pMatrix->getEndOfMapping() - pRawCubePointer);
+
+   // Requests which walk through more rows than fit in one page read the next page ahead, and requests
+   // which sweep every row are read sequentially
+   DimensionDescriptor startRow = pOriginalRequest->getStartRow();
+   DimensionDescriptor stopRow = pOriginalRequest->getStopRow();
+   if (startRow.isValid() && stopRow.isValid() &&
+      stopRow.getActiveNumber() - startRow.getActiveNumber() + 1 > numRows)
+   {
+      unsigned int requestRows = stopRow.getActiveNumber() - startRow.getActiveNumber() + 1;
+      if (pageRow.getActiveNumber() == startRow.getActiveNumber() && requestRows == mpDataDescriptor->getRowCount())
+      {
+         pMatrix->advise(pRawCubePointer, static_cast<size_t>(requestRows) * rowSize, true);
+      }
+      else if (segmentSize < availableSize)
+      {
+         pMatrix->advise(pRawCubePointer + segmentSize, segmentSize, false);
+      }
+   }
+
+   if (mSwapEndian)
+   {
+      return new EndianSwapPage(pRawCubePointer, mpDataDescriptor->getDataType(), numRows, numColumns,
+         rowSize - interlineBytes, interlineBytes, pRawCubePointer + min(segmentSize, availableSize));
+   }
+
+   // The page does not own a view, so releasing it only deletes it
+   MemoryMappedPage* pPage = new MemoryMappedPage;
+   pPage->setRawData(reinterpret_cast<char*>(pRawCubePointer));
+   pPage->setNumRows(numRows);
+   pPage->setNumColumns(numColumns);
+   pPage->setInterlineBytes(interlineBytes);
+
+   return pPage;
+}
+
 void MemoryMappedPager::releasePage(RasterPage* pPage)
 {
    VERIFYNRV(pPage != NULL);
 
-   //ensure only one thread enters this code at a time
-   mta::MutexLock mutex(mMutex);
-
    if (mSwapEndian)
    {
       delete static_cast<EndianSwapPage*>(pPage);
@@ -455,6 +513,14 @@ void MemoryMappedPager::releasePage(RasterPage* pPage)
    else
    {
       MemoryMappedPage* pOurPage = static_cast<MemoryMappedPage*>(pPage);
+      if (pOurPage->getMemoryMappedMatrixView() == NULL)
+      {
+         delete pOurPage;
+         return;
+      }
+
+      //ensure only one thread enters this code at a time
+      mta::MutexLock mutex(mMutex);
 
       map<MemoryMappedPage*, MemoryMappedMatrix*>::iterator foundIter;
       foundIter = mCurrentlyLeasedPages.find(pOurPage);
@@ -12,6 +12,7 @@
 #ifndef MEMORYMAPPEDPAGER_H
 #define MEMORYMAPPEDPAGER_H
 
+#include "ConfigurationSettings.h"
 #include "RasterPagerShell.h"
 #include "DMutex.h"
 
@@ -22,9 +23,21 @@ class RasterDataDescriptor;
 class MemoryMappedPage;
 class MemoryMappedMatrix;
 
+/**
+ * Provides pages of a file through memory mapping.
+ *
+ * When the MapEntireFile setting is enabled on a 64-bit system other than
+ * Windows, each file is mapped once when the pager is executed and pages are
+ * pointers into that mapping, so leasing and releasing a page needs neither a
+ * system call nor the pager mutex.  The operating system is advised to read
+ * ahead of requests which span more than one page.  Otherwise, each page maps
+ * its own view of the file.
+ */
 class MemoryMappedPager : public RasterPagerShell
 {
 public:
+   SETTING(MapEntireFile, MemoryMappedPager, bool, true)
+
    MemoryMappedPager();
    ~MemoryMappedPager();
 
@@ -44,6 +57,10 @@ public:
 
 
 private:
+   RasterPage* getMappedPage(DataRequest* pOriginalRequest, MemoryMappedMatrix* pMatrix,
+      unsigned char* pRawCubePointer, DimensionDescriptor pageRow, unsigned int numRows, unsigned int numColumns,
+      unsigned long rowSize, unsigned int interlineBytes);
+
    bool mbUseDataDescriptor;
    const RasterDataDescriptor* mpDataDescriptor;
    bool mSwapEndian;
@@ -821,6 +821,11 @@ void ModelServicesImp::deleteMemoryBlock(char* memory)
    delete [] memory;
 }
 
+RasterCache* ModelServicesImp::getRasterCache()
+{
+   return &mRasterCache;
+}
+
 bool ModelServicesImp::isKindOfElement(const string& className, const string& elementName) const
 {
    bool bSuccess = false;
@@ -14,6 +14,7 @@
 
 #include "DataElement.h"
 #include "ModelServices.h"
+#include "RasterCacheImp.h"
 #include "SettableSessionItemAdapter.h"
 #include "StringUtilities.h"
 #include "SubjectImp.h"
@@ -72,6 +73,8 @@ public:
    char* getMemoryBlock(size_t size);
    void deleteMemoryBlock(char* memory); 
 
+   RasterCache* getRasterCache();
+
    bool isKindOfElement(const std::string& className, const std::string& elementName) const;
    void getElementTypes(const std::string& className, std::vector<std::string>& classList) const;
    bool isKindOfDataDescriptor(const std::string& className, const std::string& descriptorName) const;
@@ -151,6 +154,7 @@ private:
    static bool mDestroyed;
    std::vector<std::string> mElementTypes;
    std::multimap<Key, DataElement*> mElements;
+   RasterCacheImp mRasterCache;
 
    std::multimap<Key, DataElement*>::iterator findElement(const DataElement* pElement);
    std::multimap<Key, DataElement*>::iterator findElement(const Key& key, const std::string& type);
@@ -0,0 +1,387 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "bthread.h"
+#include "ConvertToBsqPage.h"
+#include "DataAccessorImpl.h"
+#include "DataRequestImp.h"
+#include "ObjectResource.h"
+#include "OverviewPager.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+namespace
+{
+   // Rows are read from the sidecar in pages of approximately this many bytes
+   const unsigned int OVERVIEW_PAGE_SIZE = 1024 * 1024;
+}
+
+OverviewPager::OverviewPager(RasterElement* pRaster, const string& filename) :
+   mpRaster(pRaster),
+   mFilename(filename),
+   mBytesPerElement(0),
+   mRowCount(0),
+   mColumnCount(0),
+   mBandCount(0),
+   mLevelCount(0),
+   mBandSize(0),
+   mGeneration(0),
+   mStopping(false),
+   mpThread(NULL),
+   mFileSize(0)
+{
+   if (mpRaster != NULL)
+   {
+      const RasterDataDescriptor* pDd = dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
+      if (pDd != NULL)
+      {
+         mBytesPerElement = pDd->getBytesPerElement();
+         mRowCount = pDd->getRowCount();
+         mColumnCount = pDd->getColumnCount();
+         mBandCount = pDd->getBandCount();
+      }
+   }
+
+   // Build levels until the entire band is reduced to a single pixel
+   while (DataRequestImp::getOverviewCount(mRowCount, mLevelCount) > 1 ||
+      DataRequestImp::getOverviewCount(mColumnCount, mLevelCount) > 1)
+   {
+      ++mLevelCount;
+      mLevelOffsets.push_back(mBandSize);
+      mBandSize += static_cast<int64_t>(DataRequestImp::getOverviewCount(mRowCount, mLevelCount)) *
+         DataRequestImp::getOverviewCount(mColumnCount, mLevelCount) * mBytesPerElement;
+   }
+
+   mBandStates.resize(mBandCount, OVERVIEW_MISSING);
+   mBandOffsets.resize(mBandCount, -1);
+}
+
+OverviewPager::~OverviewPager()
+{
+   {
+      mta::MutexLock lock(mMutex);
+      mStopping = true;
+      mJobAvailable.ThreadSignalBroadcast();
+   }
+
+   if (mpThread != NULL)
+   {
+      mpThread->ThreadWait();
+      delete mpThread;
+   }
+
+   if (mFile.validHandle())
+   {
+      mFile.close();
+      remove(mFilename.c_str());
+   }
+}
+
+unsigned int OverviewPager::getLevelCount() const
+{
+   return mLevelCount;
+}
+
+bool OverviewPager::buildOverviews(unsigned int band)
+{
+   if (mLevelCount == 0 || band >= mBandCount)
+   {
+      return false;
+   }
+
+   mta::MutexLock lock(mMutex);
+   if (mBandStates[band] == OVERVIEW_FAILED)
+   {
+      return false;
+   }
+
+   queueBand(band);
+   return true;
+}
+
+void OverviewPager::invalidate()
+{
+   mta::MutexLock lock(mMutex);
+   ++mGeneration;
+
+   // Bands which are queued or being built are marked as missing when the build completes
+   for (vector<BandStateEnum>::iterator iter = mBandStates.begin(); iter != mBandStates.end(); ++iter)
+   {
+      if (*iter != OVERVIEW_QUEUED)
+      {
+         *iter = OVERVIEW_MISSING;
+      }
+   }
+}
+
+void OverviewPager::releasePage(RasterPage* pPage)
+{
+   // Check that pPage is the correct type before deleting it.
+   delete dynamic_cast<ConvertToBsqPage*>(pPage);
+}
+
+int OverviewPager::getSupportedRequestVersion() const
+{
+   return 2;
+}
+
+RasterPage* OverviewPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   VERIFY(pOriginalRequest != NULL);
+   if (pOriginalRequest->getWritable())
+   {
+      return NULL;
+   }
+
+   unsigned int level = pOriginalRequest->getResolutionLevel();
+   if (level == 0 || level > mLevelCount || startBand.isActiveNumberValid() == false)
+   {
+      return NULL;
+   }
+
+   unsigned int band = startBand.getActiveNumber();
+   if (band >= mBandCount)
+   {
+      return NULL;
+   }
+
+   {
+      mta::MutexLock lock(mMutex);
+      if (mBandStates[band] != OVERVIEW_BUILT)
+      {
+         // The caller falls back to the full resolution data until the overviews are available
+         queueBand(band);
+         return NULL;
+      }
+   }
+
+   unsigned int numRows = DataRequestImp::getOverviewCount(mRowCount, level);
+   unsigned int numCols = DataRequestImp::getOverviewCount(mColumnCount, level);
+   DimensionDescriptor stopRow = pOriginalRequest->getStopRow();
+   DimensionDescriptor stopColumn = pOriginalRequest->getStopColumn();
+   if (startRow.getActiveNumber() >= numRows || stopRow.getActiveNumber() >= numRows ||
+      startColumn.getActiveNumber() >= numCols || stopColumn.getActiveNumber() >= numCols ||
+      startRow.getActiveNumber() > stopRow.getActiveNumber() ||
+      startColumn.getActiveNumber() > stopColumn.getActiveNumber())
+   {
+      return NULL;
+   }
+
+   // Return as many rows as fit in a page since the overviews are small compared to the full resolution data
+   unsigned int cols = stopColumn.getActiveNumber() - startColumn.getActiveNumber() + 1;
+   unsigned int rows = max(pOriginalRequest->getConcurrentRows(), OVERVIEW_PAGE_SIZE / (cols * mBytesPerElement));
+   rows = max(min(rows, stopRow.getActiveNumber() - startRow.getActiveNumber() + 1), 1U);
+
+   auto_ptr<ConvertToBsqPage> pPage(new ConvertToBsqPage(rows, cols, mBytesPerElement));
+   char* pDst = reinterpret_cast<char*>(pPage->getRawData());
+   if (pDst == NULL)
+   {
+      return NULL;
+   }
+
+   mta::MutexLock lock(mFileMutex);
+   VERIFY(mBandOffsets[band] >= 0);
+
+   int64_t levelOffset = mBandOffsets[band] + mLevelOffsets[level - 1];
+   int64_t rowSize = static_cast<int64_t>(cols) * mBytesPerElement;
+   if (cols == numCols)
+   {
+      // Full rows are contiguous in the sidecar
+      int64_t offset = levelOffset + static_cast<int64_t>(startRow.getActiveNumber()) * rowSize;
+      if (mFile.seek(offset, SEEK_SET) != offset || mFile.read(pDst, rowSize * rows) != rowSize * rows)
+      {
+         return NULL;
+      }
+   }
+   else
+   {
+      for (unsigned int row = 0; row < rows; ++row)
+      {
+         int64_t offset = levelOffset + (static_cast<int64_t>(startRow.getActiveNumber() + row) * numCols +
+            startColumn.getActiveNumber()) * mBytesPerElement;
+         if (mFile.seek(offset, SEEK_SET) != offset || mFile.read(pDst + row * rowSize, rowSize) != rowSize)
+         {
+            return NULL;
+         }
+      }
+   }
+
+   return pPage.release();
+}
+
+void OverviewPager::threadFunction(OverviewPager* pPager)
+{
+   pPager->run();
+}
+
+void OverviewPager::run()
+{
+   for (;;)
+   {
+      unsigned int band = 0;
+      unsigned int generation = 0;
+      {
+         mta::MutexLock lock(mMutex);
+         while (mStopping == false && mJobs.empty())
+         {
+            mJobAvailable.ThreadSignalWait(&mMutex);
+         }
+         if (mStopping)
+         {
+            return;
+         }
+
+         band = mJobs.front();
+         mJobs.pop_front();
+         generation = mGeneration;
+      }
+
+      bool success = buildBand(band, generation);
+
+      mta::MutexLock lock(mMutex);
+      if (generation != mGeneration)
+      {
+         // The data was modified while the overviews were being built
+         mBandStates[band] = OVERVIEW_MISSING;
+      }
+      else
+      {
+         mBandStates[band] = (success ? OVERVIEW_BUILT : OVERVIEW_FAILED);
+      }
+   }
+}
+
+void OverviewPager::queueBand(unsigned int band)
+{
+   // mMutex must be locked by the caller
+   if (mBandStates[band] != OVERVIEW_MISSING)
+   {
+      return;
+   }
+
+   mBandStates[band] = OVERVIEW_QUEUED;
+   mJobs.push_back(band);
+
+   if (mpThread == NULL)
+   {
+      mpThread = new BThread(static_cast<void*>(this), reinterpret_cast<void*>(OverviewPager::threadFunction));
+      if (mpThread->ThreadLaunch() == false)
+      {
+         delete mpThread;
+         mpThread = NULL;
+
+         mJobs.clear();
+         mBandStates[band] = OVERVIEW_FAILED;
+         return;
+      }
+   }
+
+   mJobAvailable.ThreadSignalBroadcast();
+}
+
+bool OverviewPager::isCancelled(unsigned int generation)
+{
+   mta::MutexLock lock(mMutex);
+   return mStopping || generation != mGeneration;
+}
+
+bool OverviewPager::buildBand(unsigned int band, unsigned int generation)
+{
+   VERIFY(mpRaster != NULL);
+   const RasterDataDescriptor* pDd = dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
+   VERIFY(pDd != NULL);
+
+   int64_t bandOffset = -1;
+   {
+      mta::MutexLock lock(mFileMutex);
+      if (mFile.validHandle() == false &&
+         mFile.open(mFilename, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, S_IREAD | S_IWRITE) == false)
+      {
+         return false;
+      }
+
+      // Space for a band is allocated the first time it is built and reused when it is rebuilt
+      if (mBandOffsets[band] < 0)
+      {
+         mBandOffsets[band] = mFileSize;
+         mFileSize += mBandSize;
+      }
+      bandOffset = mBandOffsets[band];
+   }
+
+   DimensionDescriptor bandDim = pDd->getActiveBand(band);
+   FactoryResource<DataRequest> pRequest;
+   pRequest->setBands(bandDim, bandDim, 1);
+   DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
+
+   // Every level is built from the samples of the first level, which has every other column
+   vector<vector<char> > levelRows(mLevelCount);
+   for (unsigned int level = 1; level <= mLevelCount; ++level)
+   {
+      levelRows[level - 1].resize(DataRequestImp::getOverviewCount(mColumnCount, level) * mBytesPerElement);
+   }
+
+   for (unsigned int row = 0; row < mRowCount; row += 2)
+   {
+      if (isCancelled(generation) || da.isValid() == false)
+      {
+         return false;
+      }
+
+      vector<char>& firstRow = levelRows.front();
+      unsigned int firstColumns = DataRequestImp::getOverviewCount(mColumnCount, 1);
+      for (unsigned int column = 0; column < firstColumns; ++column)
+      {
+         memcpy(&firstRow[column * mBytesPerElement], da->getColumn(), mBytesPerElement);
+         da->nextColumn(2);
+      }
+
+      for (unsigned int level = 1; level <= mLevelCount && row % (1U << level) == 0; ++level)
+      {
+         vector<char>& levelRow = levelRows[level - 1];
+         unsigned int levelColumns = DataRequestImp::getOverviewCount(mColumnCount, level);
+         if (level > 1)
+         {
+            unsigned int stride = 1U << (level - 1);
+            for (unsigned int column = 0; column < levelColumns; ++column)
+            {
+               memcpy(&levelRow[column * mBytesPerElement], &firstRow[column * stride * mBytesPerElement],
+                  mBytesPerElement);
+            }
+         }
+
+         int64_t offset = bandOffset + mLevelOffsets[level - 1] +
+            static_cast<int64_t>(row >> level) * levelColumns * mBytesPerElement;
+         if (writeRow(offset, levelRow, levelColumns * mBytesPerElement) == false)
+         {
+            return false;
+         }
+      }
+
+      da->nextRow(2);
+   }
+
+   return true;
+}
+
+bool OverviewPager::writeRow(int64_t offset, const vector<char>& row, size_t size)
+{
+   mta::MutexLock lock(mFileMutex);
+   return mFile.seek(offset, SEEK_SET) == offset &&
+      mFile.write(&row.front(), static_cast<int64_t>(size)) == static_cast<int64_t>(size);
+}
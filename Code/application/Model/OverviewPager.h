@@ -0,0 +1,89 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef OVERVIEWPAGER_H
+#define OVERVIEWPAGER_H
+
+#include "DMutex.h"
+#include "FileResource.h"
+#include "RasterPager.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class BThread;
+class RasterElement;
+
+/**
+ * This class provides reduced resolution overviews of a RasterElement.
+ *
+ * Level n contains every 2^n th row and column of a band, so the overviews
+ * match the data produced by skipping through the full resolution data.
+ * All levels of a band are built together by a background thread the first
+ * time the band is requested, and are stored in a sidecar file which is
+ * removed when the pager is destroyed.
+ */
+class OverviewPager : public RasterPager
+{
+public:
+   OverviewPager(RasterElement* pRaster, const std::string& filename);
+
+   virtual ~OverviewPager();
+
+   unsigned int getLevelCount() const;
+   bool buildOverviews(unsigned int band);
+   void invalidate();
+
+   void releasePage(RasterPage* pPage);
+
+   int getSupportedRequestVersion() const;
+
+   RasterPage* getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+      DimensionDescriptor startColumn, DimensionDescriptor startBand);
+
+private:
+   OverviewPager();
+   OverviewPager(const OverviewPager& rhs);
+   OverviewPager& operator=(const OverviewPager& rhs);
+
+   enum BandStateEnum { OVERVIEW_MISSING, OVERVIEW_QUEUED, OVERVIEW_BUILT, OVERVIEW_FAILED };
+
+   static void threadFunction(OverviewPager* pPager);
+   void run();
+   void queueBand(unsigned int band);
+   bool isCancelled(unsigned int generation);
+   bool buildBand(unsigned int band, unsigned int generation);
+   bool writeRow(int64_t offset, const std::vector<char>& row, size_t size);
+
+   RasterElement* const mpRaster;
+   const std::string mFilename;
+   unsigned int mBytesPerElement;
+   unsigned int mRowCount;
+   unsigned int mColumnCount;
+   unsigned int mBandCount;
+   unsigned int mLevelCount;
+   std::vector<int64_t> mLevelOffsets;
+   int64_t mBandSize;
+
+   mta::DMutex mMutex;
+   mta::DThreadSignal mJobAvailable;
+   std::deque<unsigned int> mJobs;
+   std::vector<BandStateEnum> mBandStates;
+   unsigned int mGeneration;
+   bool mStopping;
+   BThread* mpThread;
+
+   mta::DMutex mFileMutex;
+   LargeFileResource mFile;
+   std::vector<int64_t> mBandOffsets;
+   int64_t mFileSize;
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include "PointCloudDataDescriptor.h"
 #include "PointCloudDataRequestImp.h"
 
+#include <algorithm>
 #include <limits>
 
 PointCloudDataRequestImp::PointCloudDataRequestImp() :
@@ -21,6 +22,7 @@ PointCloudDataRequestImp::PointCloudDataRequestImp() :
    mStopY(std::numeric_limits<double>::quiet_NaN()),
    mStartZ(std::numeric_limits<double>::quiet_NaN()),
    mStopZ(std::numeric_limits<double>::quiet_NaN()),
+   mDecimation(1),
    mbWritable(false)
 {
 }
@@ -36,6 +38,7 @@ PointCloudDataRequestImp::PointCloudDataRequestImp(const PointCloudDataRequestIm
    mStopY(rhs.mStopY),
    mStartZ(rhs.mStartZ),
    mStopZ(rhs.mStopZ),
+   mDecimation(rhs.mDecimation),
    mbWritable(rhs.mbWritable)
 {
 }
@@ -157,6 +160,16 @@ void PointCloudDataRequestImp::setBoundingBox(double startX, double stopX, doubl
    mStopZ = stopZ;
 }
 
+uint32_t PointCloudDataRequestImp::getDecimation() const
+{
+   return mDecimation;
+}
+
+void PointCloudDataRequestImp::setDecimation(uint32_t decimation)
+{
+   mDecimation = std::max(decimation, 1U);
+}
+
 void PointCloudDataRequestImp::setStartX(double val)
 {
    mStartX = val;
@@ -40,6 +40,8 @@ public:
    virtual void setStartZ(double val);
    virtual void setStopZ(double val);
    virtual void setBoundingBox(double startX, double stopX, double startY, double stopY, double startZ, double stopZ);
+   virtual uint32_t getDecimation() const;
+   virtual void setDecimation(uint32_t decimation);
 
    virtual bool getWritable() const;
    virtual void setWritable(bool writable);
@@ -51,8 +53,9 @@ private:
    double mStopY;
    double mStartZ;
    double mStopZ;
+   uint32_t mDecimation;
 
    bool mbWritable;
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
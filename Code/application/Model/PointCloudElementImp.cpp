@@ -22,8 +22,11 @@
 #include "PointCloudFileDescriptorImp.h"
 #include "PointCloudInMemoryPager.h"
 #include "PointCloudMemoryMappedPager.h"
+#include "PointCloudSpatialIndex.h"
 #include "RasterUtilities.h"
 
+#include <algorithm>
+
 namespace
 {
    double convert_s1byte_to_double(const void* pValue, double scale, double offset)
@@ -174,6 +177,10 @@ void PointCloudElementImp::createData()
 void PointCloudElementImp::updateData(uint32_t updateMask)
 {
    mModified = true;
+   {
+      mta::MutexLock lock(mSpatialIndexMutex);
+      mpSpatialIndex.reset();
+   }
    notify(SIGNAL_NAME(PointCloudElement, DataModified), boost::any(updateMask));
 }
 
@@ -461,9 +468,85 @@ PointCloudAccessor PointCloudElementImp::getPointCloudAccessor(PointCloudDataReq
       break;
    }
 
+   // Only visit the points of the spatial index tiles which intersect the bounding box
+   if (pImpl != NULL && pImpl->isValid())
+   {
+      const PointCloudDataRequest* pImplRequest = pImpl->mpRequest.get();
+      if (pImplRequest->getDecimation() > 1 ||
+         pImplRequest->getStartX() > pDesc->getXMin() || pImplRequest->getStopX() < pDesc->getXMax() ||
+         pImplRequest->getStartY() > pDesc->getYMin() || pImplRequest->getStopY() < pDesc->getYMax() ||
+         pImplRequest->getStartZ() > pDesc->getZMin() || pImplRequest->getStopZ() < pDesc->getZMax())
+      {
+         if (selectPoints(pImplRequest, pImpl->mSelectedPoints) == false)
+         {
+            delete pImpl;
+            return PointCloudAccessor(pDeleter, NULL);
+         }
+         pImpl->mHasSelection = true;
+         pImpl->toSelectedPoint(0);
+      }
+   }
+
    return PointCloudAccessor(pDeleter, pImpl);
 }
 
+bool PointCloudElementImp::selectPoints(const PointCloudDataRequest* pRequest, vector<uint32_t>& points)
+{
+   boost::shared_ptr<PointCloudSpatialIndex> pIndex;
+   {
+      mta::MutexLock lock(mSpatialIndexMutex);
+      if (mpSpatialIndex.get() == NULL)
+      {
+         boost::shared_ptr<PointCloudSpatialIndex> pNewIndex(new PointCloudSpatialIndex);
+         if (pNewIndex->build(dynamic_cast<PointCloudElement*>(this)) == false)
+         {
+            return false;
+         }
+         mpSpatialIndex = pNewIndex;
+      }
+      pIndex = mpSpatialIndex;
+   }
+
+   double startX = pRequest->getStartX();
+   double stopX = pRequest->getStopX();
+   double startY = pRequest->getStartY();
+   double stopY = pRequest->getStopY();
+   double startZ = pRequest->getStartZ();
+   double stopZ = pRequest->getStopZ();
+   vector<uint32_t> pointsToTest;
+   pIndex->getPoints(startX, stopX, startY, stopY, startZ, stopZ, pRequest->getDecimation(),
+      points, pointsToTest);
+   if (pointsToTest.empty())
+   {
+      return true;
+   }
+
+   // Only the points of the tiles on the border of the bounding box need to be compared to it
+   PointCloudAccessor pAccessor = getPointCloudAccessor();
+   if (!pAccessor.isValid())
+   {
+      return false;
+   }
+   vector<uint32_t>::size_type insideCount = points.size();
+   for (vector<uint32_t>::const_iterator iter = pointsToTest.begin(); iter != pointsToTest.end(); ++iter)
+   {
+      pAccessor->toIndex(*iter);
+      if (!pAccessor.isValid())
+      {
+         return false;
+      }
+      double x = pAccessor->getXAsDouble();
+      double y = pAccessor->getYAsDouble();
+      double z = pAccessor->getZAsDouble();
+      if (x >= startX && x <= stopX && y >= startY && y <= stopY && z >= startZ && z <= stopZ)
+      {
+         points.push_back(*iter);
+      }
+   }
+   inplace_merge(points.begin(), points.begin() + insideCount, points.end());
+   return true;
+}
+
 PointCloudAccessor PointCloudElementImp::getPointCloudAccessor(PointCloudDataRequest *pRequestIn) const
 {
    if (pRequestIn != NULL)
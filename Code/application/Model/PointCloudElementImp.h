@@ -11,10 +11,14 @@
 #define POINTCLOUDELEMENTIMP_H
 
 #include "DataElementImp.h"
+#include "DMutex.h"
 #include "PointCloudAccessor.h"
 #include "PointCloudAccessorImpl.h"
 
+#include <boost/shared_ptr.hpp>
+
 class PointCloudPager;
+class PointCloudSpatialIndex;
 
 class PointCloudElementImp : public DataElementImp
 {
@@ -49,6 +53,7 @@ public:
 
 private:
    bool createMemoryMappedPagerForNewTempFile();
+   bool selectPoints(const PointCloudDataRequest* pRequest, std::vector<uint32_t>& points);
 
    uint32_t mArrayCount;
    void createData();
@@ -57,6 +62,12 @@ private:
    char* mpInMemoryData;
    PointCloudPager* mpPager;
 
+   // Built the first time a subset of the points is requested, and discarded when the data is modified.
+   // Accessors may be requested in several threads, so the index is only built or discarded with the mutex
+   // locked, and each query holds its own reference in case the data is modified while it runs.
+   boost::shared_ptr<PointCloudSpatialIndex> mpSpatialIndex;
+   mta::DMutex mSpatialIndexMutex;
+
    mutable bool mModified;
 };
 
@@ -93,7 +93,7 @@ bool PointCloudInMemoryPager::execute(PlugInArgList* pInput, PlugInArgList* pOut
 PointDataBlock* PointCloudInMemoryPager::getPointBlock(uint32_t startIndex, uint32_t numPoints, PointCloudDataRequest* pOriginalRequest)
 {
    bool writable = false;
-   if (startIndex + numPoints >= mPointCount)
+   if (startIndex >= mPointCount || numPoints > mPointCount - startIndex)
    {
       return NULL;
    }
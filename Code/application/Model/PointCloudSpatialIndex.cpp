@@ -0,0 +1,265 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "PointCloudAccessor.h"
+#include "PointCloudAccessorImpl.h"
+#include "PointCloudDataDescriptor.h"
+#include "PointCloudElement.h"
+#include "PointCloudSpatialIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+using namespace std;
+
+namespace
+{
+   // The average number of points in a tile
+   const uint32_t POINTS_PER_TILE = 4096;
+
+   // The maximum number of tiles in each direction
+   const unsigned int MAXIMUM_TILES_ACROSS = 4096;
+
+   uint32_t reverseBits(uint32_t value, unsigned int bits)
+   {
+      uint32_t reversed = 0;
+      for (unsigned int bit = 0; bit < bits; ++bit)
+      {
+         reversed = (reversed << 1) | (value & 1);
+         value >>= 1;
+      }
+
+      return reversed;
+   }
+
+   // Orders the points of a tile so that each prefix holds every 2^k th point of the tile
+   void orderCoarseToFine(uint32_t* pPoints, uint32_t count, vector<uint32_t>& buffer)
+   {
+      if (count <= 2)
+      {
+         return;
+      }
+
+      unsigned int bits = 0;
+      while ((static_cast<uint64_t>(1) << bits) < count)
+      {
+         ++bits;
+      }
+
+      buffer.assign(pPoints, pPoints + count);
+      uint32_t ordered = 0;
+      for (uint64_t position = 0; position < (static_cast<uint64_t>(1) << bits); ++position)
+      {
+         uint32_t point = reverseBits(static_cast<uint32_t>(position), bits);
+         if (point < count)
+         {
+            pPoints[ordered++] = buffer[point];
+         }
+      }
+   }
+}
+
+PointCloudSpatialIndex::PointCloudSpatialIndex() :
+   mMinX(0.0),
+   mMinY(0.0),
+   mTileWidth(0.0),
+   mTileHeight(0.0),
+   mColumns(0),
+   mRows(0)
+{
+}
+
+bool PointCloudSpatialIndex::build(PointCloudElement* pElement)
+{
+   mColumns = 0;
+   mRows = 0;
+   mTileOffsets.clear();
+   mTileMinZ.clear();
+   mTileMaxZ.clear();
+   vector<uint32_t>().swap(mPoints);
+   if (pElement == NULL)
+   {
+      return false;
+   }
+
+   const PointCloudDataDescriptor* pDescriptor =
+      dynamic_cast<const PointCloudDataDescriptor*>(pElement->getDataDescriptor());
+   if (pDescriptor == NULL)
+   {
+      return false;
+   }
+
+   // Size the tiles from the extents in the descriptor so that the points are only read twice.
+   // Points outside of the extents are placed in the tiles at the edges.
+   mMinX = pDescriptor->getXMin();
+   mMinY = pDescriptor->getYMin();
+   double width = pDescriptor->getXMax() - mMinX;
+   double height = pDescriptor->getYMax() - mMinY;
+   double tileCount = max(static_cast<double>(pDescriptor->getPointCount() / POINTS_PER_TILE), 1.0);
+   mColumns = 1;
+   mRows = 1;
+   if (width > 0.0 && height > 0.0)
+   {
+      double tileSize = sqrt(width * height / tileCount);
+      mColumns = static_cast<unsigned int>(min(ceil(width / tileSize), static_cast<double>(MAXIMUM_TILES_ACROSS)));
+      mRows = static_cast<unsigned int>(min(ceil(height / tileSize), static_cast<double>(MAXIMUM_TILES_ACROSS)));
+   }
+   else if (width > 0.0)
+   {
+      mColumns = static_cast<unsigned int>(min(tileCount, static_cast<double>(MAXIMUM_TILES_ACROSS)));
+   }
+   else if (height > 0.0)
+   {
+      mRows = static_cast<unsigned int>(min(tileCount, static_cast<double>(MAXIMUM_TILES_ACROSS)));
+   }
+
+   mColumns = max(mColumns, 1U);
+   mRows = max(mRows, 1U);
+   mTileWidth = (width > 0.0 ? width / mColumns : 0.0);
+   mTileHeight = (height > 0.0 ? height / mRows : 0.0);
+
+   // Count the valid points in each tile
+   unsigned int tiles = mColumns * mRows;
+   vector<uint32_t> counts(tiles, 0);
+   mTileMinZ.assign(tiles, numeric_limits<double>::max());
+   mTileMaxZ.assign(tiles, -numeric_limits<double>::max());
+
+   PointCloudAccessor pAccessor = pElement->getPointCloudAccessor();
+   if (pAccessor.isValid() == false)
+   {
+      return false;
+   }
+
+   uint32_t arrayCount = pElement->getArrayCount();
+   for (uint32_t point = 0; point < arrayCount && pAccessor.isValid() == true; ++point)
+   {
+      if (pAccessor->isPointValid() == true)
+      {
+         unsigned int tile = getRow(pAccessor->getYAsDouble()) * mColumns + getColumn(pAccessor->getXAsDouble());
+         double z = pAccessor->getZAsDouble();
+         mTileMinZ[tile] = min(mTileMinZ[tile], z);
+         mTileMaxZ[tile] = max(mTileMaxZ[tile], z);
+         ++counts[tile];
+      }
+
+      pAccessor->nextPoint();
+   }
+
+   mTileOffsets.resize(tiles + 1);
+   mTileOffsets[0] = 0;
+   for (unsigned int tile = 0; tile < tiles; ++tile)
+   {
+      mTileOffsets[tile + 1] = mTileOffsets[tile] + counts[tile];
+   }
+
+   // Place the points in their tiles in file order, then reorder each tile
+   mPoints.resize(mTileOffsets[tiles]);
+   vector<uint32_t> positions(mTileOffsets.begin(), mTileOffsets.end() - 1);
+   pAccessor->toIndex(0);
+   for (uint32_t point = 0; point < arrayCount && pAccessor.isValid() == true; ++point)
+   {
+      if (pAccessor->isPointValid() == true)
+      {
+         unsigned int tile = getRow(pAccessor->getYAsDouble()) * mColumns + getColumn(pAccessor->getXAsDouble());
+         if (positions[tile] < mTileOffsets[tile + 1])
+         {
+            mPoints[positions[tile]++] = point;
+         }
+      }
+
+      pAccessor->nextPoint();
+   }
+
+   vector<uint32_t> buffer;
+   for (unsigned int tile = 0; tile < tiles; ++tile)
+   {
+      if (positions[tile] != mTileOffsets[tile + 1])
+      {
+         // The data changed while the index was being built
+         mPoints.clear();
+         return false;
+      }
+
+      if (counts[tile] > 0)
+      {
+         orderCoarseToFine(&mPoints[mTileOffsets[tile]], counts[tile], buffer);
+      }
+   }
+
+   return true;
+}
+
+void PointCloudSpatialIndex::getPoints(double startX, double stopX, double startY, double stopY,
+                                       double startZ, double stopZ, uint32_t decimation,
+                                       vector<uint32_t>& pointsInside, vector<uint32_t>& pointsToTest) const
+{
+   pointsInside.clear();
+   pointsToTest.clear();
+   if (mPoints.empty() == true || startX > stopX || startY > stopY || startZ > stopZ)
+   {
+      return;
+   }
+
+   decimation = max(decimation, 1U);
+   unsigned int firstColumn = getColumn(startX);
+   unsigned int lastColumn = getColumn(stopX);
+   unsigned int firstRow = getRow(startY);
+   unsigned int lastRow = getRow(stopY);
+   for (unsigned int row = firstRow; row <= lastRow; ++row)
+   {
+      // The tiles at the edges also hold the points outside of the extents
+      double tileStartY = (row == 0 ? -numeric_limits<double>::max() : mMinY + row * mTileHeight);
+      double tileStopY = (row == mRows - 1 ? numeric_limits<double>::max() : mMinY + (row + 1) * mTileHeight);
+      for (unsigned int column = firstColumn; column <= lastColumn; ++column)
+      {
+         unsigned int tile = row * mColumns + column;
+         uint32_t count = mTileOffsets[tile + 1] - mTileOffsets[tile];
+         if (count == 0 || mTileMaxZ[tile] < startZ || mTileMinZ[tile] > stopZ)
+         {
+            continue;
+         }
+
+         double tileStartX = (column == 0 ? -numeric_limits<double>::max() : mMinX + column * mTileWidth);
+         double tileStopX = (column == mColumns - 1 ? numeric_limits<double>::max() :
+            mMinX + (column + 1) * mTileWidth);
+         bool inside = (tileStartX >= startX && tileStopX <= stopX && tileStartY >= startY && tileStopY <= stopY &&
+            mTileMinZ[tile] >= startZ && mTileMaxZ[tile] <= stopZ);
+
+         vector<uint32_t>& points = (inside ? pointsInside : pointsToTest);
+         vector<uint32_t>::const_iterator first = mPoints.begin() + mTileOffsets[tile];
+         points.insert(points.end(), first, first + (count - 1) / decimation + 1);
+      }
+   }
+
+   sort(pointsInside.begin(), pointsInside.end());
+   sort(pointsToTest.begin(), pointsToTest.end());
+}
+
+unsigned int PointCloudSpatialIndex::getColumn(double x) const
+{
+   double column = (mTileWidth > 0.0 ? floor((x - mMinX) / mTileWidth) : 0.0);
+   if ((column >= 0.0) == false)
+   {
+      return 0;
+   }
+
+   return static_cast<unsigned int>(min(column, static_cast<double>(mColumns - 1)));
+}
+
+unsigned int PointCloudSpatialIndex::getRow(double y) const
+{
+   double row = (mTileHeight > 0.0 ? floor((y - mMinY) / mTileHeight) : 0.0);
+   if ((row >= 0.0) == false)
+   {
+      return 0;
+   }
+
+   return static_cast<unsigned int>(min(row, static_cast<double>(mRows - 1)));
+}
@@ -0,0 +1,81 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef POINTCLOUDSPATIALINDEX_H
+#define POINTCLOUDSPATIALINDEX_H
+
+#include "AppConfig.h"
+
+#include <vector>
+
+class PointCloudElement;
+
+/**
+ * This class provides a tiled spatial index of a PointCloudElement.
+ *
+ * The extents of the point cloud are divided into a grid of tiles in X and Y,
+ * sized so that each tile holds a few thousand points on average, and each
+ * tile records the range of Z values of its points.  The point indices of a
+ * tile are stored in coarse-to-fine order: the first ceil(n / 2^k) points
+ * of a tile of n points are every 2^k th point of the tile in file order, so
+ * any prefix of a tile is a level of detail subsample of it.
+ *
+ * All values are the unscaled values stored in the element, which are the
+ * values used by the extents of the PointCloudDataDescriptor and by a
+ * PointCloudDataRequest.
+ */
+class PointCloudSpatialIndex
+{
+public:
+   PointCloudSpatialIndex();
+
+   /**
+    * Builds the index from the valid points of an element.
+    *
+    * @return Returns \c false if the points could not be accessed.
+    */
+   bool build(PointCloudElement* pElement);
+
+   /**
+    * Gets the points of the tiles which intersect a bounding box.
+    *
+    * The points are returned in ascending order so that they can be visited
+    * with a single pass through the element.
+    *
+    * @param pointsInside
+    *        Populated with the points of the tiles which are contained in the
+    *        bounding box.
+    * @param pointsToTest
+    *        Populated with the points of the tiles which are partially inside
+    *        the bounding box, which must be tested against the box.
+    * @param decimation
+    *        The number of points in each tile for which one point is returned.
+    */
+   void getPoints(double startX, double stopX, double startY, double stopY, double startZ, double stopZ,
+      uint32_t decimation, std::vector<uint32_t>& pointsInside, std::vector<uint32_t>& pointsToTest) const;
+
+private:
+   unsigned int getColumn(double x) const;
+   unsigned int getRow(double y) const;
+
+   double mMinX;
+   double mMinY;
+   double mTileWidth;
+   double mTileHeight;
+   unsigned int mColumns;
+   unsigned int mRows;
+
+   // The points of tile t are mPoints[mTileOffsets[t]] to mPoints[mTileOffsets[t + 1] - 1]
+   std::vector<uint32_t> mTileOffsets;
+   std::vector<double> mTileMinZ;
+   std::vector<double> mTileMaxZ;
+   std::vector<uint32_t> mPoints;
+};
+
+#endif
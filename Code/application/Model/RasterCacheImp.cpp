@@ -0,0 +1,104 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "RasterCacheImp.h"
+
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+RasterCacheImp::RasterCacheImp() :
+   mSize(0),
+   mAccessCount(0)
+{
+}
+
+RasterCacheImp::~RasterCacheImp()
+{
+}
+
+size_t RasterCacheImp::getMaximumSize() const
+{
+   return static_cast<size_t>(RasterCache::getSettingCacheSize()) * 1024 * 1024;
+}
+
+size_t RasterCacheImp::getSize() const
+{
+   return mSize;
+}
+
+void RasterCacheImp::addClient(RasterCacheClient* pClient)
+{
+   VERIFYNRV(pClient != NULL);
+
+   mta::MutexLock lock(mMutex);
+   if (find(mClients.begin(), mClients.end(), pClient) == mClients.end())
+   {
+      mClients.push_back(pClient);
+   }
+}
+
+void RasterCacheImp::removeClient(RasterCacheClient* pClient)
+{
+   mta::MutexLock lock(mMutex);
+   mClients.erase(remove(mClients.begin(), mClients.end(), pClient), mClients.end());
+}
+
+vector<RasterCacheClient*> RasterCacheImp::getClients() const
+{
+   mta::MutexLock lock(mMutex);
+   return mClients;
+}
+
+size_t RasterCacheImp::getNextAccess()
+{
+   return ++mAccessCount;
+}
+
+void RasterCacheImp::allocate(RasterCacheClient* pClient, size_t bytes)
+{
+   mSize += bytes;
+
+   const size_t maxSize = getMaximumSize();
+   while (mSize > maxSize)
+   {
+      // The lock is held while evicting so that the victim cannot be removed
+      // (and destroyed) between finding it and evicting from it.
+      mta::MutexLock lock(mMutex);
+      RasterCacheClient* pVictim = NULL;
+      size_t oldestAccess = numeric_limits<size_t>::max();
+      for (vector<RasterCacheClient*>::iterator iter = mClients.begin(); iter != mClients.end(); ++iter)
+      {
+         size_t access = 0;
+         if ((*iter)->getLeastRecentAccess(access) && access < oldestAccess)
+         {
+            oldestAccess = access;
+            pVictim = *iter;
+         }
+      }
+
+      if (pVictim == NULL)
+      {
+         break;
+      }
+
+      size_t released = pVictim->evictLeastRecentlyUsed();
+      if (released == 0)
+      {
+         break;
+      }
+      mSize -= released;
+   }
+}
+
+void RasterCacheImp::deallocate(size_t bytes)
+{
+   mSize -= bytes;
+}
@@ -0,0 +1,44 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef RASTERCACHEIMP_H
+#define RASTERCACHEIMP_H
+
+#include "DMutex.h"
+#include "RasterCache.h"
+
+#include <boost/atomic.hpp>
+#include <vector>
+
+class RasterCacheImp : public RasterCache
+{
+public:
+   RasterCacheImp();
+   ~RasterCacheImp();
+
+   size_t getMaximumSize() const;
+   size_t getSize() const;
+   void addClient(RasterCacheClient* pClient);
+   void removeClient(RasterCacheClient* pClient);
+   std::vector<RasterCacheClient*> getClients() const;
+   size_t getNextAccess();
+   void allocate(RasterCacheClient* pClient, size_t bytes);
+   void deallocate(size_t bytes);
+
+private:
+   RasterCacheImp(const RasterCacheImp& rhs);
+   RasterCacheImp& operator=(const RasterCacheImp& rhs);
+
+   mutable mta::DMutex mMutex;
+   std::vector<RasterCacheClient*> mClients;
+   boost::atomic<size_t> mSize;
+   boost::atomic<size_t> mAccessCount;
+};
+
+#endif
@@ -16,13 +16,17 @@
 #include "ConvertToBsqPager.h"
 #include "DataAccessorImpl.h"
 #include "DataRequest.h"
+#include "DataRequestImp.h"
 #include "DimensionDescriptor.h"
 #include "Executable.h"
 #include "FileResource.h"
 #include "Georeference.h"
 #include "Importer.h"
+#include "InterleaveTranspose.h"
 #include "ModelServices.h"
+#include "MultiThreadedAlgorithm.h"
 #include "ObjectResource.h"
+#include "OverviewPager.h"
 #include "PlugInArg.h"
 #include "PlugInArgList.h"
 #include "PlugInResource.h"
@@ -45,7 +49,6 @@
 
 #include <fstream>
 #include <limits>
-#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 using namespace std;
 XERCES_CPP_NAMESPACE_USE
@@ -152,6 +155,276 @@ namespace
       return *(reinterpret_cast<const double*>(pValue) + iIndex);
    }
 
+   // The value counts of every band are kept by every thread for BIP and BIL data, so statistics are not
+   // accumulated during an import if the counts would use more than this many bytes
+   const size_t MAXIMUM_ACCUMULATOR_SIZE = 256 * 1024 * 1024;
+
+   struct ImportInput
+   {
+      const RasterElement* mpSource;
+      RasterElement* mpChip;
+      const vector<DimensionDescriptor>* mpRows;
+      const vector<DimensionDescriptor>* mpColumns;
+      const vector<DimensionDescriptor>* mpBands;
+      InterleaveFormatType mInterleave;
+      EncodingType mEncoding;
+      unsigned int mBytesPerElement;
+      double mSanitizeValue;
+      vector<const BadValues*> mBadValues;   // One per chip band, or empty to not accumulate statistics
+      unsigned int mSketchCapacity;
+      bool* mpAbort;
+   };
+
+   /**
+    * Copies, sanitizes, and accumulates the statistics of a range of chip rows.  BSQ chips are
+    * divided among the threads band by band, so each thread copies every band of BIP and BIL rows
+    * but only some bands of BSQ rows.
+    */
+   class ImportThread : public mta::AlgorithmThread
+   {
+   public:
+      ImportThread(const ImportInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mItemRange(getThreadRange(threadCount, static_cast<int>(input.mpRows->size() *
+            (input.mInterleave == BSQ ? input.mpBands->size() : 1)))),
+         mSuccess(true),
+         mSanitizedCount(0)
+      {
+         for (vector<const BadValues*>::const_iterator iter = input.mBadValues.begin();
+            iter != input.mBadValues.end();
+            ++iter)
+         {
+            mAccumulators.push_back(StatisticsAccumulator(input.mEncoding, *iter, input.mSketchCapacity));
+         }
+      }
+
+      void run()
+      {
+         const int rowCount = static_cast<int>(mInput.mpRows->size());
+         int item = mItemRange.mFirst;
+         while (item <= mItemRange.mLast && mSuccess)
+         {
+            unsigned int chipBand = 0;
+            int firstRow = item;
+            int lastRow = mItemRange.mLast;
+            if (mInput.mInterleave == BSQ)
+            {
+               chipBand = static_cast<unsigned int>(item / rowCount);
+               firstRow = item % rowCount;
+               lastRow = min(rowCount - 1, firstRow + mItemRange.mLast - item);
+            }
+
+            mSuccess = copyRows(chipBand, firstRow, lastRow);
+            item += lastRow - firstRow + 1;
+         }
+      }
+
+      bool isSuccessful() const
+      {
+         return mSuccess;
+      }
+
+      uint64_t getSanitizedCount() const
+      {
+         return mSanitizedCount;
+      }
+
+      const vector<StatisticsAccumulator>& getAccumulators() const
+      {
+         return mAccumulators;
+      }
+
+   private:
+      ImportThread& operator=(const ImportThread& rhs);
+
+      bool copyRows(unsigned int chipBand, int firstRow, int lastRow)
+      {
+         const vector<DimensionDescriptor>& rows = *mInput.mpRows;
+         const vector<DimensionDescriptor>& columns = *mInput.mpColumns;
+         const vector<DimensionDescriptor>& bands = *mInput.mpBands;
+         const InterleaveFormatType interleave = mInput.mInterleave;
+
+         const RasterDataDescriptor* pChipDd =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpChip->getDataDescriptor());
+         VERIFY(pChipDd != NULL);
+
+         const DimensionDescriptor& firstBand = (interleave == BSQ ? bands[chipBand] : bands.front());
+         const DimensionDescriptor& lastBand = (interleave == BSQ ? bands[chipBand] : bands.back());
+
+         FactoryResource<DataRequest> pSrcRequest;
+         pSrcRequest->setInterleaveFormat(interleave);
+         pSrcRequest->setRows(rows[firstRow], rows[lastRow]);
+         pSrcRequest->setColumns(columns.front(), columns.back());
+         pSrcRequest->setBands(firstBand, lastBand);
+         DataAccessor srcDa = mInput.mpSource->getDataAccessor(pSrcRequest.release());
+
+         FactoryResource<DataRequest> pChipRequest;
+         pChipRequest->setInterleaveFormat(interleave);
+         pChipRequest->setWritable(true);
+         pChipRequest->setRows(pChipDd->getActiveRow(firstRow), pChipDd->getActiveRow(lastRow));
+         if (interleave == BSQ)
+         {
+            pChipRequest->setBands(pChipDd->getActiveBand(chipBand), pChipDd->getActiveBand(chipBand));
+         }
+         DataAccessor chipDa = mInput.mpChip->getDataAccessor(pChipRequest.release());
+
+         VERIFY(chipDa.isValid() && srcDa.isValid());
+
+         // Each chip row is gathered from the elements of the source row at these offsets, unless the
+         // offsets select the whole source row
+         const unsigned int startCol = columns.front().getActiveNumber();
+         const unsigned int startBand = firstBand.getActiveNumber();
+         const size_t rowBands = (interleave == BSQ ? 1 : bands.size());
+         vector<size_t> offsets;
+         offsets.reserve(columns.size() * rowBands);
+         if (interleave == BIL)
+         {
+            size_t bandSize = srcDa->getConcurrentColumns();
+            for (vector<DimensionDescriptor>::const_iterator bandIter = bands.begin();
+               bandIter != bands.end();
+               ++bandIter)
+            {
+               for (vector<DimensionDescriptor>::const_iterator colIter = columns.begin();
+                  colIter != columns.end();
+                  ++colIter)
+               {
+                  offsets.push_back((bandIter->getActiveNumber() - startBand) * bandSize +
+                     colIter->getActiveNumber() - startCol);
+               }
+            }
+         }
+         else
+         {
+            size_t pixelStride = (interleave == BIP ? srcDa->getRowView<unsigned char, BIP>().getStride() : 1);
+            for (vector<DimensionDescriptor>::const_iterator colIter = columns.begin();
+               colIter != columns.end();
+               ++colIter)
+            {
+               size_t pixelOffset = (colIter->getActiveNumber() - startCol) * pixelStride;
+               for (size_t band = 0; band < rowBands; ++band)
+               {
+                  offsets.push_back(pixelOffset + (interleave == BIP ? bands[band].getActiveNumber() - startBand : 0));
+               }
+            }
+         }
+
+         bool contiguous = true;
+         for (size_t index = 0; index < offsets.size() && contiguous; ++index)
+         {
+            contiguous = (offsets[index] == index);
+         }
+
+         const bool sanitize = (mInput.mEncoding == FLT4BYTES || mInput.mEncoding == FLT8COMPLEX ||
+            mInput.mEncoding == FLT8BYTES);
+         const int firstItem = (interleave == BSQ ? static_cast<int>(chipBand * rows.size()) : 0);
+         int oldPercentDone = -1;
+         for (int row = firstRow; row <= lastRow; ++row)
+         {
+            if (*mInput.mpAbort)
+            {
+               return false;
+            }
+
+            srcDa->toPixel(rows[row].getActiveNumber(), startCol);
+            VERIFY(srcDa.isValid() && chipDa.isValid());
+            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
+            if (contiguous)
+            {
+               memcpy(pChip, pSrc, offsets.size() * mInput.mBytesPerElement);
+            }
+            else
+            {
+               InterleaveTranspose::gather(pSrc, &offsets[0], offsets.size(), pChip, mInput.mBytesPerElement);
+            }
+
+            // The row is still in the cache, so sanitizing and accumulating it here avoids reading the
+            // chip again
+            if (sanitize)
+            {
+               mSanitizedCount += RasterUtilities::sanitizeData(pChip, offsets.size(), mInput.mEncoding,
+                  mInput.mSanitizeValue);
+            }
+
+            if (mAccumulators.empty() == false)
+            {
+               if (interleave == BSQ)
+               {
+                  mAccumulators[chipBand].addRow(pChip, BSQ, columns.size(), 1, 0);
+               }
+               else
+               {
+                  for (size_t band = 0; band < rowBands; ++band)
+                  {
+                     mAccumulators[band].addRow(pChip, interleave, columns.size(), rowBands, band);
+                  }
+               }
+            }
+
+            chipDa->nextRow();
+
+            int percentDone = mItemRange.computePercent(row + firstItem);
+            if (percentDone > oldPercentDone)
+            {
+               oldPercentDone = percentDone;
+               getReporter().reportProgress(getThreadIndex(), percentDone);
+            }
+         }
+
+         return true;
+      }
+
+      const ImportInput& mInput;
+      mta::AlgorithmThread::Range mItemRange;
+      bool mSuccess;
+      uint64_t mSanitizedCount;
+      vector<StatisticsAccumulator> mAccumulators;
+   };
+
+   struct ImportOutput
+   {
+      ImportOutput() :
+         mSuccess(false),
+         mSanitizedCount(0)
+      {
+      }
+
+      bool compileOverallResults(const vector<ImportThread*>& threads)
+      {
+         mSuccess = (threads.empty() == false);
+         for (vector<ImportThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+         {
+            const ImportThread* pThread = *iter;
+            if (pThread == NULL || pThread->isSuccessful() == false)
+            {
+               mSuccess = false;
+               continue;
+            }
+
+            mSanitizedCount += pThread->getSanitizedCount();
+
+            const vector<StatisticsAccumulator>& accumulators = pThread->getAccumulators();
+            if (mAccumulators.empty())
+            {
+               mAccumulators = accumulators;
+            }
+            else
+            {
+               for (size_t band = 0; band < accumulators.size() && band < mAccumulators.size(); ++band)
+               {
+                  mAccumulators[band].merge(accumulators[band]);
+               }
+            }
+         }
+
+         return mSuccess;
+      }
+
+      bool mSuccess;
+      uint64_t mSanitizedCount;
+      vector<StatisticsAccumulator> mAccumulators;
+   };
 };
 RasterElementImp::RasterElementImp(const DataDescriptorImp& descriptor, const string& id) :
    DataElementImp(descriptor, id),
@@ -160,6 +433,7 @@ RasterElementImp::RasterElementImp(const DataDescriptorImp& descriptor, const st
    mpBipConverterPager(NULL),
    mpBilConverterPager(NULL),
    mpBsqConverterPager(NULL),
+   mpOverviewPager(NULL),
    mCubePointerAccessor(NULL, NULL),
    mModified(false),
    mpGeoPlugin(NULL)
@@ -281,6 +555,9 @@ RasterElementImp::~RasterElementImp()
    }
 
    mCubePointerAccessor = DataAccessor(NULL, NULL);
+
+   // The overviews must be destroyed first since they are built from the data in the pager
+   delete mpOverviewPager;
    delete mpBipConverterPager;
    delete mpBilConverterPager;
    delete mpBsqConverterPager;
@@ -346,6 +623,11 @@ double RasterElementImp::getPixelValue(DimensionDescriptor columnDim, DimensionD
 
 void RasterElementImp::updateData()
 {
+   if (mpOverviewPager != NULL)
+   {
+      mpOverviewPager->invalidate();
+   }
+
    map<DimensionDescriptor, StatisticsImp*>::iterator iter;
    for (iter = mStatistics.begin(); iter != mStatistics.end(); ++iter)
    {
@@ -426,6 +708,73 @@ uint64_t RasterElementImp::sanitizeData(double value)
    return badValueCount;
 }
 
+bool RasterElementImp::buildOverviews(DimensionDescriptor band)
+{
+   if (band.isActiveNumberValid() == false)
+   {
+      return false;
+   }
+
+   OverviewPager* pPager = NULL;
+   {
+      mta::MutexLock lock(mPagerMutex);
+      pPager = getOverviewPager();
+   }
+
+   if (pPager == NULL)
+   {
+      return false;
+   }
+
+   return pPager->buildOverviews(band.getActiveNumber());
+}
+
+OverviewPager* RasterElementImp::getOverviewPager()
+{
+   if (mpOverviewPager == NULL)
+   {
+      const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
+      if (pDescriptor == NULL || pDescriptor->getProcessingLocation() == IN_MEMORY)
+      {
+         // Data in memory can be accessed quickly enough at full resolution
+         return NULL;
+      }
+
+      if (createDefaultPager() == false)
+      {
+         return NULL;
+      }
+
+      // Store the overviews next to the temporary file if there is one
+      string filename;
+      if (mTempFilename.empty() == false)
+      {
+         filename = mTempFilename + ".ovr";
+      }
+      else
+      {
+         const Filename* pTempPath = ConfigurationSettings::getSettingTempPath();
+         string tempPath;
+         if (pTempPath != NULL)
+         {
+            tempPath = pTempPath->getFullPathAndName();
+         }
+
+         char* pTempFilename = tempnam(tempPath.c_str(), "OV");
+         if (pTempFilename == NULL)
+         {
+            return NULL;
+         }
+         filename = pTempFilename;
+         free(pTempFilename);
+      }
+
+      mpOverviewPager = new OverviewPager(dynamic_cast<RasterElement*>(this), filename);
+   }
+
+   return mpOverviewPager;
+}
+
 void RasterElementImp::setTerrain(RasterElement* pTerrain)
 {
    if (pTerrain != mpTerrain.get())
@@ -736,6 +1085,99 @@ bool RasterElementImp::copyDataToChip(RasterElement *pRasterChip,
    return success;
 }
 
+bool RasterElementImp::importDataToChip(RasterElement* pRasterChip,
+   const vector<DimensionDescriptor>& selectedRows,
+   const vector<DimensionDescriptor>& selectedColumns,
+   const vector<DimensionDescriptor>& selectedBands,
+   double sanitizeValue, uint64_t& sanitizedCount,
+   bool& abort, Progress* pProgress) const
+{
+   sanitizedCount = 0;
+
+   StatusBarProgress statusBarProgress;
+   if (pProgress == NULL)
+   {
+      pProgress = &statusBarProgress;
+   }
+
+   VERIFY(pRasterChip != NULL);
+   VERIFY(selectedRows.empty() == false && selectedColumns.empty() == false && selectedBands.empty() == false);
+   const RasterDataDescriptor* pSrcDd = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
+   VERIFY(pSrcDd != NULL);
+   const RasterDataDescriptor* pChipDd = dynamic_cast<const RasterDataDescriptor*>(pRasterChip->getDataDescriptor());
+   VERIFY(pChipDd != NULL);
+
+   InterleaveFormatType interleave = pChipDd->getInterleaveFormat();
+   if (interleave != BIP && interleave != BIL && interleave != BSQ)
+   {
+      return false;
+   }
+
+   ImportInput input;
+   input.mpSource = dynamic_cast<const RasterElement*>(this);
+   input.mpChip = pRasterChip;
+   input.mpRows = &selectedRows;
+   input.mpColumns = &selectedColumns;
+   input.mpBands = &selectedBands;
+   input.mInterleave = interleave;
+   input.mEncoding = pSrcDd->getDataType();
+   input.mBytesPerElement = pSrcDd->getBytesPerElement();
+   input.mSanitizeValue = sanitizeValue;
+   input.mSketchCapacity = Statistics::getSettingSketchCapacity();
+   input.mpAbort = &abort;
+   VERIFY(input.mpSource != NULL);
+
+   unsigned int itemCount = static_cast<unsigned int>(selectedRows.size() *
+      (interleave == BSQ ? selectedBands.size() : 1));
+   unsigned int threadCount = mta::getNumRequiredThreads(itemCount);
+
+   // Statistics are only accumulated if the histogram can be built from them
+   StatisticsAccumulator probe(input.mEncoding, NULL, input.mSketchCapacity);
+   size_t accumulatorSize = StatisticsAccumulator::getValueCountBytes(input.mEncoding) * selectedBands.size() *
+      (interleave == BSQ ? 1 : threadCount);
+   if (probe.canCompleteStatistics() && accumulatorSize <= MAXIMUM_ACCUMULATOR_SIZE)
+   {
+      for (unsigned int band = 0; band < pChipDd->getBandCount(); ++band)
+      {
+         StatisticsImp* pStatistics = dynamic_cast<StatisticsImp*>(
+            pRasterChip->getStatistics(pChipDd->getActiveBand(band)));
+         input.mBadValues.push_back(pStatistics == NULL ? NULL : pStatistics->getBadValues());
+      }
+   }
+
+   if (input.mBadValues.size() != selectedBands.size())
+   {
+      input.mBadValues.clear();
+   }
+
+   ImportOutput output;
+   mta::ProgressObjectReporter reporter("Copying data", pProgress);
+   mta::MultiThreadedAlgorithm<ImportInput, ImportOutput, ImportThread> algorithm(threadCount, input, output,
+      &reporter);
+   if (algorithm.run() != mta::SUCCESS || output.mSuccess == false || abort)
+   {
+      return false;
+   }
+
+   sanitizedCount = output.mSanitizedCount;
+   if (sanitizedCount != 0)
+   {
+      pRasterChip->updateData();
+   }
+
+   // The statistics are set after updateData() since it resets them
+   for (size_t band = 0; band < output.mAccumulators.size(); ++band)
+   {
+      StatisticsImp* pStatistics = dynamic_cast<StatisticsImp*>(
+         pRasterChip->getStatistics(pChipDd->getActiveBand(static_cast<unsigned int>(band))));
+      if (pStatistics != NULL)
+      {
+         output.mAccumulators[band].apply(pStatistics);
+      }
+   }
+
+   return true;
+}
 
 bool RasterElementImp::copyDataBip(RasterElement* pChipElement, const vector<DimensionDescriptor>& selectedRows,
                                    const vector<DimensionDescriptor>& selectedColumns,
@@ -753,146 +1195,69 @@ bool RasterElementImp::copyDataBip(RasterElement* pChipElement, const vector<Dim
 
    int bytesPerElement = pSrcDd->getBytesPerElement();
 
-   bool copyCompleted = false;
-
-   int rowIndex = 0;
-   if (selectedBands.size() == srcActiveBands.size())
-   {
-      // all bands
-      if (selectedColumns.size() == 
-         selectedColumns.back().getActiveNumber() - selectedColumns.front().getActiveNumber() + 1)
-      {
-         unsigned int startCol = selectedColumns.front().getActiveNumber();
+   unsigned int startCol = selectedColumns.front().getActiveNumber();
+   bool contiguousColumns = (selectedColumns.size() == selectedColumns.back().getActiveNumber() - startCol + 1);
 
-         // full contiguous row at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BIP);
-         pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
-         pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back());
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
+   FactoryResource<DataRequest> pSrcRequest;
+   pSrcRequest->setInterleaveFormat(BIP);
+   pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
+   pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back());
+   DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
 
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setWritable(true);
-         pChipRequest->setInterleaveFormat(BIP);
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
+   FactoryResource<DataRequest> pChipRequest;
+   pChipRequest->setWritable(true);
+   pChipRequest->setInterleaveFormat(BIP);
+   DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
 
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-            rowIter != selectedRows.end();
-            ++rowIter)
-         {
-            DimensionDescriptor rowDim = *rowIter;
-            srcDa->toPixel(rowDim.getActiveNumber(), startCol);
-            VERIFY(srcDa.isValid() && chipDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-            memcpy(pChip, pSrc, bytesPerElement * selectedBands.size() * selectedColumns.size());
-            chipDa->nextRow();
+   VERIFY(chipDa.isValid() && srcDa.isValid());
 
-            pProgress->updateProgress(progressText, (rowIndex++ * 100) / selectedRows.size(), NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-         copyCompleted = true;
-      }
-      else
+   // Unless all bands of contiguous columns are selected, each chip row is gathered from the elements of
+   // the source row at these offsets
+   vector<size_t> offsets;
+   if (selectedBands.size() != srcActiveBands.size() || contiguousColumns == false)
+   {
+      size_t pixelStride = srcDa->getRowView<unsigned char, BIP>().getStride();
+      offsets.reserve(selectedColumns.size() * selectedBands.size());
+      for (vector<DimensionDescriptor>::const_iterator colIter = selectedColumns.begin();
+         colIter != selectedColumns.end();
+         ++colIter)
       {
-         // one full pixel at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BIP);
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-         
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setWritable(true);
-         pChipRequest->setInterleaveFormat(BIP);
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-            rowIter != selectedRows.end();
-            ++rowIter)
+         size_t pixelOffset = (colIter->getActiveNumber() - startCol) * pixelStride;
+         for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
+            bandIter != selectedBands.end();
+            ++bandIter)
          {
-            VERIFY(chipDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            unsigned int rowOffsetChip = 0;
-            for (vector<DimensionDescriptor>::const_iterator colIter = selectedColumns.begin();
-               colIter != selectedColumns.end();
-               ++colIter)
-            {
-               DimensionDescriptor rowDim = *rowIter;
-               DimensionDescriptor colDim = *colIter;
-
-               srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-               memcpy(pChip + rowOffsetChip, pSrc, bytesPerElement * selectedBands.size());
-               rowOffsetChip += bytesPerElement * selectedBands.size();
-            }
-            chipDa->nextRow();
-            pProgress->updateProgress(progressText, (rowIndex++ * 100)/selectedRows.size(), NORMAL);
-            if (abort)
-            {
-               return false;
-            }
+            offsets.push_back(pixelOffset + bandIter->getActiveNumber());
          }
-         copyCompleted = true;
       }
    }
 
-   if (!copyCompleted)
-   {
-      // slowest possible copy, per pixel, but it works for any BIP data
-      FactoryResource<DataRequest> pSrcRequest;
-      pSrcRequest->setInterleaveFormat(BIP);
-      DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setWritable(true);
-      pChipRequest->setInterleaveFormat(BIP);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
+   int rowIndex = 0;
+   for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
+      rowIter != selectedRows.end();
+      ++rowIter)
+   {
+      srcDa->toPixel(rowIter->getActiveNumber(), startCol);
+      VERIFY(srcDa.isValid() && chipDa.isValid());
+      char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+      char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
+      if (offsets.empty())
       {
-         VERIFY(chipDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-         unsigned int chipOffset = 0;
-         for (vector<DimensionDescriptor>::const_iterator colIter = selectedColumns.begin();
-            colIter != selectedColumns.end();
-            ++colIter)
-         {
-            DimensionDescriptor rowDim = *rowIter;
-            DimensionDescriptor colDim = *colIter;
-
-            srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-            VERIFY(srcDa.isValid());
-            char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-            for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
-               bandIter != selectedBands.end();
-               ++bandIter)
-            {
-               DimensionDescriptor bandDim = *bandIter;
-
-               memcpy(pChip+chipOffset, pSrc + bytesPerElement * (bandDim.getActiveNumber()), 
-                  bytesPerElement);
-               chipOffset += bytesPerElement;
-            }
-
-         }
-         chipDa->nextRow();
-         pProgress->updateProgress(progressText, (rowIndex++ * 100)/selectedRows.size(), NORMAL);
-         if (abort)
-         {
-            return false;
-         }
+         // full contiguous row at a time
+         memcpy(pChip, pSrc, bytesPerElement * selectedBands.size() * selectedColumns.size());
+      }
+      else
+      {
+         InterleaveTranspose::gather(pSrc, &offsets[0], offsets.size(), pChip, bytesPerElement);
       }
-      copyCompleted = true;
 
+      chipDa->nextRow();
+      pProgress->updateProgress(progressText, (rowIndex++ * 100) / selectedRows.size(), NORMAL);
+      if (abort)
+      {
+         return false;
+      }
    }
-   VERIFY(copyCompleted);
 
    return true;
 }
@@ -953,102 +1318,76 @@ bool RasterElementImp::copyDataBil(RasterElement* pChipElement, const vector<Dim
          }
       }
    }
-   else if (selectedColumns.size() ==
-      selectedColumns.back().getActiveNumber() - selectedColumns.front().getActiveNumber() + 1)
+   else
    {
-      // copy a full row one band at a time
+      // copy each selected band of a row from a single accessor
       unsigned int step = 0;
-      unsigned int steps = selectedBands.size() * selectedRows.size();
+      unsigned int steps = selectedRows.size();
+
+      unsigned int startCol = selectedColumns.front().getActiveNumber();
+      unsigned int startBand = selectedBands.front().getActiveNumber();
+      bool contiguousColumns = (selectedColumns.size() == selectedColumns.back().getActiveNumber() - startCol + 1);
+
+      FactoryResource<DataRequest> pSrcRequest;
+      pSrcRequest->setInterleaveFormat(BIL);
+      pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
+      pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back());
+      pSrcRequest->setBands(selectedBands.front(), selectedBands.back());
+      DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
 
       FactoryResource<DataRequest> pChipRequest;
       pChipRequest->setInterleaveFormat(BIL);
       pChipRequest->setWritable(true);
       DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
 
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
-      {
-         VERIFY(chipDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+      VERIFY(chipDa.isValid() && srcDa.isValid());
 
-         for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
-            bandIter != selectedBands.end();
-            ++bandIter)
+      // Columns which are not contiguous are gathered from each band of the source row
+      vector<size_t> columnOffsets;
+      if (contiguousColumns == false)
+      {
+         columnOffsets.reserve(selectedColumns.size());
+         for (vector<DimensionDescriptor>::const_iterator columnIter = selectedColumns.begin();
+            columnIter != selectedColumns.end();
+            ++columnIter)
          {
-            FactoryResource<DataRequest> pSrcRequest;
-            pSrcRequest->setInterleaveFormat(BIL);
-            pSrcRequest->setRows(*rowIter, *rowIter, 1);
-            pSrcRequest->setBands(*bandIter, *bandIter, 1);
-            pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back(), selectedColumns.size());
-            DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-            srcDa->toPixel(rowIter->getActiveNumber(), selectedColumns.front().getActiveNumber());
-            VERIFY(srcDa.isValid());
-
-            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-            memcpy(pChip, pSrc, selectedColumns.size() * bytesPerElement);
-            pChip += selectedColumns.size() * bytesPerElement;
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
-            {
-               return false;
-            }
+            columnOffsets.push_back(columnIter->getActiveNumber() - startCol);
          }
-
-         chipDa->nextRow();
       }
-   }
-   else
-   {
-      // slowest possible copy, per pixel, but it works for any BIL data
-      unsigned int step = 0;
-      unsigned int steps = selectedBands.size() * selectedRows.size();
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setInterleaveFormat(BIL);
-      pChipRequest->setWritable(true);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
 
+      size_t bandSize = srcDa->getConcurrentColumns() * bytesPerElement;
       for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
          rowIter != selectedRows.end();
          ++rowIter)
       {
-         unsigned int chipOffset = 0;
-         VERIFY(chipDa.isValid());
+         srcDa->toPixel(rowIter->getActiveNumber(), startCol);
+         VERIFY(chipDa.isValid() && srcDa.isValid());
          char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+         char* pSrcRow = reinterpret_cast<char*>(srcDa->getRow());
 
          for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
             bandIter != selectedBands.end();
             ++bandIter)
          {
-            FactoryResource<DataRequest> pSrcRequest;
-            pSrcRequest->setInterleaveFormat(BIL);
-            pSrcRequest->setRows(*rowIter, *rowIter, 1);
-            pSrcRequest->setBands(*bandIter, *bandIter, 1);
-            pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back(), 1);
-            DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-            VERIFY(srcDa.isValid());
-
-            for (vector<DimensionDescriptor>::const_iterator columnIter = selectedColumns.begin();
-               columnIter != selectedColumns.end();
-               ++columnIter)
+            char* pSrc = pSrcRow + (bandIter->getActiveNumber() - startBand) * bandSize;
+            if (contiguousColumns)
             {
-               srcDa->toPixel(rowIter->getActiveNumber(), columnIter->getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-
-               memcpy(pChip + chipOffset, pSrc, bytesPerElement);
-               chipOffset += bytesPerElement;
+               memcpy(pChip, pSrc, selectedColumns.size() * bytesPerElement);
             }
-
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
+            else
             {
-               return false;
+               InterleaveTranspose::gather(pSrc, &columnOffsets[0], columnOffsets.size(), pChip, bytesPerElement);
             }
+
+            pChip += selectedColumns.size() * bytesPerElement;
          }
 
          chipDa->nextRow();
+         pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
+         if (abort)
+         {
+            return false;
+         }
       }
    }
 
@@ -1126,6 +1465,15 @@ bool RasterElementImp::copyDataBsq(RasterElement* pChipElement, const vector<Dim
    }
    else
    {
+      unsigned int startCol = selectedColumns.front().getActiveNumber();
+      vector<size_t> columnOffsets;
+      columnOffsets.reserve(selectedColumns.size());
+      for (vector<DimensionDescriptor>::const_iterator colItr = selectedColumns.begin();
+         colItr != selectedColumns.end(); ++colItr)
+      {
+         columnOffsets.push_back(colItr->getActiveNumber() - startCol);
+      }
+
       unsigned int chipBand = 0;
       unsigned int step = 0;
       unsigned int steps = selectedBands.size() * selectedRows.size();
@@ -1134,9 +1482,11 @@ bool RasterElementImp::copyDataBsq(RasterElement* pChipElement, const vector<Dim
       {
          DimensionDescriptor bandDim = *bandItr;
 
-         // slowest copy, one pixel at a time
+         // gather the selected columns of each row
          FactoryResource<DataRequest> pSrcRequest;
          pSrcRequest->setInterleaveFormat(BSQ);
+         pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
+         pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back());
          pSrcRequest->setBands(bandDim, bandDim);
          DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
 
@@ -1150,22 +1500,12 @@ bool RasterElementImp::copyDataBsq(RasterElement* pChipElement, const vector<Dim
          for (vector<DimensionDescriptor>::const_iterator rowItr = selectedRows.begin();
             rowItr != selectedRows.end(); ++rowItr)
          {
-            DimensionDescriptor rowDim = *rowItr;
-
+            srcDa->toPixel(rowItr->getActiveNumber(), startCol);
             VERIFY(chipDa.isValid());
+            VERIFY(srcDa.isValid());
             char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            unsigned int chipOffset = 0;
-            for (vector<DimensionDescriptor>::const_iterator colItr = selectedColumns.begin();
-               colItr != selectedColumns.end(); ++colItr)
-            {
-               DimensionDescriptor colDim = *colItr;
-
-               srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pOrig = reinterpret_cast<char*>(srcDa->getColumn());
-               memcpy(pChip + chipOffset, pOrig, bytesPerElement);
-               chipOffset += bytesPerElement;
-            }
+            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
+            InterleaveTranspose::gather(pSrc, &columnOffsets[0], columnOffsets.size(), pChip, bytesPerElement);
             chipDa->nextRow();
             pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
             if (abort)
@@ -1290,6 +1630,10 @@ bool RasterElementImp::setPager(RasterPager* pPager)
       return false;
    }
 
+   // The overviews were built from the data in the old pager
+   delete mpOverviewPager;
+   mpOverviewPager = NULL;
+
    if (mpPager != NULL)
    {
       //destroy the old plugins first
@@ -1566,6 +1910,11 @@ void RasterElementImp::incrementDataAccessor(DataAccessorImpl& da)
    da.mAccessorColumn = da.mpRequest->getStartColumn().getActiveNumber();
    da.mAccessorBand = da.mpRequest->getStartBand().getActiveNumber();
 
+   // Overview rows and columns are only identified by their active numbers
+   unsigned int level = da.mpRequest->getResolutionLevel();
+   unsigned int numRows = DataRequestImp::getOverviewCount(pDescriptor->getRowCount(), level);
+   unsigned int numColumns = DataRequestImp::getOverviewCount(pDescriptor->getColumnCount(), level);
+
    //get a new raster page loaded into memory,
    //the only thing different from the previous page that we requested
    //should be the startRow.
@@ -1574,13 +1923,24 @@ void RasterElementImp::incrementDataAccessor(DataAccessorImpl& da)
    //that we originally requested in the getDataAccessor()
    //call
    RasterPage* pPage = NULL;
-   if (da.mAccessorRow < pDescriptor->getRowCount() &&
-      da.mAccessorColumn < pDescriptor->getColumnCount() &&
+   if (da.mAccessorRow < numRows &&
+      da.mAccessorColumn < numColumns &&
       da.mAccessorBand < pDescriptor->getBandCount())
    {
-      pPage = da.mpRasterPager->getPage(da.mpRequest.get(),
-         pDescriptor->getActiveRow(da.mAccessorRow), 
-         pDescriptor->getActiveColumn(da.mAccessorColumn), 
+      DimensionDescriptor startRow;
+      DimensionDescriptor startColumn;
+      if (level == 0)
+      {
+         startRow = pDescriptor->getActiveRow(da.mAccessorRow);
+         startColumn = pDescriptor->getActiveColumn(da.mAccessorColumn);
+      }
+      else
+      {
+         startRow.setActiveNumber(da.mAccessorRow);
+         startColumn.setActiveNumber(da.mAccessorColumn);
+      }
+
+      pPage = da.mpRasterPager->getPage(da.mpRequest.get(), startRow, startColumn,
          pDescriptor->getActiveBand(da.mAccessorBand));
    }
    //set the validatily of the data accessor to be dependent on
@@ -1664,9 +2024,12 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
       return DataAccessor(NULL, NULL);
    }
 
-   if (createDefaultPager() == false)
    {
-      return DataAccessor(NULL, NULL);
+      mta::MutexLock lock(mPagerMutex);
+      if (createDefaultPager() == false)
+      {
+         return DataAccessor(NULL, NULL);
+      }
    }
 
    unsigned int numColumns = pDescriptor->getColumnCount();
@@ -1677,8 +2040,15 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
    InterleaveFormatType interleave = pRequest->getInterleaveFormat();
 
    RasterPager* pPager = mpPager;
-   if (interleave == BIP && (sourceInterleave == BSQ || sourceInterleave == BIL))
+   if (pRequest->getResolutionLevel() > 0)
+   {
+      // Overviews contain a single band, so the interleave does not matter
+      mta::MutexLock lock(mPagerMutex);
+      pPager = getOverviewPager();
+   }
+   else if (interleave == BIP && (sourceInterleave == BSQ || sourceInterleave == BIL))
    {
+      mta::MutexLock lock(mPagerMutex);
       if (mpBipConverterPager == NULL)
       {
          mpBipConverterPager = new ConvertToBipPager(dynamic_cast<RasterElement*>(this));
@@ -1687,6 +2057,7 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
    }
    else if (interleave == BSQ && (sourceInterleave == BIP || sourceInterleave == BIL))
    {
+      mta::MutexLock lock(mPagerMutex);
       if (mpBsqConverterPager == NULL)
       {
          mpBsqConverterPager = new ConvertToBsqPager(dynamic_cast<RasterElement*>(this));
@@ -1695,6 +2066,7 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
    }
    else if (interleave == BIL && (sourceInterleave == BIP || sourceInterleave == BSQ))
    {
+      mta::MutexLock lock(mPagerMutex);
       if (mpBilConverterPager == NULL)
       {
          mpBilConverterPager = new ConvertToBilPager(dynamic_cast<RasterElement*>(this));
@@ -2160,21 +2532,17 @@ vector<LocationType> RasterElementImp::convertPixelsToGeocoords(
    const vector<LocationType>& pixels, bool quick, bool* pAccurate) const
 {
    vector<LocationType> geocoords;
-   
-   if (pAccurate != NULL)
+   if (mpGeoPlugin != NULL)
    {
-      bool bAccurate(false);
-      *pAccurate = true;
-      for (vector<LocationType>::const_iterator it = pixels.begin(); it != pixels.end(); ++it)
-      {
-         geocoords.push_back(convertPixelToGeocoord(*it, quick, &bAccurate));
-         *pAccurate = *pAccurate && bAccurate;
-      }
+      mpGeoPlugin->pixelsToGeocoords(pixels, geocoords, quick, pAccurate);
    }
    else
    {
-      transform(pixels.begin(), pixels.end(), back_inserter(geocoords), 
-         boost::bind(&RasterElementImp::convertPixelToGeocoord, this, _1, quick, pAccurate));
+      geocoords.resize(pixels.size());
+      if (pAccurate != NULL)
+      {
+         *pAccurate = pixels.empty();
+      }
    }
 
    return geocoords;
@@ -2207,21 +2575,17 @@ vector<LocationType> RasterElementImp::convertGeocoordsToPixels(
    const vector<LocationType>& geocoords, bool quick, bool* pAccurate) const
 {
    vector<LocationType> pixels;
-
-   if (pAccurate != NULL)
+   if (mpGeoPlugin != NULL)
    {
-      bool bAccurate(false);
-      *pAccurate = true;
-      for (vector<LocationType>::const_iterator it = geocoords.begin(); it != geocoords.end(); ++it)
-      {
-         pixels.push_back(convertGeocoordToPixel(*it, quick, &bAccurate));
-         *pAccurate = *pAccurate && bAccurate;
-      }
+      mpGeoPlugin->geocoordsToPixels(geocoords, pixels, quick, pAccurate);
    }
    else
    {
-      transform(geocoords.begin(), geocoords.end(), std::back_inserter(pixels), 
-         boost::bind(&RasterElementImp::convertGeocoordToPixel, this, _1, quick, pAccurate));
+      pixels.resize(geocoords.size());
+      if (pAccurate != NULL)
+      {
+         *pAccurate = geocoords.empty();
+      }
    }
 
    return pixels;
@@ -14,6 +14,7 @@
 #include "DataAccessor.h"
 #include "DataElementImp.h"
 #include "DimensionDescriptor.h"
+#include "DMutex.h"
 #include "SafePtr.h"
 #include "StatisticsImp.h"
 #include "TypesFile.h"
@@ -22,6 +23,8 @@
 #include <boost/any.hpp>
 #include <vector>
 
+class OverviewPager;
+
 class RasterElementImp : public DataElementImp
 {
 public:
@@ -37,7 +40,7 @@ public:
    virtual void incrementDataAccessor(DataAccessorImpl &da);
    virtual void updateData();
    virtual uint64_t sanitizeData(double value = 0.0);
-
+   bool buildOverviews(DimensionDescriptor band);
 
    void setTerrain(RasterElement* pTerrain);
    const RasterElement* getTerrain() const;
@@ -112,6 +115,13 @@ protected:
       const std::vector<DimensionDescriptor> &selectedBands,
       bool &abort, Progress *pProgress = NULL) const;
 
+   bool importDataToChip(RasterElement* pRasterChip,
+      const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns,
+      const std::vector<DimensionDescriptor>& selectedBands,
+      double sanitizeValue, uint64_t& sanitizedCount,
+      bool& abort, Progress* pProgress = NULL) const;
+
    bool copyDataBip(RasterElement* pChipElement, const std::vector<DimensionDescriptor>& selectedRows,
       const std::vector<DimensionDescriptor>& selectedColumns, const std::vector<DimensionDescriptor>& selectedBands,
       bool& abort, Progress* pProgress) const;
@@ -175,6 +185,9 @@ protected:
 private:
    RasterElementImp(const RasterElementImp& rhs);
    RasterElementImp& operator=(const RasterElementImp& rhs);
+
+   // Must be called with mPagerMutex locked
+   OverviewPager* getOverviewPager();
    SafePtr<RasterElement> mpTerrain;
    std::map<DimensionDescriptor, StatisticsImp*> mStatistics;
 
@@ -184,6 +197,10 @@ private:
    RasterPager* mpBipConverterPager;
    RasterPager* mpBilConverterPager;
    RasterPager* mpBsqConverterPager;
+   OverviewPager* mpOverviewPager;
+
+   // Pagers are created when first needed, which may be in several threads at once
+   mta::DMutex mPagerMutex;
 
    DataAccessor mCubePointerAccessor;
 
@@ -222,6 +239,10 @@ private:
    { \
       return impClass::sanitizeData(value); \
    } \
+   bool buildOverviews(DimensionDescriptor band) \
+   { \
+      return impClass::buildOverviews(band); \
+   } \
    virtual RasterElement* copyShallow(const std::string& name, DataElement* pParent) const \
    { \
       return impClass::copyShallow(name, pParent); \
@@ -295,6 +316,16 @@ private:
       return impClass::copyDataToChip(pRasterChip, selectedRows, selectedColumns, \
          selectedBands, abort, pProgress); \
    } \
+   bool importDataToChip(RasterElement* pRasterChip, \
+      const std::vector<DimensionDescriptor>& selectedRows, \
+      const std::vector<DimensionDescriptor>& selectedColumns, \
+      const std::vector<DimensionDescriptor>& selectedBands, \
+      double sanitizeValue, uint64_t& sanitizedCount, \
+      bool& abort, Progress* pProgress = NULL) const \
+   { \
+      return impClass::importDataToChip(pRasterChip, selectedRows, selectedColumns, \
+         selectedBands, sanitizeValue, sanitizedCount, abort, pProgress); \
+   } \
    LocationType convertPixelToGeocoord(LocationType pixel, bool quick = false, bool* pAccurate = NULL) const \
    { \
       return impClass::convertPixelToGeocoord(pixel, quick, pAccurate); \
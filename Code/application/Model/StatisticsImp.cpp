@@ -32,6 +32,301 @@
 using namespace mta;
 XERCES_CPP_NAMESPACE_USE
 
+namespace
+{
+   // Number of independent partial results kept while accumulating a row, which allows the compiler to
+   // vectorize the loop
+   const size_t STATISTICS_LANES = 4;
+
+   class StatisticsKernel
+   {
+   public:
+      StatisticsKernel() :
+         mComponent(COMPLEX_MAGNITUDE),
+         mpBadValues(NULL),
+         mBadValueLower(0.0),
+         mBadValueUpper(0.0),
+         mpValueCounts(NULL),
+         mValueOffset(0),
+         mpSketch(NULL)
+      {}
+
+      ComplexComponent mComponent;
+      const BadValues* mpBadValues;    // Only set if the bad values cannot be tested as a single range
+      double mBadValueLower;           // Values between the bounds are bad, so equal bounds exclude nothing
+      double mBadValueUpper;
+      unsigned int* mpValueCounts;     // Only set if the data type has few enough values to count each one
+      int mValueOffset;
+      QuantileSketch* mpSketch;
+
+      bool isBadValue(double value) const
+      {
+         if (mpBadValues != NULL)
+         {
+            return mpBadValues->isBadValue(value);
+         }
+
+         return value > mBadValueLower && value < mBadValueUpper;
+      }
+   };
+
+   class PartialStatistics
+   {
+   public:
+      PartialStatistics() :
+         mMinimum(std::numeric_limits<double>::max()),
+         mMaximum(-std::numeric_limits<double>::max()),
+         mSum(0.0),
+         mSumSquared(0.0),
+         mCount(0)
+      {}
+
+      void addValue(double value)
+      {
+         mMinimum = std::min(mMinimum, value);
+         mMaximum = std::max(mMaximum, value);
+         mSum += value;
+         mSumSquared += value * value;
+         ++mCount;
+      }
+
+      double mMinimum;
+      double mMaximum;
+      double mSum;
+      double mSumSquared;
+      unsigned int mCount;
+   };
+
+   /**
+    * Gets the range of values which can be counted individually instead of being binned after the
+    * minimum and maximum are known.
+    */
+   bool getValueCountRange(EncodingType encoding, int& offset, unsigned int& count)
+   {
+      switch (encoding)
+      {
+      case INT1SBYTE:
+         offset = std::numeric_limits<signed char>::min();
+         count = 256;
+         return true;
+      case INT1UBYTE:
+         offset = 0;
+         count = 256;
+         return true;
+      case INT2SBYTES:
+         offset = std::numeric_limits<signed short>::min();
+         count = 65536;
+         return true;
+      case INT2UBYTES:
+         offset = 0;
+         count = 65536;
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   double getHistogramScale(double minimum, double maximum)
+   {
+      if (maximum == minimum)
+      {
+         return 0.0;
+      }
+
+      return 0.999999999 * (HISTOGRAM_SIZE) / (maximum - minimum);
+   }
+
+   int getHistogramBin(double value, double minimum, double scale)
+   {
+      int bin = static_cast<int>((value - minimum) * scale);
+      if (bin >= HISTOGRAM_SIZE)
+      {
+         bin = HISTOGRAM_SIZE - 1;
+      }
+      else if (bin < 0)
+      {
+         bin = 0;
+      }
+
+      return bin;
+   }
+
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   void accumulateRow(const RowView<T, Interleave>& row, size_t firstColumn, size_t step,
+                      const StatisticsKernel& kernel, PartialStatistics& stats)
+   {
+      size_t columns = row.getColumnCount();
+      if (kernel.mpBadValues != NULL)
+      {
+         for (size_t column = firstColumn; column < columns; column += step)
+         {
+            double value = ModelServices::getDataValue(row[column], kernel.mComponent);
+            if (kernel.isBadValue(value) == false)
+            {
+               stats.addValue(value);
+               if (kernel.mpValueCounts != NULL)
+               {
+                  kernel.mpValueCounts[static_cast<int>(value) - kernel.mValueOffset]++;
+               }
+               if (kernel.mpSketch != NULL)
+               {
+                  kernel.mpSketch->add(value);
+               }
+            }
+         }
+
+         return;
+      }
+
+      // The single bad value range is applied with selects instead of branches so that the lanes
+      // can be computed with vector instructions
+      double minimum[STATISTICS_LANES];
+      double maximum[STATISTICS_LANES];
+      double sum[STATISTICS_LANES];
+      double sumSquared[STATISTICS_LANES];
+      unsigned int count[STATISTICS_LANES];
+      for (size_t lane = 0; lane < STATISTICS_LANES; ++lane)
+      {
+         minimum[lane] = stats.mMinimum;
+         maximum[lane] = stats.mMaximum;
+         sum[lane] = 0.0;
+         sumSquared[lane] = 0.0;
+         count[lane] = 0;
+      }
+
+      size_t column = firstColumn;
+      for (; column + (STATISTICS_LANES - 1) * step < columns; column += STATISTICS_LANES * step)
+      {
+         for (size_t lane = 0; lane < STATISTICS_LANES; ++lane)
+         {
+            double value = ModelServices::getDataValue(row[column + lane * step], kernel.mComponent);
+            bool good = (value > kernel.mBadValueLower && value < kernel.mBadValueUpper) == false;
+            minimum[lane] = (good && value < minimum[lane]) ? value : minimum[lane];
+            maximum[lane] = (good && value > maximum[lane]) ? value : maximum[lane];
+            sum[lane] += good ? value : 0.0;
+            sumSquared[lane] += good ? value * value : 0.0;
+            count[lane] += good ? 1 : 0;
+         }
+      }
+
+      for (size_t lane = 0; lane < STATISTICS_LANES; ++lane)
+      {
+         stats.mMinimum = std::min(stats.mMinimum, minimum[lane]);
+         stats.mMaximum = std::max(stats.mMaximum, maximum[lane]);
+         stats.mSum += sum[lane];
+         stats.mSumSquared += sumSquared[lane];
+         stats.mCount += count[lane];
+      }
+
+      for (; column < columns; column += step)
+      {
+         double value = ModelServices::getDataValue(row[column], kernel.mComponent);
+         if (kernel.isBadValue(value) == false)
+         {
+            stats.addValue(value);
+         }
+      }
+
+      // The row is still in the cache, so counting the values separately keeps the loop above vectorizable
+      if (kernel.mpValueCounts != NULL)
+      {
+         for (column = firstColumn; column < columns; column += step)
+         {
+            double value = ModelServices::getDataValue(row[column], kernel.mComponent);
+            kernel.mpValueCounts[static_cast<int>(value) - kernel.mValueOffset] += kernel.isBadValue(value) ? 0 : 1;
+         }
+      }
+
+      if (kernel.mpSketch != NULL)
+      {
+         for (column = firstColumn; column < columns; column += step)
+         {
+            double value = ModelServices::getDataValue(row[column], kernel.mComponent);
+            if (kernel.isBadValue(value) == false)
+            {
+               kernel.mpSketch->add(value);
+            }
+         }
+      }
+   }
+
+   void initializeKernel(const StatisticsInput& input, EncodingType encoding, std::vector<unsigned int>& valueCounts,
+                         QuantileSketch& sketch, StatisticsKernel& kernel)
+   {
+      kernel.mComponent = input.mComplexComponent;
+      if (input.mpBadValues != NULL && input.mpBadValues->empty() == false)
+      {
+         if (input.mpBadValues->getSingleBadValueRange(kernel.mBadValueLower, kernel.mBadValueUpper) == false)
+         {
+            kernel.mpBadValues = input.mpBadValues;
+         }
+      }
+
+      // Count each value of small integer types so that the histogram does not require a second pass
+      unsigned int valueCount = 0;
+      if (getValueCountRange(encoding, kernel.mValueOffset, valueCount))
+      {
+         valueCounts.resize(valueCount, 0);
+         kernel.mpValueCounts = &valueCounts.front();
+      }
+      else if (input.mSketchCapacity > 0)
+      {
+         // The value counts are exact, so a sketch is only built for data types with too many values to count
+         kernel.mpSketch = &sketch;
+      }
+   }
+
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   void accumulateTile(InterleaveTraits<Interleave>, T* pData, DataAccessor& da, const std::vector<size_t>& bands,
+                       unsigned int firstRow, unsigned int columnCount, int resolution,
+                       const StatisticsKernel& kernel, PartialStatistics& stats, size_t& rowCount)
+   {
+      std::vector<TileView<T, Interleave> > tiles;
+      for (std::vector<size_t>::const_iterator iter = bands.begin(); iter != bands.end(); ++iter)
+      {
+         tiles.push_back(da->getTileView<T, Interleave>(*iter));
+      }
+
+      rowCount = tiles.empty() ? 0 : tiles.front().getRowCount();
+      for (size_t row = 0; row < rowCount; ++row)
+      {
+         // The mask selects every nth pixel of the band in row major order
+         size_t step = static_cast<size_t>(resolution);
+         uint64_t pixel = static_cast<uint64_t>(firstRow + row) * columnCount;
+         size_t firstColumn = static_cast<size_t>((step - pixel % step) % step);
+         for (size_t tile = 0; tile < tiles.size(); ++tile)
+         {
+            accumulateRow(tiles[tile].getRowView(row), firstColumn, step, kernel, stats);
+         }
+      }
+   }
+
+   template<typename T>
+   void accumulateTile(T* pData, DataAccessor& da, InterleaveFormatType interleave, const std::vector<size_t>& bands,
+                       unsigned int firstRow, unsigned int columnCount, int resolution,
+                       const StatisticsKernel& kernel, PartialStatistics& stats, size_t& rowCount)
+   {
+      rowCount = 0;
+      switchOnInterleave(interleave, accumulateTile, pData, da, bands, firstRow, columnCount, resolution,
+         kernel, stats, rowCount);
+   }
+
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   void accumulateBand(InterleaveTraits<Interleave>, T* pRow, size_t columns, size_t bands, size_t band,
+                       const StatisticsKernel& kernel, PartialStatistics& stats)
+   {
+      RowView<T, Interleave> row(pRow + InterleaveTraits<Interleave>::getBandOffset(band, columns), columns, bands);
+      accumulateRow(row, 0, 1, kernel, stats);
+   }
+
+   template<typename T>
+   void accumulateBand(T* pRow, InterleaveFormatType interleave, size_t columns, size_t bands, size_t band,
+                       const StatisticsKernel& kernel, PartialStatistics& stats)
+   {
+      switchOnInterleave(interleave, accumulateBand, pRow, columns, bands, band, kernel, stats);
+   }
+}
+
 StatisticsImp::StatisticsImp(const RasterElementImp* pRasterElement,
                              DimensionDescriptor band,
                              AoiElement* pAoi) :
@@ -335,6 +630,45 @@ void StatisticsImp::getHistogram(const double*& pBinCenters, const unsigned int*
    pHistogramCounts = &histogramValues[0];
 }
 
+void StatisticsImp::setQuantileSketch(const QuantileSketch& sketch)
+{
+   setQuantileSketch(sketch, COMPLEX_MAGNITUDE);
+}
+
+void StatisticsImp::setQuantileSketch(const QuantileSketch& sketch, ComplexComponent component)
+{
+   mQuantileSketches.erase(component);
+   mQuantileSketches.insert(std::make_pair(component, sketch));
+}
+
+const QuantileSketch* StatisticsImp::getQuantileSketch()
+{
+   return getQuantileSketch(COMPLEX_MAGNITUDE);
+}
+
+const QuantileSketch* StatisticsImp::getQuantileSketch(ComplexComponent component)
+{
+   std::map<ComplexComponent, QuantileSketch>::const_iterator iter = mQuantileSketches.find(component);
+   if (iter == mQuantileSketches.end())
+   {
+      // Statistics which were set directly do not have a sketch, so only calculate missing statistics
+      if (areStatisticsCalculated(component))
+      {
+         return NULL;
+      }
+
+      calculateStatistics(component);
+
+      iter = mQuantileSketches.find(component);
+      if (iter == mQuantileSketches.end())
+      {
+         return NULL;
+      }
+   }
+
+   return &iter->second;
+}
+
 void StatisticsImp::setStatisticsResolution(int resolution)
 {
    if (resolution < 0)
@@ -456,6 +790,7 @@ void StatisticsImp::reset(ComplexComponent component)
    mPercentileValues.erase(component);
    mHistogramValues.erase(component);
    mBinCenterValues.erase(component);
+   mQuantileSketches.erase(component);
 }
 
 void StatisticsImp::resetAll()
@@ -467,6 +802,7 @@ void StatisticsImp::resetAll()
    mPercentileValues.clear();
    mHistogramValues.clear();
    mBinCenterValues.clear();
+   mQuantileSketches.clear();
 }
 
 bool StatisticsImp::toXml(XMLWriter* pXml) const
@@ -731,8 +1067,10 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
       pMask->intersect(*(mpAoi->getSelectedPoints()));
    }
 
+   // Without an AOI, the pixels selected by the resolution are computed by each thread instead of iterated
    StatisticsInput statInput(mBands, dynamic_cast<const RasterElement*>(mpRasterElement),
-      component, mStatisticsResolution, &mBadValues, pMask.get());
+      component, mStatisticsResolution, &mBadValues, pMask.get(), mpAoi.get() == NULL,
+      Statistics::getSettingSketchCapacity());
    StatisticsOutput statOutput;
 
    mta::StatusBarReporter barReporter("Computing statistics", "app", "CF884AA2-A1BF-468d-9609-795DE0F7B7A4");
@@ -762,10 +1100,30 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
       HistogramInput histInput(statInput, statOutput);
       HistogramOutput histOutput(bInteger, statOutput.mMaximum, statOutput.mMinimum);
 
-      mta::MultiThreadedAlgorithm<HistogramInput, HistogramOutput, HistogramThread> histogramAlgorithm
-         (getNumRequiredThreads(pDescriptor->getRowCount()), histInput, histOutput, &progressReporter);
+      bool success = false;
+      int valueOffset = 0;
+      unsigned int valueCount = 0;
+      if (statOutput.mValueCounts.empty() == false && getValueCountRange(encoding, valueOffset, valueCount) &&
+         statOutput.mValueCounts.size() == valueCount)
+      {
+         // Each value was counted while computing the statistics, so the data does not need to be read again
+         success = histOutput.compileValueCounts(statOutput.mValueCounts, valueOffset);
+         progressReporter.reportProgress(100);
+      }
+      else if (statOutput.mHasSketch)
+      {
+         // The histogram is approximated from the sketch which was built while computing the statistics
+         success = histOutput.compileSketch(statOutput.mSketch);
+         progressReporter.reportProgress(100);
+      }
+      else
+      {
+         mta::MultiThreadedAlgorithm<HistogramInput, HistogramOutput, HistogramThread> histogramAlgorithm
+            (getNumRequiredThreads(pDescriptor->getRowCount()), histInput, histOutput, &progressReporter);
+         success = (histogramAlgorithm.run() == mta::SUCCESS);
+      }
 
-      if (histogramAlgorithm.run() == mta::SUCCESS)
+      if (success)
       {
          setMin(statOutput.mMinimum, component);
          setMax(statOutput.mMaximum, component);
@@ -773,6 +1131,10 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
          setStandardDeviation(statOutput.mStandardDeviation, component);
          setPercentiles(histOutput.getPercentiles(), component);
          setHistogram(histOutput.getBinCenters(), histOutput.getBinCounts(), component);
+         if (statOutput.mHasSketch)
+         {
+            setQuantileSketch(statOutput.mSketch, component);
+         }
       }
    }
    else
@@ -788,6 +1150,179 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
    }
 }
 
+StatisticsAccumulator::StatisticsAccumulator(EncodingType encoding, const BadValues* pBadValues,
+                                             unsigned int sketchCapacity) :
+   mEncoding(encoding),
+   mpBadValues(NULL),
+   mBadValueLower(0.0),
+   mBadValueUpper(0.0),
+   mMinimum(std::numeric_limits<double>::max()),
+   mMaximum(-std::numeric_limits<double>::max()),
+   mSum(0.0),
+   mSumSquared(0.0),
+   mCount(0),
+   mValueOffset(0),
+   mValueCountSize(0),
+   mHasSketch(sketchCapacity > 0),
+   mSketch(sketchCapacity)
+{
+   if (pBadValues != NULL && pBadValues->empty() == false)
+   {
+      if (pBadValues->getSingleBadValueRange(mBadValueLower, mBadValueUpper) == false)
+      {
+         mpBadValues = pBadValues;
+      }
+   }
+
+   // The value counts are exact, so a sketch is only built for data types with too many values to count
+   if (getValueCountRange(encoding, mValueOffset, mValueCountSize))
+   {
+      mHasSketch = false;
+   }
+}
+
+size_t StatisticsAccumulator::getValueCountBytes(EncodingType encoding)
+{
+   int offset = 0;
+   unsigned int count = 0;
+   getValueCountRange(encoding, offset, count);
+   return count * sizeof(unsigned int);
+}
+
+bool StatisticsAccumulator::canCompleteStatistics() const
+{
+   return mValueCountSize > 0 || mHasSketch;
+}
+
+void StatisticsAccumulator::addRow(const void* pRow, InterleaveFormatType interleave, size_t columns, size_t bands,
+                                   size_t band)
+{
+   if (pRow == NULL)
+   {
+      return;
+   }
+
+   // Only the magnitude of complex data is accumulated, which matches the statistics component set by apply()
+   StatisticsKernel kernel;
+   kernel.mComponent = COMPLEX_MAGNITUDE;
+   kernel.mpBadValues = mpBadValues;
+   kernel.mBadValueLower = mBadValueLower;
+   kernel.mBadValueUpper = mBadValueUpper;
+   if (mValueCountSize > 0)
+   {
+      mValueCounts.resize(mValueCountSize, 0);
+      kernel.mpValueCounts = &mValueCounts.front();
+      kernel.mValueOffset = mValueOffset;
+   }
+
+   if (mHasSketch)
+   {
+      kernel.mpSketch = &mSketch;
+   }
+
+   PartialStatistics stats;
+   stats.mMinimum = mMinimum;
+   stats.mMaximum = mMaximum;
+   switchOnComplexEncoding(mEncoding, accumulateBand, pRow, interleave, columns, bands, band, kernel, stats);
+
+   mMinimum = stats.mMinimum;
+   mMaximum = stats.mMaximum;
+   mSum += stats.mSum;
+   mSumSquared += stats.mSumSquared;
+   mCount += stats.mCount;
+}
+
+void StatisticsAccumulator::merge(const StatisticsAccumulator& accumulator)
+{
+   mMinimum = std::min(mMinimum, accumulator.mMinimum);
+   mMaximum = std::max(mMaximum, accumulator.mMaximum);
+   mSum += accumulator.mSum;
+   mSumSquared += accumulator.mSumSquared;
+   mCount += accumulator.mCount;
+
+   if (accumulator.mValueCounts.empty() == false)
+   {
+      mValueCounts.resize(accumulator.mValueCounts.size(), 0);
+      transform(mValueCounts.begin(), mValueCounts.end(),
+         accumulator.mValueCounts.begin(), mValueCounts.begin(), std::plus<unsigned int>());
+   }
+
+   if (mHasSketch && accumulator.mHasSketch)
+   {
+      mSketch.merge(accumulator.mSketch);
+   }
+}
+
+bool StatisticsAccumulator::apply(StatisticsImp* pStatistics) const
+{
+   VERIFY(pStatistics != NULL);
+   if (canCompleteStatistics() == false)
+   {
+      return false;
+   }
+
+   const ComplexComponent component = COMPLEX_MAGNITUDE;
+   pStatistics->reset(component);
+
+   double average = 0.0;
+   double standardDeviation = 0.0;
+   if (mCount > 0)
+   {
+      average = mSum / mCount;
+   }
+
+   if (mCount > 1)
+   {
+      // the fabs() on the next line prevents roundoff error from giving sqrt a negative
+      // when every pixel has the same value
+      double numerator = fabs(mCount * mSumSquared - mSum * mSum);
+      standardDeviation = sqrt((numerator / mCount) / (mCount - 1));
+   }
+
+   if (mCount == 0)
+   {
+      pStatistics->setMin(0.0, component);
+      pStatistics->setMax(0.0, component);
+      pStatistics->setAverage(average, component);
+      pStatistics->setStandardDeviation(standardDeviation, component);
+      std::vector<double> dzeroes(1001, 0.0);
+      std::vector<unsigned int> uizeroes(256, 0);
+      pStatistics->setPercentiles(&dzeroes.front(), component);
+      pStatistics->setHistogram(&dzeroes.front(), &uizeroes.front(), component);
+      return true;
+   }
+
+   bool bInteger = (mEncoding != FLT4BYTES && mEncoding != FLT8COMPLEX && mEncoding != FLT8BYTES &&
+      mEncoding != INT4SCOMPLEX);
+   HistogramOutput histOutput(bInteger, mMaximum, mMinimum);
+
+   bool success = false;
+   if (mValueCounts.empty() == false)
+   {
+      success = histOutput.compileValueCounts(mValueCounts, mValueOffset);
+   }
+   else if (mHasSketch)
+   {
+      success = histOutput.compileSketch(mSketch);
+   }
+
+   if (success)
+   {
+      pStatistics->setMin(mMinimum, component);
+      pStatistics->setMax(mMaximum, component);
+      pStatistics->setAverage(average, component);
+      pStatistics->setStandardDeviation(standardDeviation, component);
+      pStatistics->setPercentiles(histOutput.getPercentiles(), component);
+      pStatistics->setHistogram(histOutput.getBinCenters(), histOutput.getBinCounts(), component);
+      if (mHasSketch)
+      {
+         pStatistics->setQuantileSketch(mSketch, component);
+      }
+   }
+
+   return success;
+}
+
 StatisticsThread::StatisticsThread(const StatisticsInput& input, int threadCount, int threadIndex,
                                    ThreadReporter& reporter) :
    AlgorithmThread(threadIndex, reporter),
@@ -799,25 +1334,37 @@ StatisticsThread::StatisticsThread(const StatisticsInput& input, int threadCount
    mMinimum(std::numeric_limits<double>::max()),
    mSum(0.0),
    mSumSquared(0.0),
-   mCount(0)
+   mCount(0),
+   mSketch(input.mSketchCapacity)
 {}
 
 void StatisticsThread::run()
 {
+   mMaxMinSet = false;
+   mSum = 0.0;
+   mSumSquared = 0.0;
+   mCount = 0;
+   mValueCounts.clear();
+   mSketch.clear();
+
+   if (mInput.mRegularMask)
+   {
+      runRegular();
+      return;
+   }
+
    const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
       mInput.mpRasterElement->getDataDescriptor());
    VERIFYNRV(pDescriptor != NULL);
 
    BitMaskIterator diter(mInput.mpAoi, 0, mRowRange.mFirst, pDescriptor->getColumnCount() - 1, mRowRange.mLast);
 
-   mMaxMinSet = false;
-   mSum = 0.0;
-   mSumSquared = 0.0;
-   mCount = 0;
-
    EncodingType encoding = pDescriptor->getDataType();
    ComplexComponent component = mInput.mComplexComponent;
 
+   StatisticsKernel kernel;
+   initializeKernel(mInput, encoding, mValueCounts, mSketch, kernel);
+
    int oldPercentDone = -1;
 
    bool hasBadValues = mInput.mpBadValues != NULL && mInput.mpBadValues->empty() == false;
@@ -915,6 +1462,14 @@ void StatisticsThread::run()
                mSumSquared += temp*temp;
                mSum += temp;
                mCount++;
+               if (kernel.mpValueCounts != NULL)
+               {
+                  kernel.mpValueCounts[static_cast<int>(temp) - kernel.mValueOffset]++;
+               }
+               if (kernel.mpSketch != NULL)
+               {
+                  kernel.mpSketch->add(temp);
+               }
                if (!isBip)
                {
                   // this inner band loop is only for BIP
@@ -933,6 +1488,96 @@ void StatisticsThread::run()
    }
 }
 
+void StatisticsThread::runRegular()
+{
+   const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpRasterElement->getDataDescriptor());
+   VERIFYNRV(pDescriptor != NULL);
+
+   if (mRowRange.mFirst > mRowRange.mLast)
+   {
+      return;
+   }
+
+   EncodingType encoding = pDescriptor->getDataType();
+   unsigned int columnCount = pDescriptor->getColumnCount();
+
+   StatisticsKernel kernel;
+   initializeKernel(mInput, encoding, mValueCounts, mSketch, kernel);
+
+   // Read every band of BIP data at once, and one band at a time otherwise
+   InterleaveFormatType interleave = pDescriptor->getInterleaveFormat();
+   std::vector<std::vector<size_t> > bandPasses;
+   if (interleave == BIP)
+   {
+      bandPasses.push_back(std::vector<size_t>());
+      for (std::vector<DimensionDescriptor>::const_iterator bandIt = mInput.mBandsToCalculate.begin();
+           bandIt != mInput.mBandsToCalculate.end(); ++bandIt)
+      {
+         bandPasses.back().push_back(bandIt->getActiveNumber());
+      }
+   }
+   else
+   {
+      bandPasses.resize(mInput.mBandsToCalculate.size(), std::vector<size_t>(1, 0));
+   }
+
+   PartialStatistics stats;
+   int oldPercentDone = -1;
+   for (size_t pass = 0; pass < bandPasses.size(); ++pass)
+   {
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setRows(pDescriptor->getActiveRow(mRowRange.mFirst), pDescriptor->getActiveRow(mRowRange.mLast), 0);
+      if (interleave == BIP)
+      {
+         pRequest->setBands(pDescriptor->getActiveBand(0),
+                            pDescriptor->getActiveBand(pDescriptor->getBandCount() - 1),
+                            pDescriptor->getBandCount());
+      }
+      else
+      {
+         const DimensionDescriptor& band = mInput.mBandsToCalculate[pass];
+         pRequest->setBands(band, band, 1);
+      }
+      DataAccessor da(mInput.mpRasterElement->getDataAccessor(pRequest.release()));
+      if (!da.isValid())
+      {
+         return;
+      }
+
+      unsigned int row = mRowRange.mFirst;
+      while (row <= static_cast<unsigned int>(mRowRange.mLast))
+      {
+         int percentDone = mRowRange.computePercent(static_cast<int>(row));
+         if (percentDone >= oldPercentDone + 25)
+         {
+            oldPercentDone = percentDone;
+            getReporter().reportProgress(getThreadIndex(), percentDone);
+         }
+
+         VERIFYNRV(da.isValid());
+         size_t rowCount = 0;
+         switchOnComplexEncoding(encoding, accumulateTile, NULL, da, interleave, bandPasses[pass], row, columnCount,
+            mInput.mResolution, kernel, stats, rowCount);
+         VERIFYNRV(rowCount > 0);
+
+         row += static_cast<unsigned int>(rowCount);
+         da->nextRow(static_cast<int>(rowCount));
+      }
+   }
+
+   if (stats.mCount > 0)
+   {
+      mMaxMinSet = true;
+      mMinimum = stats.mMinimum;
+      mMaximum = stats.mMaximum;
+   }
+
+   mSum = stats.mSum;
+   mSumSquared = stats.mSumSquared;
+   mCount = stats.mCount;
+}
+
 bool StatisticsThread::isMaxMinSet() const
 {
    return mMaxMinSet;
@@ -963,12 +1608,23 @@ unsigned int StatisticsThread::getCount() const
    return mCount;
 }
 
+const std::vector<unsigned int>& StatisticsThread::getValueCounts() const
+{
+   return mValueCounts;
+}
+
+const QuantileSketch* StatisticsThread::getSketch() const
+{
+   return (mInput.mSketchCapacity > 0 && mValueCounts.empty()) ? &mSketch : NULL;
+}
+
 StatisticsOutput::StatisticsOutput() :
    mMaxMinSet(false),
    mMaximum(-std::numeric_limits<double>::max()),
    mMinimum(std::numeric_limits<double>::max()),
    mAverage(0.0),
-   mStandardDeviation(0.0)
+   mStandardDeviation(0.0),
+   mHasSketch(false)
 {}
 
 bool StatisticsOutput::compileOverallResults(const std::vector<StatisticsThread*>& threads)
@@ -978,12 +1634,18 @@ bool StatisticsOutput::compileOverallResults(const std::vector<StatisticsThread*
    mMinimum = std::numeric_limits<double>::max();
    mAverage = 0.0;
    mStandardDeviation = 0.0;
+   mValueCounts.clear();
+   mHasSketch = false;
+   mSketch.clear();
 
    if (threads.size() == 0)
    {
       return false;
    }
 
+   // The value counts can only replace the histogram pass if every thread counted its values
+   bool hasValueCounts = true;
+
    double totalSum = 0.0;
    double totalSquaredSum = 0.0;
    unsigned int pointCount = 0;
@@ -1002,9 +1664,44 @@ bool StatisticsOutput::compileOverallResults(const std::vector<StatisticsThread*
          totalSum += pThread->getSum();
          totalSquaredSum += pThread->getSumSquared();
          pointCount += pThread->getCount();
+
+         const std::vector<unsigned int>& valueCounts = pThread->getValueCounts();
+         if (valueCounts.empty() || (mValueCounts.empty() == false && valueCounts.size() != mValueCounts.size()))
+         {
+            hasValueCounts = false;
+         }
+         else if (hasValueCounts)
+         {
+            mValueCounts.resize(valueCounts.size(), 0);
+            transform(mValueCounts.begin(), mValueCounts.end(),
+               valueCounts.begin(), mValueCounts.begin(), std::plus<unsigned int>());
+         }
+
+         const QuantileSketch* pSketch = pThread->getSketch();
+         if (pSketch != NULL)
+         {
+            if (mHasSketch)
+            {
+               mSketch.merge(*pSketch);
+            }
+            else
+            {
+               mSketch = *pSketch;
+               mHasSketch = true;
+            }
+         }
+      }
+      else
+      {
+         hasValueCounts = false;
       }
    }
 
+   if (hasValueCounts == false)
+   {
+      mValueCounts.clear();
+   }
+
    if (pointCount > 0)
    {
       mAverage = totalSum / pointCount;
@@ -1035,14 +1732,7 @@ HistogramThread::HistogramThread(const HistogramInput& input,
 
 void HistogramThread::run()
 {
-   double range = 1.0;
-   double toBin = 0.0;
-   
-   if (mInput.mStatistics.mMaximum != mInput.mStatistics.mMinimum)
-   {
-      range = mInput.mStatistics.mMaximum - mInput.mStatistics.mMinimum;
-      toBin = 0.999999999 * (HISTOGRAM_SIZE)/range;
-   }
+   double toBin = getHistogramScale(mInput.mStatistics.mMinimum, mInput.mStatistics.mMaximum);
 
    std::vector<unsigned int>& binCounts = getBinCounts();
 
@@ -1132,17 +1822,7 @@ void HistogramThread::run()
 
             if (!badValue)
             {
-               int bin = static_cast<int>((temp-mInput.mStatistics.mMinimum) * toBin);
-               if (bin >= HISTOGRAM_SIZE)
-               {
-                  bin = HISTOGRAM_SIZE - 1;
-               }
-               else if (bin < 0)
-               {
-                  bin = 0;
-               }
-
-               binCounts[bin]++;
+               binCounts[getHistogramBin(temp, mInput.mStatistics.mMinimum, toBin)]++;
                mCount++;
             }
             if (!isBip)
@@ -1179,6 +1859,46 @@ bool HistogramOutput::compileOverallResults(const std::vector<HistogramThread*>&
    return true;
 }
 
+bool HistogramOutput::compileValueCounts(const std::vector<unsigned int>& valueCounts, int valueOffset)
+{
+   std::vector<unsigned int> totalBinCounts(HISTOGRAM_SIZE);
+
+   double toBin = getHistogramScale(mMinimum, mMaximum);
+   for (size_t index = 0; index < valueCounts.size(); ++index)
+   {
+      if (valueCounts[index] > 0)
+      {
+         double value = static_cast<double>(static_cast<int>(index) + valueOffset);
+         totalBinCounts[getHistogramBin(value, mMinimum, toBin)] += valueCounts[index];
+      }
+   }
+
+   computeBinCenters();
+   computeResultHistogram(totalBinCounts);
+   computePercentiles(totalBinCounts);
+
+   return true;
+}
+
+bool HistogramOutput::compileSketch(const QuantileSketch& sketch)
+{
+   std::vector<unsigned int> totalBinCounts(HISTOGRAM_SIZE);
+
+   // Each retained value represents a power of two of the values added to the sketch
+   double toBin = getHistogramScale(mMinimum, mMaximum);
+   const std::vector<std::pair<double, uint64_t> >& values = sketch.getWeightedValues();
+   for (std::vector<std::pair<double, uint64_t> >::const_iterator iter = values.begin(); iter != values.end(); ++iter)
+   {
+      totalBinCounts[getHistogramBin(iter->first, mMinimum, toBin)] += static_cast<unsigned int>(iter->second);
+   }
+
+   computeBinCenters();
+   computeResultHistogram(totalBinCounts);
+   computePercentiles(totalBinCounts);
+
+   return true;
+}
+
 const double* HistogramOutput::getBinCenters() const
 {
    return mBinCenters;
@@ -17,8 +17,10 @@
 #include "DimensionDescriptor.h"
 #include "MultiThreadedAlgorithm.h"
 #include "ObjectResource.h"
+#include "QuantileSketch.h"
 #include "SafePtr.h"
 #include "Statistics.h"
+#include "TypesFile.h"
 
 #include <boost/any.hpp>
 #include <map>
@@ -67,6 +69,11 @@ public:
    void getHistogram(const double*& pBinCenters, const unsigned int*& pHistogramCounts,
       ComplexComponent component);
 
+   void setQuantileSketch(const QuantileSketch& sketch);
+   void setQuantileSketch(const QuantileSketch& sketch, ComplexComponent component);
+   const QuantileSketch* getQuantileSketch();
+   const QuantileSketch* getQuantileSketch(ComplexComponent component);
+
    void setStatisticsResolution(int resolution);
    int getStatisticsResolution() const;
 
@@ -105,24 +112,81 @@ private:
    std::map<ComplexComponent, std::vector<double> > mPercentileValues;
    std::map<ComplexComponent, std::vector<double> > mBinCenterValues;
    std::map<ComplexComponent, std::vector<unsigned int> > mHistogramValues;
+   std::map<ComplexComponent, QuantileSketch> mQuantileSketches;
 
    int mStatisticsResolution;
    BadValuesAdapter mBadValues;
 };
 
+/**
+ * Accumulates the statistics of a band from rows which are visited once, such as while the
+ * data is being imported, so that the statistics do not require another pass over the data.
+ *
+ * Accumulators for different rows of the same band can be merged.  Only the magnitude of
+ * complex data is accumulated.
+ */
+class StatisticsAccumulator
+{
+public:
+   StatisticsAccumulator(EncodingType encoding, const BadValues* pBadValues, unsigned int sketchCapacity);
+
+   /**
+    * Returns the approximate number of bytes used by the value counts of an accumulator.
+    */
+   static size_t getValueCountBytes(EncodingType encoding);
+
+   /**
+    * Returns whether the histogram and percentiles can be computed from the accumulated
+    * values, which requires either a small integer data type or a sketch.
+    */
+   bool canCompleteStatistics() const;
+
+   void addRow(const void* pRow, InterleaveFormatType interleave, size_t columns, size_t bands, size_t band);
+   void merge(const StatisticsAccumulator& accumulator);
+
+   /**
+    * Sets the magnitude statistics of a band from the accumulated values.
+    *
+    * @return Returns \c false without changing the statistics if canCompleteStatistics()
+    *         returns \c false.
+    */
+   bool apply(StatisticsImp* pStatistics) const;
+
+private:
+   EncodingType mEncoding;
+   const BadValues* mpBadValues;    // Only set if the bad values cannot be tested as a single range
+   double mBadValueLower;
+   double mBadValueUpper;
+
+   double mMinimum;
+   double mMaximum;
+   double mSum;
+   double mSumSquared;
+   unsigned int mCount;
+
+   // The value counts are allocated when the first row is added
+   std::vector<unsigned int> mValueCounts;
+   int mValueOffset;
+   unsigned int mValueCountSize;
+   bool mHasSketch;
+   QuantileSketch mSketch;
+};
+
 class StatisticsInput
 {
 public:
    StatisticsInput(const std::vector<DimensionDescriptor>& bandsToCalculate, const RasterElement* pRaster,
                    ComplexComponent component, int resolution = 1,
                    const BadValues* pBadValues = NULL,
-                   const BitMask* pAoi = NULL) :
+                   const BitMask* pAoi = NULL, bool regularMask = false, unsigned int sketchCapacity = 0) :
       mBandsToCalculate(bandsToCalculate),
       mpRasterElement(pRaster),
       mComplexComponent(component),
       mResolution(resolution),
       mpBadValues(pBadValues),
-      mpAoi(pAoi)
+      mpAoi(pAoi),
+      mRegularMask(regularMask),
+      mSketchCapacity(sketchCapacity)
    {
    }
 
@@ -133,6 +197,12 @@ public:
    const BadValues* mpBadValues;
    const BitMask* mpAoi;
 
+   // true if mpAoi only selects every mResolution pixel, so the pixels can be computed instead of iterated
+   bool mRegularMask;
+
+   // The capacity of the QuantileSketch built by each thread, or 0 to not build a sketch
+   unsigned int mSketchCapacity;
+
 private:
    StatisticsInput& operator=(const StatisticsInput& rhs);
 };
@@ -148,6 +218,9 @@ public:
    double mMinimum;
    double mAverage;
    double mStandardDeviation;
+   std::vector<unsigned int> mValueCounts;
+   bool mHasSketch;
+   QuantileSketch mSketch;
    bool compileOverallResults(const std::vector<StatisticsThread*>& threads);
 };
 
@@ -165,10 +238,14 @@ public:
    double getSum() const;
    double getSumSquared() const;
    unsigned int getCount() const;
+   const std::vector<unsigned int>& getValueCounts() const;
+   const QuantileSketch* getSketch() const;
 
 private:
    StatisticsThread& operator=(const StatisticsThread& rhs);
 
+   void runRegular();
+
    const StatisticsInput& mInput;
 
    Range mRowRange;
@@ -178,6 +255,8 @@ private:
    double mSum;
    double mSumSquared;
    unsigned int mCount;
+   std::vector<unsigned int> mValueCounts;
+   QuantileSketch mSketch;
 };
 
 class HistogramInput
@@ -201,6 +280,8 @@ public:
       mIsInteger(isInteger), mMaximum(maximum), mMinimum(minimum) {}
 
    bool compileOverallResults(const std::vector<HistogramThread*>& threads);
+   bool compileValueCounts(const std::vector<unsigned int>& valueCounts, int valueOffset);
+   bool compileSketch(const QuantileSketch& sketch);
    const double* getBinCenters() const;
    const unsigned int* getBinCounts() const;
    const double* getPercentiles() const;
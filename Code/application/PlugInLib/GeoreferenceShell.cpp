@@ -10,19 +10,486 @@
 #include "AppVerify.h"
 #include "GeoreferenceDescriptor.h"
 #include "GeoreferenceShell.h"
+#include "MultiThreadedAlgorithm.h"
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
+#include "SessionItemDeserializer.h"
+#include "SessionItemSerializer.h"
 
-GeoreferenceShell::GeoreferenceShell()
+#include <map>
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+   // The minimum number of coordinates converted by each thread
+   const size_t MINIMUM_THREAD_CONVERSIONS = 4096;
+
+   struct ConversionInput
+   {
+      const GeoreferenceShell* mpGeoreference;
+      bool mToGeocoords;
+      const LocationType* mpSource;
+      LocationType* mpDestination;
+      size_t mCount;
+      bool mQuick;
+      bool mCheckAccuracy;
+   };
+
+   class ConversionThread : public mta::AlgorithmThread
+   {
+   public:
+      ConversionThread(const ConversionInput& input, int threadCount, int threadIndex,
+         mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mRange(getThreadRange(threadCount, static_cast<int>(input.mCount))),
+         mAccurate(true)
+      {
+      }
+
+      void run()
+      {
+         if (mRange.mFirst > mRange.mLast)
+         {
+            return;
+         }
+
+         const LocationType* pSource = mInput.mpSource + mRange.mFirst;
+         LocationType* pDestination = mInput.mpDestination + mRange.mFirst;
+         size_t count = static_cast<size_t>(mRange.mLast - mRange.mFirst + 1);
+         bool* pAccurate = (mInput.mCheckAccuracy ? &mAccurate : NULL);
+         if (mInput.mToGeocoords)
+         {
+            mInput.mpGeoreference->convertPixelsToGeocoords(pSource, count, pDestination, mInput.mQuick, pAccurate);
+         }
+         else
+         {
+            mInput.mpGeoreference->convertGeocoordsToPixels(pSource, count, pDestination, mInput.mQuick, pAccurate);
+         }
+      }
+
+      bool isAccurate() const
+      {
+         return mAccurate;
+      }
+
+   private:
+      ConversionThread& operator=(const ConversionThread& rhs);
+
+      const ConversionInput& mInput;
+      mta::AlgorithmThread::Range mRange;
+      bool mAccurate;
+   };
+
+   struct ConversionOutput
+   {
+      ConversionOutput() :
+         mAccurate(true)
+      {
+      }
+
+      bool compileOverallResults(const std::vector<ConversionThread*>& threads)
+      {
+         for (std::vector<ConversionThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+         {
+            mAccurate = mAccurate && (*iter)->isAccurate();
+         }
+
+         return true;
+      }
+
+      bool mAccurate;
+   };
+
+   // The approximation grid is divided at least this many times so that the exact model is tested throughout the scene
+   const unsigned int MINIMUM_GRID_DEPTH = 3;
+   const unsigned int MAXIMUM_GRID_DEPTH = 20;
+   const size_t MAXIMUM_GRID_CELLS = 1 << 18;
+
+   const unsigned int GRID_VERSION = 2;
+   const size_t GRID_CELL_BYTES = 4 * sizeof(double) + 3 * sizeof(int) + 8 * sizeof(double);
+
+   template<typename T>
+   void appendValue(std::vector<unsigned char>& data, T value)
+   {
+      const unsigned char* pValue = reinterpret_cast<const unsigned char*>(&value);
+      data.insert(data.end(), pValue, pValue + sizeof(T));
+   }
+
+   template<typename T>
+   T extractValue(const unsigned char*& pData)
+   {
+      T value;
+      memcpy(&value, pData, sizeof(T));
+      pData += sizeof(T);
+      return value;
+   }
+
+   void convert(const GeoreferenceShell* pGeoreference, bool toGeocoords, bool concurrent,
+      const std::vector<LocationType>& source, std::vector<LocationType>& destination, bool quick, bool* pAccurate)
+   {
+      if (pAccurate != NULL)
+      {
+         *pAccurate = true;
+      }
+
+      destination.resize(source.size());
+      if (source.empty() == true)
+      {
+         return;
+      }
+
+      if (concurrent == true && source.size() >= 2 * MINIMUM_THREAD_CONVERSIONS)
+      {
+         ConversionInput input;
+         input.mpGeoreference = pGeoreference;
+         input.mToGeocoords = toGeocoords;
+         input.mpSource = &source.front();
+         input.mpDestination = &destination.front();
+         input.mCount = source.size();
+         input.mQuick = quick;
+         input.mCheckAccuracy = (pAccurate != NULL);
+
+         ConversionOutput output;
+         unsigned int chunks = static_cast<unsigned int>(source.size() / MINIMUM_THREAD_CONVERSIONS);
+         mta::MultiThreadedAlgorithm<ConversionInput, ConversionOutput, ConversionThread>
+            algorithm(mta::getNumRequiredThreads(chunks), input, output, NULL);
+         if (algorithm.run() == mta::SUCCESS)
+         {
+            if (pAccurate != NULL)
+            {
+               *pAccurate = output.mAccurate;
+            }
+
+            return;
+         }
+
+         if (pAccurate != NULL)
+         {
+            *pAccurate = true;
+         }
+      }
+
+      if (toGeocoords)
+      {
+         pGeoreference->convertPixelsToGeocoords(&source.front(), source.size(), &destination.front(), quick,
+            pAccurate);
+      }
+      else
+      {
+         pGeoreference->convertGeocoordsToPixels(&source.front(), source.size(), &destination.front(), quick,
+            pAccurate);
+      }
+   }
+}
+
+class GeoreferenceShell::ApproximationGrid
+{
+public:
+   bool build(const Georeference& georeference, unsigned int columns, unsigned int rows, double tolerance);
+   bool interpolate(LocationType pixel, LocationType& geocoord, bool& accurate) const;
+
+   void clear()
+   {
+      mCells.clear();
+   }
+
+   bool empty() const
+   {
+      return mCells.empty();
+   }
+
+   void serialize(std::vector<unsigned char>& data) const;
+   bool deserialize(SessionItemDeserializer& deserializer);
+
+private:
+   struct Sample
+   {
+      LocationType mGeocoord;
+      bool mAccurate;
+   };
+
+   // The corners are ordered (min x, min y), (max x, min y), (min x, max y), (max x, max y), as are the children
+   struct Cell
+   {
+      double mMinX;
+      double mMinY;
+      double mMaxX;
+      double mMaxY;
+      int mFirstChild;
+      bool mAccurate;
+      bool mUseModel;    // Set if the cell cannot be divided but still exceeds the tolerance
+      LocationType mCorners[4];
+   };
+
+   typedef std::map<std::pair<double, double>, Sample> SampleMap;
+
+   const Sample& getSample(double x, double y);
+   void addCell(double minX, double minY, double maxX, double maxY);
+   bool refine(size_t index, unsigned int depth);
+   static LocationType interpolate(const Cell& cell, double x, double y);
+
+   std::vector<Cell> mCells;
+
+   // Only used while the grid is being built
+   const Georeference* mpGeoreference;
+   double mTolerance;
+   SampleMap mSamples;
+};
+
+bool GeoreferenceShell::ApproximationGrid::build(const Georeference& georeference, unsigned int columns,
+                                                 unsigned int rows, double tolerance)
+{
+   mCells.clear();
+   if (columns == 0 || rows == 0 || (tolerance > 0.0) == false)
+   {
+      return false;
+   }
+
+   mpGeoreference = &georeference;
+   mTolerance = tolerance;
+   addCell(0.0, 0.0, static_cast<double>(columns), static_cast<double>(rows));
+
+   // Divide the cells one level at a time so that the cell limit is not reached in one part of the scene first
+   bool success = true;
+   std::vector<unsigned int> depths(1, 0);
+   for (size_t index = 0; index < mCells.size() && success == true; ++index)
+   {
+      unsigned int depth = depths[index];
+      if (refine(index, depth) == true)
+      {
+         depths.resize(mCells.size(), depth + 1);
+         success = mCells.size() <= MAXIMUM_GRID_CELLS;
+      }
+   }
+
+   if (success == false)
+   {
+      // The tolerance cannot be met with a grid of a reasonable size
+      mCells.clear();
+   }
+
+   mpGeoreference = NULL;
+   SampleMap().swap(mSamples);
+   return success;
+}
+
+const GeoreferenceShell::ApproximationGrid::Sample& GeoreferenceShell::ApproximationGrid::getSample(double x, double y)
+{
+   // Neighboring cells share corners, so each location is only evaluated once
+   std::pair<SampleMap::iterator, bool> result = mSamples.insert(std::make_pair(std::make_pair(x, y), Sample()));
+   Sample& sample = result.first->second;
+   if (result.second == true)
+   {
+      sample.mAccurate = true;
+      sample.mGeocoord = mpGeoreference->pixelToGeo(LocationType(x, y), &sample.mAccurate);
+   }
+
+   return sample;
+}
+
+void GeoreferenceShell::ApproximationGrid::addCell(double minX, double minY, double maxX, double maxY)
+{
+   Cell cell;
+   cell.mMinX = minX;
+   cell.mMinY = minY;
+   cell.mMaxX = maxX;
+   cell.mMaxY = maxY;
+   cell.mFirstChild = -1;
+   cell.mAccurate = true;
+   cell.mUseModel = false;
+   for (int corner = 0; corner < 4; ++corner)
+   {
+      const Sample& sample = getSample((corner & 1) ? maxX : minX, (corner & 2) ? maxY : minY);
+      cell.mCorners[corner] = sample.mGeocoord;
+      cell.mAccurate = cell.mAccurate && sample.mAccurate;
+   }
+
+   mCells.push_back(cell);
+}
+
+bool GeoreferenceShell::ApproximationGrid::refine(size_t index, unsigned int depth)
+{
+   // Copy the cell since adding cells may reallocate the vector
+   Cell cell = mCells[index];
+   bool canDivide = depth < MAXIMUM_GRID_DEPTH && (cell.mMaxX - cell.mMinX > 1.0 || cell.mMaxY - cell.mMinY > 1.0);
+   double midX = (cell.mMinX + cell.mMaxX) / 2.0;
+   double midY = (cell.mMinY + cell.mMaxY) / 2.0;
+   bool divide = canDivide == true && depth < MINIMUM_GRID_DEPTH;
+   if (divide == false)
+   {
+      // Test the corners and centers of the cells which would be created by dividing the cell, since errors at
+      // the midpoints alone can cancel out
+      double quarterX = (cell.mMinX + midX) / 2.0;
+      double quarterY = (cell.mMinY + midY) / 2.0;
+      double threeQuarterX = (midX + cell.mMaxX) / 2.0;
+      double threeQuarterY = (midY + cell.mMaxY) / 2.0;
+      const double testPoints[9][2] = { {midX, midY}, {midX, cell.mMinY}, {midX, cell.mMaxY},
+         {cell.mMinX, midY}, {cell.mMaxX, midY}, {quarterX, quarterY}, {threeQuarterX, quarterY},
+         {quarterX, threeQuarterY}, {threeQuarterX, threeQuarterY} };
+      for (int i = 0; i < 9 && divide == false; ++i)
+      {
+         const Sample& sample = getSample(testPoints[i][0], testPoints[i][1]);
+         LocationType approximation = interpolate(cell, testPoints[i][0], testPoints[i][1]);
+         divide = fabs(approximation.mX - sample.mGeocoord.mX) > mTolerance ||
+            fabs(approximation.mY - sample.mGeocoord.mY) > mTolerance;
+      }
+   }
+
+   if (divide == false)
+   {
+      return false;
+   }
+
+   if (canDivide == false)
+   {
+      // The model changes too abruptly within the cell to interpolate, such as where the longitude wraps from
+      // +180 to -180, so the exact model is used for every pixel in the cell instead
+      mCells[index].mUseModel = true;
+      return false;
+   }
+
+   size_t firstChild = mCells.size();
+   mCells[index].mFirstChild = static_cast<int>(firstChild);
+   for (int child = 0; child < 4; ++child)
+   {
+      addCell((child & 1) ? midX : cell.mMinX, (child & 2) ? midY : cell.mMinY,
+         (child & 1) ? cell.mMaxX : midX, (child & 2) ? cell.mMaxY : midY);
+   }
+
+   return true;
+}
+
+LocationType GeoreferenceShell::ApproximationGrid::interpolate(const Cell& cell, double x, double y)
+{
+   double u = (x - cell.mMinX) / (cell.mMaxX - cell.mMinX);
+   double v = (y - cell.mMinY) / (cell.mMaxY - cell.mMinY);
+   return cell.mCorners[0] * ((1.0 - u) * (1.0 - v)) + cell.mCorners[1] * (u * (1.0 - v)) +
+      cell.mCorners[2] * ((1.0 - u) * v) + cell.mCorners[3] * (u * v);
+}
+
+bool GeoreferenceShell::ApproximationGrid::interpolate(LocationType pixel, LocationType& geocoord,
+                                                       bool& accurate) const
+{
+   if (mCells.empty() == true)
+   {
+      return false;
+   }
+
+   const Cell* pCell = &mCells.front();
+   if ((pixel.mX >= pCell->mMinX && pixel.mX <= pCell->mMaxX &&
+      pixel.mY >= pCell->mMinY && pixel.mY <= pCell->mMaxY) == false)
+   {
+      return false;
+   }
+
+   while (pCell->mFirstChild >= 0)
+   {
+      double midX = (pCell->mMinX + pCell->mMaxX) / 2.0;
+      double midY = (pCell->mMinY + pCell->mMaxY) / 2.0;
+      int child = (pixel.mX >= midX ? 1 : 0) + (pixel.mY >= midY ? 2 : 0);
+      pCell = &mCells[pCell->mFirstChild + child];
+   }
+
+   if (pCell->mUseModel == true)
+   {
+      return false;
+   }
+
+   geocoord = interpolate(*pCell, pixel.mX, pixel.mY);
+   accurate = pCell->mAccurate;
+   return true;
+}
+
+void GeoreferenceShell::ApproximationGrid::serialize(std::vector<unsigned char>& data) const
+{
+   data.clear();
+   data.reserve(2 * sizeof(unsigned int) + mCells.size() * GRID_CELL_BYTES);
+   appendValue(data, GRID_VERSION);
+   appendValue(data, static_cast<unsigned int>(mCells.size()));
+   for (std::vector<Cell>::const_iterator iter = mCells.begin(); iter != mCells.end(); ++iter)
+   {
+      appendValue(data, iter->mMinX);
+      appendValue(data, iter->mMinY);
+      appendValue(data, iter->mMaxX);
+      appendValue(data, iter->mMaxY);
+      appendValue(data, iter->mFirstChild);
+      appendValue(data, static_cast<int>(iter->mAccurate));
+      appendValue(data, static_cast<int>(iter->mUseModel));
+      for (int corner = 0; corner < 4; ++corner)
+      {
+         appendValue(data, iter->mCorners[corner].mX);
+         appendValue(data, iter->mCorners[corner].mY);
+      }
+   }
+}
+
+bool GeoreferenceShell::ApproximationGrid::deserialize(SessionItemDeserializer& deserializer)
+{
+   mCells.clear();
+
+   unsigned int version = 0;
+   unsigned int cellCount = 0;
+   if (deserializer.deserialize(&version, sizeof(version)) == false || version != GRID_VERSION ||
+      deserializer.deserialize(&cellCount, sizeof(cellCount)) == false || cellCount > MAXIMUM_GRID_CELLS)
+   {
+      return false;
+   }
+
+   std::vector<unsigned char> data(cellCount * GRID_CELL_BYTES);
+   if (data.empty() == false && deserializer.deserialize(data) == false)
+   {
+      return false;
+   }
+
+   const unsigned char* pData = data.empty() ? NULL : &data.front();
+   mCells.resize(cellCount);
+   for (unsigned int index = 0; index < cellCount; ++index)
+   {
+      Cell& cell = mCells[index];
+      cell.mMinX = extractValue<double>(pData);
+      cell.mMinY = extractValue<double>(pData);
+      cell.mMaxX = extractValue<double>(pData);
+      cell.mMaxY = extractValue<double>(pData);
+      cell.mFirstChild = extractValue<int>(pData);
+      cell.mAccurate = (extractValue<int>(pData) != 0);
+      cell.mUseModel = (extractValue<int>(pData) != 0);
+      for (int corner = 0; corner < 4; ++corner)
+      {
+         double x = extractValue<double>(pData);
+         double y = extractValue<double>(pData);
+         cell.mCorners[corner] = LocationType(x, y);
+      }
+
+      // Children are always stored after their parent, which also prevents cycles when interpolating
+      if (cell.mFirstChild >= 0 && (cell.mFirstChild <= static_cast<int>(index) ||
+         static_cast<unsigned int>(cell.mFirstChild) + 4 > cellCount))
+      {
+         mCells.clear();
+         return false;
+      }
+   }
+
+   return true;
+}
+
+GeoreferenceShell::GeoreferenceShell() :
+   mConcurrentConversions(false),
+   mpApproximationGrid(new ApproximationGrid)
 {
    setType(PlugInManagerServices::GeoreferenceType());
    allowMultipleInstances(true);
 }
 
 GeoreferenceShell::~GeoreferenceShell()
-{}
+{
+   delete mpApproximationGrid;
+}
 
 bool GeoreferenceShell::setInteractive()
 {
@@ -58,6 +525,18 @@ bool GeoreferenceShell::getInputSpecification(PlugInArgList*& pArgList)
 
 LocationType GeoreferenceShell::pixelToGeoQuick(LocationType pixel, bool* pAccurate) const
 {
+   LocationType geocoord;
+   bool accurate = false;
+   if (mpApproximationGrid->interpolate(pixel, geocoord, accurate) == true)
+   {
+      if (pAccurate != NULL)
+      {
+         *pAccurate = accurate;
+      }
+
+      return geocoord;
+   }
+
    return pixelToGeo(pixel, pAccurate);
 }
 
@@ -66,6 +545,87 @@ LocationType GeoreferenceShell::geoToPixelQuick(LocationType geo, bool* pAccurat
    return geoToPixel(geo, pAccurate);
 }
 
+void GeoreferenceShell::pixelsToGeocoords(const std::vector<LocationType>& pixels,
+                                          std::vector<LocationType>& geocoords, bool quick, bool* pAccurate) const
+{
+   convert(this, true, mConcurrentConversions, pixels, geocoords, quick, pAccurate);
+}
+
+void GeoreferenceShell::geocoordsToPixels(const std::vector<LocationType>& geocoords,
+                                          std::vector<LocationType>& pixels, bool quick, bool* pAccurate) const
+{
+   convert(this, false, mConcurrentConversions, geocoords, pixels, quick, pAccurate);
+}
+
+void GeoreferenceShell::convertPixelsToGeocoords(const LocationType* pPixels, size_t count,
+                                                 LocationType* pGeocoords, bool quick, bool* pAccurate) const
+{
+   bool accurate = true;
+   for (size_t i = 0; i < count; ++i)
+   {
+      bool* pPointAccurate = (pAccurate != NULL ? &accurate : NULL);
+      pGeocoords[i] = (quick ? pixelToGeoQuick(pPixels[i], pPointAccurate) : pixelToGeo(pPixels[i], pPointAccurate));
+      if (accurate == false)
+      {
+         *pAccurate = false;
+         accurate = true;
+      }
+   }
+}
+
+void GeoreferenceShell::convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count,
+                                                 LocationType* pPixels, bool quick, bool* pAccurate) const
+{
+   bool accurate = true;
+   for (size_t i = 0; i < count; ++i)
+   {
+      bool* pPointAccurate = (pAccurate != NULL ? &accurate : NULL);
+      pPixels[i] = (quick ? geoToPixelQuick(pGeocoords[i], pPointAccurate) : geoToPixel(pGeocoords[i], pPointAccurate));
+      if (accurate == false)
+      {
+         *pAccurate = false;
+         accurate = true;
+      }
+   }
+}
+
+void GeoreferenceShell::allowConcurrentConversions(bool allow)
+{
+   mConcurrentConversions = allow;
+}
+
+bool GeoreferenceShell::areConcurrentConversionsAllowed() const
+{
+   return mConcurrentConversions;
+}
+
+bool GeoreferenceShell::buildApproximationGrid(unsigned int columns, unsigned int rows, double tolerance)
+{
+   return mpApproximationGrid->build(*this, columns, rows, tolerance);
+}
+
+void GeoreferenceShell::clearApproximationGrid()
+{
+   mpApproximationGrid->clear();
+}
+
+bool GeoreferenceShell::hasApproximationGrid() const
+{
+   return mpApproximationGrid->empty() == false;
+}
+
+bool GeoreferenceShell::serializeApproximationGrid(SessionItemSerializer& serializer) const
+{
+   std::vector<unsigned char> data;
+   mpApproximationGrid->serialize(data);
+   return serializer.serialize(data);
+}
+
+bool GeoreferenceShell::deserializeApproximationGrid(SessionItemDeserializer& deserializer)
+{
+   return mpApproximationGrid->deserialize(deserializer);
+}
+
 QWidget* GeoreferenceShell::getWidget(RasterDataDescriptor* pDescriptor)
 {
    return NULL;
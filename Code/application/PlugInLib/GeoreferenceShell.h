@@ -14,6 +14,11 @@
 #include "Georeference.h"
 #include "LocationType.h"
 
+#include <vector>
+
+class SessionItemDeserializer;
+class SessionItemSerializer;
+
 /**
  *  \ingroup ShellModule
  */
@@ -65,7 +70,10 @@ public:
    /**
     *  @copydoc Georeference::pixelToGeoQuick()
     *
-    *  @default The default implementation calls pixelToGeo().
+    *  @default The default implementation interpolates the approximation grid
+    *           if one was built with buildApproximationGrid() and the pixel is
+    *           inside of it.  Otherwise, the default implementation calls
+    *           pixelToGeo().
     */
    LocationType pixelToGeoQuick(LocationType pixel, bool* pAccurate = NULL) const;
 
@@ -76,6 +84,85 @@ public:
     */
    LocationType geoToPixelQuick(LocationType geo, bool* pAccurate = NULL) const;
 
+   /**
+    *  @copydoc Georeference::pixelsToGeocoords()
+    *
+    *  @default The default implementation calls convertPixelsToGeocoords()
+    *           for all of the pixels.  If areConcurrentConversionsAllowed()
+    *           returns \c true, a large number of pixels is divided between
+    *           multiple threads which each call convertPixelsToGeocoords().
+    */
+   void pixelsToGeocoords(const std::vector<LocationType>& pixels, std::vector<LocationType>& geocoords,
+      bool quick = false, bool* pAccurate = NULL) const;
+
+   /**
+    *  @copydoc Georeference::geocoordsToPixels()
+    *
+    *  @default The default implementation calls convertGeocoordsToPixels()
+    *           for all of the geocoordinates.  If
+    *           areConcurrentConversionsAllowed() returns \c true, a large
+    *           number of geocoordinates is divided between multiple threads
+    *           which each call convertGeocoordsToPixels().
+    */
+   void geocoordsToPixels(const std::vector<LocationType>& geocoords, std::vector<LocationType>& pixels,
+      bool quick = false, bool* pAccurate = NULL) const;
+
+   /**
+    *  Converts a contiguous range of pixel locations into geocoordinates.
+    *
+    *  This method is called by pixelsToGeocoords(), possibly from multiple
+    *  threads at the same time for different ranges.  It should not be called
+    *  directly.
+    *
+    *  @param   pPixels
+    *           The first pixel location to convert.
+    *  @param   count
+    *           The number of pixel locations to convert.
+    *  @param   pGeocoords
+    *           The location in which to store the geocoordinate of the first
+    *           pixel, which has room for \em count geocoordinates.
+    *  @param   quick
+    *           Set to \c true if less accurate results are acceptable in
+    *           exchange for speed.
+    *  @param   pAccurate
+    *           Set to \c false if any of the conversions is not accurate, and
+    *           otherwise left unchanged.  When \c NULL, no accuracy check is
+    *           performed.
+    *
+    *  @default The default implementation calls pixelToGeo() or
+    *           pixelToGeoQuick() for each pixel.
+    */
+   virtual void convertPixelsToGeocoords(const LocationType* pPixels, size_t count, LocationType* pGeocoords,
+      bool quick, bool* pAccurate) const;
+
+   /**
+    *  Converts a contiguous range of geocoordinates into pixel locations.
+    *
+    *  This method is called by geocoordsToPixels(), possibly from multiple
+    *  threads at the same time for different ranges.  It should not be called
+    *  directly.
+    *
+    *  @param   pGeocoords
+    *           The first geocoordinate to convert.
+    *  @param   count
+    *           The number of geocoordinates to convert.
+    *  @param   pPixels
+    *           The location in which to store the pixel location of the first
+    *           geocoordinate, which has room for \em count pixel locations.
+    *  @param   quick
+    *           Set to \c true if less accurate results are acceptable in
+    *           exchange for speed.
+    *  @param   pAccurate
+    *           Set to \c false if any of the conversions is not accurate, and
+    *           otherwise left unchanged.  When \c NULL, no accuracy check is
+    *           performed.
+    *
+    *  @default The default implementation calls geoToPixel() or
+    *           geoToPixelQuick() for each geocoordinate.
+    */
+   virtual void convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count, LocationType* pPixels,
+      bool quick, bool* pAccurate) const;
+
    /**
     *  @copydoc Georeference::getWidget()
     *
@@ -94,6 +181,116 @@ public:
     *             layer name.
     */
    bool validate(const RasterDataDescriptor* pDescriptor, std::string& errorMessage) const;
+
+protected:
+   /**
+    *  Sets whether the coordinate conversions of the plug-in can be performed
+    *  by multiple threads at the same time.
+    *
+    *  Concurrent conversions should only be allowed if pixelToGeo(),
+    *  pixelToGeoQuick(), geoToPixel(), geoToPixelQuick(),
+    *  convertPixelsToGeocoords() and convertGeocoordsToPixels() do not modify
+    *  any shared state.  By default, concurrent conversions are not allowed.
+    *
+    *  @param   allow
+    *           Set to \c true to convert large numbers of coordinates in
+    *           multiple threads.
+    */
+   void allowConcurrentConversions(bool allow);
+
+   /**
+    *  Queries whether the coordinate conversions of the plug-in can be
+    *  performed by multiple threads at the same time.
+    *
+    *  @return  Returns \c true if large numbers of coordinates are converted in
+    *           multiple threads; otherwise returns \c false.
+    */
+   bool areConcurrentConversionsAllowed() const;
+
+   /**
+    *  Builds a grid which approximates pixelToGeo() for pixelToGeoQuick().
+    *
+    *  The grid is intended for plug-ins with an expensive pixelToGeo().  The
+    *  pixels of the scene are covered by cells, and pixelToGeo() is evaluated
+    *  at the corners of each cell.  A cell is divided into four cells until
+    *  the bilinear interpolation of its corners is within the tolerance of
+    *  pixelToGeo() at the center and at the midpoint of each edge of the cell
+    *  and at the centers of its quarters, or until the cell is a single pixel
+    *  across.  Once the grid is built,
+    *  pixelToGeoQuick() interpolates the grid for pixels inside of it instead
+    *  of calling pixelToGeo().
+    *
+    *  Any previous grid is replaced.  The grid should be rebuilt whenever the
+    *  parameters of pixelToGeo() change.
+    *
+    *  @param   columns
+    *           The number of columns in the scene.  The grid covers pixel
+    *           x coordinates from zero to \em columns.
+    *  @param   rows
+    *           The number of rows in the scene.  The grid covers pixel
+    *           y coordinates from zero to \em rows.
+    *  @param   tolerance
+    *           The maximum difference between the interpolated and exact
+    *           values of each geocoordinate component, in degrees.
+    *
+    *  @return  Returns \c false and removes the grid if the scene is empty or
+    *           the tolerance is not positive; otherwise returns \c true.
+    *
+    *  @see     serializeApproximationGrid()
+    */
+   bool buildApproximationGrid(unsigned int columns, unsigned int rows, double tolerance);
+
+   /**
+    *  Removes the approximation grid so that pixelToGeoQuick() calls
+    *  pixelToGeo().
+    */
+   void clearApproximationGrid();
+
+   /**
+    *  Queries whether pixelToGeoQuick() interpolates an approximation grid.
+    *
+    *  @return  Returns \c true if an approximation grid was built or
+    *           deserialized; otherwise returns \c false.
+    */
+   bool hasApproximationGrid() const;
+
+   /**
+    *  Saves the approximation grid so that it does not need to be rebuilt when
+    *  the session is restored.
+    *
+    *  The grid is written to the current block of the serializer, even if no
+    *  grid has been built.  The block should not contain any other data.
+    *
+    *  @param   serializer
+    *           The serializer passed into SessionItem::serialize().
+    *
+    *  @return  Returns \c true if the grid was saved; otherwise returns
+    *           \c false.
+    *
+    *  @see     deserializeApproximationGrid()
+    */
+   bool serializeApproximationGrid(SessionItemSerializer& serializer) const;
+
+   /**
+    *  Restores an approximation grid saved with serializeApproximationGrid().
+    *
+    *  @param   deserializer
+    *           The deserializer passed into SessionItem::deserialize(), with
+    *           the block containing the grid as the current block.
+    *
+    *  @return  Returns \c true if the grid was restored; otherwise returns
+    *           \c false and removes the grid.
+    */
+   bool deserializeApproximationGrid(SessionItemDeserializer& deserializer);
+
+private:
+   GeoreferenceShell(const GeoreferenceShell& rhs);
+   GeoreferenceShell& operator=(const GeoreferenceShell& rhs);
+
+   bool mConcurrentConversions;
+
+   class ApproximationGrid;
+   ApproximationGrid* mpApproximationGrid;
 };
 
 #endif
@@ -368,6 +368,9 @@ QWidget* RasterElementImporterShell::getPreview(const DataDescriptor* pDescripto
          // Create the spatial data view
          if (bSuccess == true)
          {
+            // Start building the overviews so that the zoomed out preview does not read every row of the data
+            pRasterElement->buildOverviews(pLoadDescriptor->getDisplayBand(GRAY));
+
             string name = pRasterElement->getName();
 
             SpatialDataView* pView = static_cast<SpatialDataView*>(mpDesktop->createView(name, SPATIAL_DATA_VIEW));
@@ -611,13 +614,14 @@ bool RasterElementImporterShell::performImport() const
          return checkAbortOrError("Could not create pager for source RasterElement", pStep.get());
       }
 
-      if (copyData(pSourceRaster.get()) == false)
+      // The data is copied, sanitized, and its statistics are computed in a single pass
+      double value = 0.0;
+      uint64_t badValueCount = 0;
+      if (importData(pSourceRaster.get(), value, badValueCount) == false)
       {
          return checkAbortOrError("Could not copy data from source RasterElement", pStep.get());
       }
 
-      double value = 0.0;
-      uint64_t badValueCount = mpRasterElement->sanitizeData(value);
       if (badValueCount != 0)
       {
          if (mpProgress != NULL)
@@ -1051,6 +1055,38 @@ bool RasterElementImporterShell::createRasterPager(RasterElement* pRaster) const
 }
 
 bool RasterElementImporterShell::copyData(const RasterElement* pSrcElement) const
+{
+   vector<DimensionDescriptor> selectedRows;
+   vector<DimensionDescriptor> selectedColumns;
+   vector<DimensionDescriptor> selectedBands;
+   bool success = selectSourceDims(pSrcElement, selectedRows, selectedColumns, selectedBands);
+
+   success = success && pSrcElement->copyDataToChip(mpRasterElement, selectedRows, 
+      selectedColumns, selectedBands, mAborted, mpProgress);
+
+   return success;
+}
+
+bool RasterElementImporterShell::importData(const RasterElement* pSrcElement, double sanitizeValue,
+                                            uint64_t& sanitizedCount) const
+{
+   sanitizedCount = 0;
+
+   vector<DimensionDescriptor> selectedRows;
+   vector<DimensionDescriptor> selectedColumns;
+   vector<DimensionDescriptor> selectedBands;
+   bool success = selectSourceDims(pSrcElement, selectedRows, selectedColumns, selectedBands);
+
+   success = success && pSrcElement->importDataToChip(mpRasterElement, selectedRows,
+      selectedColumns, selectedBands, sanitizeValue, sanitizedCount, mAborted, mpProgress);
+
+   return success;
+}
+
+bool RasterElementImporterShell::selectSourceDims(const RasterElement* pSrcElement,
+                                                  vector<DimensionDescriptor>& selectedRows,
+                                                  vector<DimensionDescriptor>& selectedColumns,
+                                                  vector<DimensionDescriptor>& selectedBands) const
 {
    VERIFY(pSrcElement != NULL && mpRasterElement != NULL);
 
@@ -1058,26 +1094,18 @@ bool RasterElementImporterShell::copyData(const RasterElement* pSrcElement) cons
       pSrcElement->getDataDescriptor());
    RasterDataDescriptor* pChipDescriptor = dynamic_cast<RasterDataDescriptor*>(
       mpRasterElement->getDataDescriptor());
-   VERIFY(pSrcDescriptor != NULL && mpRasterElement != NULL);
+   VERIFY(pSrcDescriptor != NULL && pChipDescriptor != NULL);
 
-   vector<DimensionDescriptor> selectedRows = getSelectedDims(pSrcDescriptor->getRows(),
-      pChipDescriptor->getRows());
-   vector<DimensionDescriptor> selectedColumns = getSelectedDims(pSrcDescriptor->getColumns(),
-      pChipDescriptor->getColumns());
-   vector<DimensionDescriptor> selectedBands = getSelectedDims(pSrcDescriptor->getBands(),
-      pChipDescriptor->getBands());
-
-   bool success = true;
+   selectedRows = getSelectedDims(pSrcDescriptor->getRows(), pChipDescriptor->getRows());
+   selectedColumns = getSelectedDims(pSrcDescriptor->getColumns(), pChipDescriptor->getColumns());
+   selectedBands = getSelectedDims(pSrcDescriptor->getBands(), pChipDescriptor->getBands());
 
    Service<SessionManager> pSessionManager;
    if (pSessionManager->isSessionLoading() == false)
    {
-      success = RasterUtilities::chipMetadata(mpRasterElement->getMetadata(), selectedRows, selectedColumns,
+      return RasterUtilities::chipMetadata(mpRasterElement->getMetadata(), selectedRows, selectedColumns,
          selectedBands);
    }
 
-   success = success && pSrcElement->copyDataToChip(mpRasterElement, selectedRows, 
-      selectedColumns, selectedBands, mAborted, mpProgress);
-
-   return success;
+   return true;
 }
@@ -21,6 +21,7 @@
 #include <vector>
 
 class DataDescriptor;
+class DimensionDescriptor;
 class GcpLayer;
 class GcpList;
 class LatLonLayer;
@@ -411,6 +412,24 @@ protected:
     */
    bool copyData(const RasterElement* pSrcElement) const;
 
+   /**
+    *  Copy data from the source element to the imported one, sanitizing
+    *  the data and computing its statistics while it is copied.
+    *
+    *  @param pSrcElement
+    *         The source element to copy from.  The active rows, columns,
+    *         and bands should be a superset of those being imported.
+    *  @param sanitizeValue
+    *         The value which replaces floating point NaNs.
+    *  @param sanitizedCount
+    *         Populated with the number of values which were replaced.
+    *
+    *  @return True if the copy was successful, false otherwise.
+    *
+    *  @see RasterElement::importDataToChip()
+    */
+   bool importData(const RasterElement* pSrcElement, double sanitizeValue, uint64_t& sanitizedCount) const;
+
    Service<DesktopServices> mpDesktop;
    Service<ModelServices> mpModel;
    Service<PlugInManagerServices> mpPlugInManager;
@@ -418,6 +437,8 @@ protected:
 
 private:
    bool checkAbortOrError(std::string message, Step* pStep, bool checkForError = true) const;
+   bool selectSourceDims(const RasterElement* pSrcElement, std::vector<DimensionDescriptor>& selectedRows,
+      std::vector<DimensionDescriptor>& selectedColumns, std::vector<DimensionDescriptor>& selectedBands) const;
 
    mutable bool mUsingMemoryMappedPager;
    Progress* mpProgress;
@@ -16,6 +16,21 @@ CachedPage::CacheUnit::CacheUnit(char* pData, DimensionDescriptor startRow, int
    mpData(pData),
    mStartRow(startRow),
    mConcurrentRows(concurrentRows),
+   mConcurrentColumns(0),
+   mBand(band),
+   mSize(size),
+   mInterlineBytes(interlineBytes)
+{
+}
+
+CachedPage::CacheUnit::CacheUnit(char* pData, DimensionDescriptor startRow, int concurrentRows,
+                                 DimensionDescriptor startColumn, unsigned int concurrentColumns, size_t size,
+                                 DimensionDescriptor band, unsigned int interlineBytes) :
+   mpData(pData),
+   mStartRow(startRow),
+   mConcurrentRows(concurrentRows),
+   mStartColumn(startColumn),
+   mConcurrentColumns(concurrentColumns),
    mBand(band),
    mSize(size),
    mInterlineBytes(interlineBytes)
@@ -43,11 +58,33 @@ bool CachedPage::CacheUnit::matches(DimensionDescriptor startRow, int concurrent
    return false;
 }
 
+bool CachedPage::CacheUnit::matches(DimensionDescriptor startRow, int concurrentRows, DimensionDescriptor startColumn,
+                                    DimensionDescriptor stopColumn, DimensionDescriptor band)
+{
+   if (matches(startRow, concurrentRows, band) == false)
+   {
+      return false;
+   }
+
+   if (mConcurrentColumns == 0) // all columns
+   {
+      return true;
+   }
+
+   return startColumn.getActiveNumber() >= mStartColumn.getActiveNumber() &&
+      stopColumn.getActiveNumber() < mStartColumn.getActiveNumber() + mConcurrentColumns;
+}
+
 DimensionDescriptor CachedPage::CacheUnit::getStartRow() const
 {
    return mStartRow;
 }
 
+DimensionDescriptor CachedPage::CacheUnit::getStartColumn() const
+{
+   return mStartColumn;
+}
+
 size_t CachedPage::CacheUnit::getSize() const
 {
    return mSize;
@@ -63,6 +100,11 @@ unsigned int CachedPage::CacheUnit::getConcurrentRows()
    return mConcurrentRows;
 }
 
+unsigned int CachedPage::CacheUnit::getConcurrentColumns() const
+{
+   return mConcurrentColumns;
+}
+
 unsigned int CachedPage::CacheUnit::getInterlineBytes()
 {
    return mInterlineBytes;
@@ -92,7 +134,7 @@ unsigned int CachedPage::getNumRows()
 
 unsigned int CachedPage::getNumColumns()
 {
-   return 0;
+   return mpCacheUnit->getConcurrentColumns();
 }
 
 unsigned int CachedPage::getNumBands()
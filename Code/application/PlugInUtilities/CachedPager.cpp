@@ -8,6 +8,7 @@
  */
 
 #include "AppVerify.h"
+#include "bthread.h"
 #include "CachedPager.h"
 #include "DataDescriptor.h"
 #include "DataRequest.h"
@@ -21,11 +22,237 @@
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <string.h>
+#include <vector>
+
 using namespace std;
 
+namespace
+{
+   const size_t MAX_PREFETCH_HISTORY = 64;
+   const unsigned int MAX_PREFETCH_THREADS = 4;
+}
+
+/**
+ * Fetches units on background threads ahead of sequential requests.
+ *
+ * Units are only fetched while the pager has pages outstanding.  When the last
+ * page is released, any scheduled work is discarded and fetches in progress are
+ * waited for, so that fetchUnit() is never called on a pager which may be
+ * destroyed.
+ */
+class CachedPager::Prefetcher
+{
+public:
+   enum AccessPatternEnum { RANDOM_ACCESS, SEQUENTIAL_ROWS, SEQUENTIAL_BANDS };
+
+   struct Job
+   {
+      PageCache::UnitKey mKey;
+      InterleaveFormatType mFormat;
+      unsigned int mRowsPerBlock;
+      unsigned int mConcurrentRows;
+      DimensionDescriptor mStartBand;
+      DimensionDescriptor mStopBand;
+   };
+
+   Prefetcher(CachedPager& pager) :
+      mPager(pager),
+      mPageCount(0),
+      mRunningCount(0),
+      mStopping(false)
+   {
+   }
+
+   ~Prefetcher()
+   {
+      {
+         mta::MutexLock lock(mMutex);
+         mStopping = true;
+         mJobAvailable.ThreadSignalBroadcast();
+      }
+
+      for (vector<BThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+      {
+         (*iter)->ThreadWait();
+         delete *iter;
+      }
+   }
+
+   /**
+    * Records a request for a unit and classifies the access pattern.
+    *
+    * Only the first request for a unit is classified, so that requests for
+    * successive rows within a unit do not schedule the same work again.
+    */
+   AccessPatternEnum recordAccess(const PageCache::UnitKey& key)
+   {
+      mta::MutexLock lock(mMutex);
+      if (find(mHistory.begin(), mHistory.end(), key) != mHistory.end())
+      {
+         return RANDOM_ACCESS;
+      }
+
+      AccessPatternEnum pattern = RANDOM_ACCESS;
+      if (key.mBlock > 0 &&
+         find(mHistory.begin(), mHistory.end(), PageCache::UnitKey(key.mBlock - 1, key.mBand,
+            key.mStartColumn, key.mColumnCount)) != mHistory.end())
+      {
+         pattern = SEQUENTIAL_ROWS;
+      }
+      else if (key.mBand > 0 &&
+         find(mHistory.begin(), mHistory.end(), PageCache::UnitKey(key.mBlock, key.mBand - 1,
+            key.mStartColumn, key.mColumnCount)) != mHistory.end())
+      {
+         pattern = SEQUENTIAL_BANDS;
+      }
+
+      mHistory.push_back(key);
+      if (mHistory.size() > MAX_PREFETCH_HISTORY)
+      {
+         mHistory.pop_front();
+      }
+
+      return pattern;
+   }
+
+   void acquirePage()
+   {
+      mta::MutexLock lock(mMutex);
+      ++mPageCount;
+   }
+
+   void releasePage()
+   {
+      mta::MutexLock lock(mMutex);
+      if (mPageCount > 0)
+      {
+         --mPageCount;
+      }
+
+      if (mPageCount == 0)
+      {
+         mJobs.clear();
+
+         // Stop waiting if another page is requested, since the pager cannot be destroyed while it is in use
+         while (mRunningCount > 0 && mPageCount == 0)
+         {
+            mJobsFinished.ThreadSignalWait(&mMutex);
+         }
+      }
+   }
+
+   void schedule(const vector<Job>& jobs, unsigned int depth)
+   {
+      if (jobs.empty())
+      {
+         return;
+      }
+
+      mta::MutexLock lock(mMutex);
+      mJobs.insert(mJobs.end(), jobs.begin(), jobs.end());
+
+      // Stale read-ahead is discarded in favor of the most recent requests
+      size_t maxJobs = 2 * max(depth, 1U);
+      while (mJobs.size() > maxJobs)
+      {
+         mJobs.pop_front();
+      }
+
+      if (mThreads.empty())
+      {
+         // A pager which serializes fetchUnit() cannot make use of more than one thread
+         unsigned int threadCount = mPager.canFetchConcurrently() ? min(depth, MAX_PREFETCH_THREADS) : 1;
+         for (unsigned int i = 0; i < threadCount; ++i)
+         {
+            BThread* pThread = new BThread(static_cast<void*>(this),
+               reinterpret_cast<void*>(Prefetcher::threadFunction));
+            if (pThread->ThreadLaunch())
+            {
+               mThreads.push_back(pThread);
+            }
+            else
+            {
+               delete pThread;
+            }
+         }
+      }
+
+      mJobAvailable.ThreadSignalBroadcast();
+   }
+
+private:
+   Prefetcher(const Prefetcher& rhs);
+   Prefetcher& operator=(const Prefetcher& rhs);
+
+   static void threadFunction(Prefetcher* pPrefetcher)
+   {
+      pPrefetcher->run();
+   }
+
+   void run()
+   {
+      for (;;)
+      {
+         Job job;
+         {
+            mta::MutexLock lock(mMutex);
+            while (mStopping == false && (mJobs.empty() || mPageCount == 0))
+            {
+               mJobAvailable.ThreadSignalWait(&mMutex);
+            }
+            if (mStopping)
+            {
+               return;
+            }
+
+            job = mJobs.front();
+            mJobs.pop_front();
+            ++mRunningCount;
+         }
+
+         if (mPager.mCache.reserveUnit(job.mKey))
+         {
+            CachedPage::UnitPtr pUnit;
+            try
+            {
+               pUnit = mPager.fetchBlock(job.mFormat, job.mKey, job.mRowsPerBlock, job.mConcurrentRows,
+                  job.mStartBand, job.mStopBand);
+            }
+            catch (...)
+            {
+               // Read-ahead failures are ignored; the unit will be fetched again when requested
+            }
+            mPager.mCache.insertUnit(job.mKey, pUnit);
+         }
+
+         mta::MutexLock lock(mMutex);
+         if (--mRunningCount == 0)
+         {
+            mJobsFinished.ThreadSignalBroadcast();
+         }
+      }
+   }
+
+   CachedPager& mPager;
+   mta::DMutex mMutex;
+   mta::DThreadSignal mJobAvailable;
+   mta::DThreadSignal mJobsFinished;
+   deque<Job> mJobs;
+   deque<PageCache::UnitKey> mHistory;
+   vector<BThread*> mThreads;
+   unsigned int mPageCount;
+   unsigned int mRunningCount;
+   bool mStopping;
+};
+
 CachedPager::CachedPager() :
-   mCache(10 * 1024 * 1024),
    mpMutex(new mta::DMutex),
+   mPrefetchDepth(0),
+   mPrefetchMemoryLimit(0),
    mpDescriptor(NULL),
    mpRaster(NULL),
    mBytesPerBand(0),
@@ -36,8 +263,9 @@ CachedPager::CachedPager() :
 }
 
 CachedPager::CachedPager(const size_t cacheSize) :
-   mCache(cacheSize),
    mpMutex(new mta::DMutex),
+   mPrefetchDepth(0),
+   mPrefetchMemoryLimit(0),
    mpDescriptor(NULL),
    mpRaster(NULL),
    mBytesPerBand(0),
@@ -49,6 +277,8 @@ CachedPager::CachedPager(const size_t cacheSize) :
 
 CachedPager::~CachedPager()
 {
+   // All pages have been released, so the prefetch threads are idle
+   setPrefetchEnabled(false);
 }
 
 bool CachedPager::getInputSpecification(PlugInArgList *&pArgList)
@@ -107,7 +337,11 @@ bool CachedPager::parseInputArgs(PlugInArgList *pInputArgList)
    }
    mFilename = pFilename->getFullPathAndName();
 
-   mCache.initialize(mBytesPerBand, mColumnCount, mBandCount);
+   mCache.initialize(mBytesPerBand, mColumnCount, mBandCount, mpRaster->getName());
+
+   mPrefetchDepth = CachedPager::getSettingPrefetchDepth();
+   mPrefetchMemoryLimit = min(static_cast<size_t>(CachedPager::getSettingPrefetchMemoryLimit()),
+      mCache.getMaxCacheSize() / 2);
 
    return true;
 }
@@ -128,58 +362,329 @@ RasterPage* CachedPager::getPage(DataRequest *pOriginalRequest,
 
    VERIFYRV(pOriginalRequest != NULL, NULL);
 
-   mta::MutexLock lock(*mpMutex);
-
-
    InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
-   DimensionDescriptor stopRow = pOriginalRequest->getStopRow();
-   DimensionDescriptor stopBand = pOriginalRequest->getStopBand();
-   unsigned int concurrentBands = pOriginalRequest->getConcurrentBands();
+   unsigned int concurrentRows = pOriginalRequest->getConcurrentRows();
 
    if (requestedFormat != mpDescriptor->getInterleaveFormat())
    {
       return NULL;
    }
 
-   CachedPage::UnitPtr pUnit = mCache.getUnit(pOriginalRequest, startRow, startBand);
+   // Units are aligned to fixed blocks of rows so that they can be looked up by key.
+   // A BSQ unit holds a single band, any other unit holds all bands.
+   DimensionDescriptor band = CachedPage::CacheUnit::ALL_BANDS;
+   unsigned int bandsPerUnit = mBandCount;
+   int bandKey = -1;
+   if (requestedFormat == BSQ)
+   {
+      band = startBand;
+      bandsPerUnit = 1;
+      bandKey = static_cast<int>(startBand.getActiveNumber());
+   }
+
+   // If the pager reads tiles, each unit holds a single column of tiles so that a tile is decoded at most
+   // once regardless of which columns are requested.  Otherwise a unit holds full rows.
+   DimensionDescriptor stopColumn = pOriginalRequest->getStopColumn();
+   if (stopColumn.isActiveNumberValid() == false)
+   {
+      stopColumn = mpDescriptor->getActiveColumn(mColumnCount - 1);
+   }
+   unsigned int unitStartColumn = 0;
+   unsigned int tileCount = 1;
+   unsigned int columnsPerUnit = mColumnCount;
+   unsigned int tileColumns = getTileColumnCount();
+   bool tiled = (tileColumns > 0 && static_cast<int>(tileColumns) < mColumnCount);
+   if (tiled)
+   {
+      unsigned int firstTile = startColumn.getActiveNumber() / tileColumns;
+      tileCount = stopColumn.getActiveNumber() / tileColumns - firstTile + 1;
+      unitStartColumn = firstTile * tileColumns;
+      columnsPerUnit = tileColumns;
+   }
+
+   // The block size only depends on the tile size so that every request maps a row to the same unit
+   unsigned int rowsPerBlock = std::max(1U,
+      static_cast<unsigned int>(getChunkSize() / (bandsPerUnit * columnsPerUnit * mBytesPerBand)));
+   unsigned int tileRows = getTileRowCount();
+   if (tileRows > 0 && tiled)
+   {
+      // Align blocks to whole tiles so that no tile is decoded for more than one unit
+      rowsPerBlock = (rowsPerBlock + tileRows - 1) / tileRows * tileRows;
+   }
+   PageCache::UnitKey key(startRow.getActiveNumber() / rowsPerBlock, bandKey, unitStartColumn,
+      getUnitColumnCount(unitStartColumn));
 
-   DimensionDescriptor cacheStartBand = startBand;
-   DimensionDescriptor cacheStopBand = stopBand;
-   if (pUnit.get() == NULL) // cache miss
+   if (mpPrefetcher.get() != NULL)
    {
-      if (requestedFormat != BSQ)
+      mpPrefetcher->acquirePage();
+      schedulePrefetch(requestedFormat, key, tileCount, rowsPerBlock, concurrentRows, startBand,
+         pOriginalRequest->getStopRow(), pOriginalRequest->getStopBand());
+   }
+
+   CachedPage::UnitPtr pUnit;
+   try
+   {
+      if (tileCount == 1)
+      {
+         pUnit = getUnit(requestedFormat, key, rowsPerBlock, startRow, concurrentRows, startColumn, stopColumn,
+            band, startBand, pOriginalRequest->getStopBand());
+      }
+      else
       {
-         cacheStartBand = DimensionDescriptor();
-         cacheStopBand = DimensionDescriptor();
-         concurrentBands = mBandCount;
+         vector<CachedPage::UnitPtr> tiles;
+         for (unsigned int tile = 0; tile < tileCount; ++tile)
+         {
+            unsigned int tileStartColumn = unitStartColumn + tile * tileColumns;
+            PageCache::UnitKey tileKey(key.mBlock, bandKey, tileStartColumn, getUnitColumnCount(tileStartColumn));
+            tiles.push_back(getUnit(requestedFormat, tileKey, rowsPerBlock, startRow, concurrentRows,
+               mpDescriptor->getActiveColumn(tileStartColumn),
+               mpDescriptor->getActiveColumn(tileStartColumn + tileKey.mColumnCount - 1),
+               band, startBand, pOriginalRequest->getStopBand()));
+         }
+
+         pUnit = combineUnits(tiles, requestedFormat, startRow);
       }
+   }
+   catch (...)
+   {
+      if (mpPrefetcher.get() != NULL)
+      {
+         mpPrefetcher->releasePage();
+      }
+      throw;
+   }
 
-      // get a bunch more rows if you can to prevent a cache miss
-      unsigned int concurrentRows = std::max(pOriginalRequest->getConcurrentRows(),
-         static_cast<unsigned int>(getChunkSize() / (concurrentBands * mColumnCount * mBytesPerBand)));
-      concurrentRows = std::min(concurrentRows, stopRow.getActiveNumber() - startRow.getActiveNumber() + 1);
+   RasterPage* pPage = mCache.createPage(pUnit, requestedFormat, startRow, startColumn, startBand);
+   if (pPage == NULL && mpPrefetcher.get() != NULL)
+   {
+      mpPrefetcher->releasePage();
+   }
 
-      FactoryResource<DataRequest> pNewRequest;
-      pNewRequest->setInterleaveFormat(requestedFormat);
-      pNewRequest->setRows(startRow, stopRow, concurrentRows);
-      // Get full columns
-      pNewRequest->setBands(cacheStartBand, cacheStopBand);
+   return pPage;
+}
 
-      pNewRequest->polish(mpDescriptor);
-      if (pNewRequest->validate(mpDescriptor) == true)
+CachedPage::UnitPtr CachedPager::getUnit(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+   unsigned int rowsPerBlock, DimensionDescriptor startRow, unsigned int concurrentRows,
+   DimensionDescriptor startColumn, DimensionDescriptor stopColumn, DimensionDescriptor band,
+   DimensionDescriptor startBand, DimensionDescriptor stopBand)
+{
+   bool fetchRequired = false;
+   CachedPage::UnitPtr pUnit = mCache.getUnit(key, startRow, concurrentRows, startColumn, stopColumn, band,
+      fetchRequired);
+   if (fetchRequired) // cache miss
+   {
+      // The unit is fetched without holding any cache locks so that misses
+      // on different units can be serviced at the same time.
+      try
       {
-         pUnit = fetchUnit(pNewRequest.get());
+         pUnit = fetchBlock(requestedFormat, key, rowsPerBlock, concurrentRows, startBand, stopBand);
       }
+      catch (...)
+      {
+         mCache.insertUnit(key, CachedPage::UnitPtr());
+         throw;
+      }
+      mCache.insertUnit(key, pUnit);
    }
 
-   return mCache.createPage(pUnit, requestedFormat, startRow, startColumn, startBand);
+   return pUnit;
 }
 
-void CachedPager::releasePage(RasterPage *pPage)
+CachedPage::UnitPtr CachedPager::combineUnits(const vector<CachedPage::UnitPtr>& tiles,
+   InterleaveFormatType requestedFormat, DimensionDescriptor startRow) const
+{
+   // The combined unit is only referenced by the page being created, so it is not added to the cache
+   unsigned int firstRow = startRow.getActiveNumber();
+   unsigned int rowCount = numeric_limits<unsigned int>::max();
+   unsigned int columnCount = 0;
+   for (vector<CachedPage::UnitPtr>::const_iterator iter = tiles.begin(); iter != tiles.end(); ++iter)
+   {
+      if (iter->get() == NULL)
+      {
+         return CachedPage::UnitPtr();
+      }
+
+      rowCount = min(rowCount, (*iter)->getStartRow().getActiveNumber() + (*iter)->getConcurrentRows() - firstRow);
+      columnCount += (*iter)->getConcurrentColumns();
+   }
+
+   // A BIL row contains each band of the row in turn, so its columns are copied one band at a time
+   unsigned int segmentCount = (requestedFormat == BIL ? mBandCount : 1);
+   size_t pixelBytes = static_cast<size_t>(mBytesPerBand) * (requestedFormat == BIP ? mBandCount : 1);
+   size_t rowBytes = columnCount * pixelBytes * segmentCount;
+   size_t size = rowBytes * rowCount;
+   char* pData = new char[size];
+
+   size_t columnOffset = 0;
+   for (vector<CachedPage::UnitPtr>::const_iterator iter = tiles.begin(); iter != tiles.end(); ++iter)
+   {
+      CachedPage::CacheUnit& tile = **iter;
+      size_t tileSegmentBytes = tile.getConcurrentColumns() * pixelBytes;
+      size_t tileRowBytes = tileSegmentBytes * segmentCount + tile.getInterlineBytes();
+      const char* pSource = tile.getRawData() + (firstRow - tile.getStartRow().getActiveNumber()) * tileRowBytes;
+      char* pDestination = pData + columnOffset * pixelBytes;
+      for (unsigned int row = 0; row < rowCount; ++row)
+      {
+         for (unsigned int segment = 0; segment < segmentCount; ++segment)
+         {
+            memcpy(pDestination + segment * columnCount * pixelBytes, pSource + segment * tileSegmentBytes,
+               tileSegmentBytes);
+         }
+
+         pSource += tileRowBytes;
+         pDestination += rowBytes;
+      }
+
+      columnOffset += tile.getConcurrentColumns();
+   }
+
+   return CachedPage::UnitPtr(new CachedPage::CacheUnit(pData, startRow, rowCount,
+      tiles.front()->getStartColumn(), columnCount, size, tiles.front()->getBand()));
+}
+
+unsigned int CachedPager::getUnitColumnCount(unsigned int unitStartColumn) const
+{
+   unsigned int tileColumns = getTileColumnCount();
+   if (tileColumns == 0 || static_cast<int>(tileColumns) >= mColumnCount)
+   {
+      return 0;
+   }
+
+   return min(tileColumns, static_cast<unsigned int>(mColumnCount) - unitStartColumn);
+}
+
+CachedPage::UnitPtr CachedPager::fetchBlock(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+   unsigned int rowsPerBlock, unsigned int concurrentRows, DimensionDescriptor startBand,
+   DimensionDescriptor stopBand)
 {
+   // Read the whole block plus enough additional rows that a request for
+   // concurrentRows starting anywhere in the block is contained by the unit.
+   unsigned int blockStartRow = key.mBlock * rowsPerBlock;
+   unsigned int unitRows = std::min(rowsPerBlock + std::max(concurrentRows, 1U) - 1,
+      static_cast<unsigned int>(mRowCount) - blockStartRow);
+
+   FactoryResource<DataRequest> pNewRequest;
+   pNewRequest->setInterleaveFormat(requestedFormat);
+   pNewRequest->setRows(mpDescriptor->getActiveRow(blockStartRow), mpDescriptor->getActiveRow(mRowCount - 1),
+      unitRows);
+   if (key.mColumnCount > 0)
+   {
+      pNewRequest->setColumns(mpDescriptor->getActiveColumn(key.mStartColumn),
+         mpDescriptor->getActiveColumn(key.mStartColumn + key.mColumnCount - 1), key.mColumnCount);
+   }
+   // Otherwise get full columns
+   if (requestedFormat == BSQ)
+   {
+      pNewRequest->setBands(startBand, stopBand);
+   }
+   else
+   {
+      pNewRequest->setBands(DimensionDescriptor(), DimensionDescriptor());
+   }
+
+   pNewRequest->polish(mpDescriptor);
+   if (pNewRequest->validate(mpDescriptor) == false)
+   {
+      return CachedPage::UnitPtr();
+   }
+
+   if (canFetchConcurrently())
+   {
+      return fetchUnit(pNewRequest.get());
+   }
+
    mta::MutexLock lock(*mpMutex);
+   return fetchUnit(pNewRequest.get());
+}
+
+void CachedPager::schedulePrefetch(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+   unsigned int tileCount, unsigned int rowsPerBlock, unsigned int concurrentRows, DimensionDescriptor startBand,
+   DimensionDescriptor stopRow, DimensionDescriptor stopBand)
+{
+   // Each step ahead reads every tile column of the request
+   unsigned int bandsPerUnit = (requestedFormat == BSQ ? 1 : mBandCount);
+   unsigned int tileColumns = getTileColumnCount();
+   unsigned int columnsPerUnit = (key.mColumnCount == 0 ? mColumnCount : tileColumns * tileCount);
+   size_t unitSize = static_cast<size_t>(rowsPerBlock) * bandsPerUnit * columnsPerUnit * mBytesPerBand;
+   unsigned int depth = static_cast<unsigned int>(min(static_cast<size_t>(mPrefetchDepth),
+      mPrefetchMemoryLimit / max(unitSize, static_cast<size_t>(1))));
+   if (depth == 0)
+   {
+      return;
+   }
+
+   Prefetcher::AccessPatternEnum pattern = mpPrefetcher->recordAccess(key);
+   if (pattern == Prefetcher::RANDOM_ACCESS)
+   {
+      return;
+   }
+
+   Prefetcher::Job job;
+   job.mFormat = requestedFormat;
+   job.mRowsPerBlock = rowsPerBlock;
+   job.mConcurrentRows = concurrentRows;
+   job.mStartBand = startBand;
+   job.mStopBand = stopBand;
+
+   vector<Prefetcher::Job> jobs;
+   for (unsigned int i = 1; i <= depth; ++i)
+   {
+      if (pattern == Prefetcher::SEQUENTIAL_ROWS)
+      {
+         // Do not read beyond the rows which were requested
+         unsigned int block = key.mBlock + i;
+         if (!stopRow.isActiveNumberValid() || block * rowsPerBlock > stopRow.getActiveNumber())
+         {
+            break;
+         }
+         job.mKey = PageCache::UnitKey(block, key.mBand, key.mStartColumn, key.mColumnCount);
+      }
+      else
+      {
+         // Each band of a BSQ cube is usually requested separately, so read ahead across all bands
+         int band = key.mBand + static_cast<int>(i);
+         if (band >= mBandCount)
+         {
+            break;
+         }
+         job.mKey = PageCache::UnitKey(key.mBlock, band, key.mStartColumn, key.mColumnCount);
+         job.mStartBand = mpDescriptor->getActiveBand(band);
+         job.mStopBand = job.mStartBand;
+      }
+
+      for (unsigned int tile = 0; tile < tileCount; ++tile)
+      {
+         unsigned int tileStartColumn = key.mStartColumn + tile * tileColumns;
+         job.mKey = PageCache::UnitKey(job.mKey.mBlock, job.mKey.mBand, tileStartColumn,
+            getUnitColumnCount(tileStartColumn));
+         jobs.push_back(job);
+      }
+   }
+
+   mpPrefetcher->schedule(jobs, depth * tileCount);
+}
+
+void CachedPager::setPrefetchEnabled(bool enabled)
+{
+   if (enabled == false)
+   {
+      mpPrefetcher.reset();
+   }
+   else if (mpPrefetcher.get() == NULL)
+   {
+      mpPrefetcher.reset(new Prefetcher(*this));
+   }
+}
+
+void CachedPager::releasePage(RasterPage *pPage)
+{
+   CachedPage* pCachedPage = dynamic_cast<CachedPage*>(pPage);
+   delete pCachedPage;
 
-   delete dynamic_cast<CachedPage*>(pPage);
+   if (pCachedPage != NULL && mpPrefetcher.get() != NULL)
+   {
+      mpPrefetcher->releasePage();
+   }
 }
 
 int CachedPager::getSupportedRequestVersion() const
@@ -211,3 +716,18 @@ double CachedPager::getChunkSize() const
 {
    return 1 * 1024 * 1024;
 }
+
+bool CachedPager::canFetchConcurrently() const
+{
+   return false;
+}
+
+unsigned int CachedPager::getTileRowCount() const
+{
+   return 0;
+}
+
+unsigned int CachedPager::getTileColumnCount() const
+{
+   return 0;
+}
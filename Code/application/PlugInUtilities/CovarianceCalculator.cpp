@@ -0,0 +1,426 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "BitMaskIterator.h"
+#include "CovarianceCalculator.h"
+#include "DataAccessor.h"
+#include "DataAccessorImpl.h"
+#include "DataRequest.h"
+#include "MultiThreadedAlgorithm.h"
+#include "ObjectResource.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
+#include "switchOnEncoding.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+   // The number of pixels converted to band-major order before their scatter matrix is accumulated
+   const unsigned int BLOCK_PIXELS = 256;
+
+   // The scatter matrix is computed in square tiles of this many bands so the rows of the block stay in cache
+   const unsigned int BAND_TILE = 32;
+
+   inline double dotProduct(const double* pFirst, const double* pSecond, unsigned int count)
+   {
+      // Independent sums allow the additions to be pipelined
+      double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+      unsigned int index = 0;
+      for (; index + 4 <= count; index += 4)
+      {
+         sums[0] += pFirst[index] * pSecond[index];
+         sums[1] += pFirst[index + 1] * pSecond[index + 1];
+         sums[2] += pFirst[index + 2] * pSecond[index + 2];
+         sums[3] += pFirst[index + 3] * pSecond[index + 3];
+      }
+      for (; index < count; ++index)
+      {
+         sums[0] += pFirst[index] * pSecond[index];
+      }
+
+      return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+   }
+
+   /**
+    * Computes the upper triangle of the product of a band-major block with its transpose.
+    *
+    * Each band of the block is a contiguous row of stride values, of which the first count are used.
+    */
+   void computeScatter(const double* pBlock, unsigned int bands, unsigned int count, unsigned int stride,
+      double* pScatter)
+   {
+      for (unsigned int firstRow = 0; firstRow < bands; firstRow += BAND_TILE)
+      {
+         unsigned int lastRow = min(firstRow + BAND_TILE, bands);
+         for (unsigned int firstColumn = firstRow; firstColumn < bands; firstColumn += BAND_TILE)
+         {
+            unsigned int lastColumn = min(firstColumn + BAND_TILE, bands);
+            for (unsigned int row = firstRow; row < lastRow; ++row)
+            {
+               for (unsigned int column = max(row, firstColumn); column < lastColumn; ++column)
+               {
+                  pScatter[row * bands + column] = dotProduct(&pBlock[row * stride], &pBlock[column * stride], count);
+               }
+            }
+         }
+      }
+   }
+
+   /**
+    * The count, means, and upper triangle of the scatter matrix about the means of a set of pixels.
+    */
+   class Moments
+   {
+   public:
+      Moments(unsigned int bands) :
+         mCount(0),
+         mMeans(bands, 0.0),
+         mScatter(bands * bands, 0.0),
+         mDelta(bands, 0.0)
+      {
+      }
+
+      void merge(uint64_t count, const vector<double>& means, const vector<double>& scatter)
+      {
+         if (count == 0)
+         {
+            return;
+         }
+
+         unsigned int bands = static_cast<unsigned int>(mMeans.size());
+         double total = static_cast<double>(mCount + count);
+         double weight = static_cast<double>(mCount) * static_cast<double>(count) / total;
+         for (unsigned int band = 0; band < bands; ++band)
+         {
+            mDelta[band] = means[band] - mMeans[band];
+         }
+
+         // Combine the scatter matrices about their own means and the scatter of the means about each other
+         for (unsigned int row = 0; row < bands; ++row)
+         {
+            double rowWeight = mDelta[row] * weight;
+            for (unsigned int column = row; column < bands; ++column)
+            {
+               mScatter[row * bands + column] += scatter[row * bands + column] + rowWeight * mDelta[column];
+            }
+         }
+
+         for (unsigned int band = 0; band < bands; ++band)
+         {
+            mMeans[band] += mDelta[band] * static_cast<double>(count) / total;
+         }
+
+         mCount += count;
+      }
+
+      void merge(const Moments& moments)
+      {
+         merge(moments.mCount, moments.mMeans, moments.mScatter);
+      }
+
+      uint64_t mCount;
+      vector<double> mMeans;
+      vector<double> mScatter;
+
+   private:
+      vector<double> mDelta;
+   };
+
+   struct CovarianceInput
+   {
+      const RasterElement* mpRaster;
+      const BitMaskIterator* mpMask;
+      const bool* mpAbortFlag;
+      unsigned int mBandCount;
+      int mFirstRow;
+      int mRowCount;
+      int mRowFactor;
+      int mFirstColumn;
+      int mLastColumn;
+      int mColumnFactor;
+   };
+
+   class CovarianceThread : public mta::AlgorithmThread
+   {
+   public:
+      CovarianceThread(const CovarianceInput& input, int threadCount, int threadIndex,
+         mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mRowRange(getThreadRange(threadCount, input.mRowCount)),
+         mFailed(false),
+         mMoments(input.mBandCount),
+         mBlock(input.mBandCount * BLOCK_PIXELS),
+         mBlockMeans(input.mBandCount),
+         mBlockScatter(input.mBandCount * input.mBandCount)
+      {
+      }
+
+      void run()
+      {
+         const RasterDataDescriptor* pDescriptor =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpRaster->getDataDescriptor());
+         if (pDescriptor == NULL)
+         {
+            mFailed = true;
+            return;
+         }
+
+         switchOnEncoding(pDescriptor->getDataType(), accumulate, NULL, pDescriptor);
+      }
+
+      bool isFailed() const
+      {
+         return mFailed;
+      }
+
+      const Moments& getMoments() const
+      {
+         return mMoments;
+      }
+
+   private:
+      CovarianceThread& operator=(const CovarianceThread& rhs);
+
+      template<typename T>
+      void accumulate(T* pDummy, const RasterDataDescriptor* pDescriptor)
+      {
+         if (mRowRange.mLast < mRowRange.mFirst)
+         {
+            return;
+         }
+
+         int firstRow = mInput.mFirstRow + mRowRange.mFirst * mInput.mRowFactor;
+         int lastRow = mInput.mFirstRow + mRowRange.mLast * mInput.mRowFactor;
+         FactoryResource<DataRequest> pRequest;
+         pRequest->setInterleaveFormat(BIP);
+         pRequest->setRows(pDescriptor->getActiveRow(firstRow), pDescriptor->getActiveRow(lastRow));
+         pRequest->setColumns(pDescriptor->getActiveColumn(mInput.mFirstColumn),
+            pDescriptor->getActiveColumn(mInput.mLastColumn));
+         DataAccessor accessor = mInput.mpRaster->getDataAccessor(pRequest.release());
+
+         unsigned int bands = mInput.mBandCount;
+         unsigned int blockCount = 0;
+         for (int index = mRowRange.mFirst; index <= mRowRange.mLast; ++index)
+         {
+            if (mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag)
+            {
+               return;
+            }
+            getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(index));
+
+            int row = mInput.mFirstRow + index * mInput.mRowFactor;
+            accessor->toPixel(row, mInput.mFirstColumn);
+            if (accessor.isValid() == false)
+            {
+               mFailed = true;
+               return;
+            }
+
+            const T* pRow = reinterpret_cast<const T*>(accessor->getRow());
+            for (int column = mInput.mFirstColumn; column <= mInput.mLastColumn; column += mInput.mColumnFactor)
+            {
+               if (mInput.mpMask != NULL && mInput.mpMask->getPixel(column, row) == false)
+               {
+                  continue;
+               }
+
+               const T* pPixel = pRow + static_cast<size_t>(column - mInput.mFirstColumn) * bands;
+               for (unsigned int band = 0; band < bands; ++band)
+               {
+                  mBlock[band * BLOCK_PIXELS + blockCount] = pPixel[band];
+               }
+
+               if (++blockCount == BLOCK_PIXELS)
+               {
+                  addBlock(blockCount);
+                  blockCount = 0;
+               }
+            }
+         }
+
+         addBlock(blockCount);
+      }
+
+      void addBlock(unsigned int count)
+      {
+         if (count == 0)
+         {
+            return;
+         }
+
+         // Center the block on its own means so the scatter is accumulated from small values
+         unsigned int bands = mInput.mBandCount;
+         for (unsigned int band = 0; band < bands; ++band)
+         {
+            double* pValues = &mBlock[band * BLOCK_PIXELS];
+            double sum = 0.0;
+            for (unsigned int pixel = 0; pixel < count; ++pixel)
+            {
+               sum += pValues[pixel];
+            }
+
+            double mean = sum / count;
+            for (unsigned int pixel = 0; pixel < count; ++pixel)
+            {
+               pValues[pixel] -= mean;
+            }
+            mBlockMeans[band] = mean;
+         }
+
+         computeScatter(&mBlock.front(), bands, count, BLOCK_PIXELS, &mBlockScatter.front());
+         mMoments.merge(count, mBlockMeans, mBlockScatter);
+      }
+
+      const CovarianceInput& mInput;
+      mta::AlgorithmThread::Range mRowRange;
+      bool mFailed;
+      Moments mMoments;
+      vector<double> mBlock;
+      vector<double> mBlockMeans;
+      vector<double> mBlockScatter;
+   };
+
+   struct CovarianceOutput
+   {
+      CovarianceOutput(unsigned int bands) :
+         mFailed(false),
+         mMoments(bands)
+      {
+      }
+
+      bool compileOverallResults(const vector<CovarianceThread*>& threads)
+      {
+         // Merge in thread order so the result does not depend on the order in which the threads finish
+         for (vector<CovarianceThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+         {
+            mFailed = mFailed || (*iter)->isFailed();
+            mMoments.merge((*iter)->getMoments());
+         }
+
+         return mFailed == false;
+      }
+
+      bool mFailed;
+      Moments mMoments;
+   };
+}
+
+CovarianceCalculator::CovarianceCalculator(const RasterElement* pRaster, const BitMask* pMask, int rowFactor,
+                                           int columnFactor) :
+   mpRaster(pRaster),
+   mpMask(pMask),
+   mRowFactor(max(rowFactor, 1)),
+   mColumnFactor(max(columnFactor, 1)),
+   mBandCount(0),
+   mPixelCount(0)
+{
+   if (mpRaster != NULL)
+   {
+      const RasterDataDescriptor* pDescriptor =
+         dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
+      if (pDescriptor != NULL)
+      {
+         mBandCount = pDescriptor->getBandCount();
+      }
+   }
+}
+
+bool CovarianceCalculator::calculate(Progress* pProgress, const string& message, const bool* pAbortFlag)
+{
+   mPixelCount = 0;
+   mMeans.assign(mBandCount, 0.0);
+   mCovariance.assign(mBandCount * mBandCount, 0.0);
+   if (mpRaster == NULL || mBandCount == 0)
+   {
+      return false;
+   }
+
+   // Only the rows and columns within the bounding box of the mask which are multiples of the factors are read
+   BitMaskIterator mask(mpMask, mpRaster);
+   int x1 = 0;
+   int y1 = 0;
+   int x2 = -1;
+   int y2 = -1;
+   mask.getBoundingBox(x1, y1, x2, y2);
+
+   CovarianceInput input;
+   input.mpRaster = mpRaster;
+   input.mpMask = (mpMask == NULL ? NULL : &mask);
+   input.mpAbortFlag = pAbortFlag;
+   input.mBandCount = mBandCount;
+   input.mRowFactor = mRowFactor;
+   input.mFirstRow = (y1 + mRowFactor - 1) / mRowFactor * mRowFactor;
+   input.mRowCount = (y2 >= input.mFirstRow ? (y2 - input.mFirstRow) / mRowFactor + 1 : 0);
+   input.mColumnFactor = mColumnFactor;
+   input.mFirstColumn = (x1 + mColumnFactor - 1) / mColumnFactor * mColumnFactor;
+   input.mLastColumn = x2;
+   if (input.mRowCount <= 0 || input.mLastColumn < input.mFirstColumn)
+   {
+      return false;
+   }
+
+   CovarianceOutput output(mBandCount);
+   mta::ProgressObjectReporter reporter(message, pProgress);
+   mta::MultiThreadedAlgorithm<CovarianceInput, CovarianceOutput, CovarianceThread>
+      algorithm(mta::getNumRequiredThreads(input.mRowCount), input, output, &reporter);
+   if (algorithm.run() != mta::SUCCESS || (pAbortFlag != NULL && *pAbortFlag) || output.mMoments.mCount == 0)
+   {
+      return false;
+   }
+
+   mPixelCount = output.mMoments.mCount;
+   mMeans = output.mMoments.mMeans;
+   for (unsigned int row = 0; row < mBandCount; ++row)
+   {
+      for (unsigned int column = row; column < mBandCount; ++column)
+      {
+         double value = output.mMoments.mScatter[row * mBandCount + column] / static_cast<double>(mPixelCount);
+         mCovariance[row * mBandCount + column] = value;
+         mCovariance[column * mBandCount + row] = value;
+      }
+   }
+
+   return true;
+}
+
+unsigned int CovarianceCalculator::getBandCount() const
+{
+   return mBandCount;
+}
+
+uint64_t CovarianceCalculator::getPixelCount() const
+{
+   return mPixelCount;
+}
+
+const vector<double>& CovarianceCalculator::getMeans() const
+{
+   return mMeans;
+}
+
+const vector<double>& CovarianceCalculator::getCovariance() const
+{
+   return mCovariance;
+}
+
+void CovarianceCalculator::getSecondMoment(vector<double>& secondMoment) const
+{
+   secondMoment = mCovariance;
+   for (unsigned int row = 0; row < mBandCount; ++row)
+   {
+      for (unsigned int column = 0; column < mBandCount; ++column)
+      {
+         secondMoment[row * mBandCount + column] += mMeans[row] * mMeans[column];
+      }
+   }
+}
@@ -11,6 +11,7 @@
 #include "GeoreferenceUtilities.h"
 #include "LocationType.h"
 #include "MatrixFunctions.h"
+#include <algorithm>
 #include <stdexcept>
 
 namespace GeoreferenceUtilities
@@ -123,4 +124,74 @@ LocationType evaluatePolynomial(LocationType position,
    return transformedPosition;
 }
 
+void evaluatePolynomial(const LocationType* pPositions,
+                        size_t count,
+                        const std::vector<double>& pXCoeffs,
+                        const std::vector<double>& pYCoeffs,
+                        int order,
+                        LocationType* pTransformedPositions)
+{
+   size_t numCoeffs = static_cast<size_t>(COEFFS_FOR_ORDER(std::max(order, 0)));
+   if (order < 0 || pXCoeffs.size() < numCoeffs || pYCoeffs.size() < numCoeffs)
+   {
+      std::fill(pTransformedPositions, pTransformedPositions + count, LocationType(0.0, 0.0));
+      return;
+   }
+
+   // Keep the values of a block in separate arrays so that each loop over the block is a simple vector operation
+   const size_t blockSize = 256;
+   double xValues[blockSize];
+   double yValues[blockSize];
+   double yPowers[blockSize];
+   double xyPowers[blockSize];
+   double transformedX[blockSize];
+   double transformedY[blockSize];
+
+   for (size_t start = 0; start < count; start += blockSize)
+   {
+      const size_t blockCount = std::min(blockSize, count - start);
+      for (size_t k = 0; k < blockCount; ++k)
+      {
+         xValues[k] = pPositions[start + k].mX;
+         yValues[k] = pPositions[start + k].mY;
+         yPowers[k] = 1.0;
+         transformedX[k] = 0.0;
+         transformedY[k] = 0.0;
+      }
+
+      int coeff = 0;
+      for (int i = 0; i <= order; ++i)          // y power
+      {
+         for (size_t k = 0; k < blockCount; ++k)
+         {
+            xyPowers[k] = yPowers[k];
+         }
+
+         for (int j = 0; j <= order - i; ++j)   // x power
+         {
+            const double xCoeff = pXCoeffs[coeff];
+            const double yCoeff = pYCoeffs[coeff];
+            for (size_t k = 0; k < blockCount; ++k)
+            {
+               transformedX[k] += xCoeff * xyPowers[k];
+               transformedY[k] += yCoeff * xyPowers[k];
+               xyPowers[k] *= xValues[k];
+            }
+
+            ++coeff;
+         }
+
+         for (size_t k = 0; k < blockCount; ++k)
+         {
+            yPowers[k] *= yValues[k];
+         }
+      }
+
+      for (size_t k = 0; k < blockCount; ++k)
+      {
+         pTransformedPositions[start + k] = LocationType(transformedX[k], transformedY[k]);
+      }
+   }
+}
+
 }
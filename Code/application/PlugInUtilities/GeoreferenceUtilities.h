@@ -29,6 +29,20 @@ LocationType evaluatePolynomial(LocationType position,
                                 const std::vector<double>& pXCoeffs,
                                 const std::vector<double>& pYCoeffs,
                                 int order);
+
+/**
+ * Evaluates a polynomial for many positions at once.
+ *
+ * The results are the same as calling evaluatePolynomial() for each position,
+ * but the positions are processed in blocks so that the powers are computed
+ * incrementally and the compiler can vectorize the evaluation of each term.
+ */
+void evaluatePolynomial(const LocationType* pPositions,
+                        size_t count,
+                        const std::vector<double>& pXCoeffs,
+                        const std::vector<double>& pYCoeffs,
+                        int order,
+                        LocationType* pTransformedPositions);
 }
 
 #endif
\ No newline at end of file
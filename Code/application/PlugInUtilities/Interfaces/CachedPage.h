@@ -55,6 +55,37 @@ public:
       CacheUnit(char *pData, DimensionDescriptor startRow, int concurrentRows, size_t size, 
          DimensionDescriptor band = ALL_BANDS, unsigned int interlineBytes = 0);
 
+      /**
+       * Construct a CacheUnit containing a subset of the columns.
+       *
+       * Each row in \p pData contains \p concurrentColumns columns (and all bands
+       * if BIL or BIP) followed by \p interlineBytes bytes.
+       *
+       * @param pData
+       *        The buffer which has already been populated with the data for the
+       *        cache unit.  Must be at least \p size bytes long, and must have
+       *        been allocated with new char[n].  The cache unit takes ownership
+       *        of this buffer.
+       * @param startRow
+       *        The starting row for this unit.
+       * @param concurrentRows
+       *        The number of concurrent rows provided.
+       * @param startColumn
+       *        The starting column for this unit.
+       * @param concurrentColumns
+       *        The number of concurrent columns provided, or 0 if all columns
+       *        are provided.
+       * @param size
+       *        The size of the buffer provided in \p pData.
+       * @param band
+       *        The band provided if BSQ, or ALL_BANDS if all bands are provided.
+       * @param interlineBytes
+       *        The number of interline bytes within the buffer.
+       */
+      CacheUnit(char *pData, DimensionDescriptor startRow, int concurrentRows, DimensionDescriptor startColumn,
+         unsigned int concurrentColumns, size_t size, DimensionDescriptor band = ALL_BANDS,
+         unsigned int interlineBytes = 0);
+
       /**
        * Destroy a CacheUnit.
        */
@@ -80,6 +111,24 @@ public:
        */
       bool matches(DimensionDescriptor startRow, int concurrentRows, DimensionDescriptor band);
 
+      /**
+       * A function that determines if a block of rows, a range of columns, and a
+       * band (for BSQ) is contained by this current page.
+       *
+       * @param  startRow
+       *         The start row of the block that may be requested.
+       * @param  concurrentRows
+       *         The number of rows needed at any given time.
+       * @param  startColumn
+       *         The first column which is needed.
+       * @param  stopColumn
+       *         The last column which is needed.
+       * @param  band
+       *         For BSQ data, the band number. When called on BIP data, this is assumed to be ALL_BANDS.
+       */
+      bool matches(DimensionDescriptor startRow, int concurrentRows, DimensionDescriptor startColumn,
+         DimensionDescriptor stopColumn, DimensionDescriptor band);
+
       /**
        * Accessor function to private data.
        *
@@ -87,6 +136,14 @@ public:
        */
       DimensionDescriptor getStartRow() const;
 
+      /**
+       * Accessor function to private data.
+       *
+       * @return The start column of this block.  This is only meaningful if
+       *         getConcurrentColumns() is not 0.
+       */
+      DimensionDescriptor getStartColumn() const;
+
       /**
        * Accessor function to private data.
        *
@@ -108,6 +165,14 @@ public:
        */
       unsigned int getConcurrentRows();
 
+      /**
+       * Get the number of concurrent columns contained in the cache unit.
+       *
+       * @return The number of concurrent columns contained in the cache unit,
+       *         or 0 if the cache unit contains all columns.
+       */
+      unsigned int getConcurrentColumns() const;
+
       /**
        * Get the number of interline bytes contained in the cache unit.
        *
@@ -119,6 +184,8 @@ public:
       char* mpData;
       DimensionDescriptor mStartRow;
       int mConcurrentRows;
+      DimensionDescriptor mStartColumn;
+      unsigned int mConcurrentColumns;
       DimensionDescriptor mBand; // for BSQ
       size_t mSize;
       unsigned int mInterlineBytes;
@@ -160,9 +227,10 @@ public:
 
 
    /**
-    * Inherited obligations that return 0.
+    * Accessor to the number of columns in each row of this page.
     *
-    * @return Returns 0.
+    * @return The number of concurrent columns in the cache unit, or 0
+    *         if the cache unit contains all columns.
     */
    unsigned int getNumColumns();
    
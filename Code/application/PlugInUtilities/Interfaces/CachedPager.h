@@ -13,11 +13,13 @@
 #include <string>
 
 #include "CachedPage.h"
+#include "ConfigurationSettings.h"
 #include "PageCache.h"
 #include "RasterPagerShell.h"
 #include "RasterPage.h"
 
 #include <memory>
+#include <vector>
 
 class RasterDataDescriptor;
 class RasterElement;
@@ -35,10 +37,18 @@ namespace mta
  *  to function with 2 threads, each reading odd and even rows).
  *  developers would take this class and extend it to support their 
  *  algorithm specific code.
+ *
+ *  Subclasses may also enable read-ahead with setPrefetchEnabled().  When
+ *  enabled, requests which walk sequentially through blocks of rows (or, for
+ *  BSQ data, through bands) cause the next few units to be fetched on
+ *  background threads so that decoding overlaps with processing.
  */
 class CachedPager : public RasterPagerShell
 {
 public:
+   SETTING(PrefetchDepth, CachedPager, unsigned int, 4)
+   SETTING(PrefetchMemoryLimit, CachedPager, unsigned int, 16 * 1024 * 1024)
+
    /**
     * The name to use for the raster element argument.
     *
@@ -66,7 +76,8 @@ public:
    /**
     * Creates a CachedPager PlugIn.
     *
-    * Sets cache size to 10 MB. Sets writable flag to false.
+    * Cached data shares the process-wide RasterCache budget with all other
+    * pagers.  Sets writable flag to false.
     *
     * Subclasses need to override private pure virtual methods to
     * open the file and get a block from that file.
@@ -76,13 +87,18 @@ public:
    /**
     * Creates a CachedPager PlugIn.
     *
-    * Sets cache size to cacheSize bytes. Sets writable flag to false.
+    * Sets writable flag to false.
     *
     * Subclasses need to override private pure virtual methods to
     * open the file and get a block from that file.
     *
     * @param cacheSize
-    *        Number of bytes in the page cache.
+    *        Ignored.  Cached data shares the process-wide RasterCache budget.
+    *
+    * @deprecated
+    *        This constructor is deprecated, and may be removed in a future
+    *        version.\  Use CachedPager() and the RasterCache::CacheSize
+    *        setting instead.
     */
    CachedPager(const size_t cacheSize);
 
@@ -304,11 +320,96 @@ protected:
     */
    virtual double getChunkSize() const;
 
+   /**
+    *  Specifies whether fetchUnit() may be called by multiple threads at the same time.
+    *
+    *  Cache lookups never wait on a fetch of a different unit.  If this method returns
+    *  false, calls to fetchUnit() are additionally serialized so that subclasses which
+    *  keep a single file handle do not need to provide their own locking.  Subclasses
+    *  which can read from multiple threads at once (e.g. by opening a handle per call)
+    *  should override this method and return true so that cache misses on different
+    *  units are fetched in parallel.
+    *
+    *  @return  True if fetchUnit() is thread-safe. Default implementation returns false.
+    */
+   virtual bool canFetchConcurrently() const;
+
+   /**
+    *  Returns the number of rows in each tile of a natively tiled file.
+    *
+    *  When getTileColumnCount() returns a nonzero value, blocks of rows are
+    *  rounded up to a multiple of this value so that each tile is read for
+    *  only one unit.
+    *
+    *  @return  The number of rows in each tile, or 0 if the file is not tiled
+    *           or the tile height does not matter.  Default implementation returns 0.
+    */
+   virtual unsigned int getTileRowCount() const;
+
+   /**
+    *  Returns the number of columns in each tile of a natively tiled file.
+    *
+    *  If this method returns a nonzero value, each unit contains a single
+    *  column of tiles, so that a tile is fetched at most once regardless of
+    *  which columns are requested.  Pages for requests which span several
+    *  tile columns are assembled from the cached units.  fetchUnit() will be
+    *  passed a request whose columns are those of one tile column.  The unit
+    *  returned by fetchUnit() must then contain only those columns and be
+    *  created with the CachedPage::CacheUnit constructor which accepts the
+    *  start column and number of columns.
+    *
+    *  @return  The number of columns in each tile, or 0 if fetchUnit() should
+    *           always read full rows.  Default implementation returns 0.
+    */
+   virtual unsigned int getTileColumnCount() const;
+
+   /**
+    *  Enables or disables fetching units ahead of sequential requests.
+    *
+    *  Prefetching is disabled by default.  The number of units fetched ahead is
+    *  determined by the PrefetchDepth setting, limited so that the units fetched
+    *  ahead do not exceed the PrefetchMemoryLimit setting or half of the cache.
+    *
+    *  Units are fetched on background threads by calling fetchUnit(), but only
+    *  while pages returned by getPage() have not been released.  Releasing the
+    *  last page discards any pending read-ahead and waits for fetches in
+    *  progress to complete, so subclasses do not need to disable prefetching in
+    *  their destructor.  Subclasses which override getPage() or releasePage()
+    *  <b>must</b> call the CachedPager implementation for every page so that
+    *  prefetching stops before the pager is destroyed.
+    *
+    *  This method is not thread-safe and should not be called while pages
+    *  are being requested.
+    *
+    *  @param   enabled
+    *           \c true to enable prefetching, \c false to disable it.
+    */
+   void setPrefetchEnabled(bool enabled);
+
 private:
    CachedPager& operator=(const CachedPager& rhs);
 
+   class Prefetcher;
+
+   CachedPage::UnitPtr getUnit(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+      unsigned int rowsPerBlock, DimensionDescriptor startRow, unsigned int concurrentRows,
+      DimensionDescriptor startColumn, DimensionDescriptor stopColumn, DimensionDescriptor band,
+      DimensionDescriptor startBand, DimensionDescriptor stopBand);
+   CachedPage::UnitPtr combineUnits(const std::vector<CachedPage::UnitPtr>& tiles,
+      InterleaveFormatType requestedFormat, DimensionDescriptor startRow) const;
+   unsigned int getUnitColumnCount(unsigned int unitStartColumn) const;
+   CachedPage::UnitPtr fetchBlock(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+      unsigned int rowsPerBlock, unsigned int concurrentRows, DimensionDescriptor startBand,
+      DimensionDescriptor stopBand);
+   void schedulePrefetch(InterleaveFormatType requestedFormat, const PageCache::UnitKey& key,
+      unsigned int tileCount, unsigned int rowsPerBlock, unsigned int concurrentRows, DimensionDescriptor startBand,
+      DimensionDescriptor stopRow, DimensionDescriptor stopBand);
+
    PageCache mCache;
    std::auto_ptr<mta::DMutex> mpMutex;
+   std::auto_ptr<Prefetcher> mpPrefetcher;
+   unsigned int mPrefetchDepth;
+   size_t mPrefetchMemoryLimit;
    std::string mFilename;
    RasterDataDescriptor* mpDescriptor;
    RasterElement* mpRaster;
@@ -339,6 +440,11 @@ private:
     *  and two separate DataAccessors wish to access different parts of the same
     *  page.
     *
+    *  The request contains all columns unless getTileColumnCount() returns
+    *  a nonzero value, in which case the request may contain a subset of the
+    *  columns as given by DataRequest::getStartColumn() and
+    *  DataRequest::getConcurrentColumns().
+    *
     *  @param pOriginalRequest
     *         The request to fulfill.
     */
@@ -0,0 +1,124 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef COVARIANCECALCULATOR_H
+#define COVARIANCECALCULATOR_H
+
+#include "AppConfig.h"
+
+#include <string>
+#include <vector>
+
+class BitMask;
+class Progress;
+class RasterElement;
+
+/**
+ *  Computes the mean and covariance of the bands of a RasterElement.
+ *
+ *  The data is read once.  The rows are divided among threads, and each
+ *  thread converts blocks of pixels to band-major order and accumulates the
+ *  scatter matrix of each block about the block mean.  The blocks and the
+ *  threads are combined with a pairwise update of the means and scatter
+ *  matrices, which avoids the loss of precision of accumulating raw sums of
+ *  squares while still requiring only a single pass over the data.
+ *
+ *  The pixels used can be limited by a mask and by row and column skip
+ *  factors.  A pixel is used if it is selected in the mask and its row and
+ *  column indices are multiples of the row and column factors.
+ */
+class CovarianceCalculator
+{
+public:
+   /**
+    *  Creates a calculator for a RasterElement.
+    *
+    *  @param   pRaster
+    *           The data to process.  The data type must not be complex.
+    *  @param   pMask
+    *           The pixels to use.  If \c NULL, all pixels are used.
+    *  @param   rowFactor
+    *           Use every rowFactor-th row, starting with the first row.
+    *           Values less than 1 are treated as 1.
+    *  @param   columnFactor
+    *           Use every columnFactor-th column, starting with the first
+    *           column.  Values less than 1 are treated as 1.
+    */
+   CovarianceCalculator(const RasterElement* pRaster, const BitMask* pMask = NULL, int rowFactor = 1,
+      int columnFactor = 1);
+
+   /**
+    *  Reads the data and computes the means and covariance.
+    *
+    *  @param   pProgress
+    *           The progress object to update.  May be \c NULL.
+    *  @param   message
+    *           The message reported with the progress.
+    *  @param   pAbortFlag
+    *           A flag which is polled while the data is read.  If it becomes
+    *           \c true, the calculation stops.  May be \c NULL.
+    *
+    *  @return  \c true if the calculation completed and at least one pixel
+    *           was used, or \c false if the data could not be read, no
+    *           pixels were selected, or the calculation was aborted.
+    */
+   bool calculate(Progress* pProgress, const std::string& message, const bool* pAbortFlag = NULL);
+
+   /**
+    *  Returns the number of bands in the data.
+    *
+    *  @return  The dimension of the means and the matrices.
+    */
+   unsigned int getBandCount() const;
+
+   /**
+    *  Returns the number of pixels used by the last calculation.
+    *
+    *  @return  The number of pixels which were selected.
+    */
+   uint64_t getPixelCount() const;
+
+   /**
+    *  Returns the mean of each band.
+    *
+    *  @return  The means computed by calculate().
+    */
+   const std::vector<double>& getMeans() const;
+
+   /**
+    *  Returns the covariance matrix.
+    *
+    *  @return  The population covariance of the bands, normalized by the
+    *           number of pixels, stored as a full symmetric matrix in row
+    *           major order.
+    */
+   const std::vector<double>& getCovariance() const;
+
+   /**
+    *  Computes the second moment matrix.
+    *
+    *  @param   secondMoment
+    *           Populated with the mean of the outer product of each pixel
+    *           with itself, stored as a full symmetric matrix in row major
+    *           order.
+    */
+   void getSecondMoment(std::vector<double>& secondMoment) const;
+
+private:
+   const RasterElement* mpRaster;
+   const BitMask* mpMask;
+   int mRowFactor;
+   int mColumnFactor;
+   unsigned int mBandCount;
+   uint64_t mPixelCount;
+   std::vector<double> mMeans;
+   std::vector<double> mCovariance;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef INTERLEAVETRANSPOSE_H
+#define INTERLEAVETRANSPOSE_H
+
+#include <stddef.h>
+
+/**
+ * This namespace contains functions which rearrange raster elements between
+ * interleave formats.
+ *
+ * Converting a row of BIP data to BIL is a transpose of a matrix of pixels by
+ * bands, and converting a row of BIL data, or the rows of several BSQ bands,
+ * to BIP is the opposite transpose.  The functions here copy the elements in
+ * square tiles which fit in the first level cache, so both the reads and the
+ * writes of each tile touch only a few cache lines.  Elements of 1, 2, 4, and
+ * 8 bytes are copied as integers of that size, which the compiler unrolls and
+ * vectorizes, instead of calling memcpy() for each element.
+ *
+ * All strides and offsets are in elements, not bytes.
+ */
+namespace InterleaveTranspose
+{
+   /**
+    * Transposes a matrix of elements.
+    *
+    * Element (row, column) of the source is copied to element (column, row)
+    * of the destination.  The source and destination must not overlap.
+    *
+    * @param pSource
+    *        The first element of the source.
+    * @param rows
+    *        The number of rows in the source.
+    * @param columns
+    *        The number of columns in the source.
+    * @param sourceStride
+    *        The distance between the starts of successive source rows.
+    * @param pDestination
+    *        The first element of the destination.
+    * @param destinationStride
+    *        The distance between the starts of successive destination rows.
+    * @param bytesPerElement
+    *        The size of each element.
+    */
+   void transpose(const void* pSource, size_t rows, size_t columns, size_t sourceStride, void* pDestination,
+      size_t destinationStride, unsigned int bytesPerElement);
+
+   /**
+    * Transposes a matrix of elements whose rows are stored separately.
+    *
+    * This is used to interleave rows which come from different data
+    * accessors, such as the same row of several BSQ bands.  Element \em column
+    * of row \em row is copied to element (column, row) of the destination.
+    *
+    * @param ppSourceRows
+    *        The first element of each source row.
+    * @param rows
+    *        The number of source rows.
+    * @param columns
+    *        The number of elements in each source row.
+    * @param pDestination
+    *        The first element of the destination.
+    * @param destinationStride
+    *        The distance between the starts of successive destination rows.
+    * @param bytesPerElement
+    *        The size of each element.
+    */
+   void transpose(const void* const* ppSourceRows, size_t rows, size_t columns, void* pDestination,
+      size_t destinationStride, unsigned int bytesPerElement);
+
+   /**
+    * Copies selected elements into a contiguous buffer.
+    *
+    * This is used to extract a subset of the columns or bands of a row.
+    *
+    * @param pSource
+    *        The first element of the source.
+    * @param pOffsets
+    *        The offset from \em pSource of each element to copy.
+    * @param count
+    *        The number of elements to copy.
+    * @param pDestination
+    *        Populated with \em count elements.
+    * @param bytesPerElement
+    *        The size of each element.
+    */
+   void gather(const void* pSource, const size_t* pOffsets, size_t count, void* pDestination,
+      unsigned int bytesPerElement);
+}
+
+#endif
@@ -10,17 +10,15 @@
 #ifndef PAGECACHE_H
 #define PAGECACHE_H
 
-#include <list>
-
-#include <boost/shared_array.hpp>
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
 #include "CachedPage.h"
 #include "DimensionDescriptor.h"
-#include "LocationType.h"
-
+#include "RasterCache.h"
 #include "TypesFile.h"
 
-class DataRequest;
+#include <string>
+#include <vector>
 
 /**
  * Provides an LRU cache designed to provide faster access to pages if such
@@ -29,23 +27,93 @@ class DataRequest;
  * For example, a multi-threaded algorithm could get a DataAccessor to odd
  * and even rows. These two threads would be able to share the same page.
  *
- * When clearing units from the cache, it simply removed the oldest units
- * from the cache.  It is possible that a CachedPage still holds a reference
+ * Units are identified by a UnitKey (a block of rows, a range of columns and a
+ * band) and are spread
+ * across a number of independently locked shards so that threads accessing
+ * different units do not contend with each other.  Lookup within a shard is a
+ * hash table lookup.  When a unit is missing, the first thread to ask for it is
+ * told to fetch it; any other thread asking for the same unit before the fetch
+ * completes waits for that fetch instead of reading the same data again.
+ *
+ * The memory used by the cache is allocated from the process-wide RasterCache,
+ * so the size of the cache is bounded by a single budget shared by all datasets
+ * rather than by a size for each cache.  When that budget is exceeded, the least
+ * recently used units are removed from whichever cache holds them.  It is possible that a CachedPage still holds a reference
  * to the released unit.  Since the units are consistently referred to with
  * shared_ptrs, the actual memory will not be released until the last page
  * is destroyed.  This does, however, allow duplicate units -- one that the cache
  * knows about, and one that a lingering CachedPage references.
  */
-class PageCache
+class PageCache : public RasterCacheClient
 {
 public:
    /**
-    * Creates a thread-safe LRU PageCache.
-    *
-    * @param  maxCacheSize
-    *         The maximum size of the cache in bytes.
+    * Identifies a unit within the cache.
     */
-   PageCache(const size_t maxCacheSize = 20000000);
+   class UnitKey
+   {
+   public:
+      /**
+       * Creates a UnitKey.
+       *
+       * @param  block
+       *         The zero-based index of the block of rows contained in the unit.
+       * @param  band
+       *         The active band number contained in the unit if BSQ, or -1 if the
+       *         unit contains all bands.
+       * @param  startColumn
+       *         The first active column contained in the unit.
+       * @param  columnCount
+       *         The number of columns contained in the unit, or 0 if the unit
+       *         contains all columns.
+       */
+      UnitKey(unsigned int block = 0, int band = -1, unsigned int startColumn = 0, unsigned int columnCount = 0) :
+         mBlock(block),
+         mBand(band),
+         mStartColumn(startColumn),
+         mColumnCount(columnCount)
+      {
+      }
+
+      /**
+       * Compares two keys.
+       *
+       * @param  other
+       *         The key to compare with.
+       *
+       * @return True if both keys refer to the same unit, false otherwise.
+       */
+      bool operator==(const UnitKey& other) const
+      {
+         return mBlock == other.mBlock && mBand == other.mBand &&
+            mStartColumn == other.mStartColumn && mColumnCount == other.mColumnCount;
+      }
+
+      /**
+       * The zero-based index of the block of rows contained in the unit.
+       */
+      unsigned int mBlock;
+
+      /**
+       * The active band number contained in the unit, or -1 for all bands.
+       */
+      int mBand;
+
+      /**
+       * The first active column contained in the unit.
+       */
+      unsigned int mStartColumn;
+
+      /**
+       * The number of columns contained in the unit, or 0 for all columns.
+       */
+      unsigned int mColumnCount;
+   };
+
+   /**
+    * Creates a thread-safe LRU PageCache and registers it with the RasterCache.
+    */
+   PageCache();
 
    /**
     * Destroys the thread-safe LRU PageCache.
@@ -55,27 +123,65 @@ public:
    /**
     * Fetches a unit from the cache.
     *
-    * See RasterPager::getPage() for details on the parameters.
+    * This method may be called simultaneously by multiple threads.  If another
+    * thread is currently fetching the unit for \p key, this method blocks until
+    * that fetch has completed.
     *
-    * @return A CacheUnit object containing the startRow, startColumn, and startBand,
-    *         and containing and least concurrentRows number of rows, concurrentColumns number
-    *         of columns, and concurrentBands number of bands.
+    * @param  key
+    *         The key identifying the unit.
+    * @param  startRow
+    *         The first row which must be contained by the unit.
+    * @param  concurrentRows
+    *         The number of rows starting at \p startRow which must be contained by the unit.
+    * @param  startColumn
+    *         The first column which must be contained by the unit.
+    * @param  stopColumn
+    *         The last column which must be contained by the unit.
+    * @param  band
+    *         The band which must be contained by the unit if BSQ, or CachedPage::CacheUnit::ALL_BANDS.
+    * @param  fetchRequired
+    *         Set to true if the unit is not in the cache and the caller is now
+    *         responsible for fetching it.  The caller must then call insertUnit()
+    *         with the same \p key, even if the fetch fails, so that other threads
+    *         waiting on the unit are released.
+    *
+    * @return The cached unit, or a NULL unit if \p fetchRequired is set to true.
+    */
+   CachedPage::UnitPtr getUnit(const UnitKey& key, DimensionDescriptor startRow, unsigned int concurrentRows,
+      DimensionDescriptor startColumn, DimensionDescriptor stopColumn, DimensionDescriptor band,
+      bool& fetchRequired);
+
+   /**
+    * Reserves a unit for fetching without waiting.
+    *
+    * This is used to read units ahead of when they are needed.  Unlike getUnit(),
+    * this method never blocks on a fetch being performed by another thread.
+    *
+    * @param  key
+    *         The key identifying the unit.
+    *
+    * @return True if the unit is neither cached nor being fetched, in which case
+    *         the caller is now responsible for fetching it and calling insertUnit().
+    *         False if the unit does not need to be fetched.
     */
-   CachedPage::UnitPtr getUnit(DataRequest *pOriginalRequest,
-      DimensionDescriptor startRow, 
-      DimensionDescriptor startBand);
+   bool reserveUnit(const UnitKey& key);
 
    /**
-    * An STL list of PagePtr.
+    * Adds a unit to the cache after it has been fetched.
+    *
+    * Any unit already cached under \p key is replaced and threads waiting on
+    * \p key are released.
     *
-    * This list is provided in such a fashion so that calling std::list<UnitPtr>::erase()
-    * on an iterator will also delete the CacheUnit properly if it is the last
-    * reference.
+    * @param  key
+    *         The key which was passed to getUnit() or reserveUnit().
+    * @param  pUnit
+    *         The fetched unit.  This may be NULL if the fetch failed, in which
+    *         case nothing is added to the cache.
     */
-   typedef std::list<CachedPage::UnitPtr> UnitList;
+   void insertUnit(const UnitKey& key, CachedPage::UnitPtr pUnit);
 
    /**
-    * Initializes member variables of the cache & resets hit/miss counts.
+    * Initializes member variables of the cache.
     *
     * This must be done after construction of the cache.
     *
@@ -86,8 +192,54 @@ public:
     *         The number of columns in file on disk.
     * @param  bandCount
     *         The number of bands in the file on disk.
+    * @param  name
+    *         The name reported by getCacheName(), typically the name of the
+    *         RasterElement being cached.
     */
-   void initialize(int bytesPerBand, int columnCount, int bandCount);
+   void initialize(int bytesPerBand, int columnCount, int bandCount, const std::string& name = std::string());
+
+   /**
+    * Get the maximum size of the cache.
+    *
+    * @return The maximum size of the cache in bytes.  This is the budget
+    *         shared by all caches, as returned by RasterCache::getMaximumSize().
+    */
+   size_t getMaxCacheSize() const;
+
+   /**
+    * @copydoc RasterCacheClient::getCacheName()
+    */
+   std::string getCacheName() const;
+
+   /**
+    * @copydoc RasterCacheClient::getCacheSize()
+    */
+   size_t getCacheSize() const;
+
+   /**
+    * @copydoc RasterCacheClient::getLeastRecentAccess()
+    */
+   bool getLeastRecentAccess(size_t& access) const;
+
+   /**
+    * @copydoc RasterCacheClient::evictLeastRecentlyUsed()
+    */
+   size_t evictLeastRecentlyUsed();
+
+   /**
+    * @copydoc RasterCacheClient::getHitCount()
+    */
+   size_t getHitCount() const;
+
+   /**
+    * @copydoc RasterCacheClient::getMissCount()
+    */
+   size_t getMissCount() const;
+
+   /**
+    * @copydoc RasterCacheClient::getEvictionCount()
+    */
+   size_t getEvictionCount() const;
 
    /**
     * Create a CachedPage for the given cache unit.
@@ -107,20 +259,27 @@ public:
     *         takes ownership over the created page.
     */
    CachedPage *createPage(CachedPage::UnitPtr pUnit, InterleaveFormatType requestedFormat,
-      DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand);
+      DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand) const;
 
 protected:
-   const size_t MAX_CACHE_SIZE;
-   UnitList mUnits;
-   std::string mFilename;
-   size_t mCacheSize;
+   struct Shard;
+
+   RasterCache* mpRasterCache;
+   std::vector<Shard*> mShards;
+   boost::atomic<size_t> mCacheSize;
+   boost::atomic<size_t> mHitCount;
+   boost::atomic<size_t> mMissCount;
+   boost::atomic<size_t> mEvictionCount;
    int mBytesPerBand;
    int mColumnCount;
    int mBandCount;
+   std::string mName;
 
-   void enforceCacheSize();
+   Shard& getShard(const UnitKey& key) const;
+   Shard* findLeastRecentlyUsed(size_t& access) const;
 
 private:
+   PageCache(const PageCache& rhs);
    PageCache& operator=(const PageCache& rhs);
 };
 
@@ -0,0 +1,183 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include "AppConfig.h"
+
+#include <utility>
+#include <vector>
+
+/**
+ *  Approximates the distribution of a stream of values in bounded memory.
+ *
+ *  The sketch keeps a hierarchy of compactors.  Values are added to the first
+ *  level, and when a level is full it is sorted and every other value is
+ *  promoted to the next level, where it represents twice as many values.
+ *  The total weight of the retained values always equals the number of values
+ *  added, so the rank of any value can be estimated with an error which
+ *  decreases as the capacity increases.
+ *
+ *  Sketches built from separate parts of the data can be merged, which allows
+ *  each thread of an algorithm to keep its own sketch.  A sketch can be saved
+ *  with getLevels() and restored with setLevels(), so that it can be merged or
+ *  queried later without reading the data again.
+ *
+ *  @see     Statistics::getQuantileSketch()
+ */
+class QuantileSketch
+{
+public:
+   /**
+    *  Creates an empty sketch.
+    *
+    *  @param   capacity
+    *           The number of values retained by the top level.  Lower levels
+    *           retain fewer values, except the first level, which buffers up
+    *           to this many values before they are compacted.  The rank error
+    *           is approximately proportional to 1 / capacity.  Values less
+    *           than 8 are increased to 8.
+    */
+   explicit QuantileSketch(unsigned int capacity = 1024);
+
+   /**
+    *  Returns the capacity of the top level.
+    *
+    *  @return  The capacity specified when the sketch was created.
+    */
+   unsigned int getCapacity() const;
+
+   /**
+    *  Adds a value to the sketch.
+    *
+    *  @param   value
+    *           The value to add.
+    */
+   void add(double value);
+
+   /**
+    *  Adds the values of another sketch to this sketch.
+    *
+    *  @param   sketch
+    *           The sketch to merge.  The sketch may have a different capacity.
+    */
+   void merge(const QuantileSketch& sketch);
+
+   /**
+    *  Removes all values from the sketch.
+    */
+   void clear();
+
+   /**
+    *  Returns whether any values have been added to the sketch.
+    *
+    *  @return  \c true if no values have been added, \c false otherwise.
+    */
+   bool isEmpty() const;
+
+   /**
+    *  Returns the number of values added to the sketch.
+    *
+    *  @return  The total weight of the values in the sketch.
+    */
+   uint64_t getCount() const;
+
+   /**
+    *  Returns the smallest value added to the sketch.
+    *
+    *  @return  The exact minimum, or 0.0 if the sketch is empty.
+    */
+   double getMinimum() const;
+
+   /**
+    *  Returns the largest value added to the sketch.
+    *
+    *  @return  The exact maximum, or 0.0 if the sketch is empty.
+    */
+   double getMaximum() const;
+
+   /**
+    *  Estimates the value at a given fraction of the sorted values.
+    *
+    *  @param   fraction
+    *           The fraction, from 0.0 to 1.0.  A fraction of 0.5 returns the
+    *           median.
+    *
+    *  @return  The estimated value, or 0.0 if the sketch is empty.
+    */
+   double getQuantile(double fraction) const;
+
+   /**
+    *  Estimates the fraction of the values which are less than a given value.
+    *
+    *  @param   value
+    *           The value to rank.
+    *
+    *  @return  The estimated fraction, from 0.0 to 1.0.
+    */
+   double getRank(double value) const;
+
+   /**
+    *  Returns the values retained by the sketch.
+    *
+    *  @return  The retained values sorted in ascending order, each paired with
+    *           the number of values it represents.
+    */
+   const std::vector<std::pair<double, uint64_t> >& getWeightedValues() const;
+
+   /**
+    *  Gets the contents of the sketch for serialization.
+    *
+    *  @param   values
+    *           Populated with the retained values of every level, starting
+    *           with the first level.
+    *  @param   levelCounts
+    *           Populated with the number of values in each level.  Each value
+    *           in level n represents 2^n values.
+    */
+   void getLevels(std::vector<double>& values, std::vector<unsigned int>& levelCounts) const;
+
+   /**
+    *  Restores the contents of the sketch.
+    *
+    *  @param   values
+    *           The retained values of every level, as returned by getLevels().
+    *  @param   levelCounts
+    *           The number of values in each level, as returned by getLevels().
+    *  @param   minimum
+    *           The smallest value added to the sketch.
+    *  @param   maximum
+    *           The largest value added to the sketch.
+    *
+    *  @return  \c true if the sketch was restored, or \c false if the level
+    *           counts do not match the number of values.  The sketch is
+    *           empty if \c false is returned.
+    */
+   bool setLevels(const std::vector<double>& values, const std::vector<unsigned int>& levelCounts,
+      double minimum, double maximum);
+
+private:
+   void updateLevelCapacities();
+   void compress();
+   void compact(size_t level);
+
+   unsigned int mCapacity;
+   std::vector<std::vector<double> > mLevels;
+   std::vector<unsigned int> mLevelCapacities;
+   uint64_t mCount;
+   double mMinimum;
+   double mMaximum;
+   unsigned int mCompactions;
+
+   mutable std::vector<std::pair<double, uint64_t> > mWeightedValues;
+   mutable bool mWeightedValuesValid;
+};
+
+#endif
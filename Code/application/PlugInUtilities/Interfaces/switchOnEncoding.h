@@ -11,6 +11,7 @@
 #define SWITCHONENCODING_H
 
 #include "ComplexData.h"
+#include "RowView.h"
 
 #define switchOnEncoding(encoding,function,...) \
    switch (encoding) \
@@ -80,4 +81,22 @@
       break; \
    }
 
+// Calls function with an InterleaveTraits instance as the first argument so that
+// the interleave can be deduced as a template parameter, e.g. for use with RowView.
+#define switchOnInterleave(interleave,function,...) \
+   switch (interleave) \
+   { \
+   case BIP: \
+      function(InterleaveTraits<BIP>(), __VA_ARGS__); \
+      break; \
+   case BIL: \
+      function(InterleaveTraits<BIL>(), __VA_ARGS__); \
+      break; \
+   case BSQ: \
+      function(InterleaveTraits<BSQ>(), __VA_ARGS__); \
+      break; \
+   default: \
+      break; \
+   }
+
 #endif
@@ -0,0 +1,163 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "InterleaveTranspose.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+   // The number of rows and columns in each tile.  A tile of 8 byte elements occupies 8 KB of the
+   // source and 8 KB of the destination, which leaves room in the cache for the row pointers.
+   const size_t TILE_SIZE = 32;
+
+   template<typename T>
+   void transposeTiles(const unsigned char* const* ppRows, size_t firstRow, size_t rows, size_t columns,
+      unsigned char* pDestination, size_t destinationStride)
+   {
+      const T* typedRows[TILE_SIZE];
+      for (size_t row = 0; row < rows; ++row)
+      {
+         typedRows[row] = reinterpret_cast<const T*>(ppRows[row]);
+      }
+
+      T* pTypedDestination = reinterpret_cast<T*>(pDestination) + firstRow;
+      for (size_t firstColumn = 0; firstColumn < columns; firstColumn += TILE_SIZE)
+      {
+         size_t stopColumn = std::min(firstColumn + TILE_SIZE, columns);
+         for (size_t column = firstColumn; column < stopColumn; ++column)
+         {
+            T* pOutput = pTypedDestination + column * destinationStride;
+            for (size_t row = 0; row < rows; ++row)
+            {
+               pOutput[row] = typedRows[row][column];
+            }
+         }
+      }
+   }
+
+   void transposeBytes(const unsigned char* const* ppRows, size_t firstRow, size_t rows, size_t columns,
+      unsigned char* pDestination, size_t destinationStride, unsigned int bytesPerElement)
+   {
+      for (size_t firstColumn = 0; firstColumn < columns; firstColumn += TILE_SIZE)
+      {
+         size_t stopColumn = std::min(firstColumn + TILE_SIZE, columns);
+         for (size_t column = firstColumn; column < stopColumn; ++column)
+         {
+            unsigned char* pOutput = pDestination + (column * destinationStride + firstRow) * bytesPerElement;
+            for (size_t row = 0; row < rows; ++row)
+            {
+               memcpy(pOutput + row * bytesPerElement, ppRows[row] + column * bytesPerElement, bytesPerElement);
+            }
+         }
+      }
+   }
+
+   // Transposes up to TILE_SIZE source rows into the destination, starting at destination column firstRow
+   void transposeRowTile(const unsigned char* const* ppRows, size_t firstRow, size_t rows, size_t columns,
+      unsigned char* pDestination, size_t destinationStride, unsigned int bytesPerElement)
+   {
+      switch (bytesPerElement)
+      {
+      case 1:
+         transposeTiles<uint8_t>(ppRows, firstRow, rows, columns, pDestination, destinationStride);
+         break;
+      case 2:
+         transposeTiles<uint16_t>(ppRows, firstRow, rows, columns, pDestination, destinationStride);
+         break;
+      case 4:
+         transposeTiles<uint32_t>(ppRows, firstRow, rows, columns, pDestination, destinationStride);
+         break;
+      case 8:
+         transposeTiles<uint64_t>(ppRows, firstRow, rows, columns, pDestination, destinationStride);
+         break;
+      default:
+         transposeBytes(ppRows, firstRow, rows, columns, pDestination, destinationStride, bytesPerElement);
+         break;
+      }
+   }
+
+   template<typename T>
+   void gatherElements(const void* pSource, const size_t* pOffsets, size_t count, void* pDestination)
+   {
+      const T* pTypedSource = reinterpret_cast<const T*>(pSource);
+      T* pTypedDestination = reinterpret_cast<T*>(pDestination);
+      for (size_t i = 0; i < count; ++i)
+      {
+         pTypedDestination[i] = pTypedSource[pOffsets[i]];
+      }
+   }
+}
+
+void InterleaveTranspose::transpose(const void* pSource, size_t rows, size_t columns, size_t sourceStride,
+   void* pDestination, size_t destinationStride, unsigned int bytesPerElement)
+{
+   const unsigned char* pBytes = reinterpret_cast<const unsigned char*>(pSource);
+   const unsigned char* rowPointers[TILE_SIZE];
+   for (size_t firstRow = 0; firstRow < rows; firstRow += TILE_SIZE)
+   {
+      size_t tileRows = std::min(TILE_SIZE, rows - firstRow);
+      for (size_t row = 0; row < tileRows; ++row)
+      {
+         rowPointers[row] = pBytes + (firstRow + row) * sourceStride * bytesPerElement;
+      }
+
+      transposeRowTile(rowPointers, firstRow, tileRows, columns, reinterpret_cast<unsigned char*>(pDestination),
+         destinationStride, bytesPerElement);
+   }
+}
+
+void InterleaveTranspose::transpose(const void* const* ppSourceRows, size_t rows, size_t columns,
+   void* pDestination, size_t destinationStride, unsigned int bytesPerElement)
+{
+   const unsigned char* rowPointers[TILE_SIZE];
+   for (size_t firstRow = 0; firstRow < rows; firstRow += TILE_SIZE)
+   {
+      size_t tileRows = std::min(TILE_SIZE, rows - firstRow);
+      for (size_t row = 0; row < tileRows; ++row)
+      {
+         rowPointers[row] = reinterpret_cast<const unsigned char*>(ppSourceRows[firstRow + row]);
+      }
+
+      transposeRowTile(rowPointers, firstRow, tileRows, columns, reinterpret_cast<unsigned char*>(pDestination),
+         destinationStride, bytesPerElement);
+   }
+}
+
+void InterleaveTranspose::gather(const void* pSource, const size_t* pOffsets, size_t count, void* pDestination,
+   unsigned int bytesPerElement)
+{
+   switch (bytesPerElement)
+   {
+   case 1:
+      gatherElements<uint8_t>(pSource, pOffsets, count, pDestination);
+      break;
+   case 2:
+      gatherElements<uint16_t>(pSource, pOffsets, count, pDestination);
+      break;
+   case 4:
+      gatherElements<uint32_t>(pSource, pOffsets, count, pDestination);
+      break;
+   case 8:
+      gatherElements<uint64_t>(pSource, pOffsets, count, pDestination);
+      break;
+   default:
+   {
+      const unsigned char* pBytes = reinterpret_cast<const unsigned char*>(pSource);
+      unsigned char* pOutput = reinterpret_cast<unsigned char*>(pDestination);
+      for (size_t i = 0; i < count; ++i)
+      {
+         memcpy(pOutput + i * bytesPerElement, pBytes + pOffsets[i] * bytesPerElement, bytesPerElement);
+      }
+      break;
+   }
+   }
+}
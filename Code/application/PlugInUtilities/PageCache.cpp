@@ -8,86 +8,212 @@
  */
 
 #include "AppVerify.h"
-#include "DataRequest.h"
+#include "DMutex.h"
+#include "ModelServices.h"
 #include "PageCache.h"
+#include "RasterCache.h"
 #include "TypesFile.h"
 
-#include <algorithm>
-#include <boost/bind.hpp>
-#include <sstream>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <limits>
+#include <list>
 using namespace std;
 
-PageCache::PageCache(const size_t maxCacheSize) :
-   MAX_CACHE_SIZE(maxCacheSize),
-   mCacheSize(0)
+namespace
 {
+   const unsigned int SHARD_COUNT = 16;
+
+   struct UnitKeyHash
+   {
+      size_t operator()(const PageCache::UnitKey& key) const
+      {
+         size_t seed = 0;
+         boost::hash_combine(seed, key.mBlock);
+         boost::hash_combine(seed, key.mBand);
+         boost::hash_combine(seed, key.mStartColumn);
+         boost::hash_combine(seed, key.mColumnCount);
+         return seed;
+      }
+   };
+}
+
+struct PageCache::Shard
+{
+   struct Entry
+   {
+      Entry(const UnitKey& key, CachedPage::UnitPtr pUnit, size_t lastAccess) :
+         mKey(key),
+         mpUnit(pUnit),
+         mLastAccess(lastAccess)
+      {
+      }
+
+      UnitKey mKey;
+      CachedPage::UnitPtr mpUnit;
+      size_t mLastAccess;
+   };
+
+   typedef list<Entry> EntryList;
+   typedef boost::unordered_map<UnitKey, EntryList::iterator, UnitKeyHash> EntryMap;
+   typedef boost::unordered_set<UnitKey, UnitKeyHash> KeySet;
+
+   mta::DMutex mMutex;
+   mta::DThreadSignal mFetchComplete;
+   EntryList mEntries; // least recently used at the front
+   EntryMap mIndex;
+   KeySet mPending;
+};
+
+PageCache::PageCache() :
+   mpRasterCache(Service<ModelServices>()->getRasterCache()),
+   mCacheSize(0),
+   mHitCount(0),
+   mMissCount(0),
+   mEvictionCount(0)
+{
+   for (unsigned int i = 0; i < SHARD_COUNT; ++i)
+   {
+      mShards.push_back(new Shard);
+   }
    initialize(0, 0, 0);
+   mpRasterCache->addClient(this);
 }
 
 PageCache::~PageCache()
 {
+   mpRasterCache->removeClient(this);
+   mpRasterCache->deallocate(mCacheSize);
+   for (vector<Shard*>::iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      delete *iter;
+   }
+}
+
+PageCache::Shard& PageCache::getShard(const UnitKey& key) const
+{
+   return *mShards[UnitKeyHash()(key) % mShards.size()];
 }
 
-CachedPage::UnitPtr PageCache::getUnit(DataRequest *pOriginalRequest,
-   DimensionDescriptor startRow, 
-   DimensionDescriptor startBand)
+CachedPage::UnitPtr PageCache::getUnit(const UnitKey& key, DimensionDescriptor startRow,
+   unsigned int concurrentRows, DimensionDescriptor startColumn, DimensionDescriptor stopColumn,
+   DimensionDescriptor band, bool& fetchRequired)
 {
-   CachedPage::UnitPtr pUnit;
+   fetchRequired = false;
+
+   Shard& shard = getShard(key);
+   mta::MutexLock lock(shard.mMutex);
+   for (;;)
+   {
+      Shard::EntryMap::iterator ppEntry = shard.mIndex.find(key);
+      if (ppEntry != shard.mIndex.end() &&
+         ppEntry->second->mpUnit->matches(startRow, concurrentRows, startColumn, stopColumn, band)) // cache hit
+      {
+         // Move to the back of the list so that it is the last to be evicted
+         Shard::EntryList::iterator pEntry = ppEntry->second;
+         pEntry->mLastAccess = mpRasterCache->getNextAccess();
+         shard.mEntries.splice(shard.mEntries.end(), shard.mEntries, pEntry);
+         ++mHitCount;
+         return pEntry->mpUnit;
+      }
 
-   VERIFYRV(pOriginalRequest != NULL, pUnit);
+      if (shard.mPending.find(key) == shard.mPending.end()) // cache miss
+      {
+         ++mMissCount;
+         shard.mPending.insert(key);
+         fetchRequired = true;
+         return CachedPage::UnitPtr();
+      }
 
-   InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
-   unsigned int concurrentRows = pOriginalRequest->getConcurrentRows();
+      // Another thread is fetching this unit, so wait for it and look again
+      shard.mFetchComplete.ThreadSignalWait(&shard.mMutex);
+   }
+}
 
-   DimensionDescriptor band = CachedPage::CacheUnit::ALL_BANDS; // default to all bands
-   if (requestedFormat == BSQ)
+bool PageCache::reserveUnit(const UnitKey& key)
+{
+   Shard& shard = getShard(key);
+   mta::MutexLock lock(shard.mMutex);
+   if (shard.mIndex.find(key) != shard.mIndex.end() || shard.mPending.find(key) != shard.mPending.end())
    {
-      band = startBand;
+      return false;
    }
-   UnitList ::iterator ppMatchingUnit = find_if (mUnits.begin(), mUnits.end(), 
-      boost::bind(&CachedPage::CacheUnit::matches, _1, startRow, concurrentRows, band));
 
-   if (ppMatchingUnit != mUnits.end()) // cache hit
+   shard.mPending.insert(key);
+   return true;
+}
+
+void PageCache::insertUnit(const UnitKey& key, CachedPage::UnitPtr pUnit)
+{
+   size_t replacedSize = 0;
+   Shard& shard = getShard(key);
    {
-      pUnit = (*ppMatchingUnit);
+      mta::MutexLock lock(shard.mMutex);
+      shard.mPending.erase(key);
+      if (pUnit.get() != NULL)
+      {
+         Shard::EntryMap::iterator ppEntry = shard.mIndex.find(key);
+         if (ppEntry != shard.mIndex.end())
+         {
+            replacedSize = ppEntry->second->mpUnit->getSize();
+            mCacheSize -= replacedSize;
+            shard.mEntries.erase(ppEntry->second);
+            shard.mIndex.erase(ppEntry);
+         }
 
-      // Remove from the list -- it will be re-added to the end in createPage()
-      mUnits.erase(ppMatchingUnit);
-      mCacheSize -= pUnit->getSize();
+         shard.mEntries.push_back(Shard::Entry(key, pUnit, mpRasterCache->getNextAccess()));
+         shard.mIndex[key] = --shard.mEntries.end();
+         mCacheSize += pUnit->getSize();
+      }
+      shard.mFetchComplete.ThreadSignalBroadcast();
    }
 
-   return pUnit;
+   // No shard may be locked here since the RasterCache may evict from this cache
+   if (replacedSize > 0)
+   {
+      mpRasterCache->deallocate(replacedSize);
+   }
+   if (pUnit.get() != NULL)
+   {
+      mpRasterCache->allocate(this, pUnit->getSize());
+   }
 }
 
 CachedPage *PageCache::createPage(CachedPage::UnitPtr pUnit, InterleaveFormatType requestedFormat,
-   DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand)
+   DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand) const
 {
    if (pUnit.get() == NULL)
    {
       return NULL;
    }
 
-   mUnits.push_back(pUnit);
-   mCacheSize += pUnit->getSize();
-   enforceCacheSize();
+   // A tiled unit only contains a subset of the columns in each row
+   int unitColumnCount = mColumnCount;
+   int column = startColumn.getActiveNumber();
+   if (pUnit->getConcurrentColumns() != 0)
+   {
+      unitColumnCount = pUnit->getConcurrentColumns();
+      column -= pUnit->getStartColumn().getActiveNumber();
+   }
 
-   int columnOffset = mColumnCount*(startRow.getActiveNumber()-pUnit->getStartRow().getActiveNumber());
+   int columnOffset = unitColumnCount*(startRow.getActiveNumber()-pUnit->getStartRow().getActiveNumber());
    unsigned int offset = 0;
    if (requestedFormat == BIP)
    {
-      columnOffset += startColumn.getActiveNumber();
+      columnOffset += column;
       offset = mBytesPerBand*(columnOffset*mBandCount + startBand.getActiveNumber());
    }
    else if (requestedFormat == BSQ) // a BSQ row is 1 row of 1 band of data
    {
-      columnOffset += startColumn.getActiveNumber();
+      columnOffset += column;
       offset = mBytesPerBand*columnOffset;
    }
    else if (requestedFormat == BIL)
    {
       columnOffset *= mBandCount; // get to the appropriate row in page
-      columnOffset += startBand.getActiveNumber()*mColumnCount + // get to the appropriate band in page
-                      startColumn.getActiveNumber(); // get to the appropriate column in page
+      columnOffset += startBand.getActiveNumber()*unitColumnCount + // get to the appropriate band in page
+                      column; // get to the appropriate column in page
       offset = mBytesPerBand*columnOffset;
    }
    else
@@ -98,18 +224,88 @@ CachedPage *PageCache::createPage(CachedPage::UnitPtr pUnit, InterleaveFormatTyp
    return new CachedPage(pUnit, offset, startRow);
 }
 
-void PageCache::enforceCacheSize()
+PageCache::Shard* PageCache::findLeastRecentlyUsed(size_t& access) const
 {
-   while (mCacheSize > MAX_CACHE_SIZE && !mUnits.empty())
+   // Only one shard is locked at a time so this cannot deadlock with other threads
+   Shard* pVictim = NULL;
+   access = numeric_limits<size_t>::max();
+   for (vector<Shard*>::const_iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
    {
-      mCacheSize -= mUnits.front()->getSize();
-      mUnits.pop_front();
+      Shard& shard = **iter;
+      mta::MutexLock lock(shard.mMutex);
+      if (shard.mEntries.empty() == false && shard.mEntries.front().mLastAccess < access)
+      {
+         access = shard.mEntries.front().mLastAccess;
+         pVictim = &shard;
+      }
    }
+
+   return pVictim;
+}
+
+bool PageCache::getLeastRecentAccess(size_t& access) const
+{
+   return findLeastRecentlyUsed(access) != NULL;
+}
+
+size_t PageCache::evictLeastRecentlyUsed()
+{
+   size_t access = 0;
+   Shard* pVictim = findLeastRecentlyUsed(access);
+   if (pVictim == NULL)
+   {
+      return 0;
+   }
+
+   mta::MutexLock lock(pVictim->mMutex);
+   if (pVictim->mEntries.empty())
+   {
+      return 0;
+   }
+
+   Shard::Entry& entry = pVictim->mEntries.front();
+   size_t size = entry.mpUnit->getSize();
+   mCacheSize -= size;
+   pVictim->mIndex.erase(entry.mKey);
+   pVictim->mEntries.pop_front();
+   ++mEvictionCount;
+   return size;
 }
 
-void PageCache::initialize(int bytesPerBand, int columnCount, int bandCount)
+void PageCache::initialize(int bytesPerBand, int columnCount, int bandCount, const string& name)
 {
    mBytesPerBand = bytesPerBand;
    mColumnCount = columnCount;
    mBandCount = bandCount;
+   mName = name;
+}
+
+size_t PageCache::getMaxCacheSize() const
+{
+   return mpRasterCache->getMaximumSize();
+}
+
+string PageCache::getCacheName() const
+{
+   return mName;
+}
+
+size_t PageCache::getCacheSize() const
+{
+   return mCacheSize;
+}
+
+size_t PageCache::getHitCount() const
+{
+   return mHitCount;
+}
+
+size_t PageCache::getMissCount() const
+{
+   return mMissCount;
+}
+
+size_t PageCache::getEvictionCount() const
+{
+   return mEvictionCount;
 }
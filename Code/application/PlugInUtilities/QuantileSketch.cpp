@@ -0,0 +1,310 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace
+{
+   // Each level below the top retains this fraction of the values of the level above it
+   const double LEVEL_CAPACITY_RATIO = 2.0 / 3.0;
+   const unsigned int MINIMUM_CAPACITY = 8;
+   const unsigned int MINIMUM_LEVEL_CAPACITY = 2;
+}
+
+QuantileSketch::QuantileSketch(unsigned int capacity) :
+   mCapacity(max(capacity, MINIMUM_CAPACITY)),
+   mLevels(1),
+   mCount(0),
+   mMinimum(0.0),
+   mMaximum(0.0),
+   mCompactions(0),
+   mWeightedValuesValid(false)
+{
+   updateLevelCapacities();
+}
+
+unsigned int QuantileSketch::getCapacity() const
+{
+   return mCapacity;
+}
+
+void QuantileSketch::add(double value)
+{
+   if (mCount == 0)
+   {
+      mMinimum = value;
+      mMaximum = value;
+   }
+   else
+   {
+      mMinimum = min(mMinimum, value);
+      mMaximum = max(mMaximum, value);
+   }
+
+   ++mCount;
+   mWeightedValuesValid = false;
+
+   // The first level is only compacted when its buffer is full, and each compaction can only overflow the
+   // level above it, so the remaining levels are checked only as long as the promoted values overflow them
+   mLevels.front().push_back(value);
+   for (size_t level = 0; level < mLevels.size() && mLevels[level].size() >= mLevelCapacities[level]; ++level)
+   {
+      compact(level);
+   }
+}
+
+void QuantileSketch::merge(const QuantileSketch& sketch)
+{
+   if (sketch.isEmpty())
+   {
+      return;
+   }
+
+   if (isEmpty())
+   {
+      mMinimum = sketch.mMinimum;
+      mMaximum = sketch.mMaximum;
+   }
+   else
+   {
+      mMinimum = min(mMinimum, sketch.mMinimum);
+      mMaximum = max(mMaximum, sketch.mMaximum);
+   }
+
+   if (mLevels.size() < sketch.mLevels.size())
+   {
+      mLevels.resize(sketch.mLevels.size());
+      updateLevelCapacities();
+   }
+
+   for (size_t level = 0; level < sketch.mLevels.size(); ++level)
+   {
+      const vector<double>& values = sketch.mLevels[level];
+      mLevels[level].insert(mLevels[level].end(), values.begin(), values.end());
+   }
+
+   mCount += sketch.mCount;
+   mWeightedValuesValid = false;
+   compress();
+}
+
+void QuantileSketch::clear()
+{
+   mLevels.clear();
+   mLevels.resize(1);
+   updateLevelCapacities();
+   mCount = 0;
+   mMinimum = 0.0;
+   mMaximum = 0.0;
+   mCompactions = 0;
+   mWeightedValues.clear();
+   mWeightedValuesValid = false;
+}
+
+bool QuantileSketch::isEmpty() const
+{
+   return mCount == 0;
+}
+
+uint64_t QuantileSketch::getCount() const
+{
+   return mCount;
+}
+
+double QuantileSketch::getMinimum() const
+{
+   return mMinimum;
+}
+
+double QuantileSketch::getMaximum() const
+{
+   return mMaximum;
+}
+
+double QuantileSketch::getQuantile(double fraction) const
+{
+   if (isEmpty() || fraction <= 0.0)
+   {
+      return mMinimum;
+   }
+
+   if (fraction >= 1.0)
+   {
+      return mMaximum;
+   }
+
+   const vector<pair<double, uint64_t> >& values = getWeightedValues();
+   double target = fraction * static_cast<double>(mCount);
+   uint64_t cumulative = 0;
+   for (vector<pair<double, uint64_t> >::const_iterator iter = values.begin(); iter != values.end(); ++iter)
+   {
+      cumulative += iter->second;
+      if (static_cast<double>(cumulative) >= target)
+      {
+         return iter->first;
+      }
+   }
+
+   return mMaximum;
+}
+
+double QuantileSketch::getRank(double value) const
+{
+   if (isEmpty())
+   {
+      return 0.0;
+   }
+
+   const vector<pair<double, uint64_t> >& values = getWeightedValues();
+   uint64_t cumulative = 0;
+   for (vector<pair<double, uint64_t> >::const_iterator iter = values.begin();
+      iter != values.end() && iter->first < value; ++iter)
+   {
+      cumulative += iter->second;
+   }
+
+   return static_cast<double>(cumulative) / static_cast<double>(mCount);
+}
+
+const vector<pair<double, uint64_t> >& QuantileSketch::getWeightedValues() const
+{
+   if (mWeightedValuesValid == false)
+   {
+      mWeightedValues.clear();
+      for (size_t level = 0; level < mLevels.size(); ++level)
+      {
+         uint64_t weight = static_cast<uint64_t>(1) << level;
+         for (vector<double>::const_iterator iter = mLevels[level].begin(); iter != mLevels[level].end(); ++iter)
+         {
+            mWeightedValues.push_back(make_pair(*iter, weight));
+         }
+      }
+
+      sort(mWeightedValues.begin(), mWeightedValues.end());
+      mWeightedValuesValid = true;
+   }
+
+   return mWeightedValues;
+}
+
+void QuantileSketch::getLevels(vector<double>& values, vector<unsigned int>& levelCounts) const
+{
+   values.clear();
+   levelCounts.clear();
+   for (vector<vector<double> >::const_iterator iter = mLevels.begin(); iter != mLevels.end(); ++iter)
+   {
+      values.insert(values.end(), iter->begin(), iter->end());
+      levelCounts.push_back(static_cast<unsigned int>(iter->size()));
+   }
+}
+
+bool QuantileSketch::setLevels(const vector<double>& values, const vector<unsigned int>& levelCounts,
+                               double minimum, double maximum)
+{
+   clear();
+
+   size_t total = 0;
+   for (vector<unsigned int>::const_iterator iter = levelCounts.begin(); iter != levelCounts.end(); ++iter)
+   {
+      total += *iter;
+   }
+
+   if (total != values.size() || levelCounts.empty() || levelCounts.size() >= 64)
+   {
+      return false;
+   }
+
+   mLevels.resize(levelCounts.size());
+   vector<double>::const_iterator value = values.begin();
+   for (size_t level = 0; level < levelCounts.size(); ++level)
+   {
+      mLevels[level].assign(value, value + levelCounts[level]);
+      value += levelCounts[level];
+      mCount += static_cast<uint64_t>(levelCounts[level]) << level;
+   }
+
+   updateLevelCapacities();
+
+   if (mCount > 0)
+   {
+      mMinimum = minimum;
+      mMaximum = maximum;
+   }
+
+   return true;
+}
+
+void QuantileSketch::updateLevelCapacities()
+{
+   // The capacities decrease geometrically from the top level down, which keeps the total size of the
+   // sketch proportional to the capacity regardless of how many values are added
+   mLevelCapacities.resize(mLevels.size());
+   double capacity = mCapacity;
+   for (size_t level = mLevels.size(); level > 0; --level)
+   {
+      mLevelCapacities[level - 1] = max(static_cast<unsigned int>(ceil(capacity)), MINIMUM_LEVEL_CAPACITY);
+      capacity *= LEVEL_CAPACITY_RATIO;
+   }
+
+   // The first level holds values which have not been compacted at all, so it buffers as many values as the
+   // top level to sort them in large batches instead of compacting a few values at a time
+   mLevelCapacities.front() = mCapacity;
+}
+
+void QuantileSketch::compress()
+{
+   for (size_t level = 0; level < mLevels.size(); ++level)
+   {
+      if (mLevels[level].size() >= mLevelCapacities[level])
+      {
+         compact(level);
+      }
+   }
+}
+
+void QuantileSketch::compact(size_t level)
+{
+   if (level + 1 == mLevels.size())
+   {
+      mLevels.push_back(vector<double>());
+      updateLevelCapacities();
+   }
+
+   vector<double>& values = mLevels[level];
+   vector<double>& nextValues = mLevels[level + 1];
+   sort(values.begin(), values.end());
+
+   // An odd value out stays in this level so that the total weight is unchanged
+   bool hasRemainder = (values.size() % 2 != 0);
+   double remainder = hasRemainder ? values.back() : 0.0;
+   if (hasRemainder)
+   {
+      values.pop_back();
+   }
+
+   // Alternating which half is promoted keeps the error from accumulating in one direction
+   size_t offset = (mCompactions++) % 2;
+   for (size_t index = offset; index < values.size(); index += 2)
+   {
+      nextValues.push_back(values[index]);
+   }
+
+   values.clear();
+   if (hasRemainder)
+   {
+      values.push_back(remainder);
+   }
+
+   mWeightedValuesValid = false;
+}
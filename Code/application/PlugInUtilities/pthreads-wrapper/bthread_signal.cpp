@@ -61,6 +61,15 @@ bool BThreadSignal::ThreadSignalActivate()
    return true;
 }
 
+bool BThreadSignal::ThreadSignalBroadcast()
+{
+   assert (mThreadSignalID != NULL);
+
+   pthread_cond_broadcast(mThreadSignalID);
+
+   return true;
+}
+
 bool BThreadSignal::ThreadSignalWait(void *mutexData)
 {
    assert (mThreadSignalID != NULL);
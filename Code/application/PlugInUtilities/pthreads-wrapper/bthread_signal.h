@@ -23,6 +23,7 @@ class BThreadSignal : public ThreadSignal
       virtual bool ThreadSignalDestroy();
       virtual bool ThreadSignalWait(void *mutexData);
       virtual bool ThreadSignalActivate();
+      virtual bool ThreadSignalBroadcast();
 
    private:
       pthread_cond_t *mThreadSignalID;
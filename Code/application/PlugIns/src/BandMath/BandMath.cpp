@@ -387,54 +387,24 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
       mpStep = pResultStep.get();
       pResultStep->addProperty("Expression", mExpression);
 
-      FactoryResource<DataRequest> pReturnRequest;
-      pReturnRequest->setInterleaveFormat(BIP);
-      pReturnRequest->setWritable(true);
-      DataAccessor returnDa = mpResultData->getDataAccessor(pReturnRequest.release());
-      if (!returnDa.isValid())
-      {
-         mstrProgressString = "Could not access the result data.";
-         meGabbiness = ERRORS;
-         displayErrorMessage();
-         return false;
-      }
-
       if (!mbCubeMath)
       {
-         FactoryResource<DataRequest> pCubeRequest;
-         pCubeRequest->setInterleaveFormat(BIP);
-         DataAccessor cubeDa = mpCube->getDataAccessor(pCubeRequest.release());
-         if (!cubeDa.isValid())
-         {
-            mstrProgressString = "Reading this cube format is not supported.";
-            meGabbiness = ERRORS;
-            displayErrorMessage();
-            return false;
-         }
-
-         vector<DataAccessor> accessors(1, cubeDa);
+         vector<RasterElement*> cubes(1, mpCube);
          vector<EncodingType> types(1, pDescriptor->getDataType());
 
          char* mutableExpression = new char[mExpression.size() + 1];
          strcpy(mutableExpression, mExpression.c_str());
 
-         errorCode = eval(mpProgress, accessors, types, mCubeRows, mCubeColumns,
-            mCubeBands, mutableExpression, returnDa, mbDegrees, errorVal, mbCubeMath, mbInteractive);
+         errorCode = eval(mpProgress, cubes, types, mCubeRows, mCubeColumns,
+            mCubeBands, mutableExpression, mpResultData, mbDegrees, errorVal, mbCubeMath, mbInteractive);
 
          delete [] mutableExpression;
       }
       else // cube math
       {
-         EncodingType type = pDescriptor->getDataType();
-
-         vector<DataAccessor> accessors;
          vector<EncodingType> dataTypes;
          for (unsigned int i = 0; i < mCubesList.size(); ++i)
          {
-            FactoryResource<DataRequest> pRequest;
-            pRequest->setInterleaveFormat(BIP);
-            DataAccessor daCube = mCubesList[i]->getDataAccessor(pRequest.release());
-            accessors.push_back(daCube);
             const RasterDataDescriptor* pDdCube = dynamic_cast<RasterDataDescriptor*>(mCubesList.at(i)->
                getDataDescriptor());
             if (pDdCube != NULL)
@@ -453,8 +423,8 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
          char* mutableExpression = new char[mExpression.size() + 1];
          strcpy(mutableExpression, mExpression.c_str());
 
-         errorCode = eval(mpProgress, accessors, dataTypes, mCubeRows,
-            mCubeColumns, mCubeBands, mutableExpression, returnDa,
+         errorCode = eval(mpProgress, mCubesList, dataTypes, mCubeRows,
+            mCubeColumns, mCubeBands, mutableExpression, mpResultData,
             mbDegrees, errorVal, mbCubeMath, mbInteractive);
 
          delete [] mutableExpression;
@@ -0,0 +1,741 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "bmathfuncs.h"
+#include "CompiledExpression.h"
+#include "DataAccessorImpl.h"
+#include "switchOnEncoding.h"
+
+#include <algorithm>
+#include <limits.h>
+
+using namespace std;
+
+namespace
+{
+   const unsigned int NO_OPERAND = UINT_MAX;
+
+   inline void setStatus(unsigned char& status, CompiledExpression::ValueStatusEnum value)
+   {
+      // Only the first error is kept, which is the error the tree evaluation would have thrown
+      if (status == CompiledExpression::VALUE_VALID)
+      {
+         status = value;
+      }
+   }
+
+   struct Add
+   {
+      static double apply(double left, double right, unsigned char& status)
+      {
+         return left + right;
+      }
+   };
+
+   struct Subtract
+   {
+      static double apply(double left, double right, unsigned char& status)
+      {
+         return left - right;
+      }
+   };
+
+   struct Multiply
+   {
+      static double apply(double left, double right, unsigned char& status)
+      {
+         return left * right;
+      }
+   };
+
+   struct Divide
+   {
+      static double apply(double left, double right, unsigned char& status)
+      {
+         if (right == 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_DIVIDE_BY_ZERO);
+         }
+         return left / right;
+      }
+   };
+
+   struct Power
+   {
+      static double apply(double left, double right, unsigned char& status)
+      {
+         if (left == 0 && right <= 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_DIVIDE_BY_ZERO);
+         }
+         else if (left < 0)
+         {
+            double inter;
+            if (modf(right, &inter) != 0)
+            {
+               setStatus(status, CompiledExpression::VALUE_COMPLEX);
+            }
+         }
+         return pow(left, right);
+      }
+   };
+
+   struct SquareRoot
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value <= 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_COMPLEX);
+         }
+         return sqrt(value);
+      }
+   };
+
+   struct Log
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value <= 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_UNDEFINED);
+         }
+         return log(value);
+      }
+   };
+
+   struct Log10
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value <= 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_UNDEFINED);
+         }
+         return log10(value);
+      }
+   };
+
+   struct Log2
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value <= 0)
+         {
+            setStatus(status, CompiledExpression::VALUE_UNDEFINED);
+         }
+         return log(value) / log(2.0);
+      }
+   };
+
+   struct ArcSine
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value < -1 || value > 1)
+         {
+            setStatus(status, CompiledExpression::VALUE_COMPLEX);
+         }
+         return asin(value);
+      }
+   };
+
+   struct ArcCosine
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         if (value < -1 || value > 1)
+         {
+            setStatus(status, CompiledExpression::VALUE_COMPLEX);
+         }
+         return acos(value);
+      }
+   };
+
+   struct Reciprocal
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         return 1 / value;
+      }
+   };
+
+   struct Random
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         return GRand() * value;
+      }
+   };
+
+   template<double (*Function)(double)>
+   struct Unchecked
+   {
+      static double apply(double value, unsigned char& status)
+      {
+         return Function(value);
+      }
+   };
+
+   template<typename Operation>
+   void applyBinary(const double* pLeft, const double* pRight, double* pResult, unsigned char* pStatus,
+      unsigned int count)
+   {
+      for (unsigned int column = 0; column < count; ++column)
+      {
+         pResult[column] = Operation::apply(pLeft[column], pRight[column], pStatus[column]);
+      }
+   }
+
+   template<typename Operation>
+   void applyUnary(const double* pValue, double* pResult, unsigned char* pStatus, unsigned int count)
+   {
+      for (unsigned int column = 0; column < count; ++column)
+      {
+         pResult[column] = Operation::apply(pValue[column], pStatus[column]);
+      }
+   }
+
+   template<typename T>
+   void loadRow(T* pDummy, DataAccessor& accessor, int band, unsigned int columns, double* pValues)
+   {
+      RowView<T, BIP> row = accessor->getRowView<T, BIP>(band);
+      for (unsigned int column = 0; column < columns; ++column)
+      {
+         pValues[column] = row[column];
+      }
+   }
+
+   enum AngleEnum { ANGLE_NONE, ANGLE_ARGUMENT, ANGLE_RESULT };
+
+   // The reciprocal and inverse functions are compiled from the basic functions so that the
+   // instructions which convert between degrees and radians are shared with them
+   struct FunctionDefinition
+   {
+      const char* mpName;
+      int mOpCode;
+      bool mReciprocalArgument;
+      bool mReciprocalResult;
+      AngleEnum mAngle;
+   };
+}
+
+CompiledExpression::Instruction::Instruction(OpCodeEnum opCode, unsigned int left, unsigned int right, int index,
+                                             double value) :
+   mOpCode(opCode),
+   mLeft(left),
+   mRight(right),
+   mIndex(index),
+   mValue(value),
+   mRegister(0)
+{
+}
+
+bool CompiledExpression::Instruction::operator<(const Instruction& rhs) const
+{
+   if (mOpCode != rhs.mOpCode)
+   {
+      return mOpCode < rhs.mOpCode;
+   }
+   if (mLeft != rhs.mLeft)
+   {
+      return mLeft < rhs.mLeft;
+   }
+   if (mRight != rhs.mRight)
+   {
+      return mRight < rhs.mRight;
+   }
+   if (mIndex != rhs.mIndex)
+   {
+      return mIndex < rhs.mIndex;
+   }
+   return mValue < rhs.mValue;
+}
+
+CompiledExpression::CompiledExpression() :
+   mRegisterCount(0)
+{
+}
+
+bool CompiledExpression::compile(const DataNode* pTree)
+{
+   mInstructions.clear();
+   mInstructionIndices.clear();
+   mRegisterCount = 0;
+
+   bool success = true;
+   unsigned int result = compileNode(pTree, success);
+   mInstructionIndices.clear();
+   if (success == false)
+   {
+      mInstructions.clear();
+      return false;
+   }
+
+   allocateRegisters(result);
+   return true;
+}
+
+unsigned int CompiledExpression::getInstructionCount() const
+{
+   return static_cast<unsigned int>(mInstructions.size());
+}
+
+void CompiledExpression::evaluate(vector<DataAccessor>& dataCubes, const vector<EncodingType>& types, int band,
+                                  unsigned int columns, double* pValues, unsigned char* pStatus)
+{
+   fill(pStatus, pStatus + columns, static_cast<unsigned char>(VALUE_VALID));
+   if (mInstructions.empty())
+   {
+      fill(pValues, pValues + columns, 0.0);
+      return;
+   }
+
+   mRegisters.resize(static_cast<size_t>(mRegisterCount) * columns);
+   for (vector<Instruction>::const_iterator iter = mInstructions.begin(); iter != mInstructions.end(); ++iter)
+   {
+      double* pResult = &mRegisters[static_cast<size_t>(iter->mRegister) * columns];
+      switch (iter->mOpCode)
+      {
+      case CONSTANT:
+         fill(pResult, pResult + columns, iter->mValue);
+         break;
+
+      case LOAD_BAND:   // Fall through
+      case LOAD_CUBE:
+      {
+         // Band operands read the given band of the first cube and cube operands read the current band
+         unsigned int cube = (iter->mOpCode == LOAD_BAND ? 0 : static_cast<unsigned int>(iter->mIndex));
+         int offset = (iter->mOpCode == LOAD_BAND ? iter->mIndex : band);
+         fill(pResult, pResult + columns, 0.0);
+         if (cube < dataCubes.size() && cube < types.size())
+         {
+            switchOnEncoding(types[cube], loadRow, NULL, dataCubes[cube], offset, columns, pResult);
+         }
+         break;
+      }
+
+      default:
+      {
+         const double* pLeft = NULL;
+         if (iter->mLeft != NO_OPERAND)
+         {
+            pLeft = &mRegisters[static_cast<size_t>(mInstructions[iter->mLeft].mRegister) * columns];
+         }
+         const double* pRight = &mRegisters[static_cast<size_t>(mInstructions[iter->mRight].mRegister) * columns];
+         execute(iter->mOpCode, pLeft, pRight, pResult, pStatus, columns);
+         break;
+      }
+      }
+   }
+
+   const double* pResult = &mRegisters[static_cast<size_t>(mInstructions.back().mRegister) * columns];
+   copy(pResult, pResult + columns, pValues);
+}
+
+bool CompiledExpression::isBinary(OpCodeEnum opCode)
+{
+   switch (opCode)
+   {
+   case ADD:   // Fall through
+   case SUBTRACT:   // Fall through
+   case MULTIPLY:   // Fall through
+   case DIVIDE:   // Fall through
+   case POWER:
+      return true;
+
+   default:
+      break;
+   }
+
+   return false;
+}
+
+void CompiledExpression::execute(OpCodeEnum opCode, const double* pLeft, const double* pRight, double* pResult,
+                                 unsigned char* pStatus, unsigned int count)
+{
+   switch (opCode)
+   {
+   case ADD:
+      applyBinary<Add>(pLeft, pRight, pResult, pStatus, count);
+      break;
+   case SUBTRACT:
+      applyBinary<Subtract>(pLeft, pRight, pResult, pStatus, count);
+      break;
+   case MULTIPLY:
+      applyBinary<Multiply>(pLeft, pRight, pResult, pStatus, count);
+      break;
+   case DIVIDE:
+      applyBinary<Divide>(pLeft, pRight, pResult, pStatus, count);
+      break;
+   case POWER:
+      applyBinary<Power>(pLeft, pRight, pResult, pStatus, count);
+      break;
+   case SQUARE_ROOT:
+      applyUnary<SquareRoot>(pRight, pResult, pStatus, count);
+      break;
+   case SINE:
+      applyUnary<Unchecked<sin> >(pRight, pResult, pStatus, count);
+      break;
+   case COSINE:
+      applyUnary<Unchecked<cos> >(pRight, pResult, pStatus, count);
+      break;
+   case TANGENT:
+      applyUnary<Unchecked<tan> >(pRight, pResult, pStatus, count);
+      break;
+   case LOG:
+      applyUnary<Log>(pRight, pResult, pStatus, count);
+      break;
+   case LOG10:
+      applyUnary<Log10>(pRight, pResult, pStatus, count);
+      break;
+   case LOG2:
+      applyUnary<Log2>(pRight, pResult, pStatus, count);
+      break;
+   case EXPONENTIAL:
+      applyUnary<Unchecked<exp> >(pRight, pResult, pStatus, count);
+      break;
+   case ABSOLUTE:
+      applyUnary<Unchecked<fabs> >(pRight, pResult, pStatus, count);
+      break;
+   case ARC_SINE:
+      applyUnary<ArcSine>(pRight, pResult, pStatus, count);
+      break;
+   case ARC_COSINE:
+      applyUnary<ArcCosine>(pRight, pResult, pStatus, count);
+      break;
+   case ARC_TANGENT:
+      applyUnary<Unchecked<atan> >(pRight, pResult, pStatus, count);
+      break;
+   case HYPERBOLIC_SINE:
+      applyUnary<Unchecked<sinh> >(pRight, pResult, pStatus, count);
+      break;
+   case HYPERBOLIC_COSINE:
+      applyUnary<Unchecked<cosh> >(pRight, pResult, pStatus, count);
+      break;
+   case HYPERBOLIC_TANGENT:
+      applyUnary<Unchecked<tanh> >(pRight, pResult, pStatus, count);
+      break;
+   case RECIPROCAL:
+      applyUnary<Reciprocal>(pRight, pResult, pStatus, count);
+      break;
+   case RANDOM:
+      applyUnary<Random>(pRight, pResult, pStatus, count);
+      break;
+   default:
+      fill(pResult, pResult + count, 0.0);
+      break;
+   }
+}
+
+unsigned int CompiledExpression::compileNode(const DataNode* pNode, bool& success)
+{
+   if (pNode == NULL)
+   {
+      success = false;
+      return NO_OPERAND;
+   }
+
+   const char* pOperator = pNode->Opera;
+   if (pOperator == NULL)
+   {
+      return addConstant(0.0);
+   }
+
+   if (pNode->isOperator == false)
+   {
+      if (!strcmp(pOperator, "pi") || !strcmp(pOperator, "PI") || !strcmp(pOperator, "Pi"))
+      {
+         return addConstant(PI);
+      }
+      if (!strcmp(pOperator, "e") || !strcmp(pOperator, "E"))
+      {
+         return addConstant(exp(1.0));
+      }
+      if (pOperator[0] == 'b' || pOperator[0] == 'B')
+      {
+         return addInstruction(Instruction(LOAD_BAND, NO_OPERAND, NO_OPERAND, atoi(&pOperator[1]) - 1, 0.0));
+      }
+      if (pOperator[0] == 'c' || pOperator[0] == 'C')
+      {
+         int cube = atoi(&pOperator[1]) - 1;
+         if (cube < 0)
+         {
+            return addConstant(0.0);
+         }
+         return addInstruction(Instruction(LOAD_CUBE, NO_OPERAND, NO_OPERAND, cube, 0.0));
+      }
+      return addConstant(atof(pOperator));
+   }
+
+   if (!strcmp(pOperator, "("))
+   {
+      return compileNode(pNode->Right, success);
+   }
+
+   OpCodeEnum opCode = CONSTANT;
+   if (!strcmp(pOperator, "+"))
+   {
+      opCode = ADD;
+   }
+   else if (!strcmp(pOperator, "-"))
+   {
+      opCode = SUBTRACT;
+   }
+   else if (!strcmp(pOperator, "*"))
+   {
+      opCode = MULTIPLY;
+   }
+   else if (!strcmp(pOperator, "/"))
+   {
+      opCode = DIVIDE;
+   }
+   else if (!strcmp(pOperator, "^"))
+   {
+      opCode = POWER;
+   }
+   else
+   {
+      return compileFunction(pNode, success);
+   }
+
+   // Compile the operands in the order the tree evaluated them, which determines the error reported for a pixel
+   unsigned int left = NO_OPERAND;
+   unsigned int right = NO_OPERAND;
+   if (opCode == DIVIDE)
+   {
+      right = compileNode(pNode->Right, success);
+      left = compileNode(pNode->Left, success);
+   }
+   else
+   {
+      left = compileNode(pNode->Left, success);
+      right = compileNode(pNode->Right, success);
+   }
+
+   if (success == false)
+   {
+      return NO_OPERAND;
+   }
+
+   return addInstruction(opCode, left, right);
+}
+
+unsigned int CompiledExpression::compileFunction(const DataNode* pNode, bool& success)
+{
+   static const FunctionDefinition functions[] =
+   {
+      { "sqrt", SQUARE_ROOT, false, false, ANGLE_NONE },
+      { "sin", SINE, false, false, ANGLE_ARGUMENT },
+      { "cos", COSINE, false, false, ANGLE_ARGUMENT },
+      { "tan", TANGENT, false, false, ANGLE_ARGUMENT },
+      { "log", LOG, false, false, ANGLE_NONE },
+      { "log10", LOG10, false, false, ANGLE_NONE },
+      { "log2", LOG2, false, false, ANGLE_NONE },
+      { "exp", EXPONENTIAL, false, false, ANGLE_NONE },
+      { "abs", ABSOLUTE, false, false, ANGLE_NONE },
+      { "asin", ARC_SINE, false, false, ANGLE_RESULT },
+      { "acos", ARC_COSINE, false, false, ANGLE_RESULT },
+      { "atan", ARC_TANGENT, false, false, ANGLE_RESULT },
+      { "sinh", HYPERBOLIC_SINE, false, false, ANGLE_ARGUMENT },
+      { "cosh", HYPERBOLIC_COSINE, false, false, ANGLE_ARGUMENT },
+      { "tanh", HYPERBOLIC_TANGENT, false, false, ANGLE_ARGUMENT },
+      { "csc", SINE, false, true, ANGLE_ARGUMENT },
+      { "sec", COSINE, false, true, ANGLE_ARGUMENT },
+      { "cot", TANGENT, false, true, ANGLE_ARGUMENT },
+      { "acsc", ARC_SINE, true, false, ANGLE_RESULT },
+      { "asec", ARC_COSINE, true, false, ANGLE_RESULT },
+      { "acot", ARC_TANGENT, true, false, ANGLE_RESULT },
+      { "csch", HYPERBOLIC_SINE, false, true, ANGLE_ARGUMENT },
+      { "sech", HYPERBOLIC_COSINE, false, true, ANGLE_ARGUMENT },
+      { "coth", HYPERBOLIC_TANGENT, false, true, ANGLE_ARGUMENT },
+      { "rand", RANDOM, false, false, ANGLE_NONE }
+   };
+
+   const FunctionDefinition* pFunction = NULL;
+   for (unsigned int i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i)
+   {
+      if (!strcmp(pNode->Opera, functions[i].mpName))
+      {
+         pFunction = &functions[i];
+         break;
+      }
+   }
+
+   if (pFunction == NULL)
+   {
+      // Unknown operators evaluate to zero
+      return addConstant(0.0);
+   }
+
+   unsigned int argument = compileNode(pNode->Right, success);
+   if (success == false)
+   {
+      return NO_OPERAND;
+   }
+
+   if (pFunction->mReciprocalArgument)
+   {
+      argument = addInstruction(RECIPROCAL, NO_OPERAND, argument);
+   }
+   if (pNode->degrees && pFunction->mAngle == ANGLE_ARGUMENT)
+   {
+      argument = addInstruction(MULTIPLY, addConstant(D_TO_R_MULT), argument);
+   }
+
+   unsigned int result = addInstruction(static_cast<OpCodeEnum>(pFunction->mOpCode), NO_OPERAND, argument);
+   if (pFunction->mReciprocalResult)
+   {
+      result = addInstruction(RECIPROCAL, NO_OPERAND, result);
+   }
+   if (pNode->degrees && pFunction->mAngle == ANGLE_RESULT)
+   {
+      result = addInstruction(MULTIPLY, addConstant(R_TO_D_MULT), result);
+   }
+
+   return result;
+}
+
+unsigned int CompiledExpression::addConstant(double value)
+{
+   return addInstruction(Instruction(CONSTANT, NO_OPERAND, NO_OPERAND, 0, value));
+}
+
+unsigned int CompiledExpression::addInstruction(OpCodeEnum opCode, unsigned int left, unsigned int right)
+{
+   // Addition and multiplication are commutative, so order the operands to find more common subexpressions
+   if ((opCode == ADD || opCode == MULTIPLY) && left > right)
+   {
+      swap(left, right);
+   }
+
+   // Every random instruction is unique since it produces different values each time it is evaluated
+   int index = (opCode == RANDOM ? static_cast<int>(mInstructions.size()) : 0);
+   Instruction instruction(opCode, left, right, index, 0.0);
+
+   bool constantOperands = mInstructions[right].mOpCode == CONSTANT &&
+      (left == NO_OPERAND || mInstructions[left].mOpCode == CONSTANT);
+   if (constantOperands && opCode != RANDOM)
+   {
+      double leftValue = (left == NO_OPERAND ? 0.0 : mInstructions[left].mValue);
+      double rightValue = mInstructions[right].mValue;
+      double value = 0.0;
+      unsigned char status = VALUE_VALID;
+      execute(opCode, &leftValue, &rightValue, &value, &status, 1);
+
+      // Operations which fail are left in the expression so that the error is reported for each pixel
+      if (status == VALUE_VALID)
+      {
+         return addConstant(value);
+      }
+   }
+
+   return addInstruction(instruction);
+}
+
+unsigned int CompiledExpression::addInstruction(const Instruction& instruction)
+{
+   map<Instruction, unsigned int>::const_iterator iter = mInstructionIndices.find(instruction);
+   if (iter != mInstructionIndices.end())
+   {
+      return iter->second;
+   }
+
+   unsigned int index = static_cast<unsigned int>(mInstructions.size());
+   mInstructions.push_back(instruction);
+   mInstructionIndices[instruction] = index;
+   return index;
+}
+
+void CompiledExpression::allocateRegisters(unsigned int result)
+{
+   // Remove the instructions which are not used by the result, such as the operands of folded constants
+   vector<bool> used(mInstructions.size(), false);
+   used[result] = true;
+   for (unsigned int i = result + 1; i > 0; --i)
+   {
+      const Instruction& instruction = mInstructions[i - 1];
+      if (used[i - 1])
+      {
+         if (instruction.mLeft != NO_OPERAND)
+         {
+            used[instruction.mLeft] = true;
+         }
+         if (instruction.mRight != NO_OPERAND)
+         {
+            used[instruction.mRight] = true;
+         }
+      }
+   }
+
+   vector<unsigned int> newIndices(mInstructions.size(), NO_OPERAND);
+   vector<Instruction> instructions;
+   for (unsigned int i = 0; i <= result; ++i)
+   {
+      if (used[i])
+      {
+         Instruction instruction = mInstructions[i];
+         if (instruction.mLeft != NO_OPERAND)
+         {
+            instruction.mLeft = newIndices[instruction.mLeft];
+         }
+         if (instruction.mRight != NO_OPERAND)
+         {
+            instruction.mRight = newIndices[instruction.mRight];
+         }
+
+         newIndices[i] = static_cast<unsigned int>(instructions.size());
+         instructions.push_back(instruction);
+      }
+   }
+   mInstructions.swap(instructions);
+
+   // Reuse the register of a value after its last use so that only a few rows of values are needed
+   vector<unsigned int> lastUse(mInstructions.size(), 0);
+   for (unsigned int i = 0; i < mInstructions.size(); ++i)
+   {
+      if (mInstructions[i].mLeft != NO_OPERAND)
+      {
+         lastUse[mInstructions[i].mLeft] = i;
+      }
+      if (mInstructions[i].mRight != NO_OPERAND)
+      {
+         lastUse[mInstructions[i].mRight] = i;
+      }
+   }
+
+   vector<unsigned int> freeRegisters;
+   mRegisterCount = 0;
+   for (unsigned int i = 0; i < mInstructions.size(); ++i)
+   {
+      Instruction& instruction = mInstructions[i];
+
+      // The operations are applied element by element, so the result can overwrite an operand
+      unsigned int operands[] = { instruction.mLeft, instruction.mRight };
+      for (unsigned int j = 0; j < 2; ++j)
+      {
+         if (operands[j] != NO_OPERAND && lastUse[operands[j]] == i &&
+            (j == 0 || operands[0] != operands[1]))
+         {
+            freeRegisters.push_back(mInstructions[operands[j]].mRegister);
+         }
+      }
+
+      if (freeRegisters.empty())
+      {
+         instruction.mRegister = mRegisterCount++;
+      }
+      else
+      {
+         instruction.mRegister = freeRegisters.back();
+         freeRegisters.pop_back();
+      }
+   }
+}
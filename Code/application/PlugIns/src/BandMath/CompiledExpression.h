@@ -0,0 +1,129 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include "DataAccessor.h"
+#include "TypesFile.h"
+
+#include <map>
+#include <vector>
+
+class DataNode;
+
+/**
+ * A band math expression compiled into a flat sequence of instructions.
+ *
+ * The expression tree is compiled once before the data is processed.  The
+ * operands are resolved to bands, cubes, and constants, constant
+ * subexpressions are folded, and identical subexpressions are evaluated only
+ * once.  Each instruction is then applied to an entire row of values, so the
+ * loops run over contiguous buffers which the compiler can vectorize.
+ *
+ * Errors are recorded per pixel instead of being thrown, and the first error
+ * encountered for a pixel is the same error which evaluating the tree would
+ * have thrown.
+ */
+class CompiledExpression
+{
+public:
+   /**
+    * The status of an evaluated value.
+    *
+    * VALUE_OUT_OF_RANGE is not set by evaluate().  It is available for the
+    * caller to mark values which cannot be stored in the result.
+    */
+   enum ValueStatusEnum
+   {
+      VALUE_VALID = 0, VALUE_DIVIDE_BY_ZERO, VALUE_UNDEFINED, VALUE_COMPLEX, VALUE_OUT_OF_RANGE, VALUE_STATUS_COUNT
+   };
+
+   CompiledExpression();
+
+   /**
+    * Compiles an expression tree.
+    *
+    * @param pTree
+    *        The tree created by BuildTreeFromInfix().  The tree is not
+    *        referenced after this method returns.
+    *
+    * @return \c true if the tree was compiled, or \c false if the tree is
+    *         malformed.
+    */
+   bool compile(const DataNode* pTree);
+
+   /**
+    * Returns the number of instructions in the compiled expression.
+    *
+    * @return The number of instructions executed for each row.
+    */
+   unsigned int getInstructionCount() const;
+
+   /**
+    * Evaluates the expression for a band of the current row.
+    *
+    * @param dataCubes
+    *        BIP accessors for the cubes referenced by the expression.  The
+    *        accessors are not advanced.
+    * @param types
+    *        The data type of each cube.
+    * @param band
+    *        The band read from each cube by the \c c operands.
+    * @param columns
+    *        The number of columns in the row.
+    * @param pValues
+    *        Populated with the value of each column.
+    * @param pStatus
+    *        Populated with a ValueStatusEnum for each column.  The value of a
+    *        column is undefined unless its status is VALUE_VALID.
+    */
+   void evaluate(std::vector<DataAccessor>& dataCubes, const std::vector<EncodingType>& types, int band,
+      unsigned int columns, double* pValues, unsigned char* pStatus);
+
+private:
+   enum OpCodeEnum
+   {
+      CONSTANT, LOAD_BAND, LOAD_CUBE, ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER, SQUARE_ROOT, SINE, COSINE,
+      TANGENT, LOG, LOG10, LOG2, EXPONENTIAL, ABSOLUTE, ARC_SINE, ARC_COSINE, ARC_TANGENT, HYPERBOLIC_SINE,
+      HYPERBOLIC_COSINE, HYPERBOLIC_TANGENT, RECIPROCAL, RANDOM
+   };
+
+   struct Instruction
+   {
+      Instruction(OpCodeEnum opCode, unsigned int left, unsigned int right, int index, double value);
+
+      bool operator<(const Instruction& rhs) const;
+
+      OpCodeEnum mOpCode;
+      unsigned int mLeft;
+      unsigned int mRight;
+      int mIndex;
+      double mValue;
+      unsigned int mRegister;
+   };
+
+   static bool isBinary(OpCodeEnum opCode);
+   static void execute(OpCodeEnum opCode, const double* pLeft, const double* pRight, double* pResult,
+      unsigned char* pStatus, unsigned int count);
+
+   unsigned int compileNode(const DataNode* pNode, bool& success);
+   unsigned int compileFunction(const DataNode* pNode, bool& success);
+   unsigned int addConstant(double value);
+   unsigned int addInstruction(OpCodeEnum opCode, unsigned int left, unsigned int right);
+   unsigned int addInstruction(const Instruction& instruction);
+   void allocateRegisters(unsigned int result);
+
+   std::vector<Instruction> mInstructions;
+   std::map<Instruction, unsigned int> mInstructionIndices;
+   unsigned int mRegisterCount;
+   std::vector<double> mRegisters;
+};
+
+#endif
@@ -9,9 +9,16 @@
 
 #include "AppConfig.h"
 #include "BandMath.h"
+#include "CompiledExpression.h"
+#include "DataRequest.h"
 #include "mbox.h"
+#include "ObjectResource.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
 #include "RasterUtilities.h"
 
+#include <algorithm>
+
 using namespace std;
 
 int ParseExp(char* exp, int bands, char* DelimString, int delimStringLength, int cubes)
@@ -934,8 +941,8 @@ int OpParams(char* ops, char* val)
    return retval;
 }
 
-int eval(Progress* pProgress, vector<DataAccessor>& dataCubes, const vector<EncodingType>& types,
-         int rows, int columns, int bands, char* exp, DataAccessor returnAccessor, bool degrees, char* error,
+int eval(Progress* pProgress, const vector<RasterElement*>& dataCubes, const vector<EncodingType>& types,
+         int rows, int columns, int bands, char* exp, RasterElement* pResult, bool degrees, char* error,
          bool cubeMath, bool interactive)
 {
    int stringSize = strlen(exp)*2;
@@ -1003,521 +1010,281 @@ int eval(Progress* pProgress, vector<DataAccessor>& dataCubes, const vector<Enco
    pItems = NULL;
    pString = NULL;
 
-   bool dispDZMes = true;
-   bool dispUDMes = true;
-   bool dispCMMes = true;
-
-   int j;
+   // Compile the tree once instead of walking it for each pixel
+   BandMathInput input;
+   bool compiled = input.mExpression.compile(pTree);
+   delete pTree;
+   if (compiled == false)
+   {
+      strcpy(error, "The band math expression could not be compiled.");
+      return -1;
+   }
 
-   srand(time(NULL));
+   input.mCubes = dataCubes;
+   input.mTypes = types;
+   input.mpResult = pResult;
+   input.mRows = rows;
+   input.mColumns = columns;
+   input.mBandCount = (cubeMath ? bands : 1);
+   input.mInteractive = interactive;
+   input.mSeed = static_cast<unsigned int>(time(NULL));
 
-   int bandCount = 1;
-   if (cubeMath)
+   BandMathOutput output;
+   mta::ProgressObjectReporter reporter("Band Math", pProgress);
+   mta::MultiThreadedAlgorithm<BandMathInput, BandMathOutput, BandMathThread>
+      alg(mta::getNumRequiredThreads(rows), input, output, &reporter);
+   if (alg.run() != mta::SUCCESS || output.mAccessFailed)
    {
-      bandCount = bands;
+      strcpy(error, "The band math operation could not be perfomed because the data is not available.");
+      return -1;
    }
 
-   float* pReturnValue = NULL;
-   vector<void*> cubeValues(dataCubes.size());
+   // Report the errors in the order in which they first occur in the data, regardless of which thread found them
+   vector<pair<int64_t, int> > errors;
+   for (int status = CompiledExpression::VALUE_DIVIDE_BY_ZERO; status < CompiledExpression::VALUE_STATUS_COUNT;
+      ++status)
+   {
+      if (output.mFirstErrors[status] >= 0)
+      {
+         errors.push_back(make_pair(output.mFirstErrors[status], status));
+      }
+   }
+   sort(errors.begin(), errors.end());
 
-   for (i = 0; i < rows; i++)
+   for (vector<pair<int64_t, int> >::const_iterator iter = errors.begin(); iter != errors.end(); ++iter)
    {
-      for (j = 0; j < columns; j++)
+      int row = static_cast<int>(iter->first / input.mBandCount / columns);
+      switch (iter->second)
       {
-         pReturnValue = reinterpret_cast<float*>(returnAccessor->getColumn());
-         for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
+      case CompiledExpression::VALUE_DIVIDE_BY_ZERO:
+         if (interactive == true)
          {
-            cubeValues[cubeNum] = dataCubes[cubeNum]->getColumn();
-         }
+            MBox mb("Warning", "Warning bandmathfuncs003: Divide By Zero\nSelect 'OK' to continue, \n"
+               "all bad values will be set to 0.  \nOr 'Cancel' to cancel the operation.",
+               MB_OK_CANCEL, NULL);
 
-         for (int bandNum = 0; bandNum < bandCount; ++bandNum)
-         {
-            try
+            if (mb.exec() == QDialog::Rejected)
             {
-               float newValue = static_cast<float>(pTree->eval(cubeValues, bandNum, types));
-               if (RasterUtilities::isBad(newValue))
-               {
-                  throw out_of_range("The value is out of range");
-               }
-
-               pReturnValue[bandNum] = newValue;
+               return -2;
             }
-            catch (DivZero)
-            {
-               if (interactive == true)
-               {
-                  if (dispDZMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs003: Divide By Zero\nSelect 'OK' to continue, \n"
-                        "all bad values will be set to 0.  \nOr 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
+         }
+         else if (pProgress != NULL)
+         {
+            pProgress->updateProgress("The band math operation attempted to divide by zero. "
+               "Operation will continue and bad values will be set to 0.", 100 * row / rows, WARNING);
+         }
+         break;
 
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispDZMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  if (dispDZMes)
-                  {
-                     if (pProgress != NULL)
-                     {
-                        pProgress->updateProgress("The band math operation attempted to divide by zero. "
-                           "Operation will continue and bad values will be set to 0.", 100 * i / rows, WARNING);
-                     }
-                     dispDZMes = false;
-                  }
-               }
+      case CompiledExpression::VALUE_UNDEFINED:
+         if (interactive == true)
+         {
+            MBox mb("Warning", "Warning bandmathfuncs001: Undefined Value\n"
+               "Select 'OK' to continue, \nall bad values will be set to 0.  \n"
+               "Or 'Cancel' to cancel the operation.",
+               MB_OK_CANCEL, NULL);
 
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
-            }
-            catch (Undefined)
+            if (mb.exec() == QDialog::Rejected)
             {
-               if (interactive == true)
-               {
-                  if (dispUDMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs001: Undefined Value\n"
-                        "Select 'OK' to continue, \nall bad values will be set to 0.  \n"
-                        "Or 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
-
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispUDMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  strcpy(error, "The band math operation encountered an undefined value.");
-                  return -1;
-               }
-
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
-            }
-            catch (Complex)
-            {
-               if (interactive == true)
-               {
-                  if (dispCMMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs002: Math Operation Resulted in a Complex Number\n"
-                        "Select 'OK' to continue, \nall bad values will be set to 0.\n"
-                        "Or 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
-
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispCMMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  strcpy(error, "The band math operation resulted in an invalid complex number.");
-                  return -1;
-               }
-
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
+               return -2;
             }
+         }
+         else
+         {
+            strcpy(error, "The band math operation encountered an undefined value.");
+            return -1;
+         }
+         break;
 
-            catch (NoData)
-            {
-               strcpy(error, "The band math operation could not be perfomed because the data is not available.");
-               return -1;
-            }
+      case CompiledExpression::VALUE_COMPLEX:
+         if (interactive == true)
+         {
+            MBox mb("Warning", "Warning bandmathfuncs002: Math Operation Resulted in a Complex Number\n"
+               "Select 'OK' to continue, \nall bad values will be set to 0.\n"
+               "Or 'Cancel' to cancel the operation.",
+               MB_OK_CANCEL, NULL);
 
-            catch (...)
+            if (mb.exec() == QDialog::Rejected)
             {
-               strcpy(error, "The band math operation resulted in a floating point error.");
-               return -1;
+               return -2;
             }
          }
-         returnAccessor->nextColumn();
-         for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
+         else
          {
-            dataCubes[cubeNum]->nextColumn();
+            strcpy(error, "The band math operation resulted in an invalid complex number.");
+            return -1;
          }
-      }
-      returnAccessor->nextRow();
-      for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
-      {
-         dataCubes[cubeNum]->nextRow();
-      }
+         break;
 
-      if (pProgress != NULL)
-      {
-         pProgress->updateProgress("Band Math", 100 * i / rows, NORMAL);
+      default:
+         strcpy(error, "The band math operation resulted in a floating point error.");
+         return -1;
       }
    }
 
    return 0;
 }
 
-double doubleFromEncoding(EncodingType encoding, void* data, int offset)
+BandMathThread::BandMathThread(const BandMathInput& input, int threadCount, int threadIndex,
+                               mta::ThreadReporter& reporter) :
+   mta::AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mExpression(input.mExpression),
+   mRowRange(getThreadRange(threadCount, input.mRows)),
+   mAccessFailed(false),
+   mFirstErrors(CompiledExpression::VALUE_STATUS_COUNT, -1)
 {
-   if (data == NULL)
-   {
-      return 0.0;
-   }
-
-   switch (encoding)
-   {
-   case INT1SBYTE:
-      return reinterpret_cast<signed char*>(data)[offset];
-   case INT1UBYTE:
-      return reinterpret_cast<unsigned char*>(data)[offset];
-   case INT2SBYTES:
-      return reinterpret_cast<signed short*>(data)[offset];
-   case INT2UBYTES:
-      return reinterpret_cast<unsigned short*>(data)[offset];
-   case INT4SBYTES:
-      return reinterpret_cast<signed int*>(data)[offset];
-   case INT4UBYTES:
-      return reinterpret_cast<unsigned int*>(data)[offset];
-   case FLT4BYTES:
-      return reinterpret_cast<float*>(data)[offset];
-   case FLT8BYTES:
-      return reinterpret_cast<double*>(data)[offset];
-   default:
-      break;
-   }
-
-   return 0.0;
 }
 
-double DataNode::eval(vector<void*>& data, int band, const vector<EncodingType>& types)
+void BandMathThread::run()
 {
-   if (data.empty() || data.size() != types.size() || Opera == NULL)
-   {
-      return 0.0;
-   }
+   // Each thread is seeded separately since the random number state may be kept per thread
+   srand(mInput.mSeed + getThreadIndex());
 
-   if (!isOperator)
+   vector<DataAccessor> dataCubes;
+   for (vector<RasterElement*>::const_iterator iter = mInput.mCubes.begin(); iter != mInput.mCubes.end(); ++iter)
    {
-      if (!strcmp(Opera, "pi") || !strcmp(Opera, "PI") || !strcmp(Opera, "Pi"))
+      const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>((*iter)->getDataDescriptor());
+      if (pDescriptor == NULL)
       {
-         return PI;
+         mAccessFailed = true;
+         return;
       }
 
-      if (!strcmp(Opera, "e") || !strcmp(Opera, "E"))
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setInterleaveFormat(BIP);
+      pRequest->setRows(pDescriptor->getActiveRow(mRowRange.mFirst), pDescriptor->getActiveRow(mRowRange.mLast));
+      dataCubes.push_back((*iter)->getDataAccessor(pRequest.release()));
+      if (dataCubes.back().isValid() == false)
       {
-         return exp(1.0);
+         mAccessFailed = true;
+         return;
       }
-
-      if ((Opera[0] == 'b') || (Opera[0] == 'B'))
-      {
-         int bandOperation = atoi(&Opera[1]) - 1;
-         return doubleFromEncoding(types[0], data[0], bandOperation);
-      }
-
-      if ((Opera[0] == 'c') || (Opera[0] == 'C'))
-      {
-         int cube = atoi(&Opera[1]) - 1;
-
-         if (data.size() > static_cast<unsigned int>(cube))
-         {
-            return doubleFromEncoding(types[cube], data[cube], band);
-         }
-         return 0.0;
-      }
-      return atof(Opera);
-   }
-   if (!strcmp(Opera, "("))
-   {
-      return Right->eval(data, band, types);
-   }
-   if (!strcmp(Opera, "+"))
-   {
-      return Left->eval(data, band, types) + Right->eval(data, band, types);
-   }
-   if (!strcmp(Opera, "-"))
-   {
-      return Left->eval(data, band, types) - Right->eval(data, band, types);
    }
-   if (!strcmp(Opera, "*"))
-   {
-      return Left->eval(data, band, types) * Right->eval(data, band, types);
-   }
-   if (!strcmp(Opera, "/"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight == 0)
-      {
-         throw DivZero();
-      }
 
-      return Left->eval(data, band, types) / resRight;
-   }
-   if (!strcmp(Opera, "^"))
+   const RasterDataDescriptor* pResultDescriptor = (mInput.mpResult == NULL ? NULL :
+      dynamic_cast<const RasterDataDescriptor*>(mInput.mpResult->getDataDescriptor()));
+   if (pResultDescriptor == NULL)
    {
-      double resLeft = Left->eval(data, band, types);
-      double resRight = Right->eval(data, band, types);
-
-      if (resLeft == 0 && resRight <= 0)
-      {
-         throw DivZero();
-      }
-      if (resLeft < 0)
-      {
-         double inter;
-         double frac = modf(resRight, &inter);
-         if (frac)
-         {
-            throw Complex();
-         }
-      }
-      return pow(resLeft, resRight);
+      mAccessFailed = true;
+      return;
    }
-   if (!strcmp(Opera, "sqrt"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Complex();
-      }
-      return sqrt(resRight);
-   }
-   if (!strcmp(Opera, "sin"))
-   {
-      if (degrees)
-      {
-         return sin(D_TO_R_MULT*Right->eval(data, band, types));
-      }
 
-      return sin(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "cos"))
+   FactoryResource<DataRequest> pReturnRequest;
+   pReturnRequest->setInterleaveFormat(BIP);
+   pReturnRequest->setRows(pResultDescriptor->getActiveRow(mRowRange.mFirst),
+      pResultDescriptor->getActiveRow(mRowRange.mLast));
+   pReturnRequest->setWritable(true);
+   DataAccessor returnAccessor = mInput.mpResult->getDataAccessor(pReturnRequest.release());
+   if (returnAccessor.isValid() == false)
    {
-      if (degrees)
-      {
-         return cos(D_TO_R_MULT*Right->eval(data, band, types));
-      }
-
-      return cos(Right->eval(data, band, types));
+      mAccessFailed = true;
+      return;
    }
-   if (!strcmp(Opera, "tan"))
-   {
-      if (degrees)
-      {
-         return tan(D_TO_R_MULT*Right->eval(data, band, types));
-      }
 
-      return tan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "log"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Undefined();
-      }
-      return log(resRight);
-   }
-   if (!strcmp(Opera, "log10"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Undefined();
-      }
-      return log10(resRight);
-   }
-   if (!strcmp(Opera, "log2"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Undefined();
-      }
-      return log(resRight)/log(2.0);
-   }
-   if (!strcmp(Opera, "exp"))
-   {
-      return exp(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "abs"))
-   {
-      return fabs(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "asin"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
-      {
-         throw Complex();
-      }
+   int columns = mInput.mColumns;
+   int bandCount = mInput.mBandCount;
 
-      if (degrees)
-      {
-         return R_TO_D_MULT * asin(resRight);
-      }
+   // The values and status of each band are stored contiguously for a row
+   vector<double> values(static_cast<size_t>(bandCount) * columns);
+   vector<unsigned char> status(values.size());
 
-      return asin(resRight);
-   }
-   if (!strcmp(Opera, "acos"))
+   for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
    {
-      double resRight = Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
-      {
-         throw Complex();
-      }
+      getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(row));
 
-      if (degrees)
-      {
-         return R_TO_D_MULT * acos(resRight);
-      }
-
-      return acos(resRight);
-   }
-   if (!strcmp(Opera, "atan"))
-   {
-      if (degrees)
-      {
-         return R_TO_D_MULT * atan(Right->eval(data, band, types));
-      }
-
-      return atan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sinh"))
-   {
-      if (degrees)
+      for (int band = 0; band < bandCount; ++band)
       {
-         return sinh(D_TO_R_MULT*Right->eval(data, band, types));
+         mExpression.evaluate(dataCubes, mInput.mTypes, band, columns, &values[band * columns],
+            &status[band * columns]);
       }
 
-      return sinh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "cosh"))
-   {
-      if (degrees)
+      float* pReturnRow = reinterpret_cast<float*>(returnAccessor->getRow());
+      for (int column = 0; column < columns; ++column)
       {
-         return cosh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+         float* pReturnValue = pReturnRow + column * bandCount;
+         for (int band = 0; band < bandCount; ++band)
+         {
+            unsigned char& valueStatus = status[band * columns + column];
+            if (valueStatus == CompiledExpression::VALUE_VALID)
+            {
+               float newValue = static_cast<float>(values[band * columns + column]);
+               if (RasterUtilities::isBad(newValue))
+               {
+                  valueStatus = CompiledExpression::VALUE_OUT_OF_RANGE;
+               }
+               else
+               {
+                  pReturnValue[band] = newValue;
+               }
+            }
 
-      return cosh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "tanh"))
-   {
-      if (degrees)
-      {
-         return tanh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+            if (valueStatus != CompiledExpression::VALUE_VALID)
+            {
+               int64_t& firstError = mFirstErrors[valueStatus];
+               if (firstError < 0)
+               {
+                  firstError = (static_cast<int64_t>(row) * columns + column) * bandCount + band;
+               }
+               if (isFatal(valueStatus))
+               {
+                  return;
+               }
 
-      return tanh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "csc"))
-   {
-      if (degrees)
-      {
-         return 1/sin(D_TO_R_MULT*Right->eval(data, band, types));
+               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
+            }
+         }
       }
 
-      return 1/sin(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sec"))
-   {
-      if (degrees)
+      returnAccessor->nextRow();
+      for (vector<DataAccessor>::iterator iter = dataCubes.begin(); iter != dataCubes.end(); ++iter)
       {
-         return 1/cos(D_TO_R_MULT*Right->eval(data, band, types));
+         (*iter)->nextRow();
       }
-
-      return 1/cos(Right->eval(data, band, types));
    }
-   if (!strcmp(Opera, "cot"))
-   {
-      if (degrees)
-      {
-         return 1/tan(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+}
 
-      return 1/tan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "acsc"))
-   {
-      double resRight = 1 / Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
-      {
-         throw Complex();
-      }
+bool BandMathThread::isAccessFailed() const
+{
+   return mAccessFailed;
+}
 
-      if (degrees)
-      {
-         return R_TO_D_MULT * asin(resRight);
-      }
+int64_t BandMathThread::getFirstError(CompiledExpression::ValueStatusEnum status) const
+{
+   return mFirstErrors[status];
+}
 
-      return asin(resRight);
-   }
-   if (!strcmp(Opera, "asec"))
+bool BandMathThread::isFatal(unsigned char status) const
+{
+   // Interactive users may choose to continue after undefined and complex values
+   if (status == CompiledExpression::VALUE_OUT_OF_RANGE)
    {
-      double resRight = 1 / Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
-      {
-         throw Complex();
-      }
-
-      if (degrees)
-      {
-         return R_TO_D_MULT * acos(resRight);
-      }
-
-      return acos(resRight);
+      return true;
    }
-   if (!strcmp(Opera, "acot"))
-   {
-      if (degrees)
-      {
-         return R_TO_D_MULT * atan(1/Right->eval(data, band, types));
-      }
 
-      return atan(1/Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "csch"))
-   {
-      if (degrees)
-      {
-         return 1/sinh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+   return mInput.mInteractive == false &&
+      (status == CompiledExpression::VALUE_UNDEFINED || status == CompiledExpression::VALUE_COMPLEX);
+}
 
-      return 1/sinh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sech"))
-   {
-      if (degrees)
-      {
-         return 1/cosh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+BandMathOutput::BandMathOutput() :
+   mAccessFailed(false),
+   mFirstErrors(CompiledExpression::VALUE_STATUS_COUNT, -1)
+{
+}
 
-      return 1/cosh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "coth"))
+bool BandMathOutput::compileOverallResults(const vector<BandMathThread*>& threads)
+{
+   for (vector<BandMathThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
    {
-      if (degrees)
+      mAccessFailed = mAccessFailed || (*iter)->isAccessFailed();
+      for (int status = 0; status < CompiledExpression::VALUE_STATUS_COUNT; ++status)
       {
-         return 1/tanh(D_TO_R_MULT*Right->eval(data, band, types));
+         int64_t firstError = (*iter)->getFirstError(static_cast<CompiledExpression::ValueStatusEnum>(status));
+         if (firstError >= 0 && (mFirstErrors[status] < 0 || firstError < mFirstErrors[status]))
+         {
+            mFirstErrors[status] = firstError;
+         }
       }
-
-      return 1/tanh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "rand"))
-   {
-      return GRand()*Right->eval(data, band, types);
    }
 
-   return 0.0;
+   return true;
 }
@@ -18,9 +18,14 @@
 
 #include <vector>
 
+#include "AppConfig.h"
+#include "CompiledExpression.h"
 #include "Progress.h"
 #include "DataAccessor.h"
 #include "DataAccessorImpl.h"
+#include "MultiThreadedAlgorithm.h"
+
+class RasterElement;
 
 #define D_TO_R_MULT     0.017453292519943295
 #define R_TO_D_MULT     57.295779513082321
@@ -43,8 +48,6 @@ int OpPres(char* ops, char* val);
 inline double GRand();
 inline double SingleRand();
 
-inline double doubleFromEncoding(EncodingType encoding, void* data, int offset = 0);
-
 class DataNode
 {
 public:
@@ -75,8 +78,6 @@ public:
       }
    }
 
-   double eval(std::vector<void*>& data, int band, const std::vector<EncodingType>& types);
-
    bool degrees;
    bool isOperator;
    char* Opera;
@@ -97,11 +98,77 @@ private:
 
 DataNode* BuildTreeFromInfix(char* ops, char* exp, int* offsetTable, int NumElems, bool degrees);
 
-int eval(Progress* pProgress, std::vector<DataAccessor>& dataCubes,
+int eval(Progress* pProgress, const std::vector<RasterElement*>& dataCubes,
          const std::vector<EncodingType>& types, int rows, int columns,
-         int bands, char* exp, DataAccessor returnAccessor, bool degrees,
+         int bands, char* exp, RasterElement* pResult, bool degrees,
          char* error, bool cubeMath, bool interactive);
 
+struct BandMathInput
+{
+   BandMathInput() :
+      mpResult(NULL),
+      mRows(0),
+      mColumns(0),
+      mBandCount(1),
+      mInteractive(false),
+      mSeed(0)
+   {
+   }
+
+   std::vector<RasterElement*> mCubes;
+   std::vector<EncodingType> mTypes;
+   RasterElement* mpResult;
+   CompiledExpression mExpression;
+   int mRows;
+   int mColumns;
+   int mBandCount;
+   bool mInteractive;
+   unsigned int mSeed;
+};
+
+/**
+ * Evaluates a compiled expression for a range of rows.
+ *
+ * Each thread reads its rows through its own accessors.  Pixels with errors
+ * are set to zero, and the first occurrence of each error is recorded so
+ * that the errors can be reported in the order of the data once all threads
+ * have finished.  A thread stops at the first error which fails the
+ * operation, since the rows after it are never reported.
+ */
+class BandMathThread : public mta::AlgorithmThread
+{
+public:
+   BandMathThread(const BandMathInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter);
+
+   void run();
+
+   bool isAccessFailed() const;
+   int64_t getFirstError(CompiledExpression::ValueStatusEnum status) const;
+
+private:
+   BandMathThread& operator=(const BandMathThread& rhs);
+
+   bool isFatal(unsigned char status) const;
+
+   const BandMathInput& mInput;
+   CompiledExpression mExpression;
+   mta::AlgorithmThread::Range mRowRange;
+   bool mAccessFailed;
+   std::vector<int64_t> mFirstErrors;
+};
+
+struct BandMathOutput
+{
+   BandMathOutput();
+
+   bool compileOverallResults(const std::vector<BandMathThread*>& threads);
+
+   bool mAccessFailed;
+
+   // The index of the first band value with each status in the order of the data, or -1 if there is none
+   std::vector<int64_t> mFirstErrors;
+};
+
 inline double GRand()
 {
   return sqrt(-2 * log(SingleRand())) * cos(2.0 * acos(-1.0) * SingleRand());
@@ -0,0 +1,242 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "ConvolutionEngine.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+   // Kernels with at least this many taps which are not separable are applied with an FFT
+   const unsigned int FFT_MINIMUM_TAPS = 121;
+
+   // The minimum number of output rows in each FFT block, as a multiple of the kernel rows
+   const unsigned int FFT_BLOCK_FACTOR = 2;
+   const unsigned int FFT_MINIMUM_BLOCK_ROWS = 32;
+
+   // The largest difference from the outer product, relative to the largest weight, for a separable kernel
+   const double SEPARABLE_TOLERANCE = 1e-10;
+}
+
+ConvolutionEngine::ConvolutionEngine(const NEWMAT::Matrix& kernel, unsigned int columns) :
+   mKernelRows(static_cast<unsigned int>(kernel.Nrows())),
+   mKernelColumns(static_cast<unsigned int>(kernel.Ncols())),
+   mColumns(columns),
+   mMethod(DIRECT),
+   mBlockRows(1)
+{
+   // Normalize the weights once instead of dividing every product
+   double normalization = 1.0 / static_cast<double>(kernel.Storage());
+   mKernel.resize(mKernelRows * mKernelColumns);
+   for (unsigned int row = 0; row < mKernelRows; ++row)
+   {
+      for (unsigned int column = 0; column < mKernelColumns; ++column)
+      {
+         mKernel[row * mKernelColumns + column] = kernel(row + 1, column + 1) * normalization;
+      }
+   }
+
+   if (findSeparableWeights())
+   {
+      mMethod = SEPARABLE;
+   }
+   else if (mKernelRows * mKernelColumns >= FFT_MINIMUM_TAPS)
+   {
+      mMethod = FFT;
+
+      // Each block is transformed with enough rows and columns that the correlation does not wrap around
+      unsigned int targetRows = std::max(mKernelRows * FFT_BLOCK_FACTOR, FFT_MINIMUM_BLOCK_ROWS);
+      cv::Size size(cv::getOptimalDFTSize(getPreparedColumns()),
+         cv::getOptimalDFTSize(targetRows + mKernelRows - 1));
+      mBlockRows = size.height - mKernelRows + 1;
+
+      mKernelSpectrum = cv::Mat::zeros(size, CV_64F);
+      for (unsigned int row = 0; row < mKernelRows; ++row)
+      {
+         std::copy(&mKernel[row * mKernelColumns], &mKernel[row * mKernelColumns] + mKernelColumns,
+            mKernelSpectrum.ptr<double>(row));
+      }
+      cv::dft(mKernelSpectrum, mKernelSpectrum, 0, mKernelRows);
+      mBlock.create(size, CV_64F);
+   }
+}
+
+ConvolutionEngine::MethodEnum ConvolutionEngine::getMethod() const
+{
+   return mMethod;
+}
+
+int ConvolutionEngine::getRowRadius() const
+{
+   return static_cast<int>(mKernelRows / 2);
+}
+
+int ConvolutionEngine::getColumnRadius() const
+{
+   return static_cast<int>(mKernelColumns / 2);
+}
+
+unsigned int ConvolutionEngine::getBlockRows() const
+{
+   return mBlockRows;
+}
+
+unsigned int ConvolutionEngine::getPreparedColumns() const
+{
+   return (mMethod == SEPARABLE ? mColumns : mColumns + mKernelColumns - 1);
+}
+
+void ConvolutionEngine::prepareRow(const double* pPadded, double* pPrepared) const
+{
+   if (mMethod != SEPARABLE)
+   {
+      std::copy(pPadded, pPadded + getPreparedColumns(), pPrepared);
+      return;
+   }
+
+   // The horizontal pass of a separable kernel is applied once to each input row
+   std::fill(pPrepared, pPrepared + mColumns, 0.0);
+   for (unsigned int tap = 0; tap < mKernelColumns; ++tap)
+   {
+      double weight = mColumnWeights[tap];
+      if (weight == 0.0)
+      {
+         continue;
+      }
+
+      const double* pInput = pPadded + tap;
+      for (unsigned int column = 0; column < mColumns; ++column)
+      {
+         pPrepared[column] += weight * pInput[column];
+      }
+   }
+}
+
+void ConvolutionEngine::convolve(const double* const* ppRows, unsigned int rows, double* pOutput)
+{
+   if (mMethod == FFT)
+   {
+      unsigned int inputRows = rows + mKernelRows - 1;
+      unsigned int inputColumns = getPreparedColumns();
+      mBlock.setTo(cv::Scalar(0.0));
+      for (unsigned int row = 0; row < inputRows; ++row)
+      {
+         std::copy(ppRows[row], ppRows[row] + inputColumns, mBlock.ptr<double>(row));
+      }
+
+      // Multiplying by the conjugate of the kernel spectrum correlates the block with the kernel
+      cv::dft(mBlock, mBlock, 0, inputRows);
+      cv::mulSpectrums(mBlock, mKernelSpectrum, mBlock, 0, true);
+      cv::dft(mBlock, mBlock, cv::DFT_INVERSE | cv::DFT_SCALE, rows);
+      for (unsigned int row = 0; row < rows; ++row)
+      {
+         const double* pBlockRow = mBlock.ptr<double>(row);
+         std::copy(pBlockRow, pBlockRow + mColumns, pOutput + row * mColumns);
+      }
+
+      return;
+   }
+
+   for (unsigned int row = 0; row < rows; ++row)
+   {
+      double* pOutputRow = pOutput + row * mColumns;
+      std::fill(pOutputRow, pOutputRow + mColumns, 0.0);
+      for (unsigned int kernelRow = 0; kernelRow < mKernelRows; ++kernelRow)
+      {
+         const double* pInputRow = ppRows[row + kernelRow];
+         if (mMethod == SEPARABLE)
+         {
+            double weight = mRowWeights[kernelRow];
+            if (weight != 0.0)
+            {
+               for (unsigned int column = 0; column < mColumns; ++column)
+               {
+                  pOutputRow[column] += weight * pInputRow[column];
+               }
+            }
+
+            continue;
+         }
+
+         // Apply one tap to the whole row at a time so the inner loop runs over contiguous values
+         const double* pWeights = &mKernel[kernelRow * mKernelColumns];
+         for (unsigned int tap = 0; tap < mKernelColumns; ++tap)
+         {
+            double weight = pWeights[tap];
+            if (weight == 0.0)
+            {
+               continue;
+            }
+
+            const double* pInput = pInputRow + tap;
+            for (unsigned int column = 0; column < mColumns; ++column)
+            {
+               pOutputRow[column] += weight * pInput[column];
+            }
+         }
+      }
+   }
+}
+
+bool ConvolutionEngine::findSeparableWeights()
+{
+   // A kernel is separable if it has rank one, in which case every row is a multiple of the row
+   // containing the largest weight
+   unsigned int pivotRow = 0;
+   unsigned int pivotColumn = 0;
+   double largest = 0.0;
+   for (unsigned int row = 0; row < mKernelRows; ++row)
+   {
+      for (unsigned int column = 0; column < mKernelColumns; ++column)
+      {
+         double weight = fabs(mKernel[row * mKernelColumns + column]);
+         if (weight > largest)
+         {
+            largest = weight;
+            pivotRow = row;
+            pivotColumn = column;
+         }
+      }
+   }
+
+   if (largest == 0.0 || mKernelRows == 1 || mKernelColumns == 1)
+   {
+      // Degenerate kernels are applied directly since there is nothing to gain from separating them
+      return false;
+   }
+
+   double pivot = mKernel[pivotRow * mKernelColumns + pivotColumn];
+   mRowWeights.resize(mKernelRows);
+   mColumnWeights.resize(mKernelColumns);
+   for (unsigned int row = 0; row < mKernelRows; ++row)
+   {
+      mRowWeights[row] = mKernel[row * mKernelColumns + pivotColumn];
+   }
+   for (unsigned int column = 0; column < mKernelColumns; ++column)
+   {
+      mColumnWeights[column] = mKernel[pivotRow * mKernelColumns + column] / pivot;
+   }
+
+   for (unsigned int row = 0; row < mKernelRows; ++row)
+   {
+      for (unsigned int column = 0; column < mKernelColumns; ++column)
+      {
+         double difference = mKernel[row * mKernelColumns + column] - mRowWeights[row] * mColumnWeights[column];
+         if (fabs(difference) > SEPARABLE_TOLERANCE * largest)
+         {
+            mRowWeights.clear();
+            mColumnWeights.clear();
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
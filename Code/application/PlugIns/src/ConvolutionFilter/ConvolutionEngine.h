@@ -0,0 +1,125 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef CONVOLUTIONENGINE_H
+#define CONVOLUTIONENGINE_H
+
+#include <ossim/matrix/newmat.h>
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+/**
+ * Convolves rows of data with a kernel.
+ *
+ * The kernel is analyzed once when the engine is created.  A kernel which is
+ * the outer product of a column and a row is applied as a horizontal pass
+ * over each input row followed by a vertical pass.  Other kernels with many
+ * taps are applied by multiplying spectra computed with an FFT, and the rest
+ * are applied directly.  The kernel is applied as a correlation and is
+ * normalized by its number of elements, matching the original filter.
+ *
+ * The caller converts each input row to doubles, padded on each side by
+ * getColumnRadius() values, and passes it through prepareRow().  Blocks of
+ * output rows are then computed from the prepared rows, which can be kept in
+ * a ring buffer so that each input row is read and prepared only once.
+ */
+class ConvolutionEngine
+{
+public:
+   enum MethodEnum { DIRECT, SEPARABLE, FFT };
+
+   /**
+    * Creates an engine for a kernel.
+    *
+    * @param kernel
+    *        The kernel, which must have an odd number of rows and columns.
+    * @param columns
+    *        The number of columns in each output row.
+    */
+   ConvolutionEngine(const NEWMAT::Matrix& kernel, unsigned int columns);
+
+   /**
+    * Returns how the kernel is applied.
+    *
+    * @return The method chosen for the kernel.
+    */
+   MethodEnum getMethod() const;
+
+   /**
+    * Returns the number of input rows needed above and below an output row.
+    *
+    * @return Half the number of kernel rows, rounded down.
+    */
+   int getRowRadius() const;
+
+   /**
+    * Returns the number of input columns needed on each side of an output column.
+    *
+    * @return Half the number of kernel columns, rounded down.
+    */
+   int getColumnRadius() const;
+
+   /**
+    * Returns the largest number of output rows computed by each call to convolve().
+    *
+    * @return The number of rows in a block.
+    */
+   unsigned int getBlockRows() const;
+
+   /**
+    * Returns the number of values in a prepared row.
+    *
+    * @return The size of the buffer required by prepareRow().
+    */
+   unsigned int getPreparedColumns() const;
+
+   /**
+    * Prepares a padded input row for convolve().
+    *
+    * @param pPadded
+    *        The input row, with getColumnRadius() values before the first
+    *        output column and after the last output column.
+    * @param pPrepared
+    *        Populated with getPreparedColumns() values.
+    */
+   void prepareRow(const double* pPadded, double* pPrepared) const;
+
+   /**
+    * Computes a block of output rows.
+    *
+    * @param ppRows
+    *        The prepared input rows, starting getRowRadius() rows above the
+    *        first output row and ending getRowRadius() rows below the last.
+    *        The same row may appear more than once to replicate the edges
+    *        of the data.
+    * @param rows
+    *        The number of output rows, which must not be greater than
+    *        getBlockRows().
+    * @param pOutput
+    *        Populated with the output rows, stored contiguously.
+    */
+   void convolve(const double* const* ppRows, unsigned int rows, double* pOutput);
+
+private:
+   bool findSeparableWeights();
+
+   unsigned int mKernelRows;
+   unsigned int mKernelColumns;
+   unsigned int mColumns;
+   MethodEnum mMethod;
+   unsigned int mBlockRows;
+   std::vector<double> mKernel;
+   std::vector<double> mRowWeights;
+   std::vector<double> mColumnWeights;
+   cv::Mat mKernelSpectrum;
+   cv::Mat mBlock;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "BitMask.h"
 #include "BitMaskIterator.h"
 #include "ConfigurationSettings.h"
+#include "ConvolutionEngine.h"
 #include "ConvolutionFilterShell.h"
 #include "DataAccessor.h"
 #include "DataAccessorImpl.h"
@@ -26,6 +27,7 @@
 #include "RasterElement.h"
 #include "RasterLayer.h"
 #include "RasterUtilities.h"
+#include "RowView.h"
 #include "SpatialDataView.h"
 #include "SpatialDataWindow.h"
 #include "switchOnEncoding.h"
@@ -38,9 +40,59 @@
 namespace
 {
    template<typename T>
-   void assignResult(T* pPixel, double value)
+   inline double toDouble(T value)
    {
-      *pPixel = static_cast<T>(value);
+      return static_cast<double>(value);
+   }
+
+   inline double toDouble(const IntegerComplex& value)
+   {
+      return value[COMPLEX_MAGNITUDE];
+   }
+
+   inline double toDouble(const FloatComplex& value)
+   {
+      return value[COMPLEX_MAGNITUDE];
+   }
+
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   void readRow(InterleaveTraits<Interleave>, T* pDummy, DataAccessor& accessor, double* pValues)
+   {
+      RowView<T, Interleave> view = accessor->getRowView<T, Interleave>();
+      const T* pData = view.getData();
+      size_t stride = view.getStride();
+      size_t columns = view.getColumnCount();
+      for (size_t column = 0; column < columns; ++column)
+      {
+         pValues[column] = toDouble(pData[column * stride]);
+      }
+   }
+
+   template<typename T>
+   void readRow(T* pDummy, DataAccessor& accessor, InterleaveFormatType interleave, double* pValues)
+   {
+      switchOnInterleave(interleave, readRow, pDummy, accessor, pValues);
+   }
+
+   template<typename T, InterleaveFormatTypeEnum Interleave>
+   void writeRow(InterleaveTraits<Interleave>, T* pDummy, DataAccessor& accessor, const double* pValues,
+      double offset)
+   {
+      RowView<T, Interleave> view = accessor->getRowView<T, Interleave>();
+      T* pData = view.getData();
+      size_t stride = view.getStride();
+      size_t columns = view.getColumnCount();
+      for (size_t column = 0; column < columns; ++column)
+      {
+         pData[column * stride] = static_cast<T>(pValues[column] + offset);
+      }
+   }
+
+   template<typename T>
+   void writeRow(T* pDummy, DataAccessor& accessor, InterleaveFormatType interleave, const double* pValues,
+      double offset)
+   {
+      switchOnInterleave(interleave, writeRow, pDummy, accessor, pValues, offset);
    }
 }
 
@@ -346,9 +398,48 @@ void ConvolutionFilterShell::ConvolutionFilterThread::convolve(const T*)
 
    // account for AOIs which extend outside the dataset
    int maxRowNum = static_cast<int>(mInput.mpDescriptor->getRowCount()) - 1;
+   int maxColumnNum = static_cast<int>(mInput.mpDescriptor->getColumnCount()) - 1;
    mRowRange.mFirst = std::max(0, mRowRange.mFirst);
    mRowRange.mLast = std::min(mRowRange.mLast, maxRowNum);
 
+   int rowOffset = static_cast<int>(mInput.mpIterCheck->getOffset().mY);
+   int startRow = mRowRange.mFirst + rowOffset;
+   int stopRow = mRowRange.mLast + rowOffset;
+
+   int columnOffset = static_cast<int>(mInput.mpIterCheck->getOffset().mX);
+   int startColumn = columnOffset;
+   int stopColumn = numResultsCols + columnOffset - 1;
+
+   ConvolutionEngine engine(mInput.mKernel, numResultsCols);
+   int yshift = engine.getRowRadius();
+   int xshift = engine.getColumnRadius();
+
+   // Columns beyond the edges of the data replicate the edge columns
+   int firstSourceColumn = std::max(0, startColumn - xshift);
+   int lastSourceColumn = std::min(maxColumnNum, stopColumn + xshift);
+   std::vector<int> sourceColumns(numResultsCols + 2 * xshift);
+   for (int index = 0; index < static_cast<int>(sourceColumns.size()); ++index)
+   {
+      int column = std::min(std::max(0, startColumn - xshift + index), maxColumnNum);
+      sourceColumns[index] = column - firstSourceColumn;
+   }
+
+   // Each input row is read and prepared once, and kept until no block of output rows needs it
+   unsigned int blockRows = engine.getBlockRows();
+   unsigned int windowRows = blockRows + 2 * yshift;
+   unsigned int preparedColumns = engine.getPreparedColumns();
+   std::vector<double> ring(windowRows * preparedColumns);
+   std::vector<int> ringRows(windowRows);
+   std::vector<const double*> window(windowRows);
+   std::vector<double> sourceValues(lastSourceColumn - firstSourceColumn + 1);
+   std::vector<double> paddedValues(sourceColumns.size());
+   std::vector<double> results(blockRows * numResultsCols);
+
+   InterleaveFormatType sourceInterleave = mInput.mpDescriptor->getInterleaveFormat();
+   InterleaveFormatType resultInterleave = pResultDescriptor->getInterleaveFormat();
+   EncodingType resultType = pResultDescriptor->getDataType();
+   bool useAllPixels = mInput.mpIterCheck->useAllPixels();
+
    unsigned int bandCount = mInput.mBands.size();
    for (unsigned int bandNum = 0; bandNum < bandCount; ++bandNum)
    {
@@ -366,23 +457,11 @@ void ConvolutionFilterShell::ConvolutionFilterThread::convolve(const T*)
          return;
       }
 
-      int oldPercentDone = -1;
-      int rowOffset = static_cast<int>(mInput.mpIterCheck->getOffset().mY);
-      int startRow = mRowRange.mFirst + rowOffset;
-      int stopRow = mRowRange.mLast + rowOffset;
-
-      int columnOffset = static_cast<int>(mInput.mpIterCheck->getOffset().mX);
-      int startColumn = columnOffset;
-      int stopColumn = numResultsCols + columnOffset - 1;
-
-      int yshift = (mInput.mKernel.Nrows() - 1) / 2;
-      int xshift = (mInput.mKernel.Ncols() - 1) / 2;
-
       FactoryResource<DataRequest> pRequest;
       pRequest->setRows(mInput.mpDescriptor->getActiveRow(std::max(0, startRow - yshift)),
-         mInput.mpDescriptor->getActiveRow(std::min(maxRowNum, stopRow + mInput.mKernel.Nrows() - yshift)));
-      pRequest->setColumns(mInput.mpDescriptor->getActiveColumn(startColumn),
-         mInput.mpDescriptor->getActiveColumn(stopColumn));
+         mInput.mpDescriptor->getActiveRow(std::min(maxRowNum, stopRow + yshift)));
+      pRequest->setColumns(mInput.mpDescriptor->getActiveColumn(firstSourceColumn),
+         mInput.mpDescriptor->getActiveColumn(lastSourceColumn));
       pRequest->setBands(mInput.mpDescriptor->getActiveBand(mInput.mBands[bandNum]),
          mInput.mpDescriptor->getActiveBand(mInput.mBands[bandNum]));
       DataAccessor accessor = mInput.mpRaster->getDataAccessor(pRequest.release());
@@ -391,12 +470,12 @@ void ConvolutionFilterShell::ConvolutionFilterThread::convolve(const T*)
          return;
       }
 
-      Service<ModelServices> model;
-      ModelServices* pModel = model.get();
+      std::fill(ringRows.begin(), ringRows.end(), -1);
+      int oldPercentDone = -1;
       int numRows = stopRow - startRow + 1;
-      for (int row_index = startRow; row_index <= stopRow; ++row_index)
+      for (int blockRow = startRow; blockRow <= stopRow; blockRow += blockRows)
       {
-         int percentDone = 100 * ((bandNum * numRows) + (row_index - startRow)) / (numRows * bandCount); 
+         int percentDone = 100 * ((bandNum * numRows) + (blockRow - startRow)) / (numRows * bandCount);
          if (percentDone > oldPercentDone)
          {
             oldPercentDone = percentDone;
@@ -407,43 +486,58 @@ void ConvolutionFilterShell::ConvolutionFilterThread::convolve(const T*)
             break;
          }
 
-         for (int col_index = startColumn; col_index <= stopColumn; ++col_index)
+         // Rows beyond the edges of the data replicate the edge rows
+         unsigned int rows = std::min(blockRows, static_cast<unsigned int>(stopRow - blockRow + 1));
+         for (unsigned int index = 0; index < rows + 2 * yshift; ++index)
+         {
+            int sourceRow = std::min(std::max(0, blockRow - yshift + static_cast<int>(index)), maxRowNum);
+            unsigned int slot = static_cast<unsigned int>(sourceRow) % windowRows;
+            double* pPrepared = &ring[slot * preparedColumns];
+            if (ringRows[slot] != sourceRow)
+            {
+               accessor->toPixel(sourceRow, firstSourceColumn);
+               if (accessor.isValid() == false)
+               {
+                  return;
+               }
+
+               readRow(static_cast<T*>(NULL), accessor, sourceInterleave, &sourceValues.front());
+               for (unsigned int column = 0; column < paddedValues.size(); ++column)
+               {
+                  paddedValues[column] = sourceValues[sourceColumns[column]];
+               }
+
+               engine.prepareRow(&paddedValues.front(), pPrepared);
+               ringRows[slot] = sourceRow;
+            }
+
+            window[index] = pPrepared;
+         }
+
+         engine.convolve(&window.front(), rows, &results.front());
+         for (unsigned int index = 0; index < rows; ++index)
          {
-            double accum = 0.0;
-            if (mInput.mpIterCheck->getPixel(col_index, row_index))
+            double* pValues = &results[index * numResultsCols];
+            if (useAllPixels == false)
             {
-               for (int kernelrow = 0; kernelrow < mInput.mKernel.Nrows(); kernelrow++)
+               int row = blockRow + static_cast<int>(index);
+               for (int column = 0; column < numResultsCols; ++column)
                {
-                  int neighbor_row = row_index - yshift + kernelrow;
-                  int real_row = std::min(std::max(0, neighbor_row),
-                     static_cast<int>(mInput.mpDescriptor->getRowCount()) - 1);
-                  for (int kernelcol = 0; kernelcol < mInput.mKernel.Ncols(); kernelcol++)
+                  if (mInput.mpIterCheck->getPixel(startColumn + column, row) == false)
                   {
-                     int neighbor_col = col_index - xshift + kernelcol;
-                     int real_col = std::min(std::max(0, neighbor_col),
-                        static_cast<int>(mInput.mpDescriptor->getColumnCount()) - 1);
-                     accessor->toPixel(real_row, real_col);
-                     if (accessor.isValid() == false)
-                     {
-                        return;
-                     }
-
-                     double val = 0.0;
-                     pModel->getDataValue<T>(reinterpret_cast<T*>(accessor->getColumn()), COMPLEX_MAGNITUDE, 0, val);
-                     accum += mInput.mKernel(kernelrow+1, kernelcol+1) * val / mInput.mKernel.Storage();
+                     pValues[column] = 0.0;
                   }
                }
             }
+
             if (resultAccessor.isValid() == false)
             {
                return;
             }
 
-            switchOnEncoding(pResultDescriptor->getDataType(), assignResult,
-                             resultAccessor->getColumn(), accum + mInput.mOffset);
-            resultAccessor->nextColumn();
+            switchOnEncoding(resultType, writeRow, NULL, resultAccessor, resultInterleave, pValues, mInput.mOffset);
+            resultAccessor->nextRow();
          }
-         resultAccessor->nextRow();
       }
    }
 }
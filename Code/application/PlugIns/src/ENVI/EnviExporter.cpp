@@ -22,6 +22,7 @@
 #include "Endian.h"
 #include "EnviExporter.h"
 #include "FileResource.h"
+#include "InterleaveTranspose.h"
 #include "LabeledSection.h"
 #include "MessageLogResource.h"
 #include "PlugInArg.h"
@@ -38,13 +39,78 @@
 #include "Units.h"
 
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 using namespace std;
 
 REGISTER_PLUGIN_BASIC(OpticksENVI, EnviExporter);
 
+namespace
+{
+   // The number of bytes collected before they are written to the data file
+   const size_t WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+   // Collects the rows of the data file so the file is written in large blocks instead of a row or
+   // an element at a time
+   class BufferedFileWriter
+   {
+   public:
+      BufferedFileWriter(LargeFileResource& file) :
+         mFile(file),
+         mUsed(0),
+         mSuccess(true)
+      {}
+
+      // Returns space for the next bytes of the file, which the caller must populate
+      char* reserve(size_t bytes)
+      {
+         if (mUsed + bytes > mBuffer.size())
+         {
+            flush();
+            if (bytes > mBuffer.size())
+            {
+               mBuffer.resize(max(bytes, WRITE_BUFFER_SIZE));
+            }
+         }
+
+         char* pSpace = &mBuffer[mUsed];
+         mUsed += bytes;
+         return pSpace;
+      }
+
+      void write(const void* pData, size_t bytes)
+      {
+         memcpy(reserve(bytes), pData, bytes);
+      }
+
+      // Writes the collected bytes and returns whether every write succeeded
+      bool flush()
+      {
+         if (mUsed > 0)
+         {
+            int64_t bytes = static_cast<int64_t>(mUsed);
+            if (mFile.write(&mBuffer[0], bytes) != bytes)
+            {
+               mSuccess = false;
+            }
+
+            mUsed = 0;
+         }
+
+         return mSuccess;
+      }
+
+   private:
+      LargeFileResource& mFile;
+      vector<char> mBuffer;
+      size_t mUsed;
+      bool mSuccess;
+   };
+}
+
 EnviExporter::EnviExporter() :
    mpProgress(NULL),
    mpRaster(NULL),
@@ -1084,6 +1150,8 @@ bool EnviExporter::exportDataFile() const
    const vector<DimensionDescriptor>& exportColumns = mpFileDescriptor->getColumns();
    const vector<DimensionDescriptor>& exportBands = mpFileDescriptor->getBands();
    unsigned int bytesPerElement = pDescriptor->getBytesPerElement();
+   unsigned int columnSpan = exportColumns.back().getActiveNumber() - exportColumns.front().getActiveNumber() + 1;
+   bool contiguousColumns = (exportColumns.size() == columnSpan);
 
    DimensionDescriptor startRow = pDescriptor->getActiveRow(exportRows.front().getActiveNumber());
    DimensionDescriptor endRow = pDescriptor->getActiveRow(exportRows.back().getActiveNumber());
@@ -1098,93 +1166,58 @@ bool EnviExporter::exportDataFile() const
       mpProgress->updateProgress(progressText, 0, NORMAL);
    }
 
+   BufferedFileWriter dataWriter(dataFile);
    int rowIndex = 0;
    InterleaveFormatType interleave = mpFileDescriptor->getInterleaveFormat();
    if (interleave == BIP)
    {
-      if (exportBands.size() == pDescriptor->getBandCount())   // All bands
+      if (exportBands.size() == pDescriptor->getBandCount() && contiguousColumns == true)
       {
-         if (exportColumns.size() ==
-            exportColumns.back().getActiveNumber() - exportColumns.front().getActiveNumber() + 1)
+         // Export a full contiguous row at a time
+         FactoryResource<DataRequest> pDataRequest;
+         pDataRequest->setInterleaveFormat(BIP);
+         pDataRequest->setRows(startRow, endRow, 1);
+         pDataRequest->setColumns(startColumn, endColumn, exportColumns.size());
+
+         DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
+         if (dataAccessor.isValid() == false)
          {
-            // Export a full contiguous row at a time
-            FactoryResource<DataRequest> pDataRequest;
-            pDataRequest->setInterleaveFormat(BIP);
-            pDataRequest->setRows(startRow, endRow, 1);
-            pDataRequest->setColumns(startColumn, endColumn, exportColumns.size());
+            string message = "The data in the data set could not be accessed.";
+            if (mpProgress != NULL)
+            {
+               mpProgress->updateProgress(message, 0, ERRORS);
+            }
 
-            DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
-            if (dataAccessor.isValid() == false)
+            pStep->finalize(Message::Failure, message);
+            dataFile.close();
+            remove(headerFilename.c_str());
+            remove(dataFilename.c_str());
+            return false;
+         }
+
+         vector<DimensionDescriptor>::const_iterator iter;
+         for (iter = exportRows.begin(); iter != exportRows.end(); ++iter)
+         {
+            if (isAborted() == true)
             {
-               string message = "The data in the data set could not be accessed.";
+               string message = "ENVI export aborted!";
                if (mpProgress != NULL)
                {
-                  mpProgress->updateProgress(message, 0, ERRORS);
+                  mpProgress->updateProgress(message, 0, ABORT);
                }
 
-               pStep->finalize(Message::Failure, message);
+               pStep->finalize(Message::Abort);
                dataFile.close();
                remove(headerFilename.c_str());
                remove(dataFilename.c_str());
                return false;
             }
 
-            vector<DimensionDescriptor>::const_iterator iter;
-            for (iter = exportRows.begin(); iter != exportRows.end(); ++iter)
-            {
-               if (isAborted() == true)
-               {
-                  string message = "ENVI export aborted!";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ABORT);
-                  }
-
-                  pStep->finalize(Message::Abort);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
-               }
-
-               DimensionDescriptor row = *iter;
-               dataAccessor->toPixel(row.getActiveNumber(), exportColumns.front().getActiveNumber());
-               if (dataAccessor.isValid() == false)
-               {
-                  string message = "An error occurred when reading the data from the data set.";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ERRORS);
-                  }
-
-                  pStep->finalize(Message::Failure, message);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
-               }
-
-               void* pData = dataAccessor->getRow();
-               dataFile.write(pData, bytesPerElement * exportBands.size() * exportColumns.size());
-
-               if (mpProgress != NULL)
-               {
-                  mpProgress->updateProgress(progressText, (rowIndex++ * 100) / exportRows.size(), NORMAL);
-               }
-            }
-         }
-         else
-         {
-            // Export one full pixel at a time
-            FactoryResource<DataRequest> pDataRequest;
-            pDataRequest->setInterleaveFormat(BIP);
-            pDataRequest->setRows(startRow, endRow, 1);
-            pDataRequest->setColumns(startColumn, endColumn, 1);
-
-            DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
+            DimensionDescriptor row = *iter;
+            dataAccessor->toPixel(row.getActiveNumber(), exportColumns.front().getActiveNumber());
             if (dataAccessor.isValid() == false)
             {
-               string message = "The data in the data set could not be accessed.";
+               string message = "An error occurred when reading the data from the data set.";
                if (mpProgress != NULL)
                {
                   mpProgress->updateProgress(message, 0, ERRORS);
@@ -1197,63 +1230,22 @@ bool EnviExporter::exportDataFile() const
                return false;
             }
 
-            vector<DimensionDescriptor>::const_iterator rowIter;
-            for (rowIter = exportRows.begin(); rowIter != exportRows.end(); ++rowIter)
-            {
-               if (isAborted() == true)
-               {
-                  string message = "ENVI export aborted!";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ABORT);
-                  }
-
-                  pStep->finalize(Message::Abort);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
-               }
-
-               vector<DimensionDescriptor>::const_iterator colIter;
-               for (colIter = exportColumns.begin(); colIter != exportColumns.end(); ++colIter)
-               {
-                  DimensionDescriptor row = *rowIter;
-                  DimensionDescriptor column = *colIter;
-                  dataAccessor->toPixel(row.getActiveNumber(), column.getActiveNumber());
-                  if (dataAccessor.isValid() == false)
-                  {
-                     string message = "An error occurred when reading the data from the data set.";
-                     if (mpProgress != NULL)
-                     {
-                        mpProgress->updateProgress(message, 0, ERRORS);
-                     }
-
-                     pStep->finalize(Message::Failure, message);
-                     dataFile.close();
-                     remove(headerFilename.c_str());
-                     remove(dataFilename.c_str());
-                     return false;
-                  }
-
-                  void* pData = dataAccessor->getColumn();
-                  dataFile.write(pData, bytesPerElement * exportBands.size());
-               }
+            void* pData = dataAccessor->getRow();
+            dataWriter.write(pData, bytesPerElement * exportBands.size() * exportColumns.size());
 
-               if (mpProgress != NULL)
-               {
-                  mpProgress->updateProgress(progressText, (rowIndex++ * 100) / exportRows.size(), NORMAL);
-               }
+            if (mpProgress != NULL)
+            {
+               mpProgress->updateProgress(progressText, (rowIndex++ * 100) / exportRows.size(), NORMAL);
             }
          }
       }
       else
       {
-         // Slowest possible copy, one pixel at a time
+         // Gather the exported columns and bands of each row into the write buffer
          FactoryResource<DataRequest> pDataRequest;
          pDataRequest->setInterleaveFormat(BIP);
          pDataRequest->setRows(startRow, endRow, 1);
-         pDataRequest->setColumns(startColumn, endColumn, 1);
+         pDataRequest->setColumns(startColumn, endColumn, columnSpan);
 
          DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
          if (dataAccessor.isValid() == false)
@@ -1271,6 +1263,21 @@ bool EnviExporter::exportDataFile() const
             return false;
          }
 
+         size_t pixelStride = dataAccessor->getRowView<unsigned char, BIP>().getStride();
+         vector<size_t> offsets;
+         offsets.reserve(exportColumns.size() * exportBands.size());
+         vector<DimensionDescriptor>::const_iterator colIter;
+         for (colIter = exportColumns.begin(); colIter != exportColumns.end(); ++colIter)
+         {
+            size_t pixelOffset = (colIter->getActiveNumber() - exportColumns.front().getActiveNumber()) * pixelStride;
+
+            vector<DimensionDescriptor>::const_iterator bandIter;
+            for (bandIter = exportBands.begin(); bandIter != exportBands.end(); ++bandIter)
+            {
+               offsets.push_back(pixelOffset + bandIter->getActiveNumber());
+            }
+         }
+
          vector<DimensionDescriptor>::const_iterator rowIter;
          for (rowIter = exportRows.begin(); rowIter != exportRows.end(); ++rowIter)
          {
@@ -1289,37 +1296,26 @@ bool EnviExporter::exportDataFile() const
                return false;
             }
 
-            vector<DimensionDescriptor>::const_iterator colIter;
-            for (colIter = exportColumns.begin(); colIter != exportColumns.end(); ++colIter)
+            DimensionDescriptor row = *rowIter;
+            dataAccessor->toPixel(row.getActiveNumber(), exportColumns.front().getActiveNumber());
+            if (dataAccessor.isValid() == false)
             {
-               DimensionDescriptor row = *rowIter;
-               DimensionDescriptor column = *colIter;
-               dataAccessor->toPixel(row.getActiveNumber(), column.getActiveNumber());
-               if (dataAccessor.isValid() == false)
+               string message = "An error occurred when reading the data from the data set.";
+               if (mpProgress != NULL)
                {
-                  string message = "An error occurred when reading the data from the data set.";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ERRORS);
-                  }
-
-                  pStep->finalize(Message::Failure, message);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
+                  mpProgress->updateProgress(message, 0, ERRORS);
                }
 
-               char* pData = reinterpret_cast<char*>(dataAccessor->getColumn());
-
-               vector<DimensionDescriptor>::const_iterator bandIter;
-               for (bandIter = exportBands.begin(); bandIter != exportBands.end(); ++bandIter)
-               {
-                  DimensionDescriptor band = *bandIter;
-                  dataFile.write(pData + bytesPerElement * (band.getActiveNumber()), bytesPerElement);
-               }
+               pStep->finalize(Message::Failure, message);
+               dataFile.close();
+               remove(headerFilename.c_str());
+               remove(dataFilename.c_str());
+               return false;
             }
 
+            char* pRow = dataWriter.reserve(offsets.size() * bytesPerElement);
+            InterleaveTranspose::gather(dataAccessor->getRow(), &offsets[0], offsets.size(), pRow, bytesPerElement);
+
             if (mpProgress != NULL)
             {
                mpProgress->updateProgress(progressText, (rowIndex++ * 100) / exportRows.size(), NORMAL);
@@ -1394,7 +1390,7 @@ bool EnviExporter::exportDataFile() const
                }
 
                void* pData = dataAccessor->getRow();
-               dataFile.write(pData, exportColumns.size() * bytesPerElement);
+               dataWriter.write(pData, exportColumns.size() * bytesPerElement);
 
                dataAccessor->nextRow();
 
@@ -1408,17 +1404,25 @@ bool EnviExporter::exportDataFile() const
       }
       else
       {
+         vector<size_t> offsets;
+         offsets.reserve(exportColumns.size());
+         vector<DimensionDescriptor>::const_iterator columnIter;
+         for (columnIter = exportColumns.begin(); columnIter != exportColumns.end(); ++columnIter)
+         {
+            offsets.push_back(columnIter->getActiveNumber() - exportColumns.front().getActiveNumber());
+         }
+
          vector<DimensionDescriptor>::const_iterator bandIter;
          for (bandIter = exportBands.begin(); bandIter != exportBands.end(); ++bandIter)
          {
             DimensionDescriptor exportBand = *bandIter;
             DimensionDescriptor originalBand = pDescriptor->getActiveBand(exportBand.getActiveNumber());
 
-            // Slowest possible copy, one pixel at a time
+            // Gather the exported columns of each row into the write buffer
             FactoryResource<DataRequest> pDataRequest;
             pDataRequest->setInterleaveFormat(BSQ);
             pDataRequest->setRows(startRow, endRow, 1);
-            pDataRequest->setColumns(startColumn, endColumn, 1);
+            pDataRequest->setColumns(startColumn, endColumn, columnSpan);
             pDataRequest->setBands(originalBand, originalBand, 1);
 
             DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
@@ -1456,32 +1460,25 @@ bool EnviExporter::exportDataFile() const
                }
 
                DimensionDescriptor row = *rowIter;
-
-               vector<DimensionDescriptor>::const_iterator columnIter;
-               for (columnIter = exportColumns.begin(); columnIter != exportColumns.end(); ++columnIter)
+               dataAccessor->toPixel(row.getActiveNumber(), exportColumns.front().getActiveNumber());
+               if (dataAccessor.isValid() == false)
                {
-                  DimensionDescriptor column = *columnIter;
-
-                  dataAccessor->toPixel(row.getActiveNumber(), column.getActiveNumber());
-                  if (dataAccessor.isValid() == false)
+                  string message = "An error occurred when reading the data from the data set.";
+                  if (mpProgress != NULL)
                   {
-                     string message = "An error occurred when reading the data from the data set.";
-                     if (mpProgress != NULL)
-                     {
-                        mpProgress->updateProgress(message, 0, ERRORS);
-                     }
-
-                     pStep->finalize(Message::Failure, message);
-                     dataFile.close();
-                     remove(headerFilename.c_str());
-                     remove(dataFilename.c_str());
-                     return false;
+                     mpProgress->updateProgress(message, 0, ERRORS);
                   }
 
-                  void* pData = dataAccessor->getColumn();
-                  dataFile.write(pData, bytesPerElement);
+                  pStep->finalize(Message::Failure, message);
+                  dataFile.close();
+                  remove(headerFilename.c_str());
+                  remove(dataFilename.c_str());
+                  return false;
                }
 
+               char* pRow = dataWriter.reserve(offsets.size() * bytesPerElement);
+               InterleaveTranspose::gather(dataAccessor->getRow(), &offsets[0], offsets.size(), pRow, bytesPerElement);
+
                if (mpProgress != NULL)
                {
                   mpProgress->updateProgress(progressText,
@@ -1554,7 +1551,7 @@ bool EnviExporter::exportDataFile() const
             }
 
             void* pData = dataAccessor->getRow();
-            dataFile.write(pData, bytesPerElement * exportBands.size() * exportColumns.size());
+            dataWriter.write(pData, bytesPerElement * exportBands.size() * exportColumns.size());
 
             if (mpProgress != NULL)
             {
@@ -1562,10 +1559,46 @@ bool EnviExporter::exportDataFile() const
             }
          }
       }
-      else if (exportColumns.size() ==
-         exportColumns.back().getActiveNumber() - exportColumns.front().getActiveNumber() + 1)
+      else
       {
-         // Export a row from a single band at a time
+         // Export the exported bands of each row from a single accessor, gathering the columns if they
+         // are not contiguous
+         FactoryResource<DataRequest> pDataRequest;
+         pDataRequest->setInterleaveFormat(BIL);
+         pDataRequest->setRows(startRow, endRow, 1);
+         pDataRequest->setColumns(startColumn, endColumn, columnSpan);
+         pDataRequest->setBands(startBand, endBand,
+            exportBands.back().getActiveNumber() - exportBands.front().getActiveNumber() + 1);
+
+         DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
+         if (dataAccessor.isValid() == false)
+         {
+            string message = "The data in the data set could not be accessed.";
+            if (mpProgress != NULL)
+            {
+               mpProgress->updateProgress(message, 0, ERRORS);
+            }
+
+            pStep->finalize(Message::Failure, message);
+            dataFile.close();
+            remove(headerFilename.c_str());
+            remove(dataFilename.c_str());
+            return false;
+         }
+
+         vector<size_t> offsets;
+         if (contiguousColumns == false)
+         {
+            offsets.reserve(exportColumns.size());
+            vector<DimensionDescriptor>::const_iterator columnIter;
+            for (columnIter = exportColumns.begin(); columnIter != exportColumns.end(); ++columnIter)
+            {
+               offsets.push_back(columnIter->getActiveNumber() - exportColumns.front().getActiveNumber());
+            }
+         }
+
+         size_t bandSize = dataAccessor->getConcurrentColumns() * bytesPerElement;
+         size_t exportBandSize = exportColumns.size() * bytesPerElement;
          vector<DimensionDescriptor>::const_iterator rowIter;
          for (rowIter = exportRows.begin(); rowIter != exportRows.end(); ++rowIter)
          {
@@ -1584,138 +1617,38 @@ bool EnviExporter::exportDataFile() const
                return false;
             }
 
-            DimensionDescriptor exportRow = *rowIter;
-            DimensionDescriptor originalRow = pDescriptor->getActiveRow(exportRow.getActiveNumber());
-
-            vector<DimensionDescriptor>::const_iterator bandIter;
-            for (bandIter = exportBands.begin(); bandIter != exportBands.end(); ++bandIter)
-            {
-               DimensionDescriptor exportBand = *bandIter;
-               DimensionDescriptor originalBand = pDescriptor->getActiveBand(exportBand.getActiveNumber());
-
-               FactoryResource<DataRequest> pDataRequest;
-               pDataRequest->setInterleaveFormat(BIL);
-               pDataRequest->setRows(originalRow, originalRow, 1);
-               pDataRequest->setColumns(startColumn, endColumn, exportColumns.size());
-               pDataRequest->setBands(originalBand, originalBand, 1);
-
-               DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
-               if (dataAccessor.isValid() == false)
-               {
-                  string message = "The data in the data set could not be accessed.";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ERRORS);
-                  }
-
-                  pStep->finalize(Message::Failure, message);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
-               }
-
-               dataAccessor->toPixel(originalRow.getActiveNumber(), exportColumns.front().getActiveNumber());
-               if (dataAccessor.isValid() == false)
-               {
-                  string message = "An error occurred when reading the data from the data set.";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ERRORS);
-                  }
-
-                  pStep->finalize(Message::Failure, message);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
-               }
-
-               void* pData = dataAccessor->getColumn();
-               dataFile.write(pData, exportColumns.size() * bytesPerElement);
-            }
-
-            if (mpProgress != NULL)
-            {
-               mpProgress->updateProgress(progressText, (rowIndex++ * 100) / exportRows.size(), NORMAL);
-            }
-         }
-      }
-      else
-      {
-         // Slowest possible copy, one pixel at a time
-         vector<DimensionDescriptor>::const_iterator rowIter;
-         for (rowIter = exportRows.begin(); rowIter != exportRows.end(); ++rowIter)
-         {
-            if (isAborted() == true)
+            DimensionDescriptor row = *rowIter;
+            dataAccessor->toPixel(row.getActiveNumber(), exportColumns.front().getActiveNumber());
+            if (dataAccessor.isValid() == false)
             {
-               string message = "ENVI export aborted!";
+               string message = "An error occurred when reading the data from the data set.";
                if (mpProgress != NULL)
                {
-                  mpProgress->updateProgress(message, 0, ABORT);
+                  mpProgress->updateProgress(message, 0, ERRORS);
                }
 
-               pStep->finalize(Message::Abort);
+               pStep->finalize(Message::Failure, message);
                dataFile.close();
                remove(headerFilename.c_str());
                remove(dataFilename.c_str());
                return false;
             }
 
-            DimensionDescriptor exportRow = *rowIter;
-            DimensionDescriptor originalRow = pDescriptor->getActiveRow(exportRow.getActiveNumber());
+            const char* pData = reinterpret_cast<const char*>(dataAccessor->getRow());
 
             vector<DimensionDescriptor>::const_iterator bandIter;
             for (bandIter = exportBands.begin(); bandIter != exportBands.end(); ++bandIter)
             {
-               DimensionDescriptor exportBand = *bandIter;
-               DimensionDescriptor originalBand = pDescriptor->getActiveBand(exportBand.getActiveNumber());
-
-               FactoryResource<DataRequest> pDataRequest;
-               pDataRequest->setInterleaveFormat(BIL);
-               pDataRequest->setRows(originalRow, originalRow, 1);
-               pDataRequest->setColumns(startColumn, endColumn, 1);
-               pDataRequest->setBands(originalBand, originalBand, 1);
-
-               DataAccessor dataAccessor = mpRaster->getDataAccessor(pDataRequest.release());
-               if (dataAccessor.isValid() == false)
+               const char* pBand =
+                  pData + (bandIter->getActiveNumber() - exportBands.front().getActiveNumber()) * bandSize;
+               if (contiguousColumns == true)
                {
-                  string message = "The data in the data set could not be accessed.";
-                  if (mpProgress != NULL)
-                  {
-                     mpProgress->updateProgress(message, 0, ERRORS);
-                  }
-
-                  pStep->finalize(Message::Failure, message);
-                  dataFile.close();
-                  remove(headerFilename.c_str());
-                  remove(dataFilename.c_str());
-                  return false;
+                  dataWriter.write(pBand, exportBandSize);
                }
-
-               vector<DimensionDescriptor>::const_iterator columnIter;
-               for (columnIter = exportColumns.begin(); columnIter != exportColumns.end(); ++columnIter)
+               else
                {
-                  DimensionDescriptor column = *columnIter;
-
-                  dataAccessor->toPixel(originalRow.getActiveNumber(), column.getActiveNumber());
-                  if (dataAccessor.isValid() == false)
-                  {
-                     string message = "An error occurred when reading the data from the data set.";
-                     if (mpProgress != NULL)
-                     {
-                        mpProgress->updateProgress(message, 0, ERRORS);
-                     }
-
-                     pStep->finalize(Message::Failure, message);
-                     dataFile.close();
-                     remove(headerFilename.c_str());
-                     remove(dataFilename.c_str());
-                     return false;
-                  }
-
-                  void* pData = dataAccessor->getColumn();
-                  dataFile.write(pData, bytesPerElement);
+                  InterleaveTranspose::gather(pBand, &offsets[0], offsets.size(), dataWriter.reserve(exportBandSize),
+                     bytesPerElement);
                }
             }
 
@@ -1741,6 +1674,21 @@ bool EnviExporter::exportDataFile() const
       return false;
    }
 
+   if (dataWriter.flush() == false)
+   {
+      string message = "An error occurred when writing the data file.";
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress(message, 0, ERRORS);
+      }
+
+      pStep->finalize(Message::Failure, message);
+      dataFile.close();
+      remove(headerFilename.c_str());
+      remove(dataFilename.c_str());
+      return false;
+   }
+
    if (mpProgress != NULL)
    {
       mpProgress->updateProgress("Data file export complete", 100, NORMAL);
@@ -892,6 +892,7 @@ FitsRasterPager::FitsRasterPager()
    setVersion(APP_VERSION_NUMBER);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
    setShortDescription("FITS pager");
+   setPrefetchEnabled(true);
 }
 
 FitsRasterPager::~FitsRasterPager()
@@ -83,7 +83,10 @@ namespace
    }
 }
 
-GdalRasterPager::GdalRasterPager() : mpDataset(NULL)
+GdalRasterPager::GdalRasterPager() :
+   mpDataset(NULL),
+   mTileRowCount(0),
+   mTileColumnCount(0)
 {
    setName("GDAL Raster Pager");
    setCopyright(APP_COPYRIGHT);
@@ -93,6 +96,7 @@ GdalRasterPager::GdalRasterPager() : mpDataset(NULL)
    setVersion(APP_VERSION_NUMBER);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
    setShortDescription("GDAL pager");
+   setPrefetchEnabled(true);
    GDALAllRegister();
 }
 
@@ -131,7 +135,38 @@ bool GdalRasterPager::openFile(const std::string& filename)
       mDatasetName = filename;
    }
    mpDataset.reset(reinterpret_cast<GDALDataset*>(GDALOpen(mDatasetName.c_str(), GA_ReadOnly)));
-   return mpDataset.get() != NULL;
+   if (mpDataset.get() == NULL)
+   {
+      return false;
+   }
+
+   // Read only the tiles which intersect a request if the file is natively tiled.
+   // Skipped columns do not line up with the tiles on disk, so read full rows in that case.
+   const RasterDataDescriptor* pDesc = static_cast<const RasterDataDescriptor*>(getRasterElement()->getDataDescriptor());
+   GDALRasterBand* pBand = mpDataset->GetRasterBand(1);
+   if (pBand != NULL && pDesc->getColumnSkipFactor() == 0)
+   {
+      int blockColumns = 0;
+      int blockRows = 0;
+      pBand->GetBlockSize(&blockColumns, &blockRows);
+      if (blockColumns > 0 && blockRows > 0 && blockColumns < mpDataset->GetRasterXSize())
+      {
+         mTileColumnCount = blockColumns;
+         mTileRowCount = blockRows;
+      }
+   }
+
+   return true;
+}
+
+unsigned int GdalRasterPager::getTileRowCount() const
+{
+   return mTileRowCount;
+}
+
+unsigned int GdalRasterPager::getTileColumnCount() const
+{
+   return mTileColumnCount;
 }
 
 CachedPage::UnitPtr GdalRasterPager::fetchUnit(DataRequest* pOriginalRequest)
@@ -146,16 +181,11 @@ CachedPage::UnitPtr GdalRasterPager::fetchUnit(DataRequest* pOriginalRequest)
       pOriginalRequest->getStopRow());
    unsigned int numRows = std::min<size_t>(pOriginalRequest->getConcurrentRows(), rows.size());
 
-   // calculate to columns we a loading
-
-//#pragma message(__FILE__ "(" STRING(__LINE__) ") : warning : fix this when cached pager properly handles column subsets (tclarke)")
-   /** this should work but CachedPager assumes fetchUnit() returns full rows **/
-   /*std::vector<DimensionDescriptor> cols = RasterUtilities::subsetDimensionVector(pDesc->getColumns(), pOriginalRequest->getStartColumn(),
-      pOriginalRequest->getStopColumn());
-   unsigned int numCols = std::min(pOriginalRequest->getConcurrentColumns(), cols.size());*/
-
-   std::vector<DimensionDescriptor> cols = pDesc->getColumns();
-   unsigned int numCols = cols.size();
+   // calculate the columns we are loading
+   // this is a subset of the columns if the file is tiled, see getTileColumnCount()
+   std::vector<DimensionDescriptor> cols = RasterUtilities::subsetDimensionVector(pDesc->getColumns(),
+      pOriginalRequest->getStartColumn(), pOriginalRequest->getStopColumn());
+   unsigned int numCols = std::min<size_t>(pOriginalRequest->getConcurrentColumns(), cols.size());
 
    if (numRows == 0 || numCols == 0)
    {
@@ -225,6 +255,12 @@ CachedPage::UnitPtr GdalRasterPager::fetchUnit(DataRequest* pOriginalRequest)
       }
    }
 
-   return CachedPage::UnitPtr(new CachedPage::CacheUnit(
-      pBuffer.release(), pOriginalRequest->getStartRow(), numRows, bufSize, pOriginalRequest->getStartBand()));
+   if (numCols == pDesc->getColumnCount())
+   {
+      return CachedPage::UnitPtr(new CachedPage::CacheUnit(
+         pBuffer.release(), pOriginalRequest->getStartRow(), numRows, bufSize, pOriginalRequest->getStartBand()));
+   }
+
+   return CachedPage::UnitPtr(new CachedPage::CacheUnit(pBuffer.release(), pOriginalRequest->getStartRow(), numRows,
+      pOriginalRequest->getStartColumn(), numCols, bufSize, pOriginalRequest->getStartBand()));
 }
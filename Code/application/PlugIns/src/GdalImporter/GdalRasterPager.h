@@ -21,6 +21,10 @@ public:
    virtual bool getInputSpecification(PlugInArgList*& pArgList);
    virtual bool parseInputArgs(PlugInArgList* pInputArgList);
 
+protected:
+   virtual unsigned int getTileRowCount() const;
+   virtual unsigned int getTileColumnCount() const;
+
 private:
    GdalRasterPager& operator=(const GdalRasterPager& rhs);
 
@@ -29,6 +33,8 @@ private:
 
    std::auto_ptr<GDALDataset> mpDataset;
    std::string mDatasetName;
+   unsigned int mTileRowCount;
+   unsigned int mTileColumnCount;
 };
 
 #endif
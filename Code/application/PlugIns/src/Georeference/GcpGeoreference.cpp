@@ -59,6 +59,7 @@ GcpGeoreference::GcpGeoreference() :
    executeOnStartup(false);
    destroyAfterExecute(false);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   allowConcurrentConversions(true);
 }
 
 GcpGeoreference::~GcpGeoreference()
@@ -545,9 +546,7 @@ LocationType GcpGeoreference::geoToPixel(LocationType geocoord, bool* pAccurate)
       geocoord, mXCoefficients, mYCoefficients, mReverseOrder);
    if (pAccurate != NULL)
    {
-      bool outsideCols = pixcoord.mX < 0.0 || pixcoord.mX > static_cast<double>(mNumColumns);
-      bool outsideRows = pixcoord.mY < 0.0 || pixcoord.mY > static_cast<double>(mNumRows);
-      *pAccurate = !(outsideCols || outsideRows);
+      *pAccurate = isPixelInside(pixcoord);
    }
 
    return pixcoord;
@@ -557,13 +556,45 @@ LocationType GcpGeoreference::pixelToGeo(LocationType pixel, bool* pAccurate) co
 {
    if (pAccurate != NULL)
    {
-      bool outsideCols = pixel.mX < 0.0 || pixel.mX > static_cast<double>(mNumColumns);
-      bool outsideRows = pixel.mY < 0.0 || pixel.mY > static_cast<double>(mNumRows);
-      *pAccurate = !(outsideCols || outsideRows);
+      *pAccurate = isPixelInside(pixel);
    }
   return GeoreferenceUtilities::evaluatePolynomial(pixel, mLatCoefficients, mLonCoefficients, mOrder);
 }
 
+void GcpGeoreference::convertPixelsToGeocoords(const LocationType* pPixels, size_t count,
+                                               LocationType* pGeocoords, bool quick, bool* pAccurate) const
+{
+   GeoreferenceUtilities::evaluatePolynomial(pPixels, count, mLatCoefficients, mLonCoefficients, mOrder, pGeocoords);
+   if (pAccurate != NULL)
+   {
+      for (size_t i = 0; i < count && *pAccurate == true; ++i)
+      {
+         *pAccurate = isPixelInside(pPixels[i]);
+      }
+   }
+}
+
+void GcpGeoreference::convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count,
+                                               LocationType* pPixels, bool quick, bool* pAccurate) const
+{
+   GeoreferenceUtilities::evaluatePolynomial(pGeocoords, count, mXCoefficients, mYCoefficients, mReverseOrder,
+      pPixels);
+   if (pAccurate != NULL)
+   {
+      for (size_t i = 0; i < count && *pAccurate == true; ++i)
+      {
+         *pAccurate = isPixelInside(pPixels[i]);
+      }
+   }
+}
+
+bool GcpGeoreference::isPixelInside(LocationType pixel) const
+{
+   bool outsideCols = pixel.mX < 0.0 || pixel.mX > static_cast<double>(mNumColumns);
+   bool outsideRows = pixel.mY < 0.0 || pixel.mY > static_cast<double>(mNumRows);
+   return !(outsideCols || outsideRows);
+}
+
 void GcpGeoreference::setCubeSize(unsigned int numRows, unsigned int numColumns)
 {
    mNumRows = numRows;
@@ -40,6 +40,10 @@ public:
    bool validate(const RasterDataDescriptor* pDescriptor, std::string& errorMessage) const;
    LocationType pixelToGeo(LocationType pixel, bool* pAccurate = NULL) const;
    LocationType geoToPixel(LocationType geocoord, bool* pAccurate = NULL) const;
+   void convertPixelsToGeocoords(const LocationType* pPixels, size_t count, LocationType* pGeocoords,
+      bool quick, bool* pAccurate) const;
+   void convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count, LocationType* pPixels,
+      bool quick, bool* pAccurate) const;
 
    bool serialize(SessionItemSerializer &serializer) const;
    bool deserialize(SessionItemDeserializer &deserializer);
@@ -47,6 +51,7 @@ public:
 protected:
    void computeAnchor(int corner);
    void setCubeSize(unsigned int numRows, unsigned int numColumns);
+   bool isPixelInside(LocationType pixel) const;
 
 private:
    GcpGui* mpGui;
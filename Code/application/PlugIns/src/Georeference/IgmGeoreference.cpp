@@ -10,6 +10,9 @@
 #include "AnnotationLayer.h"
 #include "AppVersion.h"
 #include "AppVerify.h"
+#include "DataAccessor.h"
+#include "DataAccessorImpl.h"
+#include "DataRequest.h"
 #include "DesktopServices.h"
 #include "DynamicObject.h"
 #include "IgmGeoreference.h"
@@ -26,6 +29,7 @@
 #include "MatrixFunctions.h"
 #include "MessageLogResource.h"
 #include "ModelServices.h"
+#include "ObjectResource.h"
 #include "PlugInArg.h"
 #include "PlugInArgList.h"
 #include "PlugInRegistration.h"
@@ -218,6 +222,9 @@ bool IgmGeoreference::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgL
       }
    }
 
+   // The UTM conversion uses a shared engine, so only convert lat/lon values in multiple threads
+   allowConcurrentConversions(mZone == 100);
+
    // calculate the reverse polynomial
    std::list<GcpPoint> gcpList;
    const unsigned int maxX = mpIgmDesc->getColumnCount() - 1;
@@ -576,19 +583,94 @@ LocationType IgmGeoreference::pixelToGeo(LocationType pixel, bool* pAccurate) co
       *pAccurate = true;
    }
 
+   return toGeocoord(mpIgmRaster->getPixelValue(column, row, firstBand),
+      mpIgmRaster->getPixelValue(column, row, secondBand));
+}
+
+void IgmGeoreference::convertPixelsToGeocoords(const LocationType* pPixels, size_t count,
+                                               LocationType* pGeocoords, bool quick, bool* pAccurate) const
+{
+   if (mpIgmRaster.get() == NULL)
+   {
+      GeoreferenceShell::convertPixelsToGeocoords(pPixels, count, pGeocoords, quick, pAccurate);
+      return;
+   }
+
+   // Read both bands of every pixel through one accessor instead of creating an accessor for each value
+   DimensionDescriptor firstBand(mpIgmDesc->getActiveBand(0));
+   DimensionDescriptor secondBand(mpIgmDesc->getActiveBand(1));
+   DataAccessor da(NULL, NULL);
+   if (firstBand.isValid() && secondBand.isValid())
+   {
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setBands(firstBand, secondBand, 1);
+      pRequest->setInterleaveFormat(BIP);
+      da = mpIgmRaster->getDataAccessor(pRequest.release());
+   }
+
+   if (da.isValid() == false)
+   {
+      GeoreferenceShell::convertPixelsToGeocoords(pPixels, count, pGeocoords, quick, pAccurate);
+      return;
+   }
+
+   EncodingType dataType = mpIgmDesc->getDataType();
+   LocationType maxPixel(mpIgmDesc->getColumnCount() - 1, mpIgmDesc->getRowCount() - 1);
+   for (size_t i = 0; i < count; ++i)
+   {
+      // Input pixel is in Active Numbers: enforce input to be within bounds.
+      LocationType pixel = pPixels[i];
+      pixel.clampMinimum(LocationType(0, 0));
+      pixel.clampMaximum(maxPixel);
+
+      da->toPixel(static_cast<int>(pixel.mY), static_cast<int>(pixel.mX));
+      if (da.isValid() == false)
+      {
+         pGeocoords[i] = LocationType();
+         if (pAccurate != NULL)
+         {
+            *pAccurate = false;
+         }
+
+         continue;
+      }
+
+      const void* pData = da->getColumn();
+      pGeocoords[i] = toGeocoord(ModelServices::getDataValue(dataType, pData, 0),
+         ModelServices::getDataValue(dataType, pData, 1));
+   }
+}
+
+void IgmGeoreference::convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count,
+                                               LocationType* pPixels, bool quick, bool* pAccurate) const
+{
+   GeoreferenceUtilities::evaluatePolynomial(pGeocoords, count, mLatCoefficients, mLonCoefficients, 2, pPixels);
+   if (pAccurate != NULL)
+   {
+      for (size_t i = 0; i < count && *pAccurate == true; ++i)
+      {
+         bool outsideCols = pPixels[i].mX < 0.0 || pPixels[i].mX > static_cast<double>(mNumColumns);
+         bool outsideRows = pPixels[i].mY < 0.0 || pPixels[i].mY > static_cast<double>(mNumRows);
+         *pAccurate = !(outsideCols || outsideRows);
+      }
+   }
+}
+
+LocationType IgmGeoreference::toGeocoord(double first, double second) const
+{
+   // first/second is either easting/northing or longitude/latitude
    if (mZone == 100) // no zone...assume we are lat/lon instead of UTM
    {
-      return LocationType(mpIgmRaster->getPixelValue(column, row, secondBand),
-         mpIgmRaster->getPixelValue(column, row, firstBand));
+      return LocationType(second, first);
    }
    char hemisphere = 'N';
-   double northing = mpIgmRaster->getPixelValue(column, row, secondBand);
+   double northing = second;
    if (northing < 0.0)
    {
       hemisphere = 'S';
       northing = -northing;
    }
-   UtmPoint uPoint(mpIgmRaster->getPixelValue(column, row, firstBand), northing, mZone, hemisphere);
+   UtmPoint uPoint(first, northing, mZone, hemisphere);
    return LocationType(uPoint.getLatLonCoordinates().getLatitude().getValue(),
       uPoint.getLatLonCoordinates().getLongitude().getValue());
 }
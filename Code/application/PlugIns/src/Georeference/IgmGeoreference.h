@@ -39,6 +39,10 @@ public:
    virtual bool validate(const RasterDataDescriptor* pDescriptor, std::string& errorMessage) const;
    virtual LocationType geoToPixel(LocationType geo, bool* pAccurate) const;
    virtual LocationType pixelToGeo(LocationType pixel, bool* pAccurate) const;
+   virtual void convertPixelsToGeocoords(const LocationType* pPixels, size_t count, LocationType* pGeocoords,
+      bool quick, bool* pAccurate) const;
+   virtual void convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count, LocationType* pPixels,
+      bool quick, bool* pAccurate) const;
 
    void elementDeleted(Subject& subject, const std::string& signal, const boost::any& data);
 
@@ -47,6 +51,7 @@ public:
 
 protected:
    bool loadIgmFile(const std::string& igmFilename);
+   LocationType toGeocoord(double first, double second) const;
 
 private:
    IgmGeoreference(const IgmGeoreference& rhs);
@@ -0,0 +1,307 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "ConfigurationSettings.h"
+#include "IceChunkWriter.h"
+#include "InterleaveTranspose.h"
+#include "MultiThreadedAlgorithm.h"
+
+#include <algorithm>
+#include <string.h>
+#include <zlib.h>
+
+// H5Dwrite_chunk() was added to the core library in HDF5 1.10.2
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 10 || \
+   (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 2)))
+#define ICE_DIRECT_CHUNK_WRITE
+#endif
+
+using namespace std;
+
+namespace
+{
+   // Filtered chunks are collected until the raw chunks occupy at least this many bytes, so each set of
+   // worker threads has enough work to be worth starting
+   const size_t BATCH_MINIMUM_SIZE = 16 * 1024 * 1024;
+
+   struct ChunkInput
+   {
+      const IceChunkWriter* mpWriter;
+      vector<IceChunkWriter::PendingChunk>* mpChunks;
+   };
+
+   class ChunkThread : public mta::AlgorithmThread
+   {
+   public:
+      ChunkThread(const ChunkInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mChunkRange(getThreadRange(threadCount, static_cast<int>(input.mpChunks->size())))
+      {
+      }
+
+      void run()
+      {
+         for (int index = mChunkRange.mFirst; index <= mChunkRange.mLast; ++index)
+         {
+            IceChunkWriter::PendingChunk& chunk = (*mInput.mpChunks)[index];
+            mInput.mpWriter->encodeChunk(chunk.mData, chunk.mEncoded);
+            vector<unsigned char>().swap(chunk.mData);
+         }
+      }
+
+   private:
+      ChunkThread& operator=(const ChunkThread& rhs);
+
+      const ChunkInput& mInput;
+      mta::AlgorithmThread::Range mChunkRange;
+   };
+
+   struct ChunkOutput
+   {
+      bool compileOverallResults(const vector<ChunkThread*>& threads)
+      {
+         return true;
+      }
+   };
+}
+
+IceChunkWriter::IceChunkWriter(hid_t dataset) :
+   mDataset(dataset),
+   mType(H5Dget_type(dataset)),
+   mFileSpace(H5Dget_space(dataset)),
+   mBytesPerElement(0),
+   mChunkBytes(0),
+   mDirect(false),
+   mShuffle(false),
+   mDeflateLevel(-1),
+   mThreadCount(max(ConfigurationSettings::getSettingThreadCount(), 1U)),
+   mPendingBytes(0)
+{
+   for (int dimension = 0; dimension < 3; ++dimension)
+   {
+      mDimensions[dimension] = 0;
+      mChunkDimensions[dimension] = 0;
+   }
+
+   if (*mType < 0 || *mFileSpace < 0 || H5Sget_simple_extent_ndims(*mFileSpace) != 3)
+   {
+      return;
+   }
+
+   H5Sget_simple_extent_dims(*mFileSpace, mDimensions, NULL);
+   mBytesPerElement = H5Tget_size(*mType);
+
+#if defined(ICE_DIRECT_CHUNK_WRITE)
+   // Only a pipeline of an optional shuffle followed by deflate is reproduced here
+   hid_t plist = H5Dget_create_plist(dataset);
+   if (plist >= 0)
+   {
+      if (H5Pget_layout(plist) == H5D_CHUNKED && H5Pget_chunk(plist, 3, mChunkDimensions) == 3)
+      {
+         bool supported = true;
+         int filterCount = H5Pget_nfilters(plist);
+         for (int index = 0; index < filterCount && supported; ++index)
+         {
+            unsigned int flags = 0;
+            size_t valueCount = 8;
+            unsigned int values[8] = {0};
+            unsigned int filterConfig = 0;
+            H5Z_filter_t filter = H5Pget_filter2(plist, static_cast<unsigned int>(index), &flags, &valueCount,
+               values, 0, NULL, &filterConfig);
+            if (filter == H5Z_FILTER_SHUFFLE && index == 0)
+            {
+               mShuffle = true;
+            }
+            else if (filter == H5Z_FILTER_DEFLATE && index == filterCount - 1 && valueCount > 0)
+            {
+               mDeflateLevel = static_cast<int>(values[0]);
+            }
+            else
+            {
+               supported = false;
+            }
+         }
+
+         mChunkBytes = mChunkDimensions[0] * mChunkDimensions[1] * mChunkDimensions[2] * mBytesPerElement;
+         mDirect = supported && mDeflateLevel >= 0 && mChunkBytes > 0;
+      }
+
+      H5Pclose(plist);
+   }
+#endif
+}
+
+bool IceChunkWriter::writeSlab(const hsize_t offset[3], const hsize_t counts[3], const void* pData)
+{
+   if (mBytesPerElement == 0)
+   {
+      return false;
+   }
+
+   if (mDirect == false)
+   {
+      Hdf5DataSpaceResource memorySpace(H5Screate_simple(3, counts, NULL));
+      if (*memorySpace < 0 ||
+         H5Sselect_hyperslab(*mFileSpace, H5S_SELECT_SET, offset, NULL, counts, NULL) < 0)
+      {
+         return false;
+      }
+
+      return H5Dwrite(mDataset, *mType, *memorySpace, *mFileSpace, H5P_DEFAULT, pData) >= 0;
+   }
+
+   hsize_t chunkCounts[3];
+   for (int dimension = 0; dimension < 3; ++dimension)
+   {
+      if (offset[dimension] % mChunkDimensions[dimension] != 0 || counts[dimension] == 0 ||
+         offset[dimension] + counts[dimension] > mDimensions[dimension] ||
+         (counts[dimension] % mChunkDimensions[dimension] != 0 &&
+         offset[dimension] + counts[dimension] != mDimensions[dimension]))
+      {
+         return false;
+      }
+
+      chunkCounts[dimension] = (counts[dimension] + mChunkDimensions[dimension] - 1) / mChunkDimensions[dimension];
+   }
+
+   // Grow the pending chunks by swapping their buffers, since copying them would copy every chunk
+   size_t required = mPending.size() + static_cast<size_t>(chunkCounts[0] * chunkCounts[1] * chunkCounts[2]);
+   if (mPending.capacity() < required)
+   {
+      vector<PendingChunk> grown;
+      grown.reserve(max(required, 2 * mPending.capacity()));
+      grown.resize(mPending.size());
+      for (size_t index = 0; index < mPending.size(); ++index)
+      {
+         memcpy(grown[index].mOffset, mPending[index].mOffset, sizeof(mPending[index].mOffset));
+         grown[index].mData.swap(mPending[index].mData);
+      }
+
+      mPending.swap(grown);
+   }
+
+   // Copy each chunk out of the slab, padding the chunks at the edges of the dataset with zeros
+   const unsigned char* pSlab = reinterpret_cast<const unsigned char*>(pData);
+   for (hsize_t chunk0 = 0; chunk0 < chunkCounts[0]; ++chunk0)
+   {
+      for (hsize_t chunk1 = 0; chunk1 < chunkCounts[1]; ++chunk1)
+      {
+         for (hsize_t chunk2 = 0; chunk2 < chunkCounts[2]; ++chunk2)
+         {
+            hsize_t start[3] = {chunk0 * mChunkDimensions[0], chunk1 * mChunkDimensions[1],
+               chunk2 * mChunkDimensions[2]};
+            hsize_t extent[3];
+            for (int dimension = 0; dimension < 3; ++dimension)
+            {
+               extent[dimension] = min(mChunkDimensions[dimension], counts[dimension] - start[dimension]);
+            }
+
+            mPending.push_back(PendingChunk());
+            PendingChunk& pending = mPending.back();
+            for (int dimension = 0; dimension < 3; ++dimension)
+            {
+               pending.mOffset[dimension] = offset[dimension] + start[dimension];
+            }
+
+            pending.mData.assign(mChunkBytes, 0);
+            size_t copySize = static_cast<size_t>(extent[2]) * mBytesPerElement;
+            for (hsize_t index0 = 0; index0 < extent[0]; ++index0)
+            {
+               for (hsize_t index1 = 0; index1 < extent[1]; ++index1)
+               {
+                  size_t source = static_cast<size_t>(((start[0] + index0) * counts[1] + start[1] + index1) *
+                     counts[2] + start[2]) * mBytesPerElement;
+                  size_t destination = static_cast<size_t>((index0 * mChunkDimensions[1] + index1) *
+                     mChunkDimensions[2]) * mBytesPerElement;
+                  memcpy(&pending.mData[destination], pSlab + source, copySize);
+               }
+            }
+
+            mPendingBytes += mChunkBytes;
+         }
+      }
+   }
+
+   if (mPendingBytes >= BATCH_MINIMUM_SIZE && mPending.size() >= mThreadCount)
+   {
+      return writeChunks();
+   }
+
+   return true;
+}
+
+bool IceChunkWriter::flush()
+{
+   if (mDirect == false || mPending.empty() == true)
+   {
+      return mBytesPerElement > 0;
+   }
+
+   return writeChunks();
+}
+
+void IceChunkWriter::encodeChunk(const vector<unsigned char>& chunk, vector<unsigned char>& encoded) const
+{
+   encoded.clear();
+   if (chunk.empty() == true)
+   {
+      return;
+   }
+
+   const unsigned char* pSource = &chunk[0];
+   vector<unsigned char> shuffled;
+   if (mShuffle == true && mBytesPerElement > 1)
+   {
+      // The shuffle filter stores the first byte of every element, then the second byte, and so on
+      shuffled.resize(chunk.size());
+      size_t elements = chunk.size() / mBytesPerElement;
+      InterleaveTranspose::transpose(pSource, elements, mBytesPerElement, mBytesPerElement, &shuffled[0],
+         elements, 1);
+      pSource = &shuffled[0];
+   }
+
+   uLongf encodedSize = compressBound(static_cast<uLong>(chunk.size()));
+   encoded.resize(encodedSize);
+   if (compress2(&encoded[0], &encodedSize, pSource, static_cast<uLong>(chunk.size()), mDeflateLevel) != Z_OK)
+   {
+      encoded.clear();
+      return;
+   }
+
+   encoded.resize(encodedSize);
+}
+
+bool IceChunkWriter::writeChunks()
+{
+   ChunkInput input;
+   input.mpWriter = this;
+   input.mpChunks = &mPending;
+
+   ChunkOutput output;
+   mta::MultiThreadedAlgorithm<ChunkInput, ChunkOutput, ChunkThread>
+      algorithm(mta::getNumRequiredThreads(static_cast<unsigned int>(mPending.size())), input, output, NULL);
+   bool success = (algorithm.run() == mta::SUCCESS);
+
+#if defined(ICE_DIRECT_CHUNK_WRITE)
+   // The chunks are written in the order they were passed in so the file is laid out sequentially
+   for (vector<PendingChunk>::const_iterator iter = mPending.begin(); iter != mPending.end() && success; ++iter)
+   {
+      success = (iter->mEncoded.empty() == false &&
+         H5Dwrite_chunk(mDataset, H5P_DEFAULT, 0, iter->mOffset, iter->mEncoded.size(), &iter->mEncoded[0]) >= 0);
+   }
+#else
+   success = false;
+#endif
+
+   mPending.clear();
+   mPendingBytes = 0;
+   return success;
+}
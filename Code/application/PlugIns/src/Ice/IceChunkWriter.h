@@ -0,0 +1,116 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef ICECHUNKWRITER_H
+#define ICECHUNKWRITER_H
+
+#include "Hdf5Resource.h"
+
+#include <hdf5.h>
+#include <vector>
+
+/**
+ * Writes slabs of a three dimensional chunked dataset.
+ *
+ * HDF5 runs the filter pipeline of a dataset on the thread which calls
+ * H5Dwrite(), so a compressed dataset is written no faster than one core can
+ * deflate it.  When the pipeline of the dataset contains only the shuffle and
+ * deflate filters, this writer splits each slab into its chunks, filters the
+ * chunks itself on worker threads, and stores the filtered chunks in order
+ * with H5Dwrite_chunk().  Other datasets, and all datasets when the HDF5
+ * library is older than 1.10.2, are written with H5Dwrite().
+ *
+ * Each slab must start on a chunk boundary and must cover whole chunks,
+ * except where it ends at the edge of the dataset.
+ */
+class IceChunkWriter
+{
+public:
+   /**
+    * Creates a writer for a dataset.
+    *
+    * @param dataset
+    *        The dataset to write, which must have three dimensions.  The
+    *        data passed to writeSlab() has the type of the dataset.
+    */
+   IceChunkWriter(hid_t dataset);
+
+   /**
+    * Writes a slab of the dataset.
+    *
+    * Filtered chunks are collected until there are enough to keep the
+    * worker threads busy, so the slab may not be stored until a later call
+    * or until flush() is called.  The data is copied, and the buffer can be
+    * reused once this method returns.
+    *
+    * @param offset
+    *        The position of the first element of the slab in the dataset.
+    * @param counts
+    *        The size of the slab in each dimension.
+    * @param pData
+    *        The elements of the slab, with the last dimension varying fastest.
+    *
+    * @return Returns \c true if the slab was accepted, or \c false if the
+    *         slab is not aligned to the chunks or if data could not be
+    *         written to the file.
+    */
+   bool writeSlab(const hsize_t offset[3], const hsize_t counts[3], const void* pData);
+
+   /**
+    * Writes any chunks which have not been stored.
+    *
+    * @return Returns \c true if every chunk has been written to the file.
+    */
+   bool flush();
+
+   /**
+    * Filters a chunk as the deflate and optional shuffle filters of the
+    * dataset would.
+    *
+    * This is an implementation detail of the writer which is called from
+    * the worker threads.
+    *
+    * @param chunk
+    *        The elements of a full chunk.
+    * @param encoded
+    *        Populated with the filtered bytes, or left empty if the chunk
+    *        could not be compressed.
+    */
+   void encodeChunk(const std::vector<unsigned char>& chunk, std::vector<unsigned char>& encoded) const;
+
+   struct PendingChunk
+   {
+      hsize_t mOffset[3];
+      std::vector<unsigned char> mData;
+      std::vector<unsigned char> mEncoded;
+   };
+
+private:
+   IceChunkWriter(const IceChunkWriter& rhs);
+   IceChunkWriter& operator=(const IceChunkWriter& rhs);
+
+   bool writeChunks();
+
+   hid_t mDataset;
+   Hdf5TypeResource mType;
+   Hdf5DataSpaceResource mFileSpace;
+   hsize_t mDimensions[3];
+   hsize_t mChunkDimensions[3];
+   size_t mBytesPerElement;
+   size_t mChunkBytes;
+   bool mDirect;
+   bool mShuffle;
+   int mDeflateLevel;
+   unsigned int mThreadCount;
+
+   std::vector<PendingChunk> mPending;
+   size_t mPendingBytes;
+};
+
+#endif
@@ -81,6 +81,7 @@ bool IceExporterShell::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArg
          writer.setChunkSize(mpOptionsWidget->getChunkSize() * 1024 * 1024);
          writer.setCompressionType(mpOptionsWidget->getCompressionType());
          writer.setGzipCompressionLevel(mpOptionsWidget->getGzipCompressionLevel());
+         writer.setChunkShape(mpOptionsWidget->getChunkShape());
       }
       if ((pRasterDescriptor->getDataType() == INT4SCOMPLEX || pRasterDescriptor->getDataType() == FLT8COMPLEX)
        && (writer.getCompressionType() == GZIP || writer.getCompressionType() == SHUFFLE_AND_GZIP))
@@ -22,6 +22,7 @@
 #include "ImportDescriptor.h"
 #include "ObjectResource.h"
 #include "PseudocolorLayer.h"
+#include "QuantileSketch.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 #include "RasterFileDescriptor.h"
@@ -1117,6 +1118,50 @@ bool IceReader::loadCubeStatistics(RasterElement* pElement)
                areStatsCalculated = pCubeStat->areStatisticsCalculated();
             }
          }
+
+         // Look for QuantileSketches. If it's present, parse it.
+         { // Resource scoping
+            Hdf5DataSetResource sketchDs;
+            {  //Turn off error handling while we check for sketches, since they may not exist
+               Hdf5ErrorHandlerResource errHandler(NULL, NULL);
+               sketchDs = Hdf5DataSetResource(fileHandle, "/Datasets/Cube1/BandStatistics/QuantileSketches");
+            }
+
+            // The sketches are optional, and are only written by newer versions
+            DO_IF(*sketchDs < 0, return true);
+            Hdf5DataSpaceResource dataSpace(H5Dget_space(*sketchDs));
+            hsize_t sizeArray[H5S_MAX_RANK];
+            int numdimensions = H5Sget_simple_extent_dims(*dataSpace, sizeArray, NULL);
+            DO_IF(numdimensions != 1, return true);
+            Hdf5IncrementalReader sketchReader(*sketchDs);
+            hsize_t oneValue = 1;
+            for (hsize_t currentRow = 0; currentRow < sizeArray[0]; ++currentRow)
+            {
+               sketchReader.selectHyperslab(H5S_SELECT_SET, &currentRow, &oneValue, &oneValue, NULL);
+               auto_ptr<StatisticsSketch> pValues(sketchReader.readSelectedData<StatisticsSketch>());
+               DO_IF(pValues.get() == NULL, return true);
+               DimensionDescriptor loadedBand = pDataDesc->getOnDiskBand(pValues->mOnDiskBandNumber);
+               if (loadedBand.isValid() == false)
+               {
+                  continue;
+               }
+               Statistics* pCubeStat = pElement->getStatistics(loadedBand);
+               DO_IF(pCubeStat == NULL, return true);
+
+               StatisticsSketch::ValueType* pSketchValues =
+                  reinterpret_cast<StatisticsSketch::ValueType*>(pValues->mpValues.p);
+               StatisticsSketch::LevelCountType* pLevelCounts =
+                  reinterpret_cast<StatisticsSketch::LevelCountType*>(pValues->mpLevelCounts.p);
+               vector<double> values(pSketchValues, pSketchValues + pValues->mpValues.len);
+               vector<unsigned int> levelCounts(pLevelCounts, pLevelCounts + pValues->mpLevelCounts.len);
+
+               QuantileSketch sketch(Statistics::getSettingSketchCapacity());
+               if (sketch.setLevels(values, levelCounts, pValues->mMin, pValues->mMax))
+               {
+                  pCubeStat->setQuantileSketch(sketch);
+               }
+            }
+         }
       }
    }
 
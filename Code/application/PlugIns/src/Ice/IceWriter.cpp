@@ -18,11 +18,14 @@
 #include "DynamicObject.h"
 #include "Hdf5IncrementalWriter.h"
 #include "Hdf5Utilities.h"
+#include "IceChunkWriter.h"
 #include "IceWriter.h"
+#include "InterleaveTranspose.h"
 #include "Layer.h"
 #include "ObjectResource.h"
 #include "Progress.h"
 #include "PseudocolorLayer.h"
+#include "QuantileSketch.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 #include "RasterFileDescriptor.h"
@@ -38,7 +41,9 @@
 #undef VERSION // Ensure no compile errors due to HDF5 headers
 #include "xmlwriter.h"
 
+#include <algorithm>
 #include <iomanip>
+#include <math.h>
 #include <sstream>
 
 using namespace std;
@@ -77,6 +82,12 @@ ADD_ENUM_MAPPING(NONE, "None", "none")
 ADD_ENUM_MAPPING(GZIP, "GZIP", "gzip")
 ADD_ENUM_MAPPING(SHUFFLE_AND_GZIP, "Shuffle+GZIP", "shuffle_gzip")
 END_ENUM_MAPPING()
+
+BEGIN_ENUM_MAPPING(IceChunkShape)
+ADD_ENUM_MAPPING(ROW_CHUNKS, "Rows", "rows")
+ADD_ENUM_MAPPING(TILE_CHUNKS, "Tiles", "tiles")
+ADD_ENUM_MAPPING(SPECTRAL_CHUNKS, "Spectral Tiles", "spectral_tiles")
+END_ENUM_MAPPING()
 }
 
 IceWriter::IceWriter(hid_t fileHandle, IceUtilities::FileType fileType) :
@@ -85,8 +96,13 @@ IceWriter::IceWriter(hid_t fileHandle, IceUtilities::FileType fileType) :
    mFileType(fileType),
    mChunkSize(std::max(IceWriter::getSettingChunkSize(), 1) * 1024 * 1024), // convert from MB to bytes
    mCompressionType(StringUtilities::fromXmlString<IceCompressionType>(IceWriter::getSettingCompressionType())),
-   mGzipCompressionLevel(std::max(std::min(IceWriter::getSettingGzipCompressionLevel(), 9), 0))
+   mGzipCompressionLevel(std::max(std::min(IceWriter::getSettingGzipCompressionLevel(), 9), 0)),
+   mChunkShape(StringUtilities::fromXmlString<IceChunkShape>(IceWriter::getSettingChunkShape()))
 {
+   if (mChunkShape.isValid() == false)
+   {
+      mChunkShape = ROW_CHUNKS;
+   }
 }
 
 void IceWriter::writeFileHeader()
@@ -416,6 +432,45 @@ void IceWriter::writeCube(const string& hdfPath,
 
          ICEVERIFY(statWriter.writeBlock(row, statVal));
       }
+
+      // Sketches are optional, so only the bands which have one are written
+      vector<pair<const QuantileSketch*, unsigned int> > sketches;
+      for (bandIter = calculatedStatistics.begin(); bandIter != calculatedStatistics.end(); ++bandIter)
+      {
+         const QuantileSketch* pSketch = bandIter->first->getQuantileSketch();
+         if (pSketch != NULL && pSketch->isEmpty() == false)
+         {
+            sketches.push_back(make_pair(pSketch, bandIter->second));
+         }
+      }
+
+      if (sketches.empty() == false)
+      {
+         vector<hsize_t> sketchDimensions;
+         sketchDimensions.push_back(sketches.size());
+         Hdf5IncrementalWriter<StatisticsSketch> sketchWriter(mFileHandle,
+            string(statPath + "/QuantileSketches"), sketchDimensions);
+
+         StatisticsSketch sketchVal;
+         vector<pair<const QuantileSketch*, unsigned int> >::const_iterator sketchIter;
+         for (sketchIter = sketches.begin(), row = 0; sketchIter != sketches.end(); ++sketchIter, ++row)
+         {
+            const QuantileSketch* pSketch = sketchIter->first;
+            vector<double> values;
+            vector<unsigned int> levelCounts;
+            pSketch->getLevels(values, levelCounts);
+
+            sketchVal.mOnDiskBandNumber = sketchIter->second;
+            sketchVal.mMin = pSketch->getMinimum();
+            sketchVal.mMax = pSketch->getMaximum();
+            sketchVal.mpValues.p = values.empty() ? NULL : &values.front();
+            sketchVal.mpValues.len = values.size();
+            sketchVal.mpLevelCounts.p = levelCounts.empty() ? NULL : &levelCounts.front();
+            sketchVal.mpLevelCounts.len = levelCounts.size();
+
+            ICEVERIFY(sketchWriter.writeBlock(row, sketchVal));
+         }
+      }
    }
    //NOTE: Currently the RasterElement::getTerrain() isn't being serialized and that is
    //intentional until some decisions are made about how terrains should be handled.
@@ -606,22 +661,18 @@ void IceWriter::writeBilCubeData(const std::string& hdfPath,
    compSpace[2] = dimSpace[2] = cols.size();
 
    unsigned int rowSize = cols.size() * bands.size() * bpe;
-   unsigned int rowsInChunk = mChunkSize/rowSize; // determine number of rows that fit into a 1MB chunk
-   if (rowsInChunk > rows.size())
-   {
-      rowsInChunk = rows.size();
-   }
-   if (rowsInChunk == 0)
+   unsigned int rowsInChunk = getRowsInChunk(rowSize, rows.size());
+   if (mChunkShape == TILE_CHUNKS || mChunkShape == SPECTRAL_CHUNKS)
    {
-      rowsInChunk = 1;
+      // every band of a square block of pixels
+      hsize_t tileSize = getTileSize(bands.size() * bpe);
+      rowsInChunk = static_cast<unsigned int>(min<hsize_t>(tileSize, dimSpace[0]));
+      compSpace[2] = min(tileSize, dimSpace[2]);
    }
    compSpace[0] = rowsInChunk;
 
    createDatasetForCube(dimSpace, compSpace, pDescriptor->getDataType(), mFileHandle, hdfPath, dataId);
-   Hdf5DataSpaceResource dspaceId(H5Dget_space(*dataId));
-   ICEVERIFY(*dspaceId >= 0);
-   Hdf5TypeResource hdfEncoding(H5Dget_type(*dataId));
-   ICEVERIFY(*hdfEncoding >= 0);
+   IceChunkWriter chunkWriter(*dataId);
 
    FactoryResource<DataRequest> pRequest;
    pRequest->setInterleaveFormat(BIL);
@@ -634,14 +685,25 @@ void IceWriter::writeBilCubeData(const std::string& hdfPath,
    vector<char> pWriteBufferRes(rowsInChunk*rowSize, 0);
    char* pWriteBuffer = &pWriteBufferRes.front();
 
-   counts[0] = rowsInChunk;
    counts[1] = bands.size();
    counts[2] = cols.size();
-
-   Hdf5DataSpaceResource mspaceId(H5Screate_simple(3, counts, NULL));
-   ICEVERIFY(*mspaceId >= 0);
    offset[1] = offset[2] = 0; // reset to beginning of rows and bands
 
+   // the offset of each exported element from the start of a row
+   vector<size_t> offsets;
+   if (bEntireRow == false)
+   {
+      offsets.reserve(bands.size() * cols.size());
+      for (unsigned int bandCount = 0; bandCount < bands.size(); ++bandCount)
+      {
+         size_t bandOffset = bands[bandCount].getActiveNumber() * da->getConcurrentColumns();
+         for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
+         {
+            offsets.push_back(bandOffset + cols[colCount].getActiveNumber());
+         }
+      }
+   }
+
    unsigned int numChunks = rows.size() / rowsInChunk;
    if (rows.size() % rowsInChunk != 0)
    {
@@ -651,107 +713,46 @@ void IceWriter::writeBilCubeData(const std::string& hdfPath,
    abortIfNecessary();
 
    int rowIndex = 0;
-   if (bEntireRow)
+   for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
    {
-      for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
+      unsigned int startChunkRow = chunkNumber * rowsInChunk;
+      unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
+      if (endChunkRow > rows.size())
       {
-         unsigned int startChunkRow = chunkNumber * rowsInChunk;
-         unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
-         if (endChunkRow > rows.size())
-         {
-            endChunkRow = rows.size();
-         }
-
-         char* pBuffer = pWriteBuffer;
-         for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
-         {
-            if (pProgress != NULL)
-            {
-               pProgress->updateProgress("Exporting cube...",
-                  (rowIndex++ * 100) / rows.size(), NORMAL);
-            }
-
-            unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
-            da->toPixel(rowActiveNum, 0);
-            ICEVERIFY(da.isValid());
-            memcpy(pBuffer, da->getRow(), rowSize);
-            pBuffer += rowSize;
-
-            abortIfNecessary();
-         }
-
-         offset[0] = startChunkRow;
-
-         if (chunkNumber + 1 == numChunks)
-         {
-            counts[0] = endChunkRow - startChunkRow;
-            mspaceId = Hdf5DataSpaceResource(H5Screate_simple(3, counts, NULL));
-            ICEVERIFY(*mspaceId >= 0);
-         }
-
-         herr_t status = H5Sselect_hyperslab(*dspaceId, H5S_SELECT_SET, offset, NULL, counts, NULL);
-         ICEVERIFY(status >= 0);
-
-         status = H5Dwrite(*dataId, *hdfEncoding, *mspaceId, *dspaceId, H5P_DEFAULT, pWriteBuffer);
-         ICEVERIFY(status >= 0);
+         endChunkRow = rows.size();
       }
-   }
-   else
-   {
-      unsigned int totalColumns = cubeCols.size();
-      for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
+
+      char* pBuffer = pWriteBuffer;
+      for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
       {
-         unsigned int startChunkRow = chunkNumber * rowsInChunk;
-         unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
-         if (endChunkRow > rows.size())
+         if (pProgress != NULL)
          {
-            endChunkRow = rows.size();
+            pProgress->updateProgress("Exporting cube...",
+               (rowIndex++ * 100) / rows.size(), NORMAL);
          }
 
-         char* pBuffer = pWriteBuffer;
-         for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
+         unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
+         da->toPixel(rowActiveNum, 0);
+         ICEVERIFY(da.isValid());
+         if (bEntireRow)
          {
-            if (pProgress != NULL)
-            {
-               pProgress->updateProgress("Exporting cube...",
-                  (rowIndex++ * 100) / rows.size(), NORMAL);
-            }
-
-            unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
-            da->toPixel(rowActiveNum, 0);
-            ICEVERIFY(da.isValid());
-            
-            for (unsigned int bandCount = 0; bandCount < bands.size(); ++bandCount)
-            {
-               unsigned int bandActiveNum = bands[bandCount].getActiveNumber();
-               for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
-               {
-                  unsigned int colActiveNum = cols[colCount].getActiveNumber();
-                  memcpy(pBuffer, static_cast<char*>(da->getColumn()) +
-                     (bandActiveNum * totalColumns * bpe) + (colActiveNum * bpe), bpe);
-                  pBuffer += bpe;
-               }
-            }
-
-            abortIfNecessary();
+            memcpy(pBuffer, da->getRow(), rowSize);
          }
-
-         offset[0] = startChunkRow;
-
-         if (chunkNumber + 1 == numChunks)
+         else
          {
-            counts[0] = endChunkRow - startChunkRow;
-            mspaceId = Hdf5DataSpaceResource(H5Screate_simple(3, counts, NULL));
-            ICEVERIFY(*mspaceId >= 0);
+            InterleaveTranspose::gather(da->getRow(), &offsets[0], offsets.size(), pBuffer, bpe);
          }
+         pBuffer += rowSize;
 
-         herr_t status = H5Sselect_hyperslab(*dspaceId, H5S_SELECT_SET, offset, NULL, counts, NULL);
-         ICEVERIFY(status >= 0);
-
-         status = H5Dwrite(*dataId, *hdfEncoding, *mspaceId, *dspaceId, H5P_DEFAULT, pWriteBuffer);
-         ICEVERIFY(status >= 0);
+         abortIfNecessary();
       }
+
+      offset[0] = startChunkRow;
+      counts[0] = endChunkRow - startChunkRow;
+      ICEVERIFY(chunkWriter.writeSlab(offset, counts, pWriteBuffer));
    }
+
+   ICEVERIFY(chunkWriter.flush());
 }
 
 void IceWriter::writeBipCubeData(const string& hdfPath,
@@ -786,22 +787,18 @@ void IceWriter::writeBipCubeData(const string& hdfPath,
    compSpace[2] = bands.size();
 
    unsigned int rowSize = cols.size() * bands.size() * bpe;
-   unsigned int rowsInChunk = mChunkSize/rowSize; // determine number of rows that fit into a chunk
-   if (rowsInChunk > rows.size())
-   {
-      rowsInChunk = rows.size();
-   }
-   if (rowsInChunk == 0)
+   unsigned int rowsInChunk = getRowsInChunk(rowSize, rows.size());
+   if (mChunkShape == TILE_CHUNKS || mChunkShape == SPECTRAL_CHUNKS)
    {
-      rowsInChunk = 1;
+      // every band of a square block of pixels
+      hsize_t tileSize = getTileSize(bands.size() * bpe);
+      rowsInChunk = static_cast<unsigned int>(min<hsize_t>(tileSize, dimSpace[0]));
+      compSpace[1] = min(tileSize, dimSpace[1]);
    }
    compSpace[0] = rowsInChunk;
 
    createDatasetForCube(dimSpace, compSpace, pDescriptor->getDataType(), mFileHandle, hdfPath, dataId );
-   Hdf5DataSpaceResource dspaceId(H5Dget_space(*dataId));
-   ICEVERIFY(*dspaceId >= 0);
-   Hdf5TypeResource hdfEncoding(H5Dget_type(*dataId));
-   ICEVERIFY(*hdfEncoding >= 0);
+   IceChunkWriter chunkWriter(*dataId);
 
    FactoryResource<DataRequest> pRequest;
    pRequest->setInterleaveFormat(BIP);
@@ -814,15 +811,27 @@ void IceWriter::writeBipCubeData(const string& hdfPath,
    vector<char> pWriteBufferRes(rowsInChunk*rowSize, 0);
    char* pWriteBuffer = &pWriteBufferRes.front();
 
-   counts[0] = rowsInChunk;
    counts[1] = cols.size();
    counts[2] = bands.size();
-
-   Hdf5DataSpaceResource mspaceId(H5Screate_simple(3, counts, NULL));
-   ICEVERIFY(*mspaceId >= 0);
    offset[1] = 0;
    offset[2] = 0; // reset to beginning of rows and bands
 
+   // the offset of each exported element from the start of a row
+   vector<size_t> offsets;
+   if (bEntireRow == false)
+   {
+      size_t pixelStride = da->getRowView<unsigned char, BIP>().getStride();
+      offsets.reserve(cols.size() * bands.size());
+      for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
+      {
+         size_t pixelOffset = cols[colCount].getActiveNumber() * pixelStride;
+         for (unsigned int bandCount = 0; bandCount < bands.size(); ++bandCount)
+         {
+            offsets.push_back(pixelOffset + bands[bandCount].getActiveNumber());
+         }
+      }
+   }
+
    unsigned int numChunks = rows.size() / rowsInChunk;
    if (rows.size() % rowsInChunk != 0)
    {
@@ -832,108 +841,46 @@ void IceWriter::writeBipCubeData(const string& hdfPath,
    abortIfNecessary();
 
    int rowIndex = 0;
-   if (bEntireRow)
+   for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
    {
-      for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
+      unsigned int startChunkRow = chunkNumber * rowsInChunk;
+      unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
+      if (endChunkRow > rows.size())
       {
-         unsigned int startChunkRow = chunkNumber * rowsInChunk;
-         unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
-         if (endChunkRow > rows.size())
-         {
-            endChunkRow = rows.size();
-         }
-
-         char* pBuffer = pWriteBuffer;
-         for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
-         {
-            if (pProgress != NULL)
-            {
-               pProgress->updateProgress("Exporting cube...",
-                  (rowIndex++ * 100) / rows.size(), NORMAL);
-            }
-
-            unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
-            da->toPixel( rowActiveNum, 0 );
-            ICEVERIFY(da.isValid());
-            memcpy(pBuffer, da->getRow(), rowSize);
-            pBuffer += rowSize;
-            
-            abortIfNecessary();
-         }
-
-         offset[0] = startChunkRow;
-
-         if (chunkNumber + 1 == numChunks)
-         {
-            counts[0] = endChunkRow - startChunkRow;
-            mspaceId = Hdf5DataSpaceResource(H5Screate_simple(3, counts, NULL));
-            ICEVERIFY(*mspaceId >= 0);
-         }
-
-         herr_t status = H5Sselect_hyperslab(*dspaceId, H5S_SELECT_SET, offset, NULL, counts, NULL);
-         ICEVERIFY(status >= 0);
-
-         status = H5Dwrite(*dataId, *hdfEncoding, *mspaceId, *dspaceId, H5P_DEFAULT, pWriteBuffer);
-         ICEVERIFY(status >= 0);
-
-
+         endChunkRow = rows.size();
       }
-   }
-   else
-   {
-      for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
+
+      char* pBuffer = pWriteBuffer;
+      for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
       {
-         unsigned int startChunkRow = chunkNumber * rowsInChunk;
-         unsigned int endChunkRow = (chunkNumber + 1) * rowsInChunk;
-         if (endChunkRow > rows.size())
+         if (pProgress != NULL)
          {
-            endChunkRow = rows.size();
+            pProgress->updateProgress("Exporting cube...",
+               (rowIndex++ * 100) / rows.size(), NORMAL);
          }
 
-         char* pBuffer = pWriteBuffer;
-         for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
+         unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
+         da->toPixel(rowActiveNum, 0);
+         ICEVERIFY(da.isValid());
+         if (bEntireRow)
          {
-            if (pProgress != NULL)
-            {
-               pProgress->updateProgress("Exporting cube...",
-                  (rowIndex++ * 100) / rows.size(), NORMAL);
-            }
-
-            for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
-            {
-               unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
-               unsigned int colActiveNum = cols[colCount].getActiveNumber();
-               da->toPixel( rowActiveNum, colActiveNum );
-               ICEVERIFY(da.isValid());
-
-               for (unsigned int bandCount = 0; bandCount < bands.size(); ++bandCount)
-               {
-                  unsigned int bandActiveNum = bands[bandCount].getActiveNumber();
-                  memcpy(pBuffer,
-                     static_cast<char*>(da->getColumn())+(bandActiveNum*bpe), bpe);
-                  pBuffer += bpe;
-               }
-            }
-
-            abortIfNecessary();
+            memcpy(pBuffer, da->getRow(), rowSize);
          }
-
-         offset[0] = startChunkRow;
-
-         if (chunkNumber + 1 == numChunks)
+         else
          {
-            counts[0] = endChunkRow - startChunkRow;
-            mspaceId = Hdf5DataSpaceResource(H5Screate_simple(3, counts, NULL));
-            ICEVERIFY(*mspaceId >= 0);
+            InterleaveTranspose::gather(da->getRow(), &offsets[0], offsets.size(), pBuffer, bpe);
          }
+         pBuffer += rowSize;
 
-         herr_t status = H5Sselect_hyperslab(*dspaceId, H5S_SELECT_SET, offset, NULL, counts, NULL);
-         ICEVERIFY(status >= 0);
-
-         status = H5Dwrite(*dataId, *hdfEncoding, *mspaceId, *dspaceId, H5P_DEFAULT, pWriteBuffer);
-         ICEVERIFY(status >= 0);
+         abortIfNecessary();
       }
+
+      offset[0] = startChunkRow;
+      counts[0] = endChunkRow - startChunkRow;
+      ICEVERIFY(chunkWriter.writeSlab(offset, counts, pWriteBuffer));
    }
+
+   ICEVERIFY(chunkWriter.flush());
 }
 
 void IceWriter::writeBsqCubeData(const string& hdfPath,
@@ -948,6 +895,8 @@ void IceWriter::writeBsqCubeData(const string& hdfPath,
    const vector<DimensionDescriptor>& rows = pOutputFileDescriptor->getRows();
    const vector<DimensionDescriptor>& cols = pOutputFileDescriptor->getColumns();
 
+   const vector<DimensionDescriptor>& cubeCols = pDescriptor->getColumns();
+
    unsigned int bpe = pDescriptor->getBytesPerElement();
 
    ICEVERIFY_MSG(!rows.empty() && !cols.empty() && !bands.empty(), "No data selected for export.")
@@ -964,58 +913,76 @@ void IceWriter::writeBsqCubeData(const string& hdfPath,
    dimSpace[2] = cols.size();
 
    // compress in chunks
-   compSpace[0] = 1;
-   counts[0] = 1; //only try to fit 1 band into a chunk
+   compSpace[0] = 1; //only try to fit 1 band into a chunk
    compSpace[2] = cols.size();
    counts[2] = cols.size();
 
    unsigned int rowSize = cols.size() * bpe;
-   unsigned int rowsInChunk = mChunkSize/rowSize; // determine number of rows that fit into a chunk
-   if (rowsInChunk > rows.size())
+   unsigned int rowsInChunk = getRowsInChunk(rowSize, rows.size());
+   if (mChunkShape == TILE_CHUNKS)
    {
-      rowsInChunk = rows.size();
+      // a square block of pixels from one band
+      hsize_t tileSize = getTileSize(bpe);
+      rowsInChunk = static_cast<unsigned int>(min<hsize_t>(tileSize, dimSpace[1]));
+      compSpace[2] = min(tileSize, dimSpace[2]);
    }
-   if (rowsInChunk == 0)
+   else if (mChunkShape == SPECTRAL_CHUNKS)
    {
-      rowsInChunk = 1;
+      // every band of a square block of pixels
+      hsize_t tileSize = getTileSize(bands.size() * bpe);
+      rowsInChunk = static_cast<unsigned int>(min<hsize_t>(tileSize, dimSpace[1]));
+      compSpace[0] = bands.size();
+      compSpace[2] = min(tileSize, dimSpace[2]);
    }
    compSpace[1] = rowsInChunk;
-   counts[1] = rowsInChunk;
+   unsigned int bandsInChunk = static_cast<unsigned int>(compSpace[0]);
 
    createDatasetForCube(dimSpace, compSpace, pDescriptor->getDataType(), mFileHandle, hdfPath, dataId);
-   Hdf5DataSpaceResource dSpaceId(H5Dget_space(*dataId));
-   ICEVERIFY(*dSpaceId >= 0);
-   Hdf5TypeResource hdfEncoding(H5Dget_type(*dataId));
-   ICEVERIFY(*hdfEncoding >= 0);
+   IceChunkWriter chunkWriter(*dataId);
 
-   vector<char> pWriteBufferRes(rowsInChunk*rowSize, 0);
+   vector<char> pWriteBufferRes(bandsInChunk*rowsInChunk*rowSize, 0);
    char* pWriteBuffer = &pWriteBufferRes.front();
 
-   Hdf5DataSpaceResource mspaceId(H5Screate_simple(3, counts, NULL));
-   ICEVERIFY(*mspaceId >= 0);
-
    unsigned int numChunks = rows.size() / rowsInChunk;
    if (rows.size() % rowsInChunk != 0)
    {
       numChunks++;
-      counts[1] = (rows.size() % rowsInChunk);
    }
-   Hdf5DataSpaceResource lastChunkWriteId(H5Screate_simple(3, counts, NULL));
 
    abortIfNecessary();
 
+   // the offset of each exported column from the start of a row
+   bool bEntireRow = (cubeCols.size() == cols.size());
+   vector<size_t> offsets;
+   if (bEntireRow == false)
+   {
+      offsets.reserve(cols.size());
+      for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
+      {
+         offsets.push_back(cols[colCount].getActiveNumber());
+      }
+   }
+
    offset[2] = 0; //always write out a whole row
    int rowIndex = 0;
-   for (unsigned int bandCount = 0; bandCount < bands.size(); ++bandCount)
+   for (unsigned int startBand = 0; startBand < bands.size(); startBand += bandsInChunk)
    {
-      offset[0] = bandCount;
+      unsigned int endBand = min(startBand + bandsInChunk, static_cast<unsigned int>(bands.size()));
+      offset[0] = startBand;
+      counts[0] = endBand - startBand;
 
-      // BSQ the slow way
-      FactoryResource<DataRequest> pRequest;
-      pRequest->setInterleaveFormat(BSQ);
-      pRequest->setBands(bands[bandCount], bands[bandCount]);
-      DataAccessor da = pCube->getDataAccessor(pRequest.release());
-      ICEVERIFY(da.isValid());
+      // one accessor for each band whose rows are in the same slab
+      vector<DataAccessor> accessors;
+      for (unsigned int bandCount = startBand; bandCount < endBand; ++bandCount)
+      {
+         FactoryResource<DataRequest> pRequest;
+         pRequest->setInterleaveFormat(BSQ);
+         pRequest->setRows(rows.front(), rows.back());
+         pRequest->setBands(bands[bandCount], bands[bandCount]);
+         DataAccessor da = pCube->getDataAccessor(pRequest.release());
+         ICEVERIFY(da.isValid());
+         accessors.push_back(da);
+      }
 
       for (unsigned int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
       {
@@ -1027,44 +994,40 @@ void IceWriter::writeBsqCubeData(const string& hdfPath,
          }
 
          char* pBuffer = pWriteBuffer;
-         for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
+         for (vector<DataAccessor>::iterator da = accessors.begin(); da != accessors.end(); ++da)
          {
-            if (pProgress != NULL)
+            for (unsigned int rowCount = startChunkRow; rowCount < endChunkRow; ++rowCount)
             {
-               pProgress->updateProgress("Exporting cube...",
-                  (rowIndex++ * 100) / (bands.size() * rows.size()), NORMAL);
-            }
+               if (pProgress != NULL)
+               {
+                  pProgress->updateProgress("Exporting cube...",
+                     (rowIndex++ * 100) / (bands.size() * rows.size()), NORMAL);
+               }
 
-            unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
-            for (unsigned int colCount = 0; colCount < cols.size(); ++colCount)
-            {
-               unsigned int colActiveNum = cols[colCount].getActiveNumber();
-               da->toPixel(rowActiveNum, colActiveNum);
-               ICEVERIFY(da.isValid());
+               unsigned int rowActiveNum = rows[rowCount].getActiveNumber();
+               (*da)->toPixel(rowActiveNum, 0);
+               ICEVERIFY(da->isValid());
+               if (bEntireRow)
+               {
+                  memcpy(pBuffer, (*da)->getRow(), rowSize);
+               }
+               else
+               {
+                  InterleaveTranspose::gather((*da)->getRow(), &offsets[0], offsets.size(), pBuffer, bpe);
+               }
+               pBuffer += rowSize;
 
-               memcpy(pBuffer, da->getColumn(), bpe);
-               pBuffer += bpe;
+               abortIfNecessary();
             }
-
-            abortIfNecessary();
          }
 
          offset[1] = startChunkRow;
          counts[1] = endChunkRow - startChunkRow;
-
-         hid_t memorySpace = *mspaceId;
-         if (chunkNumber + 1 == numChunks)
-         {
-            memorySpace = *lastChunkWriteId;
-         }
-
-         herr_t status = H5Sselect_hyperslab(*dSpaceId, H5S_SELECT_SET, offset, NULL, counts, NULL);
-         ICEVERIFY(status >= 0);
-
-         status = H5Dwrite(*dataId, *hdfEncoding, memorySpace, *dSpaceId, H5P_DEFAULT, pWriteBuffer);
-         ICEVERIFY(status >= 0);
+         ICEVERIFY(chunkWriter.writeSlab(offset, counts, pWriteBuffer));
       }
    }
+
+   ICEVERIFY(chunkWriter.flush());
 }
 
 void IceWriter::createDatasetForCube(hsize_t dimSpace[3],
@@ -1309,6 +1272,11 @@ void IceWriter::setGzipCompressionLevel(int level)
    mGzipCompressionLevel = level;
 }
 
+void IceWriter::setChunkShape(IceChunkShape shape)
+{
+   mChunkShape = shape;
+}
+
 int IceWriter::getChunkSize() const
 {
    return mChunkSize;
@@ -1324,6 +1292,32 @@ int IceWriter::getGzipCompressionLevel() const
    return mGzipCompressionLevel;
 }
 
+IceChunkShape IceWriter::getChunkShape() const
+{
+   return mChunkShape;
+}
+
+unsigned int IceWriter::getRowsInChunk(unsigned int rowSize, unsigned int rowCount) const
+{
+   unsigned int rowsInChunk = mChunkSize / rowSize; // determine number of rows that fit into a chunk
+   if (rowsInChunk > rowCount)
+   {
+      rowsInChunk = rowCount;
+   }
+   if (rowsInChunk == 0)
+   {
+      rowsInChunk = 1;
+   }
+   return rowsInChunk;
+}
+
+hsize_t IceWriter::getTileSize(size_t pixelSize) const
+{
+   // the largest multiple of 16 pixels on a side which keeps a tile within the chunk size
+   hsize_t tileSize = static_cast<hsize_t>(sqrt(static_cast<double>(mChunkSize) / pixelSize));
+   return max<hsize_t>(tileSize / 16 * 16, 16);
+}
+
 void IceWriter::abortIfNecessary()
 {
    if (mAborted)
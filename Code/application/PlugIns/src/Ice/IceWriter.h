@@ -37,12 +37,32 @@ enum IceCompressionTypeEnum
 
 typedef EnumWrapper<IceCompressionTypeEnum> IceCompressionType;
 
+/**
+ * The shape of the chunks in which the cube data is stored.
+ *
+ * Rows stores strips of whole rows, which suits reading the cube a row or a
+ * band at a time.  Tiles stores square blocks of pixels, which suits
+ * displaying or processing small areas of a large cube; for BSQ data each
+ * tile holds a single band.  Spectral tiles store every band of a square
+ * block of pixels, which suits reading the spectra of a few pixels, and are
+ * the same as tiles for BIL and BIP data.
+ */
+enum IceChunkShapeEnum
+{
+   ROW_CHUNKS,
+   TILE_CHUNKS,
+   SPECTRAL_CHUNKS
+};
+
+typedef EnumWrapper<IceChunkShapeEnum> IceChunkShape;
+
 class IceWriter
 {
 public:
    SETTING(CompressionType, IceWriter, std::string, std::string());
    SETTING(GzipCompressionLevel, IceWriter, int, 0);
    SETTING(ChunkSize, IceWriter, int, 0);
+   SETTING(ChunkShape, IceWriter, std::string, std::string());
 
    IceWriter(hid_t fileHandle, IceUtilities::FileType fileType);
    void writeFileHeader();
@@ -58,10 +78,12 @@ public:
    void setChunkSize(int chunkSize);
    void setCompressionType(IceCompressionType type);
    void setGzipCompressionLevel(int level);
+   void setChunkShape(IceChunkShape shape);
 
    int getChunkSize() const;
    IceCompressionType getCompressionType() const;
    int getGzipCompressionLevel() const;
+   IceChunkShape getChunkShape() const;
 
 private:
    void writeBilCubeData(const std::string& hdfPath,
@@ -98,6 +120,8 @@ private:
    void writeLayerProperties(const std::string& hdfPath, const std::string& name, LayerType type, double xScaleFactor,
       double yScaleFactor, double xOffset, double yOffset, Progress* pProgress);
 
+   unsigned int getRowsInChunk(unsigned int rowSize, unsigned int rowCount) const;
+   hsize_t getTileSize(size_t pixelSize) const;
    void abortIfNecessary();
 
    hid_t mFileHandle;
@@ -106,6 +130,7 @@ private:
    int mChunkSize;
    IceCompressionType mCompressionType;
    int mGzipCompressionLevel;
+   IceChunkShape mChunkShape;
 };
 
 namespace StringUtilities
@@ -118,6 +143,14 @@ namespace StringUtilities
    IceCompressionType fromDisplayString<IceCompressionType>(std::string valueText, bool* pError);
    template<>
    IceCompressionType fromXmlString<IceCompressionType>(std::string valueText, bool* pError);
+   template<>
+   std::string toDisplayString(const IceChunkShape& value, bool* pError);
+   template<>
+   std::string toXmlString(const IceChunkShape& value, bool* pError);
+   template<>
+   IceChunkShape fromDisplayString<IceChunkShape>(std::string valueText, bool* pError);
+   template<>
+   IceChunkShape fromXmlString<IceChunkShape>(std::string valueText, bool* pError);
 }
 
 #endif
@@ -60,6 +60,15 @@ OptionsIceExporter::OptionsIceExporter() :
    mpChunkSize->setSuffix(" MB");
    mpChunkSize->setAccelerated(true);
 
+   QLabel* pChunkShapeLabel = new QLabel("Chunk shape:", pChunkSizeLayoutWidget);
+   mpChunkShapeCombo = new QComboBox(pChunkSizeLayoutWidget);
+   std::vector<std::string> shapeValues = StringUtilities::getAllEnumValuesAsDisplayString<IceChunkShape>();
+   for (std::vector<std::string>::iterator shapeValue = shapeValues.begin(); shapeValue != shapeValues.end();
+      ++shapeValue)
+   {
+      mpChunkShapeCombo->addItem(QString::fromStdString(*shapeValue));
+   }
+
    // Layout 
    QGridLayout* pCompressionLayout = new QGridLayout(pCompressionLayoutWidget);
    pCompressionLayout->setMargin(0);
@@ -71,9 +80,14 @@ OptionsIceExporter::OptionsIceExporter() :
    pCompressionLayout->addWidget(mpGzipLevelValue, 1, 3);
    pCompressionLayout->setColumnStretch(2, 10);
 
-   QHBoxLayout* pChunkSizeLayout = new QHBoxLayout(pChunkSizeLayoutWidget);
-   pChunkSizeLayout->addWidget(pChunkSizeLabel);
-   pChunkSizeLayout->addWidget(mpChunkSize);
+   QGridLayout* pChunkSizeLayout = new QGridLayout(pChunkSizeLayoutWidget);
+   pChunkSizeLayout->setMargin(0);
+   pChunkSizeLayout->setSpacing(5);
+   pChunkSizeLayout->addWidget(pChunkSizeLabel, 0, 0);
+   pChunkSizeLayout->addWidget(mpChunkSize, 0, 1);
+   pChunkSizeLayout->addWidget(pChunkShapeLabel, 1, 0);
+   pChunkSizeLayout->addWidget(mpChunkShapeCombo, 1, 1);
+   pChunkSizeLayout->setColumnStretch(2, 10);
 
    LabeledSection* pCompressionSection = new LabeledSection(pCompressionLayoutWidget, "Compression Options", this);
    LabeledSection* pChunkSizeSection = new LabeledSection(pChunkSizeLayoutWidget, "Chunk Size Options", this);
@@ -104,6 +118,12 @@ OptionsIceExporter::OptionsIceExporter() :
    {
       mpChunkSize->setValue(csize);
    }
+   IceChunkShape cshape(StringUtilities::fromXmlString<IceChunkShape>(IceWriter::getSettingChunkShape()));
+   if (cshape.isValid())
+   {
+      mpChunkShapeCombo->setCurrentIndex(mpChunkShapeCombo->findText(QString::fromStdString(
+         StringUtilities::toDisplayString(cshape))));
+   }
 
    compressionTypeChanged(mpCompressionTypeCombo->currentText());
 }
@@ -115,6 +135,7 @@ void OptionsIceExporter::applyChanges()
       IceWriter::setSettingCompressionType(StringUtilities::toXmlString(getCompressionType()));
       IceWriter::setSettingGzipCompressionLevel(getGzipCompressionLevel());
       IceWriter::setSettingChunkSize(getChunkSize());
+      IceWriter::setSettingChunkShape(StringUtilities::toXmlString(getChunkShape()));
    }
 }
 
@@ -142,6 +163,11 @@ int OptionsIceExporter::getChunkSize()
    return mpChunkSize->value();
 }
 
+IceChunkShape OptionsIceExporter::getChunkShape()
+{
+   return StringUtilities::fromDisplayString<IceChunkShape>(mpChunkShapeCombo->currentText().toStdString());
+}
+
 void OptionsIceExporter::compressionTypeChanged(const QString& value)
 {
    IceCompressionType type(StringUtilities::fromDisplayString<IceCompressionType>(value.toStdString()));
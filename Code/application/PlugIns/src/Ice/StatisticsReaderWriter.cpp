@@ -170,6 +170,140 @@ bool StatisticsValuesReaderWriter::isValid() const
    return mpValue != NULL;
 }
 
+StatisticsSketchReaderWriter::StatisticsSketchReaderWriter() :
+   mpValue(NULL),
+   mDataType(-1)
+{
+}
+
+StatisticsSketchReaderWriter::StatisticsSketchReaderWriter(hid_t dataType) :
+   mpValue(NULL),
+   mDataType(dataType)
+{
+   //if data cannot be read, return from constructor before mpValue is set to non-NULL.
+   //so that isValid() will return false.
+   H5T_class_t type = H5Tget_class(dataType);
+   if (type != H5T_COMPOUND)
+   {
+      return;
+   }
+   static vector<string> sExpectedMembers;
+   if (sExpectedMembers.empty())
+   {
+      sExpectedMembers.push_back("onDiskNumber");
+      sExpectedMembers.push_back("min");
+      sExpectedMembers.push_back("max");
+      sExpectedMembers.push_back("values");
+      sExpectedMembers.push_back("levelCounts");
+      sort(sExpectedMembers.begin(), sExpectedMembers.end());
+   }
+   int memberCount = H5Tget_nmembers(dataType);
+   if (memberCount != static_cast<int>(sExpectedMembers.size()))
+   {
+      return;
+   }
+   vector<string> memberNames;
+   for (int i = 0; i < memberCount; ++i)
+   {
+      char* pMemberName = H5Tget_member_name(dataType, i);
+      if (pMemberName != NULL)
+      {
+         memberNames.push_back(string(pMemberName));
+      }
+#if !defined(DEBUG)
+      //In release mode, free the char* that H5Tget_member_name() creates using malloc().
+      //See StatisticsValuesReaderWriter for details.
+      free(pMemberName); 
+#endif
+   }
+   sort(memberNames.begin(), memberNames.end());
+   if (!equal(sExpectedMembers.begin(), sExpectedMembers.end(), memberNames.begin()))
+   {
+      return;
+   }
+
+   mpValue = new StatisticsSketch();
+}
+
+unsigned int StatisticsSketchReaderWriter::getSupportedDimensionality() const
+{
+   return 0;
+}
+
+StatisticsSketchReaderWriter::~StatisticsSketchReaderWriter()
+{
+}
+
+Hdf5TypeResource StatisticsSketchReaderWriter::getReadMemoryType() const
+{
+   Hdf5TypeResource memCompoundType(H5Tcreate(H5T_COMPOUND, sizeof(StatisticsSketch)));
+   Hdf5TypeResource uintType(HdfUtilities::getHdf5Type<unsigned int>());
+   Hdf5TypeResource doubleType(HdfUtilities::getHdf5Type<double>());
+   H5Tinsert(*memCompoundType, "onDiskNumber", HOFFSET(StatisticsSketch, mOnDiskBandNumber), *uintType);
+   H5Tinsert(*memCompoundType, "min", HOFFSET(StatisticsSketch, mMin), *doubleType);
+   H5Tinsert(*memCompoundType, "max", HOFFSET(StatisticsSketch, mMax), *doubleType);
+   Hdf5TypeResource valueType(HdfUtilities::getHdf5Type<StatisticsSketch::ValueType>());
+   Hdf5TypeResource variableValueType(H5Tvlen_create(*valueType));
+   H5Tinsert(*memCompoundType, "values", HOFFSET(StatisticsSketch, mpValues), *variableValueType);
+   Hdf5TypeResource levelCountType(HdfUtilities::getHdf5Type<StatisticsSketch::LevelCountType>());
+   Hdf5TypeResource variableLevelCountType(H5Tvlen_create(*levelCountType));
+   H5Tinsert(*memCompoundType, "levelCounts", HOFFSET(StatisticsSketch, mpLevelCounts), *variableLevelCountType);
+   return memCompoundType;
+}
+
+bool StatisticsSketchReaderWriter::setDataToWrite(void* pObject)
+{
+   if (pObject == NULL)
+   {
+      return false;
+   }
+
+   mpValue = reinterpret_cast<StatisticsSketch*>(pObject);
+   return true;
+}
+
+Hdf5TypeResource StatisticsSketchReaderWriter::getWriteMemoryType() const
+{
+   return getReadMemoryType();
+}
+
+Hdf5TypeResource StatisticsSketchReaderWriter::getWriteFileType() const
+{
+   Hdf5TypeResource type(getWriteMemoryType());
+   H5Tpack(*type);
+   return type;
+}
+
+Hdf5DataSpaceResource StatisticsSketchReaderWriter::createDataSpace() const
+{
+   return Hdf5DataSpaceResource(H5Screate(H5S_SCALAR));
+}
+
+bool StatisticsSketchReaderWriter::setReadDataSpace(const vector<hsize_t>& dataSpace)
+{
+   return dataSpace.empty();
+}
+
+void* StatisticsSketchReaderWriter::getReadBuffer() const
+{
+   return mpValue;
+}
+
+const void* StatisticsSketchReaderWriter::getWriteBuffer() const
+{
+   return mpValue;
+}
+
+void* StatisticsSketchReaderWriter::getValue() const
+{
+   return mpValue;
+}
+
+bool StatisticsSketchReaderWriter::isValid() const
+{
+   return mpValue != NULL;
+}
+
 StatisticsMetadataFloatReaderWriter::StatisticsMetadataFloatReaderWriter() :
    mpValue(NULL),
    mDataType(-1)
@@ -440,6 +574,18 @@ Hdf5CustomReader* createHdf5CustomReader<StatisticsValues>(hid_t dataType)
    return new StatisticsValuesReaderWriter(dataType);
 }
 
+template<>
+Hdf5CustomWriter* createHdf5CustomWriter<StatisticsSketch>()
+{
+   return new StatisticsSketchReaderWriter();
+}
+
+template<>
+Hdf5CustomReader* createHdf5CustomReader<StatisticsSketch>(hid_t dataType)
+{
+   return new StatisticsSketchReaderWriter(dataType);
+}
+
 template<>
 Hdf5CustomWriter* createHdf5CustomWriter<StatisticsMetadata>()
 {
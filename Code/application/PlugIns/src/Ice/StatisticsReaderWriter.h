@@ -64,6 +64,25 @@ public:
    typedef unsigned int HistogramType;
 };
 
+class StatisticsSketch
+{
+public:
+   StatisticsSketch() :
+      mOnDiskBandNumber(0),
+      mMin(0.0),
+      mMax(0.0)
+   {
+   }
+
+   unsigned int mOnDiskBandNumber;
+   double mMin;
+   double mMax;
+   hvl_t mpValues;
+   typedef double ValueType;
+   hvl_t mpLevelCounts;
+   typedef unsigned int LevelCountType;
+};
+
 class StatisticsValuesReaderWriter : public Hdf5CustomReader, public Hdf5CustomWriter
 {
 public:
@@ -88,6 +107,30 @@ private:
    hid_t mDataType;
 };
 
+class StatisticsSketchReaderWriter : public Hdf5CustomReader, public Hdf5CustomWriter
+{
+public:
+   StatisticsSketchReaderWriter();
+   StatisticsSketchReaderWriter(hid_t dataType);
+   ~StatisticsSketchReaderWriter();
+
+   unsigned int getSupportedDimensionality() const;
+   Hdf5TypeResource getReadMemoryType() const;
+   bool setDataToWrite(void* pObject);
+   Hdf5TypeResource getWriteMemoryType() const;
+   Hdf5TypeResource getWriteFileType() const;
+   Hdf5DataSpaceResource createDataSpace() const;
+   bool setReadDataSpace(const std::vector<hsize_t>& dataSpace);
+   void* getReadBuffer() const;
+   const void* getWriteBuffer() const;
+   void* getValue() const;
+   bool isValid() const;
+
+private:
+   mutable StatisticsSketch* mpValue; //not owned by class
+   hid_t mDataType;
+};
+
 class StatisticsMetadataFloatReaderWriter : public Hdf5CustomReader, public Hdf5CustomWriter
 {
 public:
@@ -17,14 +17,17 @@
 #include "DynamicObject.h"
 #include "ImportDescriptor.h"
 #include "LasImporter.h"
+#include "LasPager.h"
 #include "ObjectResource.h"
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
 #include "PlugInRegistration.h"
+#include "PlugInResource.h"
 #include "PointCloudAccessor.h"
 #include "PointCloudAccessorImpl.h"
 #include "PointCloudDataDescriptor.h"
 #include "PointCloudFileDescriptor.h"
+#include "PointDataBlock.h"
 #include "PointCloudView.h"
 #include "PointCloudWindow.h"
 #include "ProgressTracker.h"
@@ -38,13 +41,31 @@
 #include <liblas/liblas.hpp>
 #include <liblas/iterator.hpp>
 
+#include <algorithm>
 #include <boost/atomic.hpp>
 #include <math.h>
+#include <string.h>
 #include <QtCore/QString>
 #include <QtGui/QComboBox>
 
 REGISTER_PLUGIN_BASIC(Las, LasImporter);
 
+namespace
+{
+   // The number of points decoded by the pager at a time when the points are copied into the element
+   const uint32_t COPY_BLOCK_POINTS = 1024 * 1024;
+
+   // Returns the number of records for each point which is kept when a point cloud is thinned to maxPoints
+   unsigned int getThinningStride(unsigned int maxPoints, unsigned int recordCount)
+   {
+      if (maxPoints == 0 || maxPoints >= recordCount)
+      {
+         return 1;
+      }
+      return static_cast<unsigned int>(std::ceil(static_cast<double>(recordCount) / maxPoints));
+   }
+}
+
 LasImporter::LasImporter() : mpCustomOptions(NULL), mPolishEntered(false)
 {
    setName("LAS Importer");
@@ -138,6 +159,7 @@ std::vector<ImportDescriptor*> LasImporter::getImportDescriptors(const std::stri
       pMetadataZ->setAttributeByPath("LAS/Creation Year", header.GetCreationYear());
       pMetadataZ->setAttributeByPath("LAS/Point Format", header.GetDataFormatId() == liblas::ePointFormat0 ? 0 : 1);
       pMetadataZ->setAttributeByPath("LAS/Point Count", header.GetPointRecordsCount());
+      pMetadataZ->setAttributeByPath("LAS/Compressed", header.Compressed());
       pMetadataZ->setAttributeByPath("LAS/Points Per Return", pointsByReturn);
       pMetadataZ->setAttributeByPath("LAS/Scale/X", header.GetScaleX());
       pMetadataZ->setAttributeByPath("LAS/Scale/Y", header.GetScaleY());
@@ -240,18 +262,9 @@ bool LasImporter::execute( PlugInArgList* pInArgList, PlugInArgList* pOutArgList
    }
    PointCloudDataDescriptor* pDesc = dynamic_cast<PointCloudDataDescriptor*>( pData->getDataDescriptor() );
    VERIFY( pDesc );
-   if ( pDesc->getProcessingLocation() == ON_DISK_READ_ONLY )
-   {
-      progress.report( "On-disk read only not supported.", 0, ERRORS, true );
-      return false;
-   }
-   if (!pData->createDefaultPager())
-   {
-      progress.report( "Unable to allocate space for point cloud", 0, ERRORS, true );
-      return false;
-   }
+   std::string filename = pDesc->getFileDescriptor()->getFilename().getFullPathAndName();
    std::ifstream ifs;
-   if (!liblas::Open(ifs, pDesc->getFileDescriptor()->getFilename().getFullPathAndName().c_str()))
+   if (!liblas::Open(ifs, filename.c_str()))
    {
       return false;
    }
@@ -261,28 +274,72 @@ bool LasImporter::execute( PlugInArgList* pInArgList, PlugInArgList* pOutArgList
 
    int thinningOption(0);
    pDesc->getMetadata()->getAttributeByPath( "LAS/Thinning Options/Algorithm" ).getValue( thinningOption );
-   switch ( thinningOption ) {
-       case THIN_NONE:
-           if (maxPointsThinning(header.GetPointRecordsCount(), pDesc, 
-                     reader, header, pData, progress, &mAborted) < 0)
-           {
-              return false;
-           }
-           break;
-       case THIN_MAX_POINTS:
-           int maxPoints;
-           pDesc->getMetadata()->getAttributeByPath("LAS/Thinning Options/Max Points").getValue(maxPoints);
-           int totPoints;
-           if ((totPoints = maxPointsThinning( maxPoints, pDesc, reader, header, pData, progress, &mAborted)) < 0)
-           {
-              return false;
-           }
-           pDesc->setPointCount(totPoints);
-           break;
-       default:
-           break;
-   }      
-   
+   unsigned int maxPoints = header.GetPointRecordsCount();
+   if (thinningOption == THIN_MAX_POINTS)
+   {
+      int maxPointsOption = 0;
+      pDesc->getMetadata()->getAttributeByPath("LAS/Thinning Options/Max Points").getValue(maxPointsOption);
+      maxPoints = static_cast<unsigned int>(std::max(maxPointsOption, 0));
+   }
+
+   int totPoints = -1;
+   if (header.Compressed())
+   {
+      // Compressed points can only be read one at a time through liblas
+      if ( pDesc->getProcessingLocation() == ON_DISK_READ_ONLY )
+      {
+         progress.report( "On-disk read only is not supported for compressed LAS files.", 0, ERRORS, true );
+         return false;
+      }
+      if (!pData->createDefaultPager())
+      {
+         progress.report( "Unable to allocate space for point cloud", 0, ERRORS, true );
+         return false;
+      }
+      totPoints = maxPointsThinning(maxPoints, pDesc, reader, header, pData, progress, &mAborted);
+   }
+   else
+   {
+      ExecutableResource pPagerPlugIn("LAS Pager");
+      LasPager* pPager = dynamic_cast<LasPager*>(pPagerPlugIn->getPlugIn());
+      if (pPager == NULL || !pPager->initialize(filename, header.GetDataOffset(), header.GetDataRecordLength(),
+         static_cast<unsigned int>(header.GetDataFormatId()), header.GetPointRecordsCount(),
+         getThinningStride(maxPoints, header.GetPointRecordsCount()), pDesc))
+      {
+         progress.report( "Unable to map the LAS point records.", 0, ERRORS, true );
+         return false;
+      }
+
+      if ( pDesc->getProcessingLocation() == ON_DISK_READ_ONLY )
+      {
+         // The element reads the points directly from the file
+         if (!pData->setPager(pPager))
+         {
+            progress.report( "Unable to set the pager of the point cloud", 0, ERRORS, true );
+            return false;
+         }
+         pPagerPlugIn->releasePlugIn();
+         totPoints = static_cast<int>(pPager->getPointCount());
+      }
+      else
+      {
+         if (!pData->createDefaultPager())
+         {
+            progress.report( "Unable to allocate space for point cloud", 0, ERRORS, true );
+            return false;
+         }
+         totPoints = copyPoints(*pPager, pDesc, pData, progress, &mAborted);
+      }
+   }
+   if (totPoints < 0)
+   {
+      return false;
+   }
+   if (thinningOption == THIN_MAX_POINTS)
+   {
+      pDesc->setPointCount(totPoints);
+   }
+
 
    // Create the view
    if (!isBatch())
@@ -313,7 +370,7 @@ bool LasImporter::execute( PlugInArgList* pInArgList, PlugInArgList* pOutArgList
 
 bool LasImporter::isProcessingLocationSupported(ProcessingLocation location) const 
 {
-    return !(location == ON_DISK_READ_ONLY);
+    return true;
 }
 
 QWidget* LasImporter::getImportOptionsWidget(DataDescriptor* pDescriptor)
@@ -356,6 +413,16 @@ bool LasImporter::validate(const DataDescriptor* pDescriptor,
          return false;
       }
    }
+   if (pDesc->getProcessingLocation() == ON_DISK_READ_ONLY)
+   {
+      bool compressed = false;
+      const DynamicObject* pMetadata = pDesc->getMetadata();
+      if (pMetadata != NULL && pMetadata->getAttributeByPath("LAS/Compressed").getValue(compressed) && compressed)
+      {
+         errorMessage = "Compressed LAS files cannot be processed on-disk read only.";
+         return false;
+      }
+   }
    if (pDesc->getXScale() == 0. || pDesc->getYScale() == 0. || pDesc->getZScale() == 0.)
    {
       errorMessage = "Invalid scale factor (0.0).";
@@ -380,15 +447,7 @@ int LasImporter::maxPointsThinning(const unsigned int maxPoints,
 {
    bool intensity = pDesc->getFileDescriptor()->getDatasetLocation() == "intensity";
    VERIFY(pDesc->getSpatialDataType() == INT4SBYTES && pDesc->getIntensityDataType() == INT2UBYTES && pDesc->getClassificationDataType() == INT1UBYTE);
-   unsigned int nthPoint;
-   if (maxPoints >= header.GetPointRecordsCount())
-   {
-      nthPoint = 1;
-   }
-   else
-   {
-      nthPoint = static_cast<unsigned int>(std::ceil(static_cast<double>(header.GetPointRecordsCount()) / maxPoints));
-   }
+   unsigned int nthPoint = getThinningStride(maxPoints, header.GetPointRecordsCount());
 
    unsigned int cur = 0;
    unsigned int total = header.GetPointRecordsCount();
@@ -432,6 +491,59 @@ int LasImporter::maxPointsThinning(const unsigned int maxPoints,
    return totPoints;
 }
 
+int LasImporter::copyPoints(LasPager& pager,
+                            const PointCloudDataDescriptor* pDesc,
+                            PointCloudElement* pElement,
+                            ProgressTracker& progress,
+                            bool* pAborted)
+{
+   size_t pointSize = pDesc->getPointSizeInBytes();
+   FactoryResource<PointCloudDataRequest> pReq;
+   pReq->setWritable(true);
+   PointCloudAccessor accessor(pElement->getPointCloudAccessor(pReq.release()));
+   if (!accessor.isValid())
+   {
+      progress.report("Unable to access the point cloud.", 0, ERRORS, true);
+      return -1;
+   }
+
+   // The pager decodes each block on several threads, and the decoded points are already in the element's layout
+   uint32_t total = pager.getPointCount();
+   uint32_t cur = 0;
+   while (cur < total)
+   {
+      if (pAborted != NULL && *pAborted)
+      {
+         progress.report("Import canceled", 0, ABORT);
+         return -1;
+      }
+      progress.report("Loading LAS data...", std::min(static_cast<int>(static_cast<uint64_t>(cur) * 100 / total), 99),
+         NORMAL);
+
+      PointDataBlock* pBlock = pager.getPointBlock(cur, std::min(total - cur, COPY_BLOCK_POINTS), NULL);
+      if (pBlock == NULL)
+      {
+         progress.report("Unable to read the LAS point records.", 0, ERRORS, true);
+         return -1;
+      }
+      const char* pPoints = reinterpret_cast<const char*>(pBlock->getRawData());
+      uint32_t count = pBlock->getNumPoints();
+      for (uint32_t point = 0; point < count && accessor.isValid(); ++point)
+      {
+         memcpy(accessor->getRawX(), pPoints + point * pointSize, pointSize);
+         accessor->nextPoint();
+      }
+      pager.releasePointBlock(pBlock);
+      cur += count;
+      if (count == 0 || (cur < total && !accessor.isValid()))
+      {
+         progress.report("Unable to access the point cloud.", 0, ERRORS, true);
+         return -1;
+      }
+   }
+   return static_cast<int>(total);
+}
+
 PointCloudDataDescriptor* LasImporter::generatePointCloudDataDescriptor(const std::string& name, DataElement* pParent,
                                                                         InterleaveFormatType interleave,
                                                                         EncodingType encoding,
@@ -20,6 +20,7 @@ namespace liblas
    class Reader;
 }
 
+class LasPager;
 class PointCloudDataDescriptor;
 class PointCloudElement;
 class ProgressTracker;
@@ -56,6 +57,11 @@ protected:
                          PointCloudElement* pElement,
                          ProgressTracker& progress,
                          bool* pAborted);
+   int copyPoints(LasPager& pager,
+                  const PointCloudDataDescriptor* pDesc,
+                  PointCloudElement* pElement,
+                  ProgressTracker& progress,
+                  bool* pAborted);
    PointCloudDataDescriptor* generatePointCloudDataDescriptor(const std::string& name, DataElement* pParent,
                                                               InterleaveFormatType interleave, EncodingType encoding,
                                                               EncodingType intensityEncoding, EncodingType classEncoding,
@@ -0,0 +1,422 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2014 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "AppVersion.h"
+#include "Endian.h"
+#include "LasPager.h"
+#include "MultiThreadedAlgorithm.h"
+#include "PlugInRegistration.h"
+#include "PointCloudDataDescriptor.h"
+#include "PointCloudDataRequest.h"
+#include "PointCloudElement.h"
+#include "PointDataBlock.h"
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+#include <vector>
+
+#if defined(WIN_API)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+REGISTER_PLUGIN_BASIC(Las, LasPager);
+
+using namespace std;
+
+namespace
+{
+   // The largest range of the file which is mapped for a single block, which limits the number of
+   // points in a block when the point cloud is thinned
+   const uint64_t MAXIMUM_MAPPING_SIZE = 256 * 1024 * 1024;
+
+   class LasDataBlock : public PointDataBlock
+   {
+   public:
+      LasDataBlock(size_t pointSize, uint32_t pointCount) :
+         mData(pointSize * pointCount),
+         mPointCount(pointCount)
+      {
+      }
+
+      virtual void* getRawData()
+      {
+         return mData.empty() ? NULL : &mData[0];
+      }
+
+      virtual uint32_t getNumPoints()
+      {
+         return mPointCount;
+      }
+
+   private:
+      vector<char> mData;
+      uint32_t mPointCount;
+   };
+
+   struct DecodeInput
+   {
+      const LasPager* mpPager;
+      const unsigned char* mpRecords;
+      uint32_t mFirstPoint;
+      uint32_t mPointCount;
+      char* mpPoints;
+   };
+
+   class DecodeThread : public mta::AlgorithmThread
+   {
+   public:
+      DecodeThread(const DecodeInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mPointRange(getThreadRange(threadCount, static_cast<int>(input.mPointCount)))
+      {
+      }
+
+      void run()
+      {
+         if (mPointRange.mFirst <= mPointRange.mLast)
+         {
+            mInput.mpPager->decodePoints(mInput.mpRecords, mInput.mFirstPoint, mPointRange.mFirst,
+               mPointRange.mLast + 1, mInput.mpPoints);
+         }
+      }
+
+   private:
+      DecodeThread& operator=(const DecodeThread& rhs);
+
+      const DecodeInput& mInput;
+      mta::AlgorithmThread::Range mPointRange;
+   };
+
+   struct DecodeOutput
+   {
+      bool compileOverallResults(const vector<DecodeThread*>& threads)
+      {
+         return true;
+      }
+   };
+}
+
+class LasPager::FileMapping
+{
+public:
+   FileMapping() :
+#if defined(WIN_API)
+      mFile(INVALID_HANDLE_VALUE),
+      mMapping(NULL),
+#else
+      mFile(-1),
+#endif
+      mGranularity(0),
+      mFileSize(0)
+   {
+   }
+
+   ~FileMapping()
+   {
+#if defined(WIN_API)
+      if (mMapping != NULL)
+      {
+         CloseHandle(mMapping);
+      }
+      if (mFile != INVALID_HANDLE_VALUE)
+      {
+         CloseHandle(mFile);
+      }
+#else
+      if (mFile != -1)
+      {
+         close(mFile);
+      }
+#endif
+   }
+
+   bool open(const string& filename)
+   {
+#if defined(WIN_API)
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      mGranularity = info.dwAllocationGranularity;
+
+      mFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+      if (mFile == INVALID_HANDLE_VALUE)
+      {
+         return false;
+      }
+
+      LARGE_INTEGER fileSize;
+      if (GetFileSizeEx(mFile, &fileSize) == FALSE)
+      {
+         return false;
+      }
+      mFileSize = static_cast<uint64_t>(fileSize.QuadPart);
+
+      mMapping = CreateFileMapping(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+      return mMapping != NULL;
+#else
+      mGranularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+      mFile = ::open(filename.c_str(), O_RDONLY);
+      if (mFile == -1)
+      {
+         return false;
+      }
+
+      struct stat fileStats;
+      if (fstat(mFile, &fileStats) != 0)
+      {
+         return false;
+      }
+      mFileSize = static_cast<uint64_t>(fileStats.st_size);
+      return true;
+#endif
+   }
+
+   uint64_t getFileSize() const
+   {
+      return mFileSize;
+   }
+
+   // Maps a range of the file.  The returned pointer addresses the first byte of the range, and
+   // pBase and baseSize must be passed to unmap() when the range is no longer needed.
+   const unsigned char* map(uint64_t offset, uint64_t size, void*& pBase, size_t& baseSize) const
+   {
+      pBase = NULL;
+      baseSize = 0;
+      uint64_t alignedOffset = offset - offset % mGranularity;
+      uint64_t alignedSize = size + (offset - alignedOffset);
+      if (size == 0 || offset + size > mFileSize || alignedSize > numeric_limits<size_t>::max())
+      {
+         return NULL;
+      }
+
+#if defined(WIN_API)
+      pBase = MapViewOfFile(mMapping, FILE_MAP_READ, static_cast<DWORD>(alignedOffset >> 32),
+         static_cast<DWORD>(alignedOffset & 0xFFFFFFFF), static_cast<SIZE_T>(alignedSize));
+      if (pBase == NULL)
+      {
+         return NULL;
+      }
+#else
+      pBase = mmap(NULL, static_cast<size_t>(alignedSize), PROT_READ, MAP_SHARED, mFile,
+         static_cast<off_t>(alignedOffset));
+      if (pBase == MAP_FAILED)
+      {
+         pBase = NULL;
+         return NULL;
+      }
+
+      // The records are read once from front to back
+      madvise(pBase, static_cast<size_t>(alignedSize), MADV_SEQUENTIAL);
+#endif
+
+      baseSize = static_cast<size_t>(alignedSize);
+      return reinterpret_cast<const unsigned char*>(pBase) + (offset - alignedOffset);
+   }
+
+   void unmap(void* pBase, size_t baseSize) const
+   {
+      if (pBase == NULL)
+      {
+         return;
+      }
+
+#if defined(WIN_API)
+      UnmapViewOfFile(pBase);
+#else
+      munmap(pBase, baseSize);
+#endif
+   }
+
+private:
+#if defined(WIN_API)
+   HANDLE mFile;
+   HANDLE mMapping;
+#else
+   int mFile;
+#endif
+   uint64_t mGranularity;
+   uint64_t mFileSize;
+};
+
+LasPager::LasPager() :
+   mpMapping(NULL),
+   mDataOffset(0),
+   mRecordLength(0),
+   mStride(1),
+   mPointCount(0),
+   mClassificationOffset(15),
+   mClassificationMask(0x1F),
+   mPointSize(0),
+   mIdOffset(0),
+   mValidOffset(0),
+   mIntensityOffset(0),
+   mClassOffset(0)
+{
+   setName("LAS Pager");
+   setCopyright(APP_COPYRIGHT);
+   setCreator("Ball Aerospace & Technologies Corp.");
+   setDescription("Provides read-only access to the points of an uncompressed LAS file");
+   setDescriptorId("{4F0B6C0E-6A3B-4E0D-9E83-2C1F7C5D8A41}");
+   setVersion(APP_VERSION_NUMBER);
+   setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setShortDescription("Memory maps LAS point records");
+}
+
+LasPager::~LasPager()
+{
+   delete mpMapping;
+}
+
+bool LasPager::initialize(const string& filename, uint64_t dataOffset, unsigned int recordLength,
+                          unsigned int pointFormat, uint32_t recordCount, uint32_t stride,
+                          const PointCloudDataDescriptor* pDescriptor)
+{
+   VERIFY(pDescriptor != NULL && mpMapping == NULL);
+   VERIFY(pDescriptor->getSpatialDataType() == INT4SBYTES && pDescriptor->getIntensityDataType() == INT2UBYTES &&
+      pDescriptor->getClassificationDataType() == INT1UBYTE &&
+      pDescriptor->hasIntensityData() && pDescriptor->hasClassificationData());
+
+   // Point data formats 6 and later store the classification as a full byte after an extra flags byte
+   mClassificationOffset = (pointFormat >= 6 ? 16 : 15);
+   mClassificationMask = (pointFormat >= 6 ? 0xFF : 0x1F);
+   if (recordLength <= mClassificationOffset || stride == 0)
+   {
+      return false;
+   }
+
+   mpMapping = new FileMapping;
+   if (mpMapping->open(filename) == false ||
+      dataOffset + static_cast<uint64_t>(recordCount) * recordLength > mpMapping->getFileSize())
+   {
+      delete mpMapping;
+      mpMapping = NULL;
+      return false;
+   }
+
+   mDataOffset = dataOffset;
+   mRecordLength = recordLength;
+   mStride = stride;
+   mPointCount = recordCount / stride;
+
+   // This matches the layout used by PointCloudAccessorImpl
+   mPointSize = pDescriptor->getPointSizeInBytes();
+   mIdOffset = 3 * sizeof(int32_t);
+   mValidOffset = mIdOffset + sizeof(PointCloudElement::pointIdType);
+   mIntensityOffset = mValidOffset + sizeof(PointCloudElement::validPointType);
+   mClassOffset = mIntensityOffset + sizeof(uint16_t);
+   return true;
+}
+
+uint32_t LasPager::getPointCount() const
+{
+   return mPointCount;
+}
+
+void LasPager::decodePoints(const unsigned char* pRecords, uint32_t firstPoint, uint32_t startPoint,
+                            uint32_t stopPoint, char* pPoints) const
+{
+   Endian fileEndian(LITTLE_ENDIAN_ORDER);
+   size_t recordStep = static_cast<size_t>(mStride) * mRecordLength;
+   const unsigned char* pRecord = pRecords + startPoint * recordStep;
+   char* pPoint = pPoints + startPoint * mPointSize;
+   for (uint32_t point = startPoint; point < stopPoint; ++point)
+   {
+      int32_t xyz[3];
+      memcpy(xyz, pRecord, sizeof(xyz));
+      uint16_t intensity = 0;
+      memcpy(&intensity, pRecord + sizeof(xyz), sizeof(intensity));
+      fileEndian.swapBuffer(xyz, 3);
+      fileEndian.swapValue(intensity);
+
+      PointCloudElement::pointIdType id = firstPoint + point;
+      memcpy(pPoint, xyz, sizeof(xyz));
+      memcpy(pPoint + mIdOffset, &id, sizeof(id));
+      pPoint[mValidOffset] = 1;
+      memcpy(pPoint + mIntensityOffset, &intensity, sizeof(intensity));
+      pPoint[mClassOffset] = static_cast<char>(pRecord[mClassificationOffset] & mClassificationMask);
+
+      pRecord += recordStep;
+      pPoint += mPointSize;
+   }
+}
+
+bool LasPager::getInputSpecification(PlugInArgList*& pArgList)
+{
+   pArgList = NULL;
+   return true;
+}
+
+bool LasPager::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
+{
+   return true;
+}
+
+PointDataBlock* LasPager::getPointBlock(uint32_t startIndex, uint32_t numPoints,
+                                        PointCloudDataRequest* pOriginalRequest)
+{
+   if (mpMapping == NULL || (pOriginalRequest != NULL && pOriginalRequest->getWritable()))
+   {
+      return NULL;
+   }
+   if (startIndex >= mPointCount || numPoints == 0)
+   {
+      return NULL;
+   }
+
+   uint64_t recordStep = static_cast<uint64_t>(mStride) * mRecordLength;
+   uint64_t maximumPoints = max(MAXIMUM_MAPPING_SIZE / recordStep, static_cast<uint64_t>(1));
+   numPoints = static_cast<uint32_t>(min(static_cast<uint64_t>(min(numPoints, mPointCount - startIndex)),
+      maximumPoints));
+
+   // Map from the first selected record through the end of the last one
+   uint64_t firstRecord = static_cast<uint64_t>(startIndex) * mStride + mStride - 1;
+   uint64_t offset = mDataOffset + firstRecord * mRecordLength;
+   uint64_t size = (numPoints - 1) * recordStep + mRecordLength;
+   void* pBase = NULL;
+   size_t baseSize = 0;
+   const unsigned char* pRecords = mpMapping->map(offset, size, pBase, baseSize);
+   if (pRecords == NULL)
+   {
+      return NULL;
+   }
+
+   LasDataBlock* pBlock = new LasDataBlock(mPointSize, numPoints);
+   DecodeInput input;
+   input.mpPager = this;
+   input.mpRecords = pRecords;
+   input.mFirstPoint = startIndex;
+   input.mPointCount = numPoints;
+   input.mpPoints = reinterpret_cast<char*>(pBlock->getRawData());
+
+   DecodeOutput output;
+   mta::MultiThreadedAlgorithm<DecodeInput, DecodeOutput, DecodeThread>
+      algorithm(mta::getNumRequiredThreads(numPoints), input, output, NULL);
+   bool success = (algorithm.run() == mta::SUCCESS);
+   mpMapping->unmap(pBase, baseSize);
+
+   if (success == false)
+   {
+      delete pBlock;
+      return NULL;
+   }
+
+   return pBlock;
+}
+
+void LasPager::releasePointBlock(PointDataBlock* pBlock)
+{
+   delete dynamic_cast<LasDataBlock*>(pBlock);
+}
@@ -0,0 +1,102 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2014 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef LASPAGER_H__
+#define LASPAGER_H__
+
+#include "PointCloudPagerShell.h"
+
+#include <string>
+
+class PointCloudDataDescriptor;
+
+/**
+ * Provides the points of an uncompressed LAS file without copying the file.
+ *
+ * Each block of points is decoded from a read-only memory mapping of the point
+ * records by several threads.  The X, Y and Z values are kept as the unscaled
+ * integers stored in the file; the scale and offset in the descriptor are only
+ * applied when the PointCloudAccessor is asked for scaled values.
+ */
+class LasPager : public PointCloudPagerShell
+{
+public:
+   LasPager();
+   ~LasPager();
+
+   /**
+    * Opens the point records of a LAS file.
+    *
+    * @param filename
+    *        The LAS file.
+    * @param dataOffset
+    *        The offset of the first point record in the file.
+    * @param recordLength
+    *        The size of each point record in bytes.
+    * @param pointFormat
+    *        The point data format of the records.
+    * @param recordCount
+    *        The number of point records in the file.
+    * @param stride
+    *        The pager provides one point for every \em stride records, starting
+    *        with record \em stride - 1, to thin the point cloud.
+    * @param pDescriptor
+    *        The descriptor of the element, which must use the encodings
+    *        created by the LAS importer.
+    *
+    * @return Returns \c false if the file could not be mapped or the records
+    *         do not fit in the file.
+    */
+   bool initialize(const std::string& filename, uint64_t dataOffset, unsigned int recordLength,
+      unsigned int pointFormat, uint32_t recordCount, uint32_t stride, const PointCloudDataDescriptor* pDescriptor);
+
+   /**
+    * Returns the number of points provided by the pager.
+    */
+   uint32_t getPointCount() const;
+
+   /**
+    * Converts point records into the layout used by a PointCloudElement.
+    *
+    * This is an implementation detail of the pager which is called from the
+    * worker threads.
+    */
+   void decodePoints(const unsigned char* pRecords, uint32_t firstPoint, uint32_t startPoint, uint32_t stopPoint,
+      char* pPoints) const;
+
+   bool getInputSpecification(PlugInArgList*& pArgList);
+   bool execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList);
+
+   virtual PointDataBlock* getPointBlock(uint32_t startIndex, uint32_t numPoints,
+      PointCloudDataRequest* pOriginalRequest);
+   virtual void releasePointBlock(PointDataBlock* pBlock);
+
+private:
+   LasPager(const LasPager& rhs);
+   LasPager& operator=(const LasPager& rhs);
+
+   class FileMapping;
+   FileMapping* mpMapping;
+
+   uint64_t mDataOffset;
+   unsigned int mRecordLength;
+   uint32_t mStride;
+   uint32_t mPointCount;
+
+   unsigned int mClassificationOffset;
+   unsigned char mClassificationMask;
+
+   size_t mPointSize;
+   size_t mIdOffset;
+   size_t mValidOffset;
+   size_t mIntensityOffset;
+   size_t mClassOffset;
+};
+
+#endif
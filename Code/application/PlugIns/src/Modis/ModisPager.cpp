@@ -26,9 +26,6 @@
 REGISTER_PLUGIN_BASIC(OpticksModis, ModisPager);
 
 ModisPager::ModisPager() :
-   CachedPager(10 * 1024 * 1024 * 4),  // Specify a cache size large enough (40MB) to contain data for all
-                                       // bands with the default number of concurrent rows, which provides
-                                       // cache hits when performing interleave conversions on import
    mFileHandle(FAIL),
    mDatasetHandle(FAIL),
    mpMetadata(NULL),
@@ -43,6 +40,7 @@ ModisPager::ModisPager() :
    setDescriptorId("{698840EC-A3AA-45f6-BA25-6A75BCC07F22}");
    setVersion(APP_VERSION_NUMBER);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setPrefetchEnabled(true);
 }
 
 ModisPager::~ModisPager()
@@ -16,6 +16,8 @@
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
 #include "PlugInRegistration.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
 #include "switchOnEncoding.h"
 
 #include <ossim/base/ossimFilename.h>
@@ -33,6 +35,8 @@ REGISTER_PLUGIN(OpticksNitf, Pager, Nitf::Pager);
 
 Nitf::Pager::Pager() :
    mSegment(0),
+   mTileRowCount(0),
+   mTileColumnCount(0),
    mpStep(NULL)
 {
    setCopyright(APP_COPYRIGHT);
@@ -41,10 +45,17 @@ Nitf::Pager::Pager() :
    setCreator("Ball Aerospace & Technologies Corp.");
    setDescriptorId("{4946AB79-B6DF-4ecd-8DA7-B77B04329C2F}");
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setPrefetchEnabled(true);
 }
 
 Nitf::Pager::~Pager()
-{}
+{
+   for (vector<ossimImageHandler*>::iterator iter = mIdleImageHandlers.begin();
+      iter != mIdleImageHandlers.end(); ++iter)
+   {
+      Nitf::OssimImageHandlerObject().releaseResource(Nitf::OssimImageHandlerObject::Args(mFilename), *iter);
+   }
+}
 
 bool Nitf::Pager::getInputSpecification(PlugInArgList*& pArgList)
 {
@@ -60,11 +71,82 @@ bool Nitf::Pager::parseInputArgs(PlugInArgList* pInputArgList)
 
 bool Nitf::Pager::openFile(const string& filename)
 {
-   mpImageHandler = Nitf::OssimImageHandlerResource(filename);
-   return mpImageHandler.get() != NULL;
+   mFilename = filename;
+
+   // Open the first handler now to verify the file and keep it for the first fetch
+   ossimImageHandler* pImageHandler = acquireImageHandler();
+   if (pImageHandler == NULL)
+   {
+      return false;
+   }
+
+   // Read only the blocks which intersect a request if the image segment is blocked.
+   // Skipped columns do not line up with the blocks on disk, so read full rows in that case.
+   const RasterDataDescriptor* pDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(getRasterElement()->getDataDescriptor());
+   pImageHandler->setCurrentEntry(mSegment);
+   if (pDescriptor != NULL && pDescriptor->getColumnSkipFactor() == 0 && pImageHandler->isImageTiled())
+   {
+      mTileColumnCount = pImageHandler->getImageTileWidth();
+      mTileRowCount = pImageHandler->getImageTileHeight();
+   }
+
+   releaseImageHandler(pImageHandler);
+   return true;
+}
+
+bool Nitf::Pager::canFetchConcurrently() const
+{
+   return true;
+}
+
+unsigned int Nitf::Pager::getTileRowCount() const
+{
+   return mTileRowCount;
+}
+
+unsigned int Nitf::Pager::getTileColumnCount() const
+{
+   return mTileColumnCount;
+}
+
+ossimImageHandler* Nitf::Pager::acquireImageHandler()
+{
+   {
+      mta::MutexLock lock(mImageHandlerMutex);
+      if (mIdleImageHandlers.empty() == false)
+      {
+         ossimImageHandler* pImageHandler = mIdleImageHandlers.back();
+         mIdleImageHandlers.pop_back();
+         return pImageHandler;
+      }
+   }
+
+   // OSSIM image handlers are not thread-safe, so each concurrent fetch gets its own
+   Nitf::OssimImageHandlerResource pImageHandler(mFilename);
+   return pImageHandler.release();
+}
+
+void Nitf::Pager::releaseImageHandler(ossimImageHandler* pImageHandler)
+{
+   if (pImageHandler != NULL)
+   {
+      mta::MutexLock lock(mImageHandlerMutex);
+      mIdleImageHandlers.push_back(pImageHandler);
+   }
 }
 
 CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest)
+{
+   ossimImageHandler* pImageHandler = acquireImageHandler();
+   VERIFYRV(pImageHandler != NULL, CachedPage::UnitPtr());
+
+   CachedPage::UnitPtr pUnit = fetchUnit(pOriginalRequest, pImageHandler);
+   releaseImageHandler(pImageHandler);
+   return pUnit;
+}
+
+CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest, ossimImageHandler* pImageHandler)
 {
    VERIFYRV(pOriginalRequest != NULL, CachedPage::UnitPtr());
    DimensionDescriptor startRow = pOriginalRequest->getStartRow();
@@ -74,23 +156,23 @@ CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest)
    DimensionDescriptor startBand = pOriginalRequest->getStartBand();
    DimensionDescriptor stopBand = pOriginalRequest->getStopBand();
    unsigned int concurrentRows = pOriginalRequest->getConcurrentRows();
-   unsigned int concurrentColumns = getColumnCount();
+   unsigned int concurrentColumns = pOriginalRequest->getConcurrentColumns();
    unsigned int concurrentBands = pOriginalRequest->getConcurrentBands();
 
    unsigned int rowNumber = startRow.getOnDiskNumber();
    unsigned int colNumber = startColumn.getOnDiskNumber();
    unsigned int bandNumber = startBand.getOnDiskNumber();
 
-   VERIFYRV(mpImageHandler.get() != NULL, CachedPage::UnitPtr());
-   if (mpImageHandler->canCastTo("ossimNitfTileSource") == false)
+   VERIFYRV(pImageHandler != NULL, CachedPage::UnitPtr());
+   if (pImageHandler->canCastTo("ossimNitfTileSource") == false)
    {
       return CachedPage::UnitPtr();
    }
 
-   ossimNitfTileSource* pTileSource = PTR_CAST(ossimNitfTileSource, mpImageHandler.get());
+   ossimNitfTileSource* pTileSource = PTR_CAST(ossimNitfTileSource, pImageHandler);
    VERIFYRV(pTileSource != NULL, CachedPage::UnitPtr());
    pTileSource->setExpandLut(false);
-   mpImageHandler->setCurrentEntry(mSegment);
+   pImageHandler->setCurrentEntry(mSegment);
 
    // Try to set the output band list.
    // If it cannot succeed (e.g.: for VQ), this is not an error.
@@ -100,10 +182,10 @@ CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest)
       bandList[band] = bandNumber + band;
    }
 
-   mpImageHandler->setOutputBandList(bandList);
+   pImageHandler->setOutputBandList(bandList);
 
    // The Bounding Rectangle contains NITF Chipping Information.
-   ossimIrect br = mpImageHandler->getBoundingRect();
+   ossimIrect br = pImageHandler->getBoundingRect();
 
    int minx;
    int miny;
@@ -121,7 +203,7 @@ CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest)
       return CachedPage::UnitPtr();
    }
 
-   ossimRefPtr<ossimImageData> cubeData = mpImageHandler->getTile(region);
+   ossimRefPtr<ossimImageData> cubeData = pImageHandler->getTile(region);
    if (cubeData == NULL || cubeData->getBuf() == NULL)
    {
       return CachedPage::UnitPtr();
@@ -168,6 +250,13 @@ CachedPage::UnitPtr Nitf::Pager::fetchUnit(DataRequest *pOriginalRequest)
       cubeData->unloadTile(pData.get(), region, interleave);
    }
 
+   DimensionDescriptor unitBand = (concurrentBands == 1 ? startBand : CachedPage::CacheUnit::ALL_BANDS);
+   if (static_cast<int>(concurrentColumns) == getColumnCount())
+   {
+      return CachedPage::UnitPtr(new CachedPage::CacheUnit(pData.release(), startRow, concurrentRows,
+         dstSize, unitBand));
+   }
+
    return CachedPage::UnitPtr(new CachedPage::CacheUnit(pData.release(), startRow, concurrentRows,
-      dstSize, concurrentBands == 1 ? startBand : CachedPage::CacheUnit::ALL_BANDS));
+      startColumn, concurrentColumns, dstSize, unitBand));
 }
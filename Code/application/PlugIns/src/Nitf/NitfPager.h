@@ -11,12 +11,15 @@
 #define NITFPAGER_H
 
 #include "CachedPager.h"
+#include "DMutex.h"
 #include "NitfResource.h"
 #include "PlugInArg.h"
 
+#include <string>
 #include <vector>
 
 class NITF_IMAGE_SEGMENT_BASE;
+class ossimImageHandler;
 
 namespace Nitf
 {
@@ -46,11 +49,43 @@ namespace Nitf
 
       virtual CachedPage::UnitPtr fetchUnit(DataRequest *pOriginalRequest);
 
+      /**
+       *  Each fetch checks out its own OSSIM image handler, so units can be decoded concurrently.
+       *
+       *  @return  Returns \c true.
+       */
+      virtual bool canFetchConcurrently() const;
+
+      /**
+       *  Blocked image segments are read one block column at a time when only part
+       *  of the columns are requested.
+       *
+       *  @return  The number of rows in each block, or 0 if the image segment is not blocked.
+       */
+      virtual unsigned int getTileRowCount() const;
+
+      /**
+       *  Blocked image segments are read one block column at a time when only part
+       *  of the columns are requested.
+       *
+       *  @return  The number of columns in each block, or 0 if the image segment is not blocked.
+       */
+      virtual unsigned int getTileColumnCount() const;
+
    private:
       Pager& operator=(const Pager& rhs);
 
+      CachedPage::UnitPtr fetchUnit(DataRequest *pOriginalRequest, ossimImageHandler* pImageHandler);
+
+      ossimImageHandler* acquireImageHandler();
+      void releaseImageHandler(ossimImageHandler* pImageHandler);
+
       unsigned int mSegment; // 0-based segment number
-      Nitf::OssimImageHandlerResource mpImageHandler;
+      unsigned int mTileRowCount;
+      unsigned int mTileColumnCount;
+      std::string mFilename;
+      std::vector<ossimImageHandler*> mIdleImageHandlers;
+      mta::DMutex mImageHandlerMutex;
       Step* mpStep;
    };
 }
@@ -55,6 +55,9 @@ Nitf::RpcGeoreference::RpcGeoreference() :
    executeOnStartup(false);
    destroyAfterExecute(false);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+
+   // The RPC model is not modified when converting coordinates
+   allowConcurrentConversions(true);
 }
 
 Nitf::RpcGeoreference::~RpcGeoreference()
@@ -286,6 +289,7 @@ bool Nitf::RpcGeoreference::execute(PlugInArgList* pInParam, PlugInArgList* pOut
       return false;
    }
 
+   updateApproximationGrid();
    mpRaster->setGeoreferencePlugin(this);
 
    // Update the georeference descriptor with the current georeference parameters if necessary
@@ -374,6 +378,77 @@ LocationType Nitf::RpcGeoreference::geoToPixel(LocationType geo, bool* pAccurate
    return mpChipConverter->originalToActive(LocationType(imagePoint.x, imagePoint.y));
 }
 
+void Nitf::RpcGeoreference::convertPixelsToGeocoords(const LocationType* pPixels, size_t count,
+                                                     LocationType* pGeocoords, bool quick, bool* pAccurate) const
+{
+   if (quick == true && hasApproximationGrid() == true)
+   {
+      GeoreferenceShell::convertPixelsToGeocoords(pPixels, count, pGeocoords, quick, pAccurate);
+      return;
+   }
+
+   ossimDpt imagePoint;
+   ossimGpt worldPoint;
+   for (size_t i = 0; i < count; ++i)
+   {
+      LocationType pixel = mpChipConverter->activeToOriginal(pPixels[i]);
+      imagePoint.x = pixel.mX;
+      imagePoint.y = pixel.mY;
+      mModel.lineSampleHeightToWorld(imagePoint, mHeight, worldPoint);
+      if (worldPoint.isNan())
+      {
+         pGeocoords[i] = LocationType();
+         if (pAccurate != NULL)
+         {
+            *pAccurate = false;
+         }
+      }
+      else
+      {
+         pGeocoords[i] = LocationType(worldPoint.latd(), worldPoint.lond());
+      }
+   }
+}
+
+void Nitf::RpcGeoreference::convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count,
+                                                     LocationType* pPixels, bool quick, bool* pAccurate) const
+{
+   ossimGpt worldPoint;
+   worldPoint.height(mHeight);
+   ossimDpt imagePoint;
+   for (size_t i = 0; i < count; ++i)
+   {
+      worldPoint.latd(pGeocoords[i].mX);
+      worldPoint.lond(pGeocoords[i].mY);
+      mModel.worldToLineSample(worldPoint, imagePoint);
+      if (imagePoint.isNan())
+      {
+         pPixels[i] = LocationType();
+         if (pAccurate != NULL)
+         {
+            *pAccurate = false;
+         }
+      }
+      else
+      {
+         pPixels[i] = mpChipConverter->originalToActive(LocationType(imagePoint.x, imagePoint.y));
+      }
+   }
+}
+
+void Nitf::RpcGeoreference::updateApproximationGrid()
+{
+   clearApproximationGrid();
+
+   const RasterDataDescriptor* pDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpRaster == NULL ? NULL : mpRaster->getDataDescriptor());
+   double tolerance = getSettingApproximationGridTolerance();
+   if (pDescriptor != NULL && tolerance > 0.0)
+   {
+      buildApproximationGrid(pDescriptor->getColumnCount(), pDescriptor->getRowCount(), tolerance);
+   }
+}
+
 const DynamicObject* Nitf::RpcGeoreference::getRpcInstance(const RasterDataDescriptor* pDescriptor) const
 {
    if (pDescriptor == NULL)
@@ -495,7 +570,13 @@ bool Nitf::RpcGeoreference::serialize(SessionItemSerializer& serializer) const
       return false;
    }
    ossimString str = kwl.toString();
-   return serializer.serialize(str.chars(), str.size());
+   if (!serializer.serialize(str.chars(), str.size()))
+   {
+      return false;
+   }
+   serializer.endBlock();
+
+   return serializeApproximationGrid(serializer);
 }
 
 bool Nitf::RpcGeoreference::deserialize(SessionItemDeserializer& deserializer)
@@ -507,7 +588,8 @@ bool Nitf::RpcGeoreference::deserialize(SessionItemDeserializer& deserializer)
       return true;
    }
 
-   if (sizes.size() != 2)
+   // Sessions saved before the approximation grid was added do not contain it
+   if (sizes.size() != 2 && sizes.size() != 3)
    {
       return false;
    }
@@ -548,5 +630,21 @@ bool Nitf::RpcGeoreference::deserialize(SessionItemDeserializer& deserializer)
    {
       return false;
    }
-   return mModel.loadState(kwl);
+   if (!mModel.loadState(kwl))
+   {
+      return false;
+   }
+
+   // The grid is rebuilt if it was not saved or was saved in an older format
+   if (sizes.size() == 3)
+   {
+      deserializer.nextBlock();
+      if (deserializeApproximationGrid(deserializer) == true)
+      {
+         return true;
+      }
+   }
+
+   updateApproximationGrid();
+   return true;
 }
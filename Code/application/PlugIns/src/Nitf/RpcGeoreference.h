@@ -10,6 +10,7 @@
 #ifndef RPCGEOREFERENCE_H
 #define RPCGEOREFERENCE_H
 
+#include "ConfigurationSettings.h"
 #include "GeoreferenceShell.h"
 #include "NitfChipConverter.h"
 
@@ -31,6 +32,10 @@ namespace Nitf
       RpcGeoreference();
       virtual ~RpcGeoreference();
 
+      // The tolerance in degrees of the grid which approximates pixelToGeo() for quick conversions, or zero to
+      // always evaluate the RPC model
+      SETTING(ApproximationGridTolerance, RpcGeoreference, double, 0.0);
+
       bool getInputSpecification(PlugInArgList*& pArgList);
       bool execute(PlugInArgList* pInParam, PlugInArgList* pOutParam);
 
@@ -39,12 +44,17 @@ namespace Nitf
       bool validate(const RasterDataDescriptor* pDescriptor, std::string& errorMessage) const;
       LocationType pixelToGeo(LocationType pixel, bool* pAccurate = NULL) const;
       LocationType geoToPixel(LocationType geo, bool* pAccurate = NULL) const;
+      void convertPixelsToGeocoords(const LocationType* pPixels, size_t count, LocationType* pGeocoords,
+         bool quick, bool* pAccurate) const;
+      void convertGeocoordsToPixels(const LocationType* pGeocoords, size_t count, LocationType* pPixels,
+         bool quick, bool* pAccurate) const;
 
       bool serialize(SessionItemSerializer &serializer) const;
       bool deserialize(SessionItemDeserializer &deserializer);
 
    private:
       const DynamicObject* getRpcInstance(const RasterDataDescriptor* pDescriptor) const;
+      void updateApproximationGrid();
 
       RasterElement* mpRaster;
       mutable std::string mRpcVersion;
@@ -12,9 +12,13 @@
 #include "AppVersion.h"
 #include "BitMask.h"
 #include "ConnectedComponents.h"
+#include "DataAccessor.h"
+#include "DataAccessorImpl.h"
+#include "DataRequest.h"
 #include "DesktopServices.h"
 #include "DynamicObject.h"
 #include "LayerList.h"
+#include "MultiThreadedAlgorithm.h"
 #include "ObjectResource.h"
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
@@ -25,53 +29,365 @@
 #include "RasterUtilities.h"
 #include "SpatialDataView.h"
 #include "StringUtilities.h"
-#include "UtilityServices.h"
 
-#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <limits>
 
 REGISTER_PLUGIN_BASIC(OpticksObjectFinding, ConnectedComponents);
 
 namespace
 {
-   void fillContours(cv::Mat labels,
-                     const std::vector<std::vector<cv::Point> >& contours,
-                     const std::vector<cv::Vec4i>& hierarchy,
-                     unsigned short& label,
-                     unsigned short parentLabel, // or 0 for an external
-                     int contourIdx)
+   /**
+    * The area, extents and centroid of a component, in the pixel coordinates of the AOI.
+    */
+   struct ComponentStatistics
    {
-      if (static_cast<int>(hierarchy.size()) <= contourIdx)
+      ComponentStatistics() :
+         mArea(0),
+         mMinX(std::numeric_limits<int>::max()),
+         mMinY(std::numeric_limits<int>::max()),
+         mMaxX(std::numeric_limits<int>::min()),
+         mMaxY(std::numeric_limits<int>::min()),
+         mSumX(0.0),
+         mSumY(0.0)
+      {}
+
+      void add(int x, int y)
+      {
+         ++mArea;
+         mMinX = std::min(mMinX, x);
+         mMinY = std::min(mMinY, y);
+         mMaxX = std::max(mMaxX, x);
+         mMaxY = std::max(mMaxY, y);
+         mSumX += x;
+         mSumY += y;
+      }
+
+      void merge(const ComponentStatistics& other)
+      {
+         mArea += other.mArea;
+         mMinX = std::min(mMinX, other.mMinX);
+         mMinY = std::min(mMinY, other.mMinY);
+         mMaxX = std::max(mMaxX, other.mMaxX);
+         mMaxY = std::max(mMaxY, other.mMaxY);
+         mSumX += other.mSumX;
+         mSumY += other.mSumY;
+      }
+
+      unsigned int mArea;
+      int mMinX;
+      int mMinY;
+      int mMaxX;
+      int mMaxY;
+      double mSumX;
+      double mSumY;
+   };
+
+   /**
+    * Finds the provisional label at the root of a tree, halving the path to the root along the way.
+    */
+   unsigned int findRoot(std::vector<unsigned int>& parents, unsigned int label)
+   {
+      while (parents[label] != label)
+      {
+         parents[label] = parents[parents[label]];
+         label = parents[label];
+      }
+      return label;
+   }
+
+   /**
+    * Merges the trees of two provisional labels.  The lower label becomes the root, so the root of each
+    * component is the label of the first pixel of the component in raster order.
+    */
+   void unite(std::vector<unsigned int>& parents, unsigned int first, unsigned int second)
+   {
+      first = findRoot(parents, first);
+      second = findRoot(parents, second);
+      if (first < second)
+      {
+         parents[second] = first;
+      }
+      else if (second < first)
       {
-         return;
+         parents[first] = second;
       }
-      // Loop all contours at this level of the tree
-      while (contourIdx != -1)
+   }
+
+   struct LabelInput
+   {
+      LabelInput() :
+         mpMask(NULL),
+         mpLabels(NULL),
+         mXOffset(0),
+         mYOffset(0),
+         mpAbortFlag(NULL),
+         mpLabelOffsets(NULL),
+         mpFinalLabels(NULL)
+      {}
+
+      const BitMask* mpMask;
+      RasterElement* mpLabels;
+      int mXOffset;
+      int mYOffset;
+      const bool* mpAbortFlag;
+
+      // Set for the second pass, which replaces the provisional labels of each thread with the final labels
+      const std::vector<unsigned int>* mpLabelOffsets;
+      const std::vector<unsigned int>* mpFinalLabels;
+   };
+
+   /**
+    * Labels the 8-connected components of a strip of rows.
+    *
+    * In the first pass, each thread labels its strip independently with provisional labels starting at 1,
+    * recording which provisional labels touch, the statistics of each provisional label, and the labels of
+    * the first and last rows so that components crossing the strip boundaries can be merged.  In the
+    * second pass, each thread replaces the provisional labels in its strip with the final labels.
+    */
+   class LabelThread : public mta::AlgorithmThread
+   {
+   public:
+      LabelThread(const LabelInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mRowRange(getThreadRange(threadCount, static_cast<const RasterDataDescriptor*>(
+            input.mpLabels->getDataDescriptor())->getRowCount()))
+      {}
+
+      void run()
       {
-         if (parentLabel > 0)
+         if (mRowRange.mLast < mRowRange.mFirst)
+         {
+            mParents.assign(1, 0);
+            mStatistics.resize(1);
+            return;
+         }
+
+         if (mInput.mpFinalLabels == NULL)
+         {
+            labelRows();
+         }
+         else
          {
-            // Internal contours include the edge of object, not the edge of the hole
-            // So we blank out the internal contour then redraw the contour line
-            cv::drawContours(labels, contours, contourIdx, cv::Scalar(0), CV_FILLED, 8, hierarchy, 0);
-            cv::drawContours(labels, contours, contourIdx, cv::Scalar(parentLabel), 1, 8, hierarchy, 0);
-            if (hierarchy[contourIdx][2] != -1)
+            relabelRows();
+         }
+      }
+
+      std::vector<unsigned int> mParents;
+      std::vector<ComponentStatistics> mStatistics;
+      std::vector<unsigned int> mFirstRow;
+      std::vector<unsigned int> mLastRow;
+
+   private:
+      LabelThread& operator=(const LabelThread& rhs);
+
+      DataAccessor getAccessor() const
+      {
+         const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
+            mInput.mpLabels->getDataDescriptor());
+         FactoryResource<DataRequest> pRequest;
+         pRequest->setRows(pDescriptor->getActiveRow(mRowRange.mFirst), pDescriptor->getActiveRow(mRowRange.mLast));
+         pRequest->setWritable(true);
+         return mInput.mpLabels->getDataAccessor(pRequest.release());
+      }
+
+      bool isAborted() const
+      {
+         return mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag;
+      }
+
+      void labelRows()
+      {
+         DataAccessor accessor = getAccessor();
+         unsigned int width = static_cast<const RasterDataDescriptor*>(
+            mInput.mpLabels->getDataDescriptor())->getColumnCount();
+
+         // Label 0 is the background
+         mParents.assign(1, 0);
+         mStatistics.resize(1);
+
+         // The previous row is padded by a column on each side so every pixel has three neighbors above it
+         std::vector<unsigned int> previous(width + 2, 0);
+         std::vector<unsigned int> current(width + 2, 0);
+         for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
+         {
+            getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(row));
+            if (isAborted() || accessor.isValid() == false)
             {
-               // If there are nested contours, draw them as well
-               fillContours(labels, contours, hierarchy, label, 0, hierarchy[contourIdx][2]);
+               return;
             }
+
+            int y = row + mInput.mYOffset;
+            for (unsigned int column = 0; column < width; ++column)
+            {
+               int x = static_cast<int>(column) + mInput.mXOffset;
+               unsigned int& label = current[column + 1];
+               if (mInput.mpMask->getPixel(x, y) == false)
+               {
+                  label = 0;
+                  continue;
+               }
+
+               // The neighbors to the left and above have already been labeled
+               unsigned int neighbors[4] = { current[column], previous[column], previous[column + 1],
+                  previous[column + 2] };
+               label = 0;
+               for (int neighbor = 0; neighbor < 4; ++neighbor)
+               {
+                  if (neighbors[neighbor] != 0)
+                  {
+                     if (label == 0)
+                     {
+                        label = neighbors[neighbor];
+                     }
+                     else if (neighbors[neighbor] != label)
+                     {
+                        unite(mParents, label, neighbors[neighbor]);
+                     }
+                  }
+               }
+               if (label == 0)
+               {
+                  label = static_cast<unsigned int>(mParents.size());
+                  mParents.push_back(label);
+                  mStatistics.push_back(ComponentStatistics());
+               }
+               mStatistics[label].add(x, y);
+            }
+
+            std::copy(current.begin() + 1, current.end() - 1, reinterpret_cast<unsigned int*>(accessor->getRow()));
+            accessor->nextRow();
+            if (row == mRowRange.mFirst)
+            {
+               mFirstRow.assign(current.begin() + 1, current.end() - 1);
+            }
+            previous.swap(current);
          }
-         else
+
+         mLastRow.assign(previous.begin() + 1, previous.end() - 1);
+      }
+
+      void relabelRows()
+      {
+         DataAccessor accessor = getAccessor();
+         unsigned int width = static_cast<const RasterDataDescriptor*>(
+            mInput.mpLabels->getDataDescriptor())->getColumnCount();
+         const unsigned int* pFinalLabels = &mInput.mpFinalLabels->front() + (*mInput.mpLabelOffsets)[getThreadIndex()];
+         for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
          {
-            // Fill the entire contour poly
-            cv::drawContours(labels, contours, contourIdx, cv::Scalar(++label), CV_FILLED, 8, hierarchy, 0);
-            if (hierarchy[contourIdx][2] != -1)
+            getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(row));
+            if (isAborted() || accessor.isValid() == false)
             {
-               // If there are nested contours, draw them as well
-               fillContours(labels, contours, hierarchy, label, label, hierarchy[contourIdx][2]);
+               return;
             }
+
+            unsigned int* pLabels = reinterpret_cast<unsigned int*>(accessor->getRow());
+            for (unsigned int column = 0; column < width; ++column)
+            {
+               pLabels[column] = pFinalLabels[pLabels[column]];
+            }
+            accessor->nextRow();
          }
-         contourIdx = hierarchy[contourIdx][0];
       }
-   }
+
+      const LabelInput& mInput;
+      mta::AlgorithmThread::Range mRowRange;
+   };
+
+   /**
+    * Merges the provisional labels of the threads into consecutive final labels.
+    */
+   struct LabelOutput
+   {
+      bool compileOverallResults(const std::vector<LabelThread*>& threads)
+      {
+         if (mLabelOffsets.empty() == false)
+         {
+            // Nothing is combined after the second pass
+            return true;
+         }
+
+         // Each thread's labels, including its background label, are offset into a single range
+         unsigned int total = 0;
+         for (std::vector<LabelThread*>::const_iterator thread = threads.begin(); thread != threads.end(); ++thread)
+         {
+            mLabelOffsets.push_back(total);
+            total += static_cast<unsigned int>((*thread)->mParents.size());
+         }
+
+         std::vector<unsigned int> parents(total);
+         std::vector<ComponentStatistics> statistics;
+         statistics.reserve(total);
+         for (unsigned int index = 0; index < threads.size(); ++index)
+         {
+            LabelThread* pThread = threads[index];
+            unsigned int offset = mLabelOffsets[index];
+            for (unsigned int label = 0; label < pThread->mParents.size(); ++label)
+            {
+               parents[offset + label] = offset + pThread->mParents[label];
+            }
+            statistics.insert(statistics.end(), pThread->mStatistics.begin(), pThread->mStatistics.end());
+         }
+
+         // Merge components which cross the boundary between consecutive strips
+         for (unsigned int index = 1; index < threads.size(); ++index)
+         {
+            const std::vector<unsigned int>& above = threads[index - 1]->mLastRow;
+            const std::vector<unsigned int>& below = threads[index]->mFirstRow;
+            if (above.empty() || below.empty())
+            {
+               continue;
+            }
+
+            for (unsigned int column = 0; column < below.size(); ++column)
+            {
+               if (below[column] == 0)
+               {
+                  continue;
+               }
+
+               unsigned int first = (column == 0 ? 0 : column - 1);
+               unsigned int last = std::min(column + 1, static_cast<unsigned int>(above.size()) - 1);
+               for (unsigned int neighbor = first; neighbor <= last; ++neighbor)
+               {
+                  if (above[neighbor] != 0)
+                  {
+                     unite(parents, mLabelOffsets[index] + below[column], mLabelOffsets[index - 1] + above[neighbor]);
+                  }
+               }
+            }
+         }
+
+         // Number the roots in order, which is the raster order of the first pixel of each component
+         mFinalLabels.assign(total, 0);
+         for (unsigned int index = 0; index < threads.size(); ++index)
+         {
+            unsigned int offset = mLabelOffsets[index];
+            for (unsigned int label = 1; label < threads[index]->mParents.size(); ++label)
+            {
+               unsigned int provisional = offset + label;
+               unsigned int root = findRoot(parents, provisional);
+               if (root == provisional)
+               {
+                  mFinalLabels[provisional] = static_cast<unsigned int>(mStatistics.size()) + 1;
+                  mStatistics.push_back(statistics[provisional]);
+               }
+               else
+               {
+                  mFinalLabels[provisional] = mFinalLabels[root];
+                  mStatistics[mFinalLabels[root] - 1].merge(statistics[provisional]);
+               }
+            }
+         }
+
+         return true;
+      }
+
+      std::vector<unsigned int> mLabelOffsets;
+      std::vector<unsigned int> mFinalLabels;
+      std::vector<ComponentStatistics> mStatistics;
+   };
 }
 
 ConnectedComponents::ConnectedComponents() : mpView(NULL), mpLabels(NULL), mXOffset(0), mYOffset(0)
@@ -84,7 +400,6 @@ ConnectedComponents::ConnectedComponents() : mpView(NULL), mpLabels(NULL), mXOff
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
    setAbortSupported(true);
    setMenuLocation("[General Algorithms]/Connected Components");
-   addDependencyCopyright("OpenCV", Service<UtilityServices>()->getTextFromFile(":/licenses/opencv"));
 }
 
 ConnectedComponents::~ConnectedComponents()
@@ -110,7 +425,7 @@ bool ConnectedComponents::getOutputSpecification(PlugInArgList*& pOutArgList)
       "The number of blobs found after removing blobs which don't meet the minimum size."));
    VERIFY(pOutArgList->addArg<RasterElement>("Blobs",
       "Labeled blobs with 0 indicating no blob. In interactive mode, a pseudocolor layer will "
-      "be created with this element."));
+      "be created with this element. The metadata contains the area, extents and centroid of each blob."));
    return true;
 }
 
@@ -172,7 +487,7 @@ bool ConnectedComponents::execute(PlugInArgList* pInArgList, PlugInArgList* pOut
       x2 = std::max(x2, 0);
       y2 = std::max(y2, 0);
    }
-   // Include a 1 pixel border so we include the edge pixels
+   // Include a 1 pixel border of background around the blobs
    x1--;
    x2++;
    y1--;
@@ -196,7 +511,7 @@ bool ConnectedComponents::execute(PlugInArgList* pInArgList, PlugInArgList* pOut
       Service<ModelServices>()->destroyElement(mpLabels);
       mpLabels = NULL;
    }
-   mpLabels = RasterUtilities::createRasterElement("Blobs", height, width, INT2UBYTES, true, pAoi);
+   mpLabels = RasterUtilities::createRasterElement("Blobs", height, width, INT4UBYTES, true, pAoi);
    if (mpLabels == NULL)
    {
       mProgress.report("Unable to create label element.", 0, ERRORS, true);
@@ -204,70 +519,96 @@ bool ConnectedComponents::execute(PlugInArgList* pInArgList, PlugInArgList* pOut
    }
    ModelResource<RasterElement> pLabels(mpLabels);
 
-   try
+   LabelInput input;
+   input.mpMask = mpBitmask;
+   input.mpLabels = mpLabels;
+   input.mXOffset = mXOffset;
+   input.mYOffset = mYOffset;
+   input.mpAbortFlag = &mAborted;
+
+   // Both passes must divide the rows among the same number of threads
+   int threadCount = mta::getNumRequiredThreads(height);
+   LabelOutput output;
+   mta::ProgressObjectReporter labelReporter("Labeling blobs", mProgress.getCurrentProgress());
+   mta::MultiThreadedAlgorithm<LabelInput, LabelOutput, LabelThread>
+      labelAlg(threadCount, input, output, &labelReporter);
+   if (labelAlg.run() != mta::SUCCESS || isAborted())
    {
-      cv::Mat data(height, width, CV_8UC1, cv::Scalar(0));
-      for (unsigned int y = 0; y < height; ++y)
-      {
-         mProgress.report("Reading AOI data", 10 * y / height, NORMAL);
-         for (unsigned int x = 0; x < width; ++x)
-         {
-            if (mpBitmask->getPixel(x + mXOffset, y + mYOffset))
-            {
-               data.at<unsigned char>(y, x) = 255;
-            }
-         }
-      }
-      mProgress.report("Finding contours", 15, NORMAL);
-      std::vector<std::vector<cv::Point> > contours;
-      std::vector<cv::Vec4i> hierarchy;
-      cv::findContours(data, contours, hierarchy, CV_RETR_TREE, CV_CHAIN_APPROX_SIMPLE);
-      cv::Mat labels(height, width, CV_16UC1, mpLabels->getRawData());
-      mProgress.report("Filling blobs", 50, NORMAL);
-      unsigned short lastLabel = 0;
-      fillContours(labels, contours, hierarchy, lastLabel, 0, 0);
-
-      // create a pseudocolor layer for display
-      mProgress.report("Displaying results", 90, NORMAL);
-      mpLabels->updateData();
-      if (!createPseudocolor(lastLabel))
-      {
-         mProgress.report("Unable to create blob layer", 0, ERRORS, true);
-         return false;
-      }
+      mProgress.report("Labeling connected components aborted.", 0, ABORT, true);
+      return false;
+   }
 
-      // add blob count to the metadata
-      DynamicObject* pMeta = pLabels->getMetadata();
-      VERIFY(pMeta);
-      unsigned int numBlobs = static_cast<unsigned int>(lastLabel);
-      pMeta->setAttribute("BlobCount", numBlobs);
-      if (numBlobs == 0 && !isBatch())
-      {
-         // Inform the user that there were no blobs so they don't think there was an
-         // error running the algorithm. No need to do this in batch since this is
-         // represented in the metadata already.
-         mProgress.report("No blobs were found.", 95, WARNING);
-      }
-      // update the output arg list
-      if (pOutArgList != NULL)
-      {
-         pOutArgList->setPlugInArgValue("Blobs", pLabels.get());
-         pOutArgList->setPlugInArgValue("Number of Blobs", &numBlobs);
-      }
+   input.mpLabelOffsets = &output.mLabelOffsets;
+   input.mpFinalLabels = &output.mFinalLabels;
+   mta::ProgressObjectReporter relabelReporter("Numbering blobs", mProgress.getCurrentProgress());
+   mta::MultiThreadedAlgorithm<LabelInput, LabelOutput, LabelThread>
+      relabelAlg(threadCount, input, output, &relabelReporter);
+   if (relabelAlg.run() != mta::SUCCESS || isAborted())
+   {
+      mProgress.report("Labeling connected components aborted.", 0, ABORT, true);
+      return false;
    }
-   catch(const cv::Exception& exc)
+
+   // create a pseudocolor layer for display
+   mProgress.report("Displaying results", 90, NORMAL);
+   mpLabels->updateData();
+   unsigned int numBlobs = static_cast<unsigned int>(output.mStatistics.size());
+   if (!createPseudocolor(numBlobs))
    {
-      mProgress.report(exc.what(), 0, ERRORS, true);
+      mProgress.report("Unable to create blob layer", 0, ERRORS, true);
       return false;
    }
 
+   // add blob count and the statistics of each blob to the metadata
+   DynamicObject* pMeta = pLabels->getMetadata();
+   VERIFY(pMeta);
+   pMeta->setAttribute("BlobCount", numBlobs);
+   std::vector<unsigned int> areas(numBlobs);
+   std::vector<int> minX(numBlobs);
+   std::vector<int> minY(numBlobs);
+   std::vector<int> maxX(numBlobs);
+   std::vector<int> maxY(numBlobs);
+   std::vector<double> centroidX(numBlobs);
+   std::vector<double> centroidY(numBlobs);
+   for (unsigned int blob = 0; blob < numBlobs; ++blob)
+   {
+      const ComponentStatistics& blobStatistics = output.mStatistics[blob];
+      areas[blob] = blobStatistics.mArea;
+      minX[blob] = blobStatistics.mMinX;
+      minY[blob] = blobStatistics.mMinY;
+      maxX[blob] = blobStatistics.mMaxX;
+      maxY[blob] = blobStatistics.mMaxY;
+      centroidX[blob] = blobStatistics.mSumX / blobStatistics.mArea;
+      centroidY[blob] = blobStatistics.mSumY / blobStatistics.mArea;
+   }
+   pMeta->setAttribute("BlobArea", areas);
+   pMeta->setAttribute("BlobMinX", minX);
+   pMeta->setAttribute("BlobMinY", minY);
+   pMeta->setAttribute("BlobMaxX", maxX);
+   pMeta->setAttribute("BlobMaxY", maxY);
+   pMeta->setAttribute("BlobCentroidX", centroidX);
+   pMeta->setAttribute("BlobCentroidY", centroidY);
+   if (numBlobs == 0 && !isBatch())
+   {
+      // Inform the user that there were no blobs so they don't think there was an
+      // error running the algorithm. No need to do this in batch since this is
+      // represented in the metadata already.
+      mProgress.report("No blobs were found.", 95, WARNING);
+   }
+   // update the output arg list
+   if (pOutArgList != NULL)
+   {
+      pOutArgList->setPlugInArgValue("Blobs", pLabels.get());
+      pOutArgList->setPlugInArgValue("Number of Blobs", &numBlobs);
+   }
+
    pLabels.release();
    mProgress.report("Labeling connected components", 100, NORMAL);
    mProgress.upALevel();
    return true;
 }
 
-bool ConnectedComponents::createPseudocolor(unsigned short maxLabel) const
+bool ConnectedComponents::createPseudocolor(unsigned int maxLabel) const
 {
    if (isBatch() || mpView == NULL)
    {
@@ -288,10 +629,10 @@ bool ConnectedComponents::createPseudocolor(unsigned short maxLabel) const
       std::vector<ColorType> excluded;
       excluded.push_back(ColorType(0, 0, 0));
       excluded.push_back(ColorType(255, 255, 255));
-      ColorType::getUniqueColors(std::min<unsigned short>(maxLabel, 50), colors, excluded);
-      for (int cl = 1; cl <= maxLabel; ++cl)
+      ColorType::getUniqueColors(std::min<unsigned int>(maxLabel, 50), colors, excluded);
+      for (unsigned int cl = 1; cl <= maxLabel; ++cl)
       {
-         pOutLayer->addInitializedClass(StringUtilities::toDisplayString(cl), cl, colors[(cl - 1) % 50]);
+         pOutLayer->addInitializedClass(StringUtilities::toDisplayString(cl), static_cast<int>(cl), colors[(cl - 1) % 50]);
       }
    }
    return true;
@@ -29,7 +29,7 @@ public:
    virtual bool execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList);
 
 private:
-   bool createPseudocolor(unsigned short maxLabel) const;
+   bool createPseudocolor(unsigned int maxLabel) const;
 
    mutable ProgressTracker mProgress;
    SpatialDataView* mpView;
@@ -11,6 +11,7 @@
 #include "AnnotationLayer.h"
 #include "AoiElement.h"
 #include "AoiLayer.h"
+#include "AppConfig.h"
 #include "AppVersion.h"
 #include "BitMask.h"
 #include "BitMaskIterator.h"
@@ -22,6 +23,7 @@
 #include "LayerList.h"
 #include "LocationType.h"
 #include "ModelServices.h"
+#include "MultiThreadedAlgorithm.h"
 #include "ObjectFactory.h"
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
@@ -38,24 +40,181 @@
 #include <QtCore/QList>
 #include <QtCore/QPoint>
 #include <QtGui/QApplication>
-#include <limits>
+#include <algorithm>
 #include <math.h>
-#if !defined(DEBUG)
-// boost optimizations on
-#define NDEBUG
-#endif
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/matrix_proxy.hpp>
-#include <boost/numeric/ublas/symmetric.hpp>
-
-using namespace boost::numeric;
+#include <queue>
+#include <utility>
+#include <vector>
 
 REGISTER_PLUGIN_BASIC(OpticksObjectFinding, QtCluster);
 
 namespace
 {
 typedef QList<QPoint> PointsType;
-typedef ublas::symmetric_matrix<int> MatrixType;
+
+/**
+ * Finds the points within the cluster size of a point.
+ *
+ * The points are sorted by the square cell containing them.  The cells are as wide as the cluster size, so
+ * only the points in the 3x3 block of cells around a point need to be checked, and the index needs memory
+ * proportional to the number of points regardless of the extent of the AOI.
+ */
+class PointGrid
+{
+public:
+   PointGrid(const PointsType& points, double clusterSize) :
+      mPoints(points),
+      mClusterSize(clusterSize),
+      mCellSize(std::max(1, static_cast<int>(ceil(clusterSize)))),
+      mMinX(0),
+      mMinY(0),
+      mColumns(1)
+   {
+      if (points.empty())
+      {
+         return;
+      }
+
+      int maxX = points.front().x();
+      mMinX = maxX;
+      mMinY = points.front().y();
+      for (int index = 0; index < points.size(); ++index)
+      {
+         mMinX = std::min(mMinX, points[index].x());
+         mMinY = std::min(mMinY, points[index].y());
+         maxX = std::max(maxX, points[index].x());
+      }
+      mColumns = (maxX - mMinX) / mCellSize + 1;
+
+      // Sorting the pairs also keeps the points of each cell in ascending order
+      mCells.reserve(points.size());
+      for (int index = 0; index < points.size(); ++index)
+      {
+         mCells.push_back(std::make_pair(getCell(points[index]), index));
+      }
+      std::sort(mCells.begin(), mCells.end());
+   }
+
+   /**
+    * Finds the points within the cluster size of a point, including the point itself.
+    */
+   void getNeighbors(int index, std::vector<int>& neighbors) const
+   {
+      neighbors.clear();
+      const QPoint& point = mPoints[index];
+      int cellX = (point.x() - mMinX) / mCellSize;
+      int cellY = (point.y() - mMinY) / mCellSize;
+
+      // The three cells in each row of the block have consecutive keys
+      int64_t firstColumn = std::max(cellX - 1, 0);
+      int64_t lastColumn = std::min(cellX + 1, mColumns - 1);
+      for (int64_t row = std::max(cellY - 1, 0); row <= cellY + 1; ++row)
+      {
+         std::vector<std::pair<int64_t, int> >::const_iterator cell = std::lower_bound(mCells.begin(), mCells.end(),
+            std::make_pair(row * mColumns + firstColumn, -1));
+         int64_t lastCell = row * mColumns + lastColumn;
+         for (; cell != mCells.end() && cell->first <= lastCell; ++cell)
+         {
+            QPoint difference = mPoints[cell->second] - point;
+            double distance = sqrt(static_cast<double>(difference.x()) * difference.x() +
+               static_cast<double>(difference.y()) * difference.y());
+            // if the pairwise distance is larger than the cluster size,
+            // these two points will never be in a cluster together
+            if (distance <= mClusterSize || cell->second == index)
+            {
+               neighbors.push_back(cell->second);
+            }
+         }
+      }
+   }
+
+private:
+   int64_t getCell(const QPoint& point) const
+   {
+      return static_cast<int64_t>((point.y() - mMinY) / mCellSize) * mColumns + (point.x() - mMinX) / mCellSize;
+   }
+
+   const PointsType& mPoints;
+   double mClusterSize;
+   int mCellSize;
+   int mMinX;
+   int mMinY;
+   int mColumns;
+   std::vector<std::pair<int64_t, int> > mCells;
+};
+
+struct NeighborCountInput
+{
+   NeighborCountInput() :
+      mpGrid(NULL),
+      mpCounts(NULL),
+      mpAbortFlag(NULL)
+   {}
+
+   const PointGrid* mpGrid;
+   std::vector<int>* mpCounts;
+   const bool* mpAbortFlag;
+};
+
+/**
+ * Counts the points which would be clustered with each candidate seed.
+ */
+class NeighborCountThread : public mta::AlgorithmThread
+{
+public:
+   NeighborCountThread(const NeighborCountInput& input, int threadCount, int threadIndex,
+      mta::ThreadReporter& reporter) :
+      mta::AlgorithmThread(threadIndex, reporter),
+      mInput(input),
+      mRange(getThreadRange(threadCount, static_cast<int>(input.mpCounts->size())))
+   {}
+
+   void run()
+   {
+      std::vector<int> neighbors;
+      int oldPercentDone = -1;
+      for (int index = mRange.mFirst; index <= mRange.mLast; ++index)
+      {
+         int percentDone = mRange.computePercent(index);
+         if (percentDone > oldPercentDone)
+         {
+            oldPercentDone = percentDone;
+            getReporter().reportProgress(getThreadIndex(), percentDone);
+            if (mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag)
+            {
+               return;
+            }
+         }
+
+         mInput.mpGrid->getNeighbors(index, neighbors);
+         (*mInput.mpCounts)[index] = static_cast<int>(neighbors.size());
+      }
+      getReporter().reportProgress(getThreadIndex(), 100);
+   }
+
+private:
+   NeighborCountThread& operator=(const NeighborCountThread& rhs);
+
+   const NeighborCountInput& mInput;
+   mta::AlgorithmThread::Range mRange;
+};
+
+struct NeighborCountOutput
+{
+   bool compileOverallResults(const std::vector<NeighborCountThread*>& threads)
+   {
+      return true;
+   }
+};
+
+// Candidate seeds are ordered by their count, then by the lowest point index
+typedef std::pair<int, int> CandidateType;
+typedef std::priority_queue<CandidateType> CandidateQueue;
+
+void pushCandidate(CandidateQueue& candidates, const std::vector<int>& counts, int index)
+{
+   candidates.push(std::make_pair(counts[index], -index));
+}
 }
 
 QtCluster::QtCluster()
@@ -179,11 +338,6 @@ bool QtCluster::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
          progress.report("No points in the AOI.", 0, ERRORS, true);
          return false;
       }
-      if (pOrigMaskIt->getCount() > sqrt(static_cast<double>(std::numeric_limits<unsigned int>::max())))
-      {
-         progress.report("Too many points in the AOI.", 0, ERRORS, true);
-         return false;
-      }
    }
    else
    {
@@ -192,20 +346,6 @@ bool QtCluster::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
          progress.report("No points in the AOI.", 0, ERRORS, true);
          return false;
       }
-      if (pOrigMask->getCount() > sqrt(static_cast<double>(std::numeric_limits<unsigned int>::max())))
-      {
-         progress.report("Too many points in the AOI.", 0, ERRORS, true);
-         return false;
-      }
-   }
-   if (!isBatch() && pOrigMask->getCount() > 10000)
-   {
-      if (Service<DesktopServices>()->showMessageBox("Warning", "The AOI contains a large number of points. "
-         "Clustering may take a long time. Would you like to continue?", "Yes", "No") == 1)
-      {
-         progress.report("Aborted by user", 0, ABORT, true);
-         return false;
-      }
    }
 
    std::string resultName;
@@ -346,48 +486,39 @@ bool QtCluster::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
    }
    delete pOrigMaskIt;
    /**********
-    * Calculate in range points
+    * Count the points in range of each point
     **********/
-   MatrixType inRange(points.size(), points.size());
-   numToIncPercentage = points.size() / 99;
-   if (numToIncPercentage <= 0)
-   {
-      numToIncPercentage = 1;
-   }
-   else if (numToIncPercentage > 100)
-   {
-      numToIncPercentage = 100;
-   }
-   progress.report("Calculating distance matrix", 0, NORMAL);
-   for (int start = 0; start < points.size(); ++start)
+   PointGrid grid(points, clusterSize);
+   int total = points.size();
+   std::vector<int> counts(total, 0);
+   NeighborCountInput countInput;
+   countInput.mpGrid = &grid;
+   countInput.mpCounts = &counts;
+   countInput.mpAbortFlag = &mAborted;
+   NeighborCountOutput countOutput;
+   mta::ProgressObjectReporter reporter("Calculating neighborhoods", progress.getCurrentProgress());
+   mta::MultiThreadedAlgorithm<NeighborCountInput, NeighborCountOutput, NeighborCountThread>
+      countAlg(mta::getNumRequiredThreads(total), countInput, countOutput, &reporter);
+   if (countAlg.run() != mta::SUCCESS || isAborted())
    {
-      inRange(start, start) = 1;
-      if (start % numToIncPercentage == 0)
-      {
-         if (isAborted())
-         {
-            progress.report("User aborted", 0, ABORT, true);
-            return false;
-         }
-         progress.report("Calculating distance matrix", 99 * start / points.size(), NORMAL);
-      }
-      for (int end = start+1; end < points.size(); ++end)
-      {
-         QPoint a = points[start];
-         QPoint b = points[end];
-         QPoint c = b - a;
-         double distance = sqrt(static_cast<double>(c.x()) * c.x() + c.y() * c.y());
-         // if the pairwise distance is larger than the cluster size,
-         // these two points will never be in a cluster together so
-         // we throw them out
-         inRange(start,end) = (distance <= clusterSize) ? 1 : 0;
-      }
+      progress.report("User aborted", 0, ABORT, true);
+      return false;
    }
 
    /**********
     * iterate until everything is clustered
     **********/
-   int total = points.size();
+   CandidateQueue candidates;
+   for (int index = 0; index < total; ++index)
+   {
+      pushCandidate(candidates, counts, index);
+   }
+
+   std::vector<char> chosen(total, 0);
+   std::vector<int> members;
+   std::vector<int> neighbors;
+   std::vector<int> touched;
+   std::vector<int> touchedCluster(total, 0);
    int pointsChosen = 0;
    int clusterNumber = 1;
    progress.report("Locating clusters", 0, NORMAL);
@@ -402,16 +533,20 @@ bool QtCluster::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
          .arg(clusterNumber-1).arg(total - pointsChosen).toStdString(),
          99 * pointsChosen / total, NORMAL);
 
+      // Counts only decrease, so candidates whose count has changed since they were queued are discarded
       int largest = -1;
       int largestCount = 0;
-      for (int row = 0; row < points.size(); ++row)
+      while (candidates.empty() == false)
       {
-         int tmpCount = sum(ublas::matrix_row<MatrixType>(inRange, row));
-         if (tmpCount > largestCount)
+         CandidateType candidate = candidates.top();
+         int index = -candidate.second;
+         if (chosen[index] == 0 && counts[index] == candidate.first)
          {
-            largest = row;
-            largestCount = tmpCount;
+            largest = index;
+            largestCount = candidate.first;
+            break;
          }
+         candidates.pop();
       }
       if (largestCount == 0)
       {
@@ -420,47 +555,79 @@ bool QtCluster::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList)
 
       LocationType centroid(0, 0);
 
-      ublas::vector<int> row(inRange.size1());
-      for (size_t col = 0; col < inRange.size1(); ++col)
+      grid.getNeighbors(largest, neighbors);
+      members.clear();
+      for (std::vector<int>::const_iterator neighbor = neighbors.begin(); neighbor != neighbors.end(); ++neighbor)
       {
-         row(col) = inRange(largest, col);
+         if (chosen[*neighbor] == 0)
+         {
+            members.push_back(*neighbor);
+            chosen[*neighbor] = 1;
+         }
       }
-      for (size_t col = 0; col < row.size(); ++col)
+
+      touched.clear();
+      for (size_t member = 0; member < members.size(); ++member)
       {
-         if (col % 100 == 0)
+         if (member % 100 == 0)
          {
             QApplication::processEvents();
          }
-         if (row(col) != 0)
+         int col = members[member];
+         ++pointsChosen;
+         centroid.mX += points[col].x();
+         centroid.mY += points[col].y();
+
+         // the remaining points near this one can no longer cluster with it
+         grid.getNeighbors(col, neighbors);
+         for (std::vector<int>::const_iterator neighbor = neighbors.begin(); neighbor != neighbors.end(); ++neighbor)
          {
-            ++pointsChosen;
-            centroid.mX += points[col].x();
-            centroid.mY += points[col].y();
+            if (chosen[*neighbor] == 0)
+            {
+               --counts[*neighbor];
+               if (touchedCluster[*neighbor] != clusterNumber)
+               {
+                  touchedCluster[*neighbor] = clusterNumber;
+                  touched.push_back(*neighbor);
+               }
+            }
+         }
 
-            for (size_t idx = 0; idx < inRange.size1(); ++idx)
+         if (displayType == PSEUDO)
+         {
+            pPseudoAcc->toPixel(points[col].y(), points[col].x());
+            if (!pPseudoAcc.isValid())
             {
-               inRange(col, idx) = 0;
+               progress.report("Unable to access pseudocolor layer.", 0, ERRORS, true);
+               return false;
             }
+            *reinterpret_cast<unsigned char*>(pPseudoAcc->getColumn()) = clusterNumber;
+         }
+      }
 
-            if (displayType == PSEUDO)
+      if (candidates.size() + touched.size() > 2 * static_cast<size_t>(total))
+      {
+         // Rebuild the queue once it is mostly stale so its size stays proportional to the number of points
+         candidates = CandidateQueue();
+         for (int index = 0; index < total; ++index)
+         {
+            if (chosen[index] == 0)
             {
-               pPseudoAcc->toPixel(points[col].y(), points[col].x());
-               if (!pPseudoAcc.isValid())
-               {
-                  progress.report("Unable to access pseudocolor layer.", 0, ERRORS, true);
-                  return false;
-               }
-               *reinterpret_cast<unsigned char*>(pPseudoAcc->getColumn()) = clusterNumber;
+               pushCandidate(candidates, counts, index);
             }
          }
       }
-      centroid.mX /= largestCount;
-      centroid.mY /= largestCount;
-      for (size_t idx = 0; idx < inRange.size1(); ++idx)
+      else
       {
-         inRange(largest, idx) = 0;
+         for (std::vector<int>::const_iterator index = touched.begin(); index != touched.end(); ++index)
+         {
+            pushCandidate(candidates, counts, *index);
+         }
       }
 
+      centroid.mX /= largestCount;
+      centroid.mY /= largestCount;
+
       // adjust the centroid to the center of a pixel
       centroid.mX += 0.5;
       centroid.mY += 0.5;
@@ -18,6 +18,7 @@
 #include "ApplicationServices.h"
 #include "BitMaskIterator.h"
 #include "ConfigurationSettings.h"
+#include "CovarianceCalculator.h"
 #include "DataAccessorImpl.h"
 #include "DimensionDescriptor.h"
 #include "EigenPlotDlg.h"
@@ -25,6 +26,7 @@
 #include "FileResource.h"
 #include "MatrixFunctions.h"
 #include "MessageLogResource.h"
+#include "MultiThreadedAlgorithm.h"
 #include "ObjectResource.h"
 #include "PCA.h"
 #include "PcaDlg.h"
@@ -54,411 +56,432 @@ T *GetPixelPtr(T *raw, int numCols, int numBands, int row, int col)
    return raw + numBands * (row *numCols + col);
 }
 
-template<class T>
-void ComputeFactoredCov(T *pData, RasterElement* pRaster, double **pMatrix,
-                        Progress *pProgress, const bool *pAbortFlag,
-                        int rowFactor, int columnFactor)
+// Intended for use with integer data types -- adds 0.5 for rounding.
+template <class T>
+void StorePcaRow(T* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
+   double minVal, double scaleFactor, int minOutputVal)
 {
-   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(pRaster->getDataDescriptor());
-   if (pDescriptor == NULL)
+   for (unsigned int col = 0; col < numCols; ++col)
    {
-      return;
+      *pPcaData = static_cast<T>(static_cast<int64_t>((*pCompValues - minVal) * scaleFactor + 0.5) + minOutputVal);
+      ++pCompValues;
+      pPcaData += numComponents;
    }
+}
 
-   unsigned int numRows = pDescriptor->getRowCount();
-   unsigned int numCols = pDescriptor->getColumnCount();
-   unsigned int numBands = pDescriptor->getBandCount();
-   unsigned int row, col;
-   unsigned int band1, band2;
-   unsigned int lCount = 0;
-   T *pPixel = NULL;
-   vector<double> averages(numBands, 0);
-   double* pAverage = &averages.front();
-
-   if (rowFactor < 1)
+template <>
+void StorePcaRow<float>(float* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
+   double minVal, double scaleFactor, int minOutputVal)
+{
+   for (unsigned int col = 0; col < numCols; ++col)
    {
-      rowFactor = 1;
+      *pPcaData = static_cast<float>((*pCompValues - minVal) * scaleFactor + minOutputVal);
+      ++pCompValues;
+      pPcaData += numComponents;
    }
-   if (columnFactor < 1)
+}
+
+template <>
+void StorePcaRow<double>(double* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
+   double minVal, double scaleFactor, int minOutputVal)
+{
+   for (unsigned int col = 0; col < numCols; ++col)
    {
-      columnFactor = 1;
+      *pPcaData = static_cast<double>((*pCompValues - minVal) * scaleFactor + minOutputVal);
+      ++pCompValues;
+      pPcaData += numComponents;
    }
+}
 
-   // calculate average spectrum
-   float progScale = 100.0f * static_cast<float>(rowFactor)/static_cast<float>(numRows);
-   FactoryResource<DataRequest> pRequest;
-   pRequest->setInterleaveFormat(BIP);
-   DataAccessor accessor = pRaster->getDataAccessor(pRequest.release());
-   for (row = 0; row < numRows; row += rowFactor)
-   {
-      VERIFYNRV(accessor.isValid());
-      if (pProgress != NULL)
+// Intended for use with integer data types -- adds 0.5 for rounding.
+template <class T>
+void StorePcaValue(T* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
+{
+   *pPcaData = static_cast<T>(static_cast<int64_t>((*pValue - *pMinVal) * (*pScaleFactor) + 0.5) + *pMinOutputVal);
+}
+
+template <>
+void StorePcaValue<float>(float* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
+{
+   *pPcaData = static_cast<float>((*pValue - *pMinVal) * (*pScaleFactor) + *pMinOutputVal);
+}
+
+template <>
+void StorePcaValue<double>(double* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
+{
+   *pPcaData = static_cast<double>((*pValue - *pMinVal) * (*pScaleFactor) + *pMinOutputVal);
+}
+
+namespace
+{
+   struct ProjectionInput
+   {
+      const RasterElement* mpRaster;
+      RasterElement* mpValuesRaster;
+      const BitMaskIterator* mpMask;
+      const bool* mpAbortFlag;
+      const double* mpCoefficients;
+      unsigned int mNumBands;
+      unsigned int mNumComponents;
+      int mFirstRow;
+      int mLastRow;
+      int mFirstColumn;
+      int mLastColumn;
+   };
+
+   /**
+    * Projects the pixels of a range of rows onto the principal components.
+    *
+    * Each row is read once and all components are computed from it.  The
+    * unscaled components are stored in the BIL values raster, which covers
+    * only the rows and columns being projected, and the range of each
+    * component is found so that the values can be scaled afterwards.
+    */
+   class ProjectionThread : public mta::AlgorithmThread
+   {
+   public:
+      ProjectionThread(const ProjectionInput& input, int threadCount, int threadIndex,
+         mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mRowRange(getThreadRange(threadCount, input.mLastRow - input.mFirstRow + 1)),
+         mFailed(false),
+         mMinValues(input.mNumComponents, numeric_limits<double>::max()),
+         mMaxValues(input.mNumComponents, -numeric_limits<double>::max())
+      {
+      }
+
+      void run()
       {
-         if ((pAbortFlag == NULL) || !(*pAbortFlag))
+         const RasterDataDescriptor* pDescriptor =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpRaster->getDataDescriptor());
+         if (pDescriptor == NULL)
          {
-            pProgress->updateProgress ("Computing Average Signature...", int(progScale*row), NORMAL);
-         }
-         else
-         {
-            break;
+            mFailed = true;
+            return;
          }
+
+         switchOnEncoding(pDescriptor->getDataType(), project, NULL, pDescriptor);
       }
-      for (col = 0; col < numCols; col += columnFactor)
+
+      bool isFailed() const
       {
-         ++lCount;
-         pPixel = reinterpret_cast<T*>(accessor->getColumn());
+         return mFailed;
+      }
 
-         for (band1 = 0; band1 < numBands; ++band1)
-         {
-            pAverage[band1] += *pPixel;
-            ++pPixel;
-         }
-         accessor->nextColumn();
+      const vector<double>& getMinValues() const
+      {
+         return mMinValues;
       }
-      accessor->nextRow();
-   }
 
-   // check if aborted
-   if ((pAbortFlag == NULL) || !(*pAbortFlag))
-   {
-      for (band1 = 0; band1 < numBands; ++band1)
+      const vector<double>& getMaxValues() const
       {
-         pAverage[band1] /= lCount;
+         return mMaxValues;
       }
 
-      // compute the covariance
-      FactoryResource<DataRequest> pRequest2;
-      pRequest2->setInterleaveFormat(BIP);
-      accessor = pRaster->getDataAccessor(pRequest2.release());
+   private:
+      ProjectionThread& operator=(const ProjectionThread& rhs);
 
-      for (row = 0; row < numRows; row += rowFactor)
+      template<typename T>
+      void project(T* pDummy, const RasterDataDescriptor* pDescriptor)
       {
-         VERIFYNRV(accessor.isValid());
-         if (pProgress != NULL)
+         if (mRowRange.mLast < mRowRange.mFirst)
+         {
+            return;
+         }
+
+         int firstRow = mInput.mFirstRow + mRowRange.mFirst;
+         int lastRow = mInput.mFirstRow + mRowRange.mLast;
+         FactoryResource<DataRequest> pRequest;
+         pRequest->setInterleaveFormat(BIP);
+         pRequest->setRows(pDescriptor->getActiveRow(firstRow), pDescriptor->getActiveRow(lastRow));
+         pRequest->setColumns(pDescriptor->getActiveColumn(mInput.mFirstColumn),
+            pDescriptor->getActiveColumn(mInput.mLastColumn));
+         DataAccessor accessor = mInput.mpRaster->getDataAccessor(pRequest.release());
+
+         const RasterDataDescriptor* pValuesDescriptor =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpValuesRaster->getDataDescriptor());
+         if (pValuesDescriptor == NULL)
+         {
+            mFailed = true;
+            return;
+         }
+
+         FactoryResource<DataRequest> pValuesRequest;
+         pValuesRequest->setInterleaveFormat(BIL);
+         pValuesRequest->setRows(pValuesDescriptor->getActiveRow(mRowRange.mFirst),
+            pValuesDescriptor->getActiveRow(mRowRange.mLast));
+         pValuesRequest->setWritable(true);
+         DataAccessor valuesAccessor = mInput.mpValuesRaster->getDataAccessor(pValuesRequest.release());
+
+         unsigned int numBands = mInput.mNumBands;
+         unsigned int numComponents = mInput.mNumComponents;
+         unsigned int numColumns = static_cast<unsigned int>(mInput.mLastColumn - mInput.mFirstColumn + 1);
+         vector<double> pixels(numColumns * numBands);
+         vector<unsigned char> selected(numColumns, 1);
+         for (int index = mRowRange.mFirst; index <= mRowRange.mLast; ++index)
          {
-            if ((pAbortFlag == NULL) || !(*pAbortFlag))
+            if (mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag)
             {
-               pProgress->updateProgress("Computing Covariance Matrix...", int(progScale * row), NORMAL);
+               return;
             }
-            else
+            getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(index));
+
+            int row = mInput.mFirstRow + index;
+            accessor->toPixel(row, mInput.mFirstColumn);
+            valuesAccessor->toPixel(index, 0);
+            if (accessor.isValid() == false || valuesAccessor.isValid() == false)
             {
-               break;
+               mFailed = true;
+               return;
             }
-         }
-         for (col = 0; col < numCols; col += columnFactor)
-         {
-            pPixel = reinterpret_cast<T*>(accessor->getColumn());
 
-            for (band2 = 0; band2 < numBands; ++band2)
+            // Convert the row once so the products below run over contiguous doubles
+            const T* pRow = reinterpret_cast<const T*>(accessor->getRow());
+            for (unsigned int column = 0; column < numColumns; ++column)
             {
-               pData = pPixel;
-               for (band1 = band2; band1 < numBands; ++band1)
+               if (mInput.mpMask != NULL)
                {
-                  pMatrix[band2][band1] += (*pData - pAverage[band1]) * (*pPixel - pAverage[band2]);
-                  ++pData;
+                  selected[column] = mInput.mpMask->getPixel(mInput.mFirstColumn + column, row) ? 1 : 0;
+               }
+
+               if (selected[column] != 0)
+               {
+                  const T* pPixel = pRow + column * numBands;
+                  double* pValues = &pixels[column * numBands];
+                  for (unsigned int band = 0; band < numBands; ++band)
+                  {
+                     pValues[band] = static_cast<double>(pPixel[band]);
+                  }
                }
-               ++pPixel;
             }
-            accessor->nextColumn();
+
+            // Multiply the coefficients by the pixels, storing the result with one row of values per component
+            double* pValuesRow = static_cast<double*>(valuesAccessor->getRow());
+            for (unsigned int component = 0; component < numComponents; ++component)
+            {
+               const double* pCoefficients = mInput.mpCoefficients + component * numBands;
+               double* pValues = pValuesRow + component * numColumns;
+               double minValue = mMinValues[component];
+               double maxValue = mMaxValues[component];
+               for (unsigned int column = 0; column < numColumns; ++column)
+               {
+                  if (selected[column] == 0)
+                  {
+                     continue;
+                  }
+
+                  const double* pPixel = &pixels[column * numBands];
+                  double value = 0.0;
+                  for (unsigned int band = 0; band < numBands; ++band)
+                  {
+                     value += pCoefficients[band] * pPixel[band];
+                  }
+
+                  pValues[column] = value;
+                  minValue = min(minValue, value);
+                  maxValue = max(maxValue, value);
+               }
+
+               mMinValues[component] = minValue;
+               mMaxValues[component] = maxValue;
+            }
          }
-         accessor->nextRow();
       }
-   }
 
-   // check if aborted
-   if ((pAbortFlag == NULL) || !(*pAbortFlag))
+      const ProjectionInput& mInput;
+      mta::AlgorithmThread::Range mRowRange;
+      bool mFailed;
+      vector<double> mMinValues;
+      vector<double> mMaxValues;
+   };
+
+   struct ProjectionOutput
    {
-      for (band2 = 0; band2 < numBands; ++band2)
+      ProjectionOutput(unsigned int numComponents) :
+         mMinValues(numComponents, numeric_limits<double>::max()),
+         mMaxValues(numComponents, -numeric_limits<double>::max())
       {
-         for (band1 = band2; band1 < numBands; ++band1)
-         {
-            pMatrix[band2][band1] /= lCount;
-         }
       }
 
-      for (band2 = 0; band2 < numBands; ++band2)
+      bool compileOverallResults(const vector<ProjectionThread*>& threads)
       {
-         for (band1 = band2 + 1; band1 < numBands; ++band1)
+         bool success = true;
+         for (vector<ProjectionThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
          {
-            pMatrix[band1][band2] = pMatrix[band2][band1];
+            success = success && ((*iter)->isFailed() == false);
+            const vector<double>& minValues = (*iter)->getMinValues();
+            const vector<double>& maxValues = (*iter)->getMaxValues();
+            for (size_t component = 0; component < mMinValues.size(); ++component)
+            {
+               mMinValues[component] = min(mMinValues[component], minValues[component]);
+               mMaxValues[component] = max(mMaxValues[component], maxValues[component]);
+            }
          }
-      }
-   }
 
-   if (pProgress != NULL)
-   {
-      if ((pAbortFlag == NULL) || !(*pAbortFlag))
-      {
-         pProgress->updateProgress("Covariance Matrix Complete", 100, NORMAL);
+         return success;
       }
-      else
-      {
-         pProgress->updateProgress("Aborted computing Covariance Matrix", 0, ABORT);
-      }
-   }
-}
 
-struct MaskInput
-{
-   RasterElement* mpRaster;
-   double** mpMatrix;
-   Progress* mpProgress;
-   const bool* mpAbortFlag;
-   const BitMask* mpMask;
-};
+      vector<double> mMinValues;
+      vector<double> mMaxValues;
+   };
 
-template<class T>
-void ComputeMaskedCov(T* pData, MaskInput* pInput)
-{
-   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>
-      (pInput->mpRaster->getDataDescriptor());
-   if (pDescriptor == NULL)
+   struct ScalingInput
    {
-      return;
-   }
+      const RasterElement* mpValuesRaster;
+      RasterElement* mpPcaRaster;
+      const BitMaskIterator* mpMask;
+      const bool* mpAbortFlag;
+      unsigned int mNumComponents;
+      int mFirstRow;
+      int mLastRow;
+      int mFirstColumn;
+      int mLastColumn;
+      EncodingType mOutputType;
+      const double* mpMinValues;
+      const double* mpScaleFactors;
+      int mMinOutputValue;
+   };
 
-   unsigned int numBands = pDescriptor->getBandCount();
-   unsigned int band1, band2;
-   unsigned int lCount = 0;
-   vector<double> averages(numBands, 0);
-   double* pAverage = &averages.front();
-   T *pPixel = NULL;
-
-   // calculate average spectrum
-   FactoryResource<DataRequest> pRequest;
-   pRequest->setInterleaveFormat(BIP);
-
-   DataAccessor accessor = pInput->mpRaster->getDataAccessor(pRequest->copy());
-   BitMaskIterator it(pInput->mpMask, pInput->mpRaster);
-   int numPixels = it.getCount();
-   float progScale = 100.0f / numPixels;
-   LocationType loc;
-   pPixel = reinterpret_cast<T*>(accessor->getColumn());
-   int mask = 0;
-   int progSave = 0;
-   if (it == it.end())
+   /**
+    * Scales the components stored by ProjectionThread into the PCA raster.
+    */
+   class ScalingThread : public mta::AlgorithmThread
    {
-      pInput->mpProgress->updateProgress("No pixels Selected", 0, ERRORS);
-   }
+   public:
+      ScalingThread(const ScalingInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mRowRange(getThreadRange(threadCount, input.mLastRow - input.mFirstRow + 1)),
+         mFailed(false)
+      {
+      }
 
-   while (it != it.end())
-   {
-      if (pInput->mpProgress != NULL &&
-          progSave != static_cast<int>(progScale * mask))
+      void run()
       {
-         if ((pInput->mpAbortFlag == NULL) || !(*pInput->mpAbortFlag))
+         if (mRowRange.mLast < mRowRange.mFirst)
          {
-            progSave = static_cast<int>(progScale * mask);
-            pInput->mpProgress->updateProgress("Computing Average Signature...",
-               progSave , NORMAL);
+            return;
          }
-         else
+
+         const RasterDataDescriptor* pValuesDescriptor =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpValuesRaster->getDataDescriptor());
+         const RasterDataDescriptor* pPcaDescriptor =
+            dynamic_cast<const RasterDataDescriptor*>(mInput.mpPcaRaster->getDataDescriptor());
+         if (pValuesDescriptor == NULL || pPcaDescriptor == NULL)
          {
-            break;
+            mFailed = true;
+            return;
          }
-      }
-      it.getPixelLocation(loc);
-      accessor->toPixel(loc.mY, loc.mX);
-      VERIFYNRV(accessor.isValid());
-      pPixel = reinterpret_cast<T*>(accessor->getColumn());
-      ++lCount;
-      for (band1 = 0; band1 < numBands; ++band1)
-      {
-         pAverage[band1] += *pPixel;
-         ++pPixel;
-      }
-      ++it;
-      ++mask;
-   }
 
-   // check if aborted
-   if ((pInput->mpAbortFlag == NULL) || !(*pInput->mpAbortFlag))
-   {
-      for (band1 = 0; band1 < numBands; ++band1)
-      {
-         pAverage[band1] /= lCount;
-      }
+         FactoryResource<DataRequest> pValuesRequest;
+         pValuesRequest->setInterleaveFormat(BIL);
+         pValuesRequest->setRows(pValuesDescriptor->getActiveRow(mRowRange.mFirst),
+            pValuesDescriptor->getActiveRow(mRowRange.mLast));
+         DataAccessor valuesAccessor = mInput.mpValuesRaster->getDataAccessor(pValuesRequest.release());
 
-      // calculate covariance matrix
-      accessor = pInput->mpRaster->getDataAccessor(pRequest->copy());
-      it.firstPixel();
-      mask = 0;
-      unsigned int numPixels = it.getCount();
-      float progScale = 100.0f / numPixels;
-      LocationType loc;
-      progSave = 0;
-      while (it != it.end())
-      {
-         if (pInput->mpProgress != NULL &&
-             progSave != static_cast<int>(progScale * mask))
+         int firstRow = mInput.mFirstRow + mRowRange.mFirst;
+         int lastRow = mInput.mFirstRow + mRowRange.mLast;
+         FactoryResource<DataRequest> pPcaRequest;
+         pPcaRequest->setInterleaveFormat(BIP);
+         pPcaRequest->setRows(pPcaDescriptor->getActiveRow(firstRow), pPcaDescriptor->getActiveRow(lastRow));
+         pPcaRequest->setColumns(pPcaDescriptor->getActiveColumn(mInput.mFirstColumn),
+            pPcaDescriptor->getActiveColumn(mInput.mLastColumn));
+         pPcaRequest->setWritable(true);
+         DataAccessor pcaAccessor = mInput.mpPcaRaster->getDataAccessor(pPcaRequest.release());
+
+         unsigned int numColumns = static_cast<unsigned int>(mInput.mLastColumn - mInput.mFirstColumn + 1);
+         size_t outputBytes = RasterUtilities::bytesInEncoding(mInput.mOutputType);
+         vector<unsigned char> selected(numColumns, 1);
+         for (int index = mRowRange.mFirst; index <= mRowRange.mLast; ++index)
          {
-            if ((pInput->mpAbortFlag == NULL) || !(*pInput->mpAbortFlag))
+            if (mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag)
             {
-               progSave = static_cast<int>(progScale * mask);
-               pInput->mpProgress->updateProgress("Computing Covariance Matrix...",
-                  progSave, NORMAL);
+               return;
             }
-            else
+            getReporter().reportProgress(getThreadIndex(), mRowRange.computePercent(index));
+
+            int row = mInput.mFirstRow + index;
+            valuesAccessor->toPixel(index, 0);
+            pcaAccessor->toPixel(row, mInput.mFirstColumn);
+            if (valuesAccessor.isValid() == false || pcaAccessor.isValid() == false)
             {
-               break;
+               mFailed = true;
+               return;
             }
-         }
-         it.getPixelLocation(loc);
-         accessor->toPixel(loc.mY, loc.mX);
-         VERIFYNRV(accessor.isValid());
-         pPixel = reinterpret_cast<T*>(accessor->getColumn());
-         for (band2 = 0; band2 < numBands; ++band2)
-         {
-            pData = pPixel;
-            for (band1 = band2; band1 < numBands; ++band1)
+
+            if (mInput.mpMask != NULL)
             {
-               pInput->mpMatrix[band2][band1] += (*pPixel-pAverage[band2]) * (*pData-pAverage[band1]);
-               ++pData;
+               for (unsigned int column = 0; column < numColumns; ++column)
+               {
+                  selected[column] = mInput.mpMask->getPixel(mInput.mFirstColumn + column, row) ? 1 : 0;
+               }
             }
-            ++pPixel;
+
+            storeRow(static_cast<char*>(pcaAccessor->getRow()), static_cast<double*>(valuesAccessor->getRow()),
+               selected, numColumns, outputBytes);
          }
-         ++mask;
-         ++it;
       }
-   }
 
-   // check if aborted
-   if ((pInput->mpAbortFlag == NULL) || !(*pInput->mpAbortFlag))
-   {
-      for (band2 = 0; band2 < numBands; ++band2)
+      bool isFailed() const
       {
-         for (band1 = band2; band1 < numBands; ++band1)
-         {
-            pInput->mpMatrix[band2][band1] /= lCount;
-         }
+         return mFailed;
       }
 
-      for (band2 = 0; band2 < numBands; ++band2)
+   private:
+      ScalingThread& operator=(const ScalingThread& rhs);
+
+      void storeRow(char* pPcaRow, double* pValuesRow, const vector<unsigned char>& selected,
+         unsigned int numColumns, size_t outputBytes)
       {
-         for (band1 = band2; band1 < numBands; ++band1)
+         unsigned int numComponents = mInput.mNumComponents;
+         for (unsigned int component = 0; component < numComponents; ++component)
          {
-            pInput->mpMatrix[band1][band2] = pInput->mpMatrix[band2][band1];
-         }
-      }
-   }
+            double* pValues = pValuesRow + component * numColumns;
+            double minValue = mInput.mpMinValues[component];
+            double scaleFactor = mInput.mpScaleFactors[component];
+            int minOutputValue = mInput.mMinOutputValue;
+            void* pPcaData = pPcaRow + component * outputBytes;
+            if (mInput.mpMask == NULL)
+            {
+               switchOnEncoding(mInput.mOutputType, StorePcaRow, pPcaData, pValues, numColumns, numComponents,
+                  minValue, scaleFactor, minOutputValue);
+               continue;
+            }
 
-   if (pInput->mpProgress != NULL)
-   {
-      if ((pInput->mpAbortFlag == NULL) || !(*pInput->mpAbortFlag))
-      {
-         pInput->mpProgress->updateProgress("Covariance Matrix Complete", 100, NORMAL);
-      }
-      else
-      {
-         pInput->mpProgress->updateProgress("Aborted computing Covariance Matrix", 0, ABORT);
+            // Pixels outside of the mask are left unchanged
+            for (unsigned int column = 0; column < numColumns; ++column)
+            {
+               if (selected[column] != 0)
+               {
+                  pPcaData = pPcaRow + (column * numComponents + component) * outputBytes;
+                  switchOnEncoding(mInput.mOutputType, StorePcaValue, pPcaData, &pValues[column], &minValue,
+                     &scaleFactor, &minOutputValue);
+               }
+            }
+         }
       }
-   }
-}
 
-template<class T>
-void ComputePcaValue(T *pData, double* pPcaValue, double *pCoefficients, unsigned int numBands)
-{
-   T* pInput = pData;
-   double* pCoef = pCoefficients;
-   *pPcaValue = 0.0;
-
-   for (unsigned int i = 0; i < numBands; ++i)
-   {
-      *pPcaValue += static_cast<double>(*pInput) * (*pCoef);
-      ++pInput;
-      ++pCoef;
-   }
-}
-
-template <class T>
-void ComputePcaRow(T* pData, double* pPcaData,  double* pCoefficients, unsigned int numCols, unsigned int numBands,
-                   double* pMinValue, double* pMaxValue)
-{
-   T* pColumn = pData;
-   T* pInput = NULL;
-   double* pValue = pPcaData;
-   double* pCoef = NULL;
+      const ScalingInput& mInput;
+      mta::AlgorithmThread::Range mRowRange;
+      bool mFailed;
+   };
 
-   for (unsigned int col = 0; col < numCols; ++col)
+   struct ScalingOutput
    {
-      *pValue = 0.0;
-      pInput = pColumn;
-      pCoef = pCoefficients;
-      for (unsigned int band = 0; band < numBands; ++band)
+      bool compileOverallResults(const vector<ScalingThread*>& threads)
       {
-         *pValue += (*pCoef * static_cast<double>(*pInput));
-         ++pCoef;
-         ++pInput;
-      }
-      if (*pValue > *pMaxValue)
-      {
-         *pMaxValue = *pValue;
-      }
+         for (vector<ScalingThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+         {
+            if ((*iter)->isFailed())
+            {
+               return false;
+            }
+         }
 
-      if (*pValue < *pMinValue)
-      {
-         *pMinValue = *pValue;
+         return true;
       }
-
-      ++pValue;
-      pColumn += numBands;
-   }
-}
-
-// Intended for use with integer data types -- adds 0.5 for rounding.
-template <class T>
-void StorePcaRow(T* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
-   double minVal, double scaleFactor, int minOutputVal)
-{
-   for (unsigned int col = 0; col < numCols; ++col)
-   {
-      *pPcaData = static_cast<T>(static_cast<int64_t>((*pCompValues - minVal) * scaleFactor + 0.5) + minOutputVal);
-      ++pCompValues;
-      pPcaData += numComponents;
-   }
-}
-
-template <>
-void StorePcaRow<float>(float* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
-   double minVal, double scaleFactor, int minOutputVal)
-{
-   for (unsigned int col = 0; col < numCols; ++col)
-   {
-      *pPcaData = static_cast<float>((*pCompValues - minVal) * scaleFactor + minOutputVal);
-      ++pCompValues;
-      pPcaData += numComponents;
-   }
-}
-
-template <>
-void StorePcaRow<double>(double* pPcaData, double* pCompValues, unsigned int numCols, unsigned int numComponents,
-   double minVal, double scaleFactor, int minOutputVal)
-{
-   for (unsigned int col = 0; col < numCols; ++col)
-   {
-      *pPcaData = static_cast<double>((*pCompValues - minVal) * scaleFactor + minOutputVal);
-      ++pCompValues;
-      pPcaData += numComponents;
-   }
-}
-
-// Intended for use with integer data types -- adds 0.5 for rounding.
-template <class T>
-void StorePcaValue(T* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
-{
-   *pPcaData = static_cast<T>(static_cast<int64_t>((*pValue - *pMinVal) * (*pScaleFactor) + 0.5) + *pMinOutputVal);
-}
-
-template <>
-void StorePcaValue<float>(float* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
-{
-   *pPcaData = static_cast<float>((*pValue - *pMinVal) * (*pScaleFactor) + *pMinOutputVal);
-}
-
-template <>
-void StorePcaValue<double>(double* pPcaData, double* pValue, double* pMinVal, double* pScaleFactor, int* pMinOutputVal)
-{
-   *pPcaData = static_cast<double>((*pValue - *pMinVal) * (*pScaleFactor) + *pMinOutputVal);
+   };
 }
 
 REGISTER_PLUGIN_BASIC(OpticksPCA, PCA);
@@ -1223,10 +1246,7 @@ bool PCA::createPCACube()
 
 bool PCA::computePCAwhole()
 {
-   QString message;
-
    const RasterDataDescriptor* pPcaDesc = dynamic_cast<RasterDataDescriptor*>(mpPCARaster->getDataDescriptor());
-   EncodingType pcaDataType = pPcaDesc->getDataType();
    unsigned int pcaNumRows = pPcaDesc->getRowCount();
    unsigned int pcaNumCols = pPcaDesc->getColumnCount();
    unsigned int pcaNumBands = pPcaDesc->getBandCount();
@@ -1242,21 +1262,6 @@ bool PCA::computePCAwhole()
       return false;
    }
 
-   FactoryResource<DataRequest> pBipRequest;
-   pBipRequest->setInterleaveFormat(BIP);
-   DataAccessor pcaAccessor = mpPCARaster->getDataAccessor(pBipRequest->copy());
-   if (!pcaAccessor.isValid())
-   {
-      mMessage = "PCA could not obtain an accessor the PCA RasterElement";
-      if (mpProgress != NULL)
-      {
-         mpProgress->updateProgress(mMessage, 0, ERRORS);
-      }
-
-      mpStep->finalize(Message::Failure, mMessage);
-      return false;
-   }
-
    const RasterDataDescriptor* pOrigDescriptor = dynamic_cast<const RasterDataDescriptor*>
       (mpRaster->getDataDescriptor());
    if (pOrigDescriptor == NULL)
@@ -1284,147 +1289,7 @@ bool PCA::computePCAwhole()
       return false;
    }
 
-   // Initialize progress bar variables
-   int currentProgress = 0;
-
-   void* pPCAData = NULL;
-   void* pOrigData = NULL;
-
-   DataAccessor origAccessor = mpRaster->getDataAccessor(pBipRequest->copy());
-   if (!origAccessor.isValid())
-   {
-      mMessage = "Could not get the pixels in the original cube!";
-      if (mpProgress != NULL)
-      {
-         mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
-      }
-
-      mpStep->finalize(Message::Failure, mMessage);
-      return false;
-   }
-
-   // Set the PCA cube data values
-   double min = 0.0;
-   double max = 0.0;
-   double scalefactor = 0.0;
-
-   string compValuesName = "PcaComponentValues";
-   RasterElement* pOldComponentValues = dynamic_cast<RasterElement*>(
-      Service<ModelServices>()->getElement(compValuesName, TypeConverter::toString<RasterElement>(), mpRaster));
-   if (pOldComponentValues != NULL)
-   {
-      VERIFY(Service<ModelServices>()->destroyElement(pOldComponentValues));
-   }
-
-   ModelResource<RasterElement> pComponentValues(RasterUtilities::createRasterElement(compValuesName,
-      mNumRows, mNumColumns, FLT8BYTES, true, mpRaster));
-   if (pComponentValues.get() == NULL)
-   {
-      mMessage = "Out of memory";
-      if (mpProgress != NULL)
-      {
-         mpProgress->updateProgress(mMessage, 0, ERRORS);
-      }
-
-      mpStep->finalize(Message::Failure, mMessage);
-      return false;
-   }
-
-   FactoryResource<DataRequest> pBipWritableRequest;
-   pBipWritableRequest->setWritable(true);
-   pBipWritableRequest->setInterleaveFormat(BIP);
-
-   unsigned int comp = 0;
-   unsigned int row = 0;
-   unsigned int band = 0;
-   double* pValues = NULL;
-   vector<double> coefficients(mNumBands, 0);
-   double* pCoefficients = &coefficients.front();
-   int progSave = 0;
-   for (comp = 0; comp < mNumComponentsToUse; ++comp)
-   {
-      origAccessor = mpRaster->getDataAccessor(pBipRequest->copy());
-
-      DataAccessor compValAccessor = pComponentValues->getDataAccessor(pBipWritableRequest->copy());
-      for (band = 0; band < mNumBands; ++band)
-      {
-         pCoefficients[band] = mpMatrixValues[band][comp];
-      }
-      min = numeric_limits<double>::max();
-      max = numeric_limits<double>::min();
-      for (row = 0; row < mNumRows; ++row)
-      {
-         VERIFY(origAccessor.isValid());
-         pOrigData = origAccessor->getRow();
-         VERIFY(compValAccessor.isValid());
-         pValues = reinterpret_cast<double*>(compValAccessor->getRow());
-         switchOnEncoding(eDataType, ComputePcaRow, pOrigData, pValues,
-            pCoefficients, mNumColumns, mNumBands, &min, &max);
-         origAccessor->nextRow();
-         compValAccessor->nextRow();
-      }
-
-      // check if aborted
-      if (!isAborted())
-      {
-         // scale component values and save in pPCACube -- need the int64_t cast to prevent overflow/underflow
-         scalefactor = static_cast<double>(static_cast<int64_t>(mMaxScaleValue) - mMinScaleValue) / (max - min);
-
-         FactoryResource<DataRequest> pPcaRequest;
-         pPcaRequest->setBands(pPcaDesc->getActiveBand(comp), pPcaDesc->getActiveBand(comp));
-         pPcaRequest->setWritable(true);
-         DataAccessor pcaAccessor = mpPCARaster->getDataAccessor(pPcaRequest.release());
-         if (!pcaAccessor.isValid())
-         {
-            mMessage = "Could not get the pixels in the PCA cube!";
-            if (mpProgress != NULL)
-            {
-               mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
-            }
-
-            mpStep->finalize(Message::Failure, mMessage);
-            return false;
-         }
-
-         compValAccessor = pComponentValues->getDataAccessor(pBipRequest->copy());
-         for (row = 0; row < mNumRows; ++row)
-         {
-            VERIFY(pcaAccessor.isValid());
-            pPCAData = pcaAccessor->getRow();
-            VERIFY(compValAccessor.isValid());
-            pValues = reinterpret_cast<double*>(compValAccessor->getRow());
-            switchOnEncoding(mOutputDataType, StorePcaRow, pPCAData, pValues, pcaNumCols, pcaNumBands,
-               min, scalefactor, mMinScaleValue);
-            pcaAccessor->nextRow();
-            compValAccessor->nextRow();
-
-            if (isAborted())
-            {
-               break;
-            }
-         }
-
-         currentProgress = 100 * (comp + 1) / mNumComponentsToUse;
-         if (mpProgress != NULL && currentProgress != progSave)
-         {
-            progSave = currentProgress;
-            mpProgress->updateProgress("Generating scaled PCA data cube...", currentProgress, NORMAL);
-         }
-      }
-   }
-
-   if (isAborted())
-   {
-      mpProgress->updateProgress("PCA aborted!", currentProgress, ABORT);
-      mpStep->finalize(Message::Abort);
-      return false;
-   }
-   if (mpProgress != NULL)
-   {
-      mpProgress->updateProgress("PCA computations complete!", 100, NORMAL);
-   }
-
-   return true;
+   return projectComponents(NULL);
 }
 
 bool PCA::computePCAaoi()
@@ -1470,201 +1335,156 @@ bool PCA::computePCAaoi()
       return false;
    }
 
-   // Initialize progress bar variables
-   int currentProgress = 0;
-
-   void* pPCAData = NULL;
-   void* pOrigData = NULL;
+   return projectComponents(mpAoiBitMask);
+}
 
-   // Set the PCA cube data values
-   double min = 0.0;
-   double max = 0.0;
-   double scalefactor = 0.0;
+bool PCA::projectComponents(const BitMask* pMask)
+{
    int x1 = 0;
    int y1 = 0;
    int x2 = 0;
    int y2 = 0;
-   BitMaskIterator it(mpAoiBitMask, mpRaster);
+   BitMaskIterator it(pMask, mpRaster);
    it.getBoundingBox(x1, y1, x2, y2);
+   if (x2 < x1 || y2 < y1)
+   {
+      mMessage = "There are no pixels to project onto the principal components.";
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress(mMessage, 0, ERRORS);
+      }
+
+      mpStep->finalize(Message::Failure, mMessage);
+      return false;
+   }
+
+   // Store the coefficients of each component contiguously
+   vector<double> coefficients(mNumComponentsToUse * mNumBands);
+   for (unsigned int comp = 0; comp < mNumComponentsToUse; ++comp)
+   {
+      for (unsigned int band = 0; band < mNumBands; ++band)
+      {
+         coefficients[comp * mNumBands + band] = mpMatrixValues[band][comp];
+      }
+   }
 
-   int numRows = y2 - y1 + 1;
-   int numCols = x2 - x1 + 1;
+   // The unscaled components are staged so that the source is only read once
+   const RasterDataDescriptor* pPcaDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpPCARaster->getDataDescriptor());
+   VERIFY(pPcaDescriptor != NULL);
 
    string compValuesName = "PcaComponentValues";
    RasterElement* pOldComponentValues = dynamic_cast<RasterElement*>(
-      Service<ModelServices>()->getElement(compValuesName, TypeConverter::toString<RasterElement>(), mpRaster));
+      mpModel->getElement(compValuesName, TypeConverter::toString<RasterElement>(), mpRaster));
    if (pOldComponentValues != NULL)
    {
-      VERIFY(Service<ModelServices>()->destroyElement(pOldComponentValues));
+      VERIFY(mpModel->destroyElement(pOldComponentValues));
    }
 
    ModelResource<RasterElement> pComponentValues(RasterUtilities::createRasterElement(compValuesName,
-      numRows, numCols, FLT8BYTES, true, mpRaster));
+      y2 - y1 + 1, x2 - x1 + 1, mNumComponentsToUse, FLT8BYTES, BIL,
+      pPcaDescriptor->getProcessingLocation() == IN_MEMORY, mpRaster));
    if (pComponentValues.get() == NULL)
    {
-      mMessage = "Out of memory";
+      mMessage = "Unable to create a raster element for the PCA component values!";
       if (mpProgress != NULL)
       {
-         mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
+         mpProgress->updateProgress(mMessage, 0, ERRORS);
       }
 
       mpStep->finalize(Message::Failure, mMessage);
       return false;
    }
 
-   int comp = 0;
-   int band = 0;
-   vector<double> coefficients(mNumBands, 0);
-   double* pCoefficients = &coefficients.front();
-   double* pTempVal = NULL;
-   int progSave = 0;
-   for (comp = 0; comp < static_cast<int>(mNumComponentsToUse); ++comp)
-   {
-      FactoryResource<DataRequest> pRequest;
-      pRequest->setInterleaveFormat(BIP);
-      pRequest->setRows(pOrigDescriptor->getActiveRow(y1), pOrigDescriptor->getActiveRow(y2));
-      pRequest->setColumns(pOrigDescriptor->getActiveColumn(x1), pOrigDescriptor->getActiveColumn(x2));
-      pRequest->setBands(pOrigDescriptor->getActiveBand(comp), pOrigDescriptor->getActiveBand(comp));
-      DataAccessor accessor = mpRaster->getDataAccessor(pRequest.release());
-      if (!accessor.isValid())
+   ProjectionInput input;
+   input.mpRaster = mpRaster;
+   input.mpValuesRaster = pComponentValues.get();
+   input.mpMask = (pMask == NULL ? NULL : &it);
+   input.mpAbortFlag = &mAborted;
+   input.mpCoefficients = &coefficients.front();
+   input.mNumBands = mNumBands;
+   input.mNumComponents = mNumComponentsToUse;
+   input.mFirstRow = y1;
+   input.mLastRow = y2;
+   input.mFirstColumn = x1;
+   input.mLastColumn = x2;
+   unsigned int threadCount = mta::getNumRequiredThreads(y2 - y1 + 1);
+
+   // The range of each component is needed to scale the values that are stored
+   ProjectionOutput range(mNumComponentsToUse);
+   {
+      mta::ProgressObjectReporter reporter("Computing the PCA components...", mpProgress);
+      mta::MultiThreadedAlgorithm<ProjectionInput, ProjectionOutput, ProjectionThread>
+         algorithm(threadCount, input, range, &reporter);
+      if (algorithm.run() != mta::SUCCESS && isAborted() == false)
       {
          mMessage = "Could not get the pixels in the original cube!";
          if (mpProgress != NULL)
          {
-            mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
+            mpProgress->updateProgress(mMessage, 0, ERRORS);
          }
 
          mpStep->finalize(Message::Failure, mMessage);
          return false;
       }
+   }
 
-      FactoryResource<DataRequest> pWritableRequest;
-      pWritableRequest->setWritable(true);
-      DataAccessor compValAccessor = pComponentValues->getDataAccessor(pWritableRequest.release());
-
-      for (band = 0; band < static_cast<int>(mNumBands); ++band)
+   if (isAborted() == false)
+   {
+      // need the int64_t cast to prevent overflow/underflow
+      vector<double> scaleFactors(mNumComponentsToUse);
+      for (unsigned int comp = 0; comp < mNumComponentsToUse; ++comp)
       {
-         pCoefficients[band] = mpMatrixValues[band][comp];
+         scaleFactors[comp] = static_cast<double>(static_cast<int64_t>(mMaxScaleValue) - mMinScaleValue) /
+            (range.mMaxValues[comp] - range.mMinValues[comp]);
       }
-      min = numeric_limits<double>::max();
-      max = numeric_limits<double>::min();
 
-      it.firstPixel();
-      LocationType loc;
+      ScalingInput scalingInput;
+      scalingInput.mpValuesRaster = pComponentValues.get();
+      scalingInput.mpPcaRaster = mpPCARaster;
+      scalingInput.mpMask = input.mpMask;
+      scalingInput.mpAbortFlag = &mAborted;
+      scalingInput.mNumComponents = mNumComponentsToUse;
+      scalingInput.mFirstRow = y1;
+      scalingInput.mLastRow = y2;
+      scalingInput.mFirstColumn = x1;
+      scalingInput.mLastColumn = x2;
+      scalingInput.mOutputType = mOutputDataType;
+      scalingInput.mpMinValues = &range.mMinValues.front();
+      scalingInput.mpScaleFactors = &scaleFactors.front();
+      scalingInput.mMinOutputValue = mMinScaleValue;
 
-      while (it != it.end())
+      ScalingOutput output;
+      mta::ProgressObjectReporter reporter("Generating scaled PCA data cube...", mpProgress);
+      mta::MultiThreadedAlgorithm<ScalingInput, ScalingOutput, ScalingThread>
+         algorithm(threadCount, scalingInput, output, &reporter);
+      if (algorithm.run() != mta::SUCCESS && isAborted() == false)
       {
-         it.getPixelLocation(loc);
-         accessor->toPixel(loc.mY, loc.mX);
-         compValAccessor->toPixel(loc.mY - y1, loc.mX - x1);
-         VERIFY(accessor.isValid());
-         VERIFY(compValAccessor.isValid());
-
-         pTempVal = reinterpret_cast<double*>(compValAccessor->getColumn());
-         pOrigData = accessor->getColumn();
-         if (pOrigData == NULL)
-         {
-               mMessage = "Could not get the pixels in the Original cube!";
-            if (mpProgress != NULL)
-            {
-               mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
-            }
-
-            mpStep->finalize(Message::Failure, mMessage);
-            return false;
-         }
-
-         switchOnEncoding(eDataType, ComputePcaValue, pOrigData, pTempVal, pCoefficients, mNumBands);
-
-         if (*pTempVal > max)
-         {
-            max = *pTempVal;
-         }
-         if (*pTempVal < min)
-         {
-            min = *pTempVal;
-         }
-         if (isAborted())
-         {
-            break;
-         }
-          ++it;
-      }
-
-      if (!isAborted())
-      {
-         // scale component values and save in pPCACube -- need the int64_t cast to prevent overflow/underflow
-         scalefactor = static_cast<double>(static_cast<int64_t>(mMaxScaleValue) - mMinScaleValue) / (max - min);
-
-         FactoryResource<DataRequest> pPcaRequest;
-         pPcaRequest->setRows(pPcaDescriptor->getActiveRow(y1), pPcaDescriptor->getActiveRow(y2));
-         pPcaRequest->setColumns(pPcaDescriptor->getActiveColumn(x1), pPcaDescriptor->getActiveColumn(x2));
-         pPcaRequest->setBands(pPcaDescriptor->getActiveBand(comp), pPcaDescriptor->getActiveBand(comp));
-         pPcaRequest->setWritable(true);
-         DataAccessor pcaAccessor = mpPCARaster->getDataAccessor(pPcaRequest.release());
-
-         if (!pcaAccessor.isValid())
-         {
-            mMessage = "Could not get the pixels in the PCA cube!";
-            if (mpProgress != NULL)
-            {
-               mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
-            }
-
-            mpStep->finalize(Message::Failure, mMessage);
-            return false;
-         }
-
-         it.firstPixel();
-         compValAccessor = pComponentValues->getDataAccessor();
-         while (it != it.end())
-         {
-            it.getPixelLocation(loc);
-            pcaAccessor->toPixel(loc.mY, loc.mX);
-            compValAccessor->toPixel(loc.mY - y1, loc.mX - x1);
-            VERIFY(pcaAccessor.isValid());
-            VERIFY(compValAccessor.isValid());
-            pPCAData = pcaAccessor->getColumn();
-            pTempVal = reinterpret_cast<double*>(compValAccessor->getColumn());
-            if (pPCAData == NULL)
-            {
-               mMessage = "Could not get the pixels in the PCA cube!";
-               if (mpProgress != NULL)
-               {
-                  mpProgress->updateProgress(mMessage, currentProgress, ERRORS);
-               }
-
-               mpStep->finalize(Message::Failure, mMessage);
-               return false;
-            }
-
-            switchOnEncoding(mOutputDataType, StorePcaValue, pPCAData, pTempVal, &min, &scalefactor, &mMinScaleValue);
-            ++it;
-         }
-         if (isAborted())
+         mMessage = "Could not get the pixels in the PCA cube!";
+         if (mpProgress != NULL)
          {
-            break;
+            mpProgress->updateProgress(mMessage, 0, ERRORS);
          }
-      }
 
-      currentProgress = 100 * (comp + 1) / mNumComponentsToUse;
-      if (mpProgress != NULL && currentProgress != progSave)
-      {
-         progSave = currentProgress;
-         mpProgress->updateProgress("Generating scaled PCA data cube...", currentProgress, NORMAL);
+         mpStep->finalize(Message::Failure, mMessage);
+         return false;
       }
    }
 
    if (isAborted())
    {
-      mpProgress->updateProgress("PCA aborted!", currentProgress, ABORT);
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress("PCA aborted!", 0, ABORT);
+      }
+
       mpStep->finalize(Message::Abort);
       return false;
    }
 
    if (mpProgress != NULL)
    {
-      mpProgress->updateProgress("PCA computations complete!", 99, NORMAL);
+      mpProgress->updateProgress("PCA computations complete!", 100, NORMAL);
    }
 
    return true;
@@ -2171,32 +1991,14 @@ bool PCA::getStatistics(vector<string> aoiList)
 
 bool PCA::computeCovarianceMatrix(QString aoiName, int rowSkip, int colSkip)
 {
-   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
-   if (pDescriptor == NULL)
+   if ((rowSkip < 1) || (colSkip < 1))
    {
       return false;
    }
 
-   void* pData = NULL;
-
-   if (aoiName.isEmpty())
-   {
-      if ((rowSkip < 1) || (colSkip < 1))
-      {
-         return false;
-      }
-
-      switchOnEncoding(pDescriptor->getDataType(), ComputeFactoredCov,
-                        pData, mpRaster, mpMatrixValues, mpProgress,
-                        &mAborted, rowSkip, colSkip);
-   }
-   else  // compute over AOI
+   const BitMask* pMask = NULL;
+   if (aoiName.isEmpty() == false)
    {
-      MaskInput input;
-      input.mpMatrix = mpMatrixValues;
-      input.mpRaster = mpRaster;
-      input.mpProgress = mpProgress;
-      input.mpAbortFlag = &mAborted;
       AoiElement* pAoi = getAoiElement(aoiName.toStdString());
       if (pAoi == NULL)
       {
@@ -2209,8 +2011,8 @@ bool PCA::computeCovarianceMatrix(QString aoiName, int rowSkip, int colSkip)
          mpStep->finalize(Message::Failure, mMessage);
          return false;
       }
-      input.mpMask = pAoi->getSelectedPoints();
-      BitMaskIterator it(input.mpMask, mpRaster);
+      pMask = pAoi->getSelectedPoints();
+      BitMaskIterator it(pMask, mpRaster);
 
       // check if AOI has any points selected
       if (it.getCount() < 2)
@@ -2229,13 +2031,15 @@ bool PCA::computeCovarianceMatrix(QString aoiName, int rowSkip, int colSkip)
          }
          return false;
       }
-      switchOnEncoding(pDescriptor->getDataType(), ComputeMaskedCov, pData, &input);
    }
 
+   CovarianceCalculator calculator(mpRaster, pMask, rowSkip, colSkip);
+   bool success = calculator.calculate(mpProgress, "Computing Covariance Matrix...", &mAborted);
    if (isAborted())
    {
       if (mpProgress != NULL)
       {
+         mpProgress->updateProgress("Aborted computing Covariance Matrix", 0, ABORT);
          mpProgress->updateProgress("Processing Covariance matrix aborted", 100, NORMAL);
       }
 
@@ -2243,6 +2047,32 @@ bool PCA::computeCovarianceMatrix(QString aoiName, int rowSkip, int colSkip)
       return false;
    }
 
+   if (success == false)
+   {
+      mMessage = "Unable to compute the Covariance Matrix";
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress(mMessage, 0, ERRORS);
+      }
+
+      mpStep->finalize(Message::Failure, mMessage);
+      return false;
+   }
+
+   const vector<double>& covariance = calculator.getCovariance();
+   for (unsigned int band1 = 0; band1 < mNumBands; ++band1)
+   {
+      for (unsigned int band2 = 0; band2 < mNumBands; ++band2)
+      {
+         mpMatrixValues[band1][band2] = covariance[band1 * mNumBands + band2];
+      }
+   }
+
+   if (mpProgress != NULL)
+   {
+      mpProgress->updateProgress("Covariance Matrix Complete", 100, NORMAL);
+   }
+
    return true;
 }
 
@@ -66,6 +66,7 @@ private:
    bool writeOutPCAtransform(QString filename);
    bool readInPCAtransform(QString filename);
    bool computeCovarianceMatrix(QString aoiName = "", int rowSkip = 1, int colSkip = 1);
+   bool projectComponents(const BitMask* pMask);
    bool getStatistics(std::vector<std::string> aoiList);
    BitMask* mpAoiBitMask;
    bool mUseAoi;
@@ -7,8 +7,12 @@
  * http://www.gnu.org/licenses/lgpl.html
  */
 
+#include <algorithm>
+#include <limits>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <geotiff.h>
 #include <geovalues.h>
@@ -17,11 +21,15 @@
 
 #include "AppVersion.h"
 #include "AppVerify.h"
+#include "ConfigurationSettings.h"
 #include "DataAccessorImpl.h"
 #include "DimensionDescriptor.h"
 #include "DynamicObject.h"
+#include "FileResource.h"
+#include "Filename.h"
 #include "GeoTIFFExporter.h"
 #include "GeoTiffExportOptionsWidget.h"
+#include "InterleaveTranspose.h"
 #include "MessageLogResource.h"
 #include "OptionsTiffExporter.h"
 #include "PlugInArgList.h"
@@ -31,7 +39,10 @@
 #include "RasterElement.h"
 #include "RasterDataDescriptor.h"
 #include "RasterFileDescriptor.h"
+#include "RasterUtilities.h"
 #include "StringUtilities.h"
+#include "switchOnEncoding.h"
+#include "TiffBlockWriter.h"
 
 using namespace std;
 
@@ -58,6 +69,250 @@ namespace
       return SAMPLEFORMAT_VOID;
    }
 
+   unsigned short getTiffCompression(OptionsTiffExporter::CompressionMethod method)
+   {
+      switch (method)
+      {
+      case OptionsTiffExporter::PACKBITS_COMPRESSION:
+         return COMPRESSION_PACKBITS;
+      case OptionsTiffExporter::LZW_COMPRESSION:
+         return COMPRESSION_LZW;
+      case OptionsTiffExporter::DEFLATE_COMPRESSION:
+         return COMPRESSION_ADOBE_DEFLATE;
+      default:
+         break;
+      }
+      return COMPRESSION_NONE;
+   }
+
+   // Overviews of strips are reduced until both dimensions are no larger than this, and overviews of tiles
+   // are reduced until they fit in a single tile
+   const unsigned int OVERVIEW_MINIMUM_SIZE = 256;
+
+   template<typename T>
+   void averagePixels(const T* pFirst, const void* pSecond, unsigned int inputColumns, unsigned int samplesPerPixel,
+      void* pOutput)
+   {
+      const T* pSecondRow = reinterpret_cast<const T*>(pSecond);
+      T* pOutputRow = reinterpret_cast<T*>(pOutput);
+      unsigned int outputColumns = (inputColumns + 1) / 2;
+      for (unsigned int column = 0; column < outputColumns; ++column)
+      {
+         // The last column is repeated when there is an odd number of columns
+         unsigned int left = 2 * column * samplesPerPixel;
+         unsigned int right = min(2 * column + 1, inputColumns - 1) * samplesPerPixel;
+         for (unsigned int sample = 0; sample < samplesPerPixel; ++sample)
+         {
+            double average = 0.25 * (static_cast<double>(pFirst[left + sample]) + pFirst[right + sample] +
+               pSecondRow[left + sample] + pSecondRow[right + sample]);
+            if (numeric_limits<T>::is_integer)
+            {
+               average = floor(average + 0.5);
+            }
+
+            pOutputRow[column * samplesPerPixel + sample] = static_cast<T>(average);
+         }
+      }
+   }
+
+   /**
+    * One reduced resolution level of the exported image.
+    *
+    * Each pair of input rows is averaged into an output row, which is
+    * appended to a temporary file until the level is written to the TIFF file.
+    */
+   class OverviewLevel
+   {
+   public:
+      OverviewLevel(unsigned int inputColumns, unsigned int inputRows, unsigned int samplesPerPixel,
+         EncodingType dataType, const string& filename) :
+         mInputColumns(inputColumns),
+         mInputRows(inputRows),
+         mSamplesPerPixel(samplesPerPixel),
+         mDataType(dataType),
+         mRowsAdded(0),
+         mPendingRow(false),
+         mFailed(false),
+         mSpool(filename.c_str(), "w+b", true)
+      {
+         size_t pixelSize = static_cast<size_t>(samplesPerPixel) * RasterUtilities::bytesInEncoding(dataType);
+         mPending.resize(inputColumns * pixelSize);
+         mOutput.resize(getColumns() * pixelSize);
+      }
+
+      bool isValid() const
+      {
+         return mSpool.get() != NULL;
+      }
+
+      unsigned int getColumns() const
+      {
+         return (mInputColumns + 1) / 2;
+      }
+
+      unsigned int getRows() const
+      {
+         return (mInputRows + 1) / 2;
+      }
+
+      const void* addRow(const void* pRow)
+      {
+         if (mFailed == true)
+         {
+            return NULL;
+         }
+
+         ++mRowsAdded;
+         const void* pFirst = pRow;
+         if (mPendingRow == false)
+         {
+            // The last row is repeated when there is an odd number of rows
+            memcpy(&mPending[0], pRow, mPending.size());
+            if (mRowsAdded < mInputRows)
+            {
+               mPendingRow = true;
+               return NULL;
+            }
+         }
+         else
+         {
+            pFirst = &mPending[0];
+            mPendingRow = false;
+         }
+
+         switchOnEncoding(mDataType, averagePixels, pFirst, pRow, mInputColumns, mSamplesPerPixel, &mOutput[0]);
+         if (fwrite(&mOutput[0], 1, mOutput.size(), mSpool.get()) != mOutput.size())
+         {
+            mFailed = true;
+            return NULL;
+         }
+
+         return &mOutput[0];
+      }
+
+      bool isFailed() const
+      {
+         return mFailed;
+      }
+
+      bool rewind()
+      {
+         return mFailed == false && fseek(mSpool.get(), 0, SEEK_SET) == 0;
+      }
+
+      bool readRow(void* pRow)
+      {
+         return fread(pRow, 1, mOutput.size(), mSpool.get()) == mOutput.size();
+      }
+
+   private:
+      OverviewLevel(const OverviewLevel& rhs);
+      OverviewLevel& operator=(const OverviewLevel& rhs);
+
+      unsigned int mInputColumns;
+      unsigned int mInputRows;
+      unsigned int mSamplesPerPixel;
+      EncodingType mDataType;
+      unsigned int mRowsAdded;
+      bool mPendingRow;
+      bool mFailed;
+      vector<unsigned char> mPending;
+      vector<unsigned char> mOutput;
+      FileResource mSpool;
+   };
+
+   /**
+    * The reduced resolution levels of the exported image, each half the size of the previous level.
+    */
+   class OverviewPyramid
+   {
+   public:
+      OverviewPyramid(unsigned int columns, unsigned int rows, unsigned int samplesPerPixel, EncodingType dataType,
+         unsigned int minimumSize) :
+         mValid(true)
+      {
+         if (minimumSize == 0)
+         {
+            return;
+         }
+
+         const Filename* pTempPath = ConfigurationSettings::getSettingTempPath();
+         string tempPath;
+         if (pTempPath != NULL)
+         {
+            tempPath = pTempPath->getFullPathAndName();
+         }
+
+         while (columns > minimumSize || rows > minimumSize)
+         {
+            char* pTempFilename = tempnam(tempPath.c_str(), "GT");
+            if (pTempFilename == NULL)
+            {
+               mValid = false;
+               return;
+            }
+
+            string filename = pTempFilename;
+            free(pTempFilename);
+
+            OverviewLevel* pLevel = new OverviewLevel(columns, rows, samplesPerPixel, dataType, filename);
+            mLevels.push_back(pLevel);
+            if (pLevel->isValid() == false)
+            {
+               mValid = false;
+               return;
+            }
+
+            columns = pLevel->getColumns();
+            rows = pLevel->getRows();
+         }
+      }
+
+      ~OverviewPyramid()
+      {
+         for (vector<OverviewLevel*>::iterator iter = mLevels.begin(); iter != mLevels.end(); ++iter)
+         {
+            delete *iter;
+         }
+      }
+
+      bool isValid() const
+      {
+         return mValid;
+      }
+
+      unsigned int getLevelCount() const
+      {
+         return mLevels.size();
+      }
+
+      OverviewLevel& getLevel(unsigned int level)
+      {
+         return *mLevels[level];
+      }
+
+      bool addRow(const void* pRow)
+      {
+         // Each completed row of a level is passed on to the next level
+         for (vector<OverviewLevel*>::iterator iter = mLevels.begin(); iter != mLevels.end() && pRow != NULL; ++iter)
+         {
+            pRow = (*iter)->addRow(pRow);
+            if ((*iter)->isFailed() == true)
+            {
+               return false;
+            }
+         }
+
+         return true;
+      }
+
+   private:
+      OverviewPyramid(const OverviewPyramid& rhs);
+      OverviewPyramid& operator=(const OverviewPyramid& rhs);
+
+      bool mValid;
+      vector<OverviewLevel*> mLevels;
+   };
 };
 
 REGISTER_PLUGIN_BASIC(OpticksPictures, GeoTIFFExporter);
@@ -68,7 +323,11 @@ GeoTIFFExporter::GeoTIFFExporter() :
    mpRaster(NULL),
    mpFileDescriptor(NULL),
    mAbortFlag(false),
-   mRowsPerStrip(OptionsTiffExporter::getSettingRowsPerStrip())
+   mRowsPerStrip(OptionsTiffExporter::getSettingRowsPerStrip()),
+   mCompression(getTiffCompression(OptionsTiffExporter::getGeoTiffCompressionMethod())),
+   mPredictor(OptionsTiffExporter::getSettingPredictor()),
+   mTileSize(OptionsTiffExporter::getSettingTiledOutput() ? OptionsTiffExporter::getSettingTileSize() : 0),
+   mOverviews(OptionsTiffExporter::getSettingOverviews())
 {
    setName("GeoTIFF Exporter");
    setCreator("Ball Aerospace & Technologies Corp.");
@@ -110,10 +369,25 @@ bool GeoTIFFExporter::execute(PlugInArgList* pInParam, PlugInArgList* pOutParam)
    if (isBatch() == true)
    {
       pInParam->getPlugInArgValue("Rows Per Strip", mRowsPerStrip);
+
+      string compressionMethod;
+      if (pInParam->getPlugInArgValue("Compression Method", compressionMethod) == true)
+      {
+         mCompression = getTiffCompression(
+            StringUtilities::fromXmlString<OptionsTiffExporter::CompressionMethod>(compressionMethod));
+      }
+
+      pInParam->getPlugInArgValue("Predictor", mPredictor);
+      pInParam->getPlugInArgValue("Tile Size", mTileSize);
+      pInParam->getPlugInArgValue("Overviews", mOverviews);
    }
    else if (mpOptionWidget.get() != NULL)
    {
       mRowsPerStrip = mpOptionWidget->getRowsPerStrip();
+      mCompression = getTiffCompression(mpOptionWidget->getCompressionMethod());
+      mPredictor = mpOptionWidget->getPredictor();
+      mTileSize = (mpOptionWidget->getTiledOutput() ? mpOptionWidget->getTileSize() : 0);
+      mOverviews = mpOptionWidget->getOverviews();
    }
 
    // Check for complex data
@@ -229,6 +503,15 @@ bool GeoTIFFExporter::getInputSpecification(PlugInArgList*& pArgList)
    if (isBatch() == true)
    {
       VERIFY(pArgList->addArg<unsigned int>("Rows Per Strip", mRowsPerStrip, "Rows per strip for the TIFF file."));
+      VERIFY(pArgList->addArg<string>("Compression Method",
+         StringUtilities::toXmlString(OptionsTiffExporter::getGeoTiffCompressionMethod()),
+         "Compression of the TIFF file: None, PackBits, LZW, or Deflate."));
+      VERIFY(pArgList->addArg<bool>("Predictor", mPredictor,
+         "Whether to apply a predictor before LZW or Deflate compression."));
+      VERIFY(pArgList->addArg<unsigned int>("Tile Size", mTileSize,
+         "Width and height of the tiles in the TIFF file, or zero to write strips."));
+      VERIFY(pArgList->addArg<bool>("Overviews", mOverviews,
+         "Whether to write reduced resolution overviews after the full resolution image."));
    }
 
    return true;
@@ -285,15 +568,19 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
       return false;
    }
 
-   int size = 0;
-   int row = 0;
-   unsigned char* pBuffer = NULL;
-   unsigned short numRows = pDescriptor->getRowCount();
-   unsigned short numCols = pDescriptor->getColumnCount();
-   unsigned short numBands = pDescriptor->getBandCount();
-   unsigned short scols = mpFileDescriptor->getColumnCount();
-   unsigned short srows = mpFileDescriptor->getRowCount();
-   unsigned short sbands = mpFileDescriptor->getBandCount();
+   const vector<DimensionDescriptor>& rows = mpFileDescriptor->getRows();
+   const vector<DimensionDescriptor>& columns = mpFileDescriptor->getColumns();
+   const vector<DimensionDescriptor>& bands = mpFileDescriptor->getBands();
+   if ((rows.empty() == true) || (columns.empty() == true) || (bands.empty() == true))
+   {
+      mMessage = "The file descriptor does not contain any data to export!";
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress(mMessage, 0, ERRORS);
+      }
+
+      return false;
+   }
 
    FactoryResource<DataRequest> pRequest;
    pRequest->setInterleaveFormat(BIP);
@@ -319,30 +606,53 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
       }
    }
 
-   unsigned int bytesPerElement(pDescriptor->getBytesPerElement());
-   size = scols * sbands * bytesPerElement;
-
-   TIFFSetField(pOut, TIFFTAG_IMAGEWIDTH, scols);
-   TIFFSetField(pOut, TIFFTAG_IMAGELENGTH, srows);
-   TIFFSetField(pOut, TIFFTAG_SAMPLESPERPIXEL, sbands);
+   unsigned int exportRows = rows.size();
+   unsigned int exportColumns = columns.size();
+   unsigned int exportBands = bands.size();
+   unsigned int bytesPerElement = pDescriptor->getBytesPerElement();
+   EncodingType dataType = pDescriptor->getDataType();
+   unsigned short sampleFormat = static_cast<unsigned short>(getTiffSampleFormat(dataType));
+
+   // Whole rows of the cube are written directly, and the other rows are gathered from the offset of each
+   // exported element from the start of a row
+   bool wholeRows = (exportColumns == pDescriptor->getColumnCount() && exportBands == pDescriptor->getBandCount());
+   vector<size_t> offsets;
+   if (wholeRows == false)
+   {
+      size_t pixelStride = accessor->getRowView<unsigned char, BIP>().getStride();
+      offsets.reserve(exportColumns * exportBands);
+      for (unsigned int c = 0; c < exportColumns; ++c)
+      {
+         size_t pixelOffset = columns[c].getActiveNumber() * pixelStride;
+         for (unsigned int b = 0; b < exportBands; ++b)
+         {
+            offsets.push_back(pixelOffset + bands[b].getActiveNumber());
+         }
+      }
+   }
 
-   //for this tag, must multiply by # of bytes per data type
-   TIFFSetField(pOut, TIFFTAG_BITSPERSAMPLE, static_cast<unsigned short>(bytesPerElement * 8));
-   TIFFSetField(pOut, TIFFTAG_SAMPLEFORMAT, static_cast<unsigned short>(
-                           getTiffSampleFormat(pDescriptor->getDataType())));
+   vector<unsigned char> rowBuffer(static_cast<size_t>(exportColumns) * exportBands * bytesPerElement);
 
-   bool packBits = OptionsTiffExporter::getSettingPackBitsCompression();
-   if (mpOptionWidget.get() != NULL)
+   // The overviews are reduced from the exported rows as they are written and kept in temporary files until
+   // the full resolution image is complete
+   OverviewPyramid overviews(exportColumns, exportRows, exportBands, dataType,
+      mOverviews ? (mTileSize > 0 ? mTileSize : OVERVIEW_MINIMUM_SIZE) : 0);
+   if (overviews.isValid() == false)
    {
-      packBits = mpOptionWidget->getPackBitsCompression();
+      mMessage = "Unable to create the temporary files for the overviews.";
+      if (mpProgress != NULL)
+      {
+         mpProgress->updateProgress(mMessage, 0, ERRORS);
+      }
+
+      return false;
    }
-   ttag_t compOpt = (packBits ? COMPRESSION_PACKBITS : COMPRESSION_NONE);
 
-   TIFFSetField(pOut, TIFFTAG_COMPRESSION, compOpt);
-   TIFFSetField(pOut, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-   TIFFSetField(pOut, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-   TIFFSetField(pOut, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);      //????
-   TIFFSetField(pOut, TIFFTAG_ROWSPERSTRIP, mRowsPerStrip);
+   unsigned int totalRows = exportRows;
+   for (unsigned int level = 0; level < overviews.getLevelCount(); ++level)
+   {
+      totalRows += overviews.getLevel(level).getRows();
+   }
 
    //ready to test write
    mMessage = "Writing out GeoTIFF file...";
@@ -351,9 +661,13 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
       mpProgress->updateProgress( mMessage, 0, NORMAL);
    }
 
-   if ((numRows == srows) && (numCols == scols) && (numBands == sbands))   // full cube write from memory
    {
-      for (row = 0; row < srows; row++)
+      TiffBlockWriter writer(pOut, exportColumns, exportRows, exportBands, bytesPerElement, sampleFormat,
+         mCompression, mPredictor, mTileSize, mRowsPerStrip);
+      TIFFSetField(pOut, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+      TIFFSetField(pOut, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);      //????
+
+      for (unsigned int r = 0; r < exportRows; ++r)
       {
          if (mAbortFlag)
          {
@@ -366,41 +680,20 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
             return false;
          }
 
+         accessor->toPixel(rows[r].getActiveNumber(), 0);
          VERIFY(accessor.isValid());
-         pBuffer = reinterpret_cast<unsigned char*>(accessor->getRow());
-         if (pBuffer != NULL)
-         {
-            if (TIFFWriteScanline(pOut, pBuffer, row, size) < 0)
-            {
-               mMessage = "Unable to save GeoTIFF file, check folder permissions.";
-               if (mpProgress)
-               {
-                  mpProgress->updateProgress(mMessage, 0, ERRORS);
-               }
-
-               return false;
-            }
 
-            updateProgress(row, srows, mMessage, NORMAL);
+         const void* pRow = accessor->getRow();
+         if (wholeRows == false)
+         {
+            InterleaveTranspose::gather(pRow, &offsets[0], offsets.size(), &rowBuffer[0], bytesPerElement);
+            pRow = &rowBuffer[0];
          }
-         accessor->nextRow();
-      }
-   }
-   else // subcube write
-   {
-      const vector<DimensionDescriptor>& rows = mpFileDescriptor->getRows();
-      const vector<DimensionDescriptor>& columns = mpFileDescriptor->getColumns();
-      const vector<DimensionDescriptor>& bands = mpFileDescriptor->getBands();
 
-      unsigned int activeRowNumber = 0;
-      unsigned int rowSize(0);
-      unsigned int outRow(0);
-      for (unsigned int r = 0; r < srows; ++r)
-      {
-         if (mAbortFlag == true)
+         if (writer.writeRow(pRow) == false)
          {
-            mMessage = "GeoTIFF export aborted!";
-            if (mpProgress != NULL)
+            mMessage = "Unable to save GeoTIFF file, check folder permissions.";
+            if (mpProgress)
             {
                mpProgress->updateProgress(mMessage, 0, ERRORS);
             }
@@ -408,103 +701,43 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
             return false;
          }
 
-         DimensionDescriptor rowDim = rows[r];
-         if (rowDim.isActiveNumberValid())
+         if (overviews.addRow(pRow) == false)
          {
-            // Skip to the next row
-            for (; activeRowNumber < rowDim.getActiveNumber(); ++activeRowNumber)
-            {
-               accessor->nextRow();
-            }
-
-            VERIFY(accessor.isValid());
-
-            vector<char> rowData(size);
-            if (rowData.empty())
+            mMessage = "Unable to write the overviews to a temporary file.";
+            if (mpProgress)
             {
-               mMessage = "Error GeoTIFFExporter008: Unable to allocate row buffer.";
-               if (mpProgress)
-               {
-                  mpProgress->updateProgress(mMessage, 0, ERRORS);
-               }
-
-               return false;
+               mpProgress->updateProgress(mMessage, 0, ERRORS);
             }
 
-            unsigned int activeColumnNumber = 0;
+            return false;
+         }
 
-            char* pExportData = &(rowData.front());
-            for (unsigned int c = 0; c < scols; ++c)
-            {
-               DimensionDescriptor columnDim = columns[c];
-               if (columnDim.isActiveNumberValid())
-               {
-                  // Skip to the next column
-                  for (; activeColumnNumber < columnDim.getActiveNumber(); ++activeColumnNumber)
-                  {
-                     accessor->nextColumn();
-                  }
-
-                  char* pCurrentPixel = reinterpret_cast<char*>(accessor->getColumn());
-
-                  unsigned int activeBandNumber = 0;
-                  for (unsigned int b = 0; b < sbands; ++b)
-                  {
-                     DimensionDescriptor bandDim = bands[b];
-                     if (bandDim.isActiveNumberValid())
-                     {
-                        // Skip to the next band
-                        for (; activeBandNumber < bandDim.getActiveNumber(); ++activeBandNumber)
-                        {
-                           pCurrentPixel += bytesPerElement;
-                        }
-
-                        memcpy(pExportData, pCurrentPixel, bytesPerElement);
-                        pExportData += bytesPerElement;
-                        rowSize += bytesPerElement;
-                     }
-                  }
-               }
-               else // this column is not included, go to next column 
-               {
-                  accessor->nextColumn();
-               }
-            }
+         updateProgress(r, totalRows, mMessage, NORMAL);
+      }
 
-            if (rowSize > 0)
-            {
-               // write here
-               if (TIFFWriteScanline(pOut, &rowData[0], outRow, size) < 0)
-               {
-                  mMessage = "Error GeoTIFFExporter006: Unable to save GeoTIFF file, check folder permissions.";
-                  if (mpProgress)
-                  {
-                     mpProgress->updateProgress(mMessage, 0, ERRORS);
-                  }
-
-                  return false;
-               }
-
-               updateProgress(outRow++, srows, mMessage, NORMAL);
-            }
-         }
-         else // this row is not included, go to next row
+      if (writer.finish() == false)
+      {
+         mMessage = "Unable to save GeoTIFF file, check folder permissions.";
+         if (mpProgress)
          {
-            accessor->nextRow();
+            mpProgress->updateProgress(mMessage, 0, ERRORS);
          }
+
+         return false;
       }
    }
 
    //assumed everything has been done correctly up to now
    //copy over Geo ref info if there are any, else
    //try to look for world file in same directory and apply
+   //the tags must be set before the directory of the full resolution image is written
    if (!(applyWorldFile(pOut)))
    {
       if (!(CreateGeoTIFF(pOut)))
       {
          //no geo info found, where is it located?
          mMessage = "Geo data is unavailable and will not be written to the output file!";
-         updateProgress(srows, srows, mMessage, WARNING);
+         updateProgress(exportRows, totalRows, mMessage, WARNING);
          if (mpStep != NULL)
          {
             mpStep->addMessage(mMessage, "app", "9C1E7ADE-ADC4-468c-B15E-FEB53D5FEF5B", true);
@@ -512,6 +745,60 @@ bool GeoTIFFExporter::writeCube(TIFF* pOut)
       }
    }
 
+   // Each overview is a reduced resolution image in its own directory after the full resolution image, and
+   // the last directory is written when the file is closed
+   unsigned int rowsWritten = exportRows;
+   for (unsigned int level = 0; level < overviews.getLevelCount(); ++level)
+   {
+      mMessage = "Writing out GeoTIFF overviews...";
+      if (TIFFWriteDirectory(pOut) == 0)
+      {
+         mMessage = "Unable to save GeoTIFF file, check folder permissions.";
+         if (mpProgress)
+         {
+            mpProgress->updateProgress(mMessage, 0, ERRORS);
+         }
+
+         return false;
+      }
+
+      OverviewLevel& overview = overviews.getLevel(level);
+      TIFFSetField(pOut, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+      TiffBlockWriter writer(pOut, overview.getColumns(), overview.getRows(), exportBands, bytesPerElement,
+         sampleFormat, mCompression, mPredictor, mTileSize, mRowsPerStrip);
+      TIFFSetField(pOut, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+      TIFFSetField(pOut, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+
+      bool success = overview.rewind();
+      for (unsigned int r = 0; success == true && r < overview.getRows(); ++r)
+      {
+         if (mAbortFlag)
+         {
+            mMessage = "GeoTIFF export aborted!";
+            if (mpProgress != NULL)
+            {
+               mpProgress->updateProgress(mMessage, 0, ERRORS);
+            }
+
+            return false;
+         }
+
+         success = overview.readRow(&rowBuffer[0]) && writer.writeRow(&rowBuffer[0]);
+         updateProgress(rowsWritten++, totalRows, mMessage, NORMAL);
+      }
+
+      if (success == false || writer.finish() == false)
+      {
+         mMessage = "Unable to save the GeoTIFF overviews.";
+         if (mpProgress)
+         {
+            mpProgress->updateProgress(mMessage, 0, ERRORS);
+         }
+
+         return false;
+      }
+   }
+
    return true;
 }
 
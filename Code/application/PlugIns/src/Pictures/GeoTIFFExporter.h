@@ -51,6 +51,10 @@ private:
    bool mAbortFlag;
    std::string mMessage;
    unsigned int mRowsPerStrip;
+   unsigned short mCompression;
+   bool mPredictor;
+   unsigned int mTileSize;
+   bool mOverviews;
 };
 
 #endif
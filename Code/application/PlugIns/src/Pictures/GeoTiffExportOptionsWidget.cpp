@@ -12,6 +12,7 @@
 #include "StringUtilities.h"
 
 #include <QtGui/QCheckBox>
+#include <QtGui/QComboBox>
 #include <QtGui/QGridLayout>
 #include <QtGui/QGroupBox>
 #include <QtGui/QLabel>
@@ -53,14 +54,35 @@ GeoTiffExportOptionsWidget::GeoTiffExportOptionsWidget() :
    mpRowsPerStrip = new QSpinBox(pCompressionWidget);
    mpRowsPerStrip->setRange(1, std::numeric_limits<int>::max());
 
-   mpPackBits = new QCheckBox("Pack Bits", pCompressionWidget);
+   QLabel* pCompressionMethodLabel = new QLabel("Compression: ", pCompressionWidget);
+   mpCompressionCombo = new QComboBox(pCompressionWidget);
+   std::vector<std::string> methods =
+      StringUtilities::getAllEnumValuesAsDisplayString<OptionsTiffExporter::CompressionMethod>();
+   for (std::vector<std::string>::iterator iter = methods.begin(); iter != methods.end(); ++iter)
+   {
+      mpCompressionCombo->addItem(QString::fromStdString(*iter));
+   }
+
+   mpPredictor = new QCheckBox("Predictor (LZW and Deflate)", pCompressionWidget);
+   mpTiled = new QCheckBox("Tiles instead of strips", pCompressionWidget);
+   QLabel* pTileSizeLabel = new QLabel("Tile Size: ", pCompressionWidget);
+   mpTileSize = new QSpinBox(pCompressionWidget);
+   mpTileSize->setRange(16, 4096);
+   mpTileSize->setSingleStep(16);
+   mpOverviews = new QCheckBox("Reduced resolution overviews", pCompressionWidget);
 
    QGridLayout* pCompressionLayout = new QGridLayout(pCompressionWidget);
    pCompressionLayout->setMargin(0);
    pCompressionLayout->setSpacing(5);
    pCompressionLayout->addWidget(pRowsPerStripLabel, 0, 0);
    pCompressionLayout->addWidget(mpRowsPerStrip, 0, 1);
-   pCompressionLayout->addWidget(mpPackBits, 1, 1);
+   pCompressionLayout->addWidget(pCompressionMethodLabel, 1, 0);
+   pCompressionLayout->addWidget(mpCompressionCombo, 1, 1);
+   pCompressionLayout->addWidget(mpPredictor, 2, 1);
+   pCompressionLayout->addWidget(mpTiled, 3, 1);
+   pCompressionLayout->addWidget(pTileSizeLabel, 4, 0);
+   pCompressionLayout->addWidget(mpTileSize, 4, 1);
+   pCompressionLayout->addWidget(mpOverviews, 5, 1);
    pCompressionLayout->setColumnStretch(2, 10);
 
    LabeledSection* pCompressionSection = new LabeledSection(pCompressionWidget, "Compression Options", this);
@@ -85,7 +107,18 @@ GeoTiffExportOptionsWidget::GeoTiffExportOptionsWidget() :
    }
 
    mpRowsPerStrip->setValue(static_cast<int>(OptionsTiffExporter::getSettingRowsPerStrip()));
-   mpPackBits->setChecked(OptionsTiffExporter::getSettingPackBitsCompression());
+
+   OptionsTiffExporter::CompressionMethod compressionMethod = OptionsTiffExporter::getGeoTiffCompressionMethod();
+   if (compressionMethod.isValid() == true)
+   {
+      mpCompressionCombo->setCurrentIndex(mpCompressionCombo->findText(QString::fromStdString(
+         StringUtilities::toDisplayString(compressionMethod))));
+   }
+
+   mpPredictor->setChecked(OptionsTiffExporter::getSettingPredictor());
+   mpTiled->setChecked(OptionsTiffExporter::getSettingTiledOutput());
+   mpTileSize->setValue(static_cast<int>(OptionsTiffExporter::getSettingTileSize()));
+   mpOverviews->setChecked(OptionsTiffExporter::getSettingOverviews());
 }
 
 GeoTiffExportOptionsWidget::~GeoTiffExportOptionsWidget()
@@ -110,7 +143,28 @@ int GeoTiffExportOptionsWidget::getRowsPerStrip() const
    return mpRowsPerStrip->value();
 }
 
-bool GeoTiffExportOptionsWidget::getPackBitsCompression() const
+OptionsTiffExporter::CompressionMethod GeoTiffExportOptionsWidget::getCompressionMethod() const
+{
+   return StringUtilities::fromDisplayString<OptionsTiffExporter::CompressionMethod>(
+      mpCompressionCombo->currentText().toStdString());
+}
+
+bool GeoTiffExportOptionsWidget::getPredictor() const
+{
+   return mpPredictor->isChecked();
+}
+
+bool GeoTiffExportOptionsWidget::getTiledOutput() const
+{
+   return mpTiled->isChecked();
+}
+
+unsigned int GeoTiffExportOptionsWidget::getTileSize() const
+{
+   return static_cast<unsigned int>(mpTileSize->value());
+}
+
+bool GeoTiffExportOptionsWidget::getOverviews() const
 {
-   return mpPackBits->isChecked();
+   return mpOverviews->isChecked();
 }
@@ -14,6 +14,7 @@
 #include "OptionsTiffExporter.h"
 
 class QCheckBox;
+class QComboBox;
 class QRadioButton;
 class QSpinBox;
 
@@ -27,13 +28,21 @@ public:
 
    OptionsTiffExporter::TransformationMethod getTransformationMethod() const;
    int getRowsPerStrip() const;
-   bool getPackBitsCompression() const;
+   OptionsTiffExporter::CompressionMethod getCompressionMethod() const;
+   bool getPredictor() const;
+   bool getTiledOutput() const;
+   unsigned int getTileSize() const;
+   bool getOverviews() const;
 
 private:
    QRadioButton* mpTiePointRadio;
    QRadioButton* mpMatrixRadio;
    QSpinBox* mpRowsPerStrip;
-   QCheckBox* mpPackBits;
+   QComboBox* mpCompressionCombo;
+   QCheckBox* mpPredictor;
+   QCheckBox* mpTiled;
+   QSpinBox* mpTileSize;
+   QCheckBox* mpOverviews;
 };
 
 #endif
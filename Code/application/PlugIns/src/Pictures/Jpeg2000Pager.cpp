@@ -11,6 +11,7 @@
 #include "AppVersion.h"
 #include "DataRequest.h"
 #include "DimensionDescriptor.h"
+#include "FileResource.h"
 #include "Jpeg2000Pager.h"
 #include "Jpeg2000Utilities.h"
 #include "ObjectResource.h"
@@ -28,12 +29,11 @@
 
 REGISTER_PLUGIN_BASIC(OpticksPictures, Jpeg2000Pager);
 
-size_t Jpeg2000Pager::msMaxCacheSize = 1024 * 1024 * 50; // Specify a cache size (50MB) larger than the default
-                                                         // to minimize the number of calls to decode the image
+size_t Jpeg2000Pager::msChunkSize = 1024 * 1024 * 50; // Specify a chunk size (50MB) larger than the default
+                                                      // to minimize the number of calls to decode the image
+unsigned int Jpeg2000Pager::msTileSize = 1024;        // Decode wide images in regions of this many columns
 
 Jpeg2000Pager::Jpeg2000Pager() :
-   CachedPager(msMaxCacheSize),
-   mpFile(NULL),
    mOffset(0),
    mSize(0)
 {
@@ -45,16 +45,11 @@ Jpeg2000Pager::Jpeg2000Pager() :
    setVersion(APP_VERSION_NUMBER);
    setProductionStatus(APP_IS_PRODUCTION_RELEASE);
    setShortDescription("JPEG2000");
+   setPrefetchEnabled(true);
 }
 
 Jpeg2000Pager::~Jpeg2000Pager()
-{
-   if (mpFile != NULL)
-   {
-      fclose(mpFile);
-      mpFile = NULL;
-   }
-}
+{}
 
 std::string Jpeg2000Pager::offsetArg()
 {
@@ -102,13 +97,20 @@ bool Jpeg2000Pager::parseInputArgs(PlugInArgList* pArgList)
 
 bool Jpeg2000Pager::openFile(const std::string& filename)
 {
-   if ((mpFile != NULL) || (filename.empty() == true))
+   if ((mFilename.empty() == false) || (filename.empty() == true))
+   {
+      return false;
+   }
+
+   // Each decode opens its own handle so that units can be decoded concurrently
+   FileResource pFile(filename.c_str(), "rb");
+   if (pFile.get() == NULL)
    {
       return false;
    }
 
-   mpFile = fopen(filename.c_str(), "rb");
-   return (mpFile != NULL);
+   mFilename = filename;
+   return true;
 }
 
 CachedPage::UnitPtr Jpeg2000Pager::fetchUnit(DataRequest* pOriginalRequest)
@@ -214,8 +216,20 @@ CachedPage::UnitPtr Jpeg2000Pager::fetchUnit(DataRequest* pOriginalRequest)
 
 double Jpeg2000Pager::getChunkSize() const
 {
-   // Set the chunk size as the maximum cache size to minimize the number of calls to decode the image
-   return msMaxCacheSize;
+   // Use a large chunk size to minimize the number of calls to decode the image
+   return msChunkSize;
+}
+
+bool Jpeg2000Pager::canFetchConcurrently() const
+{
+   return true;
+}
+
+unsigned int Jpeg2000Pager::getTileColumnCount() const
+{
+   // The decoder only decodes the region which is requested, so there is
+   // no need to decode full rows when only part of a wide image is accessed
+   return msTileSize;
 }
 
 template <typename Out>
@@ -352,14 +366,26 @@ CachedPage::UnitPtr Jpeg2000Pager::populateImageData(const DimensionDescriptor&
    opj_image_destroy(pImage);
 
    // Transfer ownership of the resulting data into a new page which will be owned by the caller of this method
+   if (concurrentColumns == pDescriptor->getColumnCount())
+   {
+      return CachedPage::UnitPtr(new CachedPage::CacheUnit(reinterpret_cast<char*>(pDestination.release()), startRow,
+         static_cast<int>(concurrentRows), numBytes));
+   }
+
    return CachedPage::UnitPtr(new CachedPage::CacheUnit(reinterpret_cast<char*>(pDestination.release()), startRow,
-      static_cast<int>(concurrentRows), numBytes));
+      static_cast<int>(concurrentRows), startColumn, concurrentColumns, numBytes));
 }
 
 opj_image_t* Jpeg2000Pager::decodeImage(unsigned int originalStartRow, unsigned int originalStartColumn,
                                         unsigned int originalStopRow, unsigned int originalStopColumn,
                                         int decoderType) const
 {
+   FileResource pFile(mFilename.c_str(), "rb");
+   if (pFile.get() == NULL)
+   {
+      return NULL;
+   }
+
    // Open a byte stream of the required size
    size_t fileLength = 0;
    if (mSize > 0)
@@ -368,9 +394,9 @@ opj_image_t* Jpeg2000Pager::decodeImage(unsigned int originalStartRow, unsigned
    }
    else
    {
-      fseek(mpFile, 0, SEEK_END);
+      fseek(pFile, 0, SEEK_END);
 
-      size_t fileSize = static_cast<size_t>(ftell(mpFile));
+      size_t fileSize = static_cast<size_t>(ftell(pFile));
       if (fileSize <= mOffset)
       {
          return NULL;
@@ -379,7 +405,7 @@ opj_image_t* Jpeg2000Pager::decodeImage(unsigned int originalStartRow, unsigned
       fileLength = fileSize - static_cast<size_t>(mOffset);
    }
 
-   opj_stream_t* pStream = opj_stream_create_file_stream(mpFile, fileLength, true);
+   opj_stream_t* pStream = opj_stream_create_file_stream(pFile, fileLength, true);
    if (pStream == NULL)
    {
       return NULL;
@@ -388,7 +414,7 @@ opj_image_t* Jpeg2000Pager::decodeImage(unsigned int originalStartRow, unsigned
    opj_stream_set_user_data_length(pStream, fileLength);
 
    // Seek to the required position in the file
-   fseek(mpFile, static_cast<long>(mOffset), SEEK_SET);
+   fseek(pFile, static_cast<long>(mOffset), SEEK_SET);
 
    // Create the appropriate codec
    opj_codec_t* pCodec = NULL;
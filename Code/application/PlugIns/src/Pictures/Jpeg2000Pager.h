@@ -33,6 +33,8 @@ public:
 
 protected:
    virtual double getChunkSize() const;
+   virtual bool canFetchConcurrently() const;
+   virtual unsigned int getTileColumnCount() const;
 
    template <typename Out>
    CachedPage::UnitPtr populateImageData(const DimensionDescriptor& startRow, const DimensionDescriptor& startColumn,
@@ -42,9 +44,10 @@ protected:
       unsigned int originalStopRow, unsigned int originalStopColumn, int decoderType) const;
 
 private:
-   static size_t msMaxCacheSize;
+   static size_t msChunkSize;
+   static unsigned int msTileSize;
 
-   FILE* mpFile;
+   std::string mFilename;
    uint64_t mOffset;
    uint64_t mSize;
 };
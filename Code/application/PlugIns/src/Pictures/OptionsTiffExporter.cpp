@@ -8,6 +8,7 @@
  */
 
 #include <QtGui/QCheckBox>
+#include <QtGui/QComboBox>
 #include <QtGui/QGridLayout>
 #include <QtGui/QGroupBox>
 #include <QtGui/QLabel>
@@ -33,30 +34,46 @@ namespace StringUtilities
    ADD_ENUM_MAPPING(OptionsTiffExporter::TIE_POINT_PIXEL_SCALE, "Tie Point/Pixel Scale", "TiePointPixelScale")
    ADD_ENUM_MAPPING(OptionsTiffExporter::TRANSFORMATION_MATRIX, "Transformation Matrix", "TransformationMatrix")
    END_ENUM_MAPPING()
+
+   BEGIN_ENUM_MAPPING_ALIAS(OptionsTiffExporter::CompressionMethod, CompressionMethod)
+   ADD_ENUM_MAPPING(OptionsTiffExporter::NO_COMPRESSION, "None", "None")
+   ADD_ENUM_MAPPING(OptionsTiffExporter::PACKBITS_COMPRESSION, "Pack Bits", "PackBits")
+   ADD_ENUM_MAPPING(OptionsTiffExporter::LZW_COMPRESSION, "LZW", "LZW")
+   ADD_ENUM_MAPPING(OptionsTiffExporter::DEFLATE_COMPRESSION, "Deflate", "Deflate")
+   END_ENUM_MAPPING()
 }
 
 OptionsTiffExporter::OptionsTiffExporter() :
    LabeledSectionGroup(NULL)
 {
-   // Compression
-   QWidget* pCompressionWidget = new QWidget(this);
+   // Strips
+   QWidget* pStripWidget = new QWidget(this);
 
-   QLabel* pRowsPerStripLabel = new QLabel("Rows Per Strip: ", pCompressionWidget);
-   mpRowsPerStrip = new QSpinBox(pCompressionWidget);
+   QLabel* pRowsPerStripLabel = new QLabel("Rows Per Strip: ", pStripWidget);
+   mpRowsPerStrip = new QSpinBox(pStripWidget);
    mpRowsPerStrip->setRange(1, std::numeric_limits<int>::max());
 
+   QGridLayout* pStripLayout = new QGridLayout(pStripWidget);
+   pStripLayout->setMargin(0);
+   pStripLayout->setSpacing(5);
+   pStripLayout->addWidget(pRowsPerStripLabel, 0, 0);
+   pStripLayout->addWidget(mpRowsPerStrip, 0, 1);
+   pStripLayout->setColumnStretch(2, 10);
+
+   LabeledSection* pStripSection = new LabeledSection(pStripWidget, "Strips (TIFF and GeoTIFF)", this);
+
+   // Compression
+   QWidget* pCompressionWidget = new QWidget(this);
+
    mpPackBits = new QCheckBox("Pack Bits", pCompressionWidget);
 
-   QGridLayout* pCompressionLayout = new QGridLayout(pCompressionWidget);
+   QVBoxLayout* pCompressionLayout = new QVBoxLayout(pCompressionWidget);
    pCompressionLayout->setMargin(0);
    pCompressionLayout->setSpacing(5);
-   pCompressionLayout->addWidget(pRowsPerStripLabel, 0, 0);
-   pCompressionLayout->addWidget(mpRowsPerStrip, 0, 1);
-   pCompressionLayout->addWidget(mpPackBits, 1, 1);
-   pCompressionLayout->setColumnStretch(2, 10);
+   pCompressionLayout->addWidget(mpPackBits);
 
    LabeledSection* pCompressionSection = new LabeledSection(pCompressionWidget,
-      "Compression Options (TIFF and GeoTIFF)", this);
+      "Compression Options (TIFF only)", this);
 
    // Image resolution
    mpResolutionWidget = new ResolutionWidget(this);
@@ -84,10 +101,45 @@ OptionsTiffExporter::OptionsTiffExporter() :
    LabeledSection* pTransformationSection = new LabeledSection(pTransformationWidget,
       "Coordinate Transformation (GeoTIFF only)", this);
 
+   // Data layout
+   QWidget* pLayoutWidget = new QWidget(this);
+
+   QLabel* pCompressionMethodLabel = new QLabel("Compression: ", pLayoutWidget);
+   mpCompressionCombo = new QComboBox(pLayoutWidget);
+   std::vector<std::string> methods = StringUtilities::getAllEnumValuesAsDisplayString<CompressionMethod>();
+   for (std::vector<std::string>::iterator iter = methods.begin(); iter != methods.end(); ++iter)
+   {
+      mpCompressionCombo->addItem(QString::fromStdString(*iter));
+   }
+
+   mpPredictor = new QCheckBox("Predictor (LZW and Deflate)", pLayoutWidget);
+   mpTiled = new QCheckBox("Tiles", pLayoutWidget);
+   QLabel* pTileSizeLabel = new QLabel("Tile Size: ", pLayoutWidget);
+   mpTileSize = new QSpinBox(pLayoutWidget);
+   mpTileSize->setRange(16, 4096);
+   mpTileSize->setSingleStep(16);
+   mpOverviews = new QCheckBox("Reduced resolution overviews", pLayoutWidget);
+
+   QGridLayout* pLayoutLayout = new QGridLayout(pLayoutWidget);
+   pLayoutLayout->setMargin(0);
+   pLayoutLayout->setSpacing(5);
+   pLayoutLayout->addWidget(pCompressionMethodLabel, 0, 0);
+   pLayoutLayout->addWidget(mpCompressionCombo, 0, 1);
+   pLayoutLayout->addWidget(mpPredictor, 1, 1);
+   pLayoutLayout->addWidget(mpTiled, 2, 1);
+   pLayoutLayout->addWidget(pTileSizeLabel, 3, 0);
+   pLayoutLayout->addWidget(mpTileSize, 3, 1);
+   pLayoutLayout->addWidget(mpOverviews, 4, 1);
+   pLayoutLayout->setColumnStretch(2, 10);
+
+   LabeledSection* pLayoutSection = new LabeledSection(pLayoutWidget, "Data Layout (GeoTIFF only)", this);
+
    // Initialization
+   addSection(pStripSection);
    addSection(pCompressionSection);
    addSection(pResolutionSection);
    addSection(pTransformationSection);
+   addSection(pLayoutSection);
    addStretch(10);
    setSizeHint(350, 250);
 
@@ -109,15 +161,41 @@ OptionsTiffExporter::OptionsTiffExporter() :
    {
       mpMatrixRadio->setChecked(true);
    }
+
+   CompressionMethod compressionMethod = OptionsTiffExporter::getGeoTiffCompressionMethod();
+   if (compressionMethod.isValid() == true)
+   {
+      mpCompressionCombo->setCurrentIndex(mpCompressionCombo->findText(QString::fromStdString(
+         StringUtilities::toDisplayString(compressionMethod))));
+   }
+
+   mpPredictor->setChecked(OptionsTiffExporter::getSettingPredictor());
+   mpTiled->setChecked(OptionsTiffExporter::getSettingTiledOutput());
+   mpTileSize->setValue(static_cast<int>(OptionsTiffExporter::getSettingTileSize()));
+   mpOverviews->setChecked(OptionsTiffExporter::getSettingOverviews());
 }
 
 OptionsTiffExporter::~OptionsTiffExporter()
 {}
 
+OptionsTiffExporter::CompressionMethod OptionsTiffExporter::getGeoTiffCompressionMethod()
+{
+   Service<ConfigurationSettings> pSettings;
+   if (pSettings->isDefaultSetting(getSettingCompressionMethodKey()) == true &&
+      OptionsTiffExporter::getSettingPackBitsCompression() == true)
+   {
+      return PACKBITS_COMPRESSION;
+   }
+
+   return StringUtilities::fromXmlString<CompressionMethod>(OptionsTiffExporter::getSettingCompressionMethod());
+}
+
 void OptionsTiffExporter::applyChanges()
 {
-   // Compression
+   // Strips
    OptionsTiffExporter::setSettingRowsPerStrip(static_cast<unsigned int>(mpRowsPerStrip->value()));
+
+   // Compression
    OptionsTiffExporter::setSettingPackBitsCompression(mpPackBits->isChecked());
 
    // Image resolution
@@ -143,4 +221,18 @@ void OptionsTiffExporter::applyChanges()
 
    OptionsTiffExporter::setSettingTransformationMethod(StringUtilities::toXmlString<TransformationMethod>(
       transformationMethod));
+
+   // Data layout
+   CompressionMethod compressionMethod = StringUtilities::fromDisplayString<CompressionMethod>(
+      mpCompressionCombo->currentText().toStdString());
+   if (compressionMethod.isValid() == true)
+   {
+      // Always store the method so that choosing no compression overrides the PackBitsCompression setting
+      OptionsTiffExporter::setSettingCompressionMethod(StringUtilities::toXmlString(compressionMethod), true);
+   }
+
+   OptionsTiffExporter::setSettingPredictor(mpPredictor->isChecked());
+   OptionsTiffExporter::setSettingTiledOutput(mpTiled->isChecked());
+   OptionsTiffExporter::setSettingTileSize(static_cast<unsigned int>(mpTileSize->value()));
+   OptionsTiffExporter::setSettingOverviews(mpOverviews->isChecked());
 }
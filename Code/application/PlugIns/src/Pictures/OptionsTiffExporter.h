@@ -16,6 +16,7 @@
 #include "LabeledSectionGroup.h"
 
 class QCheckBox;
+class QComboBox;
 class QRadioButton;
 class QSpinBox;
 class ResolutionWidget;
@@ -36,6 +37,11 @@ public:
    SETTING(OutputHeight, TiffExporter, unsigned int, 0);
    SETTING(TransformationMethod, TiffExporter, std::string, "TiePointPixelScale");
    SETTING(SetBackgroundColorTransparent, TiffExporter, bool, false)
+   SETTING(CompressionMethod, TiffExporter, std::string, "None");
+   SETTING(Predictor, TiffExporter, bool, false);
+   SETTING(TiledOutput, TiffExporter, bool, false);
+   SETTING(TileSize, TiffExporter, unsigned int, 256);
+   SETTING(Overviews, TiffExporter, bool, false);
 
    enum TransformationMethodEnum
    {
@@ -44,6 +50,26 @@ public:
    };
    typedef EnumWrapper<TransformationMethodEnum> TransformationMethod;
 
+   enum CompressionMethodEnum
+   {
+      NO_COMPRESSION,
+      PACKBITS_COMPRESSION,
+      LZW_COMPRESSION,
+      DEFLATE_COMPRESSION
+   };
+   typedef EnumWrapper<CompressionMethodEnum> CompressionMethod;
+
+   /**
+    * Returns the compression method to use for GeoTIFF files.
+    *
+    * The CompressionMethod setting is used unless it still has its default
+    * value, in which case PackBits compression is used if the older
+    * PackBitsCompression setting is enabled.
+    *
+    * @return The compression method to use for GeoTIFF files.
+    */
+   static CompressionMethod getGeoTiffCompressionMethod();
+
    void applyChanges();
 
    static const std::string& getName()
@@ -107,6 +133,11 @@ private:
    ResolutionWidget* mpResolutionWidget;
    QRadioButton* mpTiePointRadio;
    QRadioButton* mpMatrixRadio;
+   QComboBox* mpCompressionCombo;
+   QCheckBox* mpPredictor;
+   QCheckBox* mpTiled;
+   QSpinBox* mpTileSize;
+   QCheckBox* mpOverviews;
 };
 
 #endif
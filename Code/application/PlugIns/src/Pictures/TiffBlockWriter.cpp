@@ -0,0 +1,554 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "Endian.h"
+#include "MultiThreadedAlgorithm.h"
+#include "TiffBlockWriter.h"
+
+#include <algorithm>
+#include <string.h>
+#include <zlib.h>
+
+using namespace std;
+
+namespace
+{
+   // Rows are collected until the uncompressed blocks of a batch occupy at least this many bytes, so each
+   // set of worker threads has enough work to be worth starting
+   const size_t BATCH_MINIMUM_SIZE = 4 * 1024 * 1024;
+
+   // LZW codes as defined by the TIFF specification and written by libtiff
+   const int LZW_CLEAR = 256;
+   const int LZW_EOI = 257;
+   const int LZW_FIRST = 258;
+   const int LZW_MINIMUM_BITS = 9;
+   const int LZW_MAXIMUM_CODE = 4095;
+   const int LZW_HASH_SIZE = 9001;
+   const int LZW_HASH_SHIFT = 5;
+
+   /**
+    * Encodes bytes with the TIFF variant of LZW, which writes codes with the
+    * most significant bit first and widens the codes one entry early.
+    */
+   class LzwEncoder
+   {
+   public:
+      LzwEncoder(vector<unsigned char>& output) :
+         mOutput(output),
+         mHashCodes(LZW_HASH_SIZE),
+         mHashEntries(LZW_HASH_SIZE),
+         mBits(0),
+         mBitCount(0)
+      {
+      }
+
+      void encode(const unsigned char* pData, size_t count)
+      {
+         mOutput.clear();
+         reset();
+         putCode(LZW_CLEAR);
+         if (count == 0)
+         {
+            putCode(LZW_EOI);
+            flushBits();
+            return;
+         }
+
+         int entry = pData[0];
+         for (size_t index = 1; index < count; ++index)
+         {
+            int byte = pData[index];
+            int key = (byte << 12) | entry;
+            int hash = (byte << LZW_HASH_SHIFT) ^ entry;
+            int displacement = (hash == 0 ? 1 : LZW_HASH_SIZE - hash);
+            bool found = false;
+            while (mHashCodes[hash] >= 0)
+            {
+               if (mHashCodes[hash] == key)
+               {
+                  found = true;
+                  break;
+               }
+
+               hash -= displacement;
+               if (hash < 0)
+               {
+                  hash += LZW_HASH_SIZE;
+               }
+            }
+
+            if (found == true)
+            {
+               entry = mHashEntries[hash];
+               continue;
+            }
+
+            putCode(entry);
+            entry = byte;
+            mHashCodes[hash] = key;
+            mHashEntries[hash] = mFreeEntry++;
+            if (mFreeEntry == LZW_MAXIMUM_CODE - 1)
+            {
+               // The table is full, so start over with an empty table
+               putCode(LZW_CLEAR);
+               reset();
+            }
+            else if (mFreeEntry > mMaximumCode)
+            {
+               ++mCodeBits;
+               mMaximumCode = (1 << mCodeBits) - 1;
+            }
+         }
+
+         // The decoder adds an entry for the last code, so the end code is written with the width that follows it
+         putCode(entry);
+         ++mFreeEntry;
+         if (mFreeEntry == LZW_MAXIMUM_CODE - 1)
+         {
+            putCode(LZW_CLEAR);
+            mCodeBits = LZW_MINIMUM_BITS;
+         }
+         else if (mFreeEntry > mMaximumCode)
+         {
+            ++mCodeBits;
+         }
+
+         putCode(LZW_EOI);
+         flushBits();
+      }
+
+   private:
+      LzwEncoder& operator=(const LzwEncoder& rhs);
+
+      void reset()
+      {
+         fill(mHashCodes.begin(), mHashCodes.end(), -1);
+         mFreeEntry = LZW_FIRST;
+         mCodeBits = LZW_MINIMUM_BITS;
+         mMaximumCode = (1 << mCodeBits) - 1;
+      }
+
+      void putCode(int code)
+      {
+         mBits = (mBits << mCodeBits) | static_cast<unsigned int>(code);
+         mBitCount += mCodeBits;
+         while (mBitCount >= 8)
+         {
+            mBitCount -= 8;
+            mOutput.push_back(static_cast<unsigned char>(mBits >> mBitCount));
+         }
+
+         mBits &= (1U << mBitCount) - 1;
+      }
+
+      void flushBits()
+      {
+         if (mBitCount > 0)
+         {
+            mOutput.push_back(static_cast<unsigned char>(mBits << (8 - mBitCount)));
+            mBits = 0;
+            mBitCount = 0;
+         }
+      }
+
+      vector<unsigned char>& mOutput;
+      vector<int> mHashCodes;
+      vector<int> mHashEntries;
+      int mFreeEntry;
+      int mCodeBits;
+      int mMaximumCode;
+      unsigned int mBits;
+      int mBitCount;
+   };
+
+   void packBitsRow(const unsigned char* pData, size_t count, vector<unsigned char>& output)
+   {
+      size_t index = 0;
+      while (index < count)
+      {
+         size_t runEnd = index + 1;
+         while (runEnd < count && runEnd - index < 128 && pData[runEnd] == pData[index])
+         {
+            ++runEnd;
+         }
+
+         if (runEnd - index >= 3)
+         {
+            output.push_back(static_cast<unsigned char>(257 - (runEnd - index)));
+            output.push_back(pData[index]);
+            index = runEnd;
+            continue;
+         }
+
+         // Copy literal bytes up to the start of the next run of three identical bytes
+         size_t literalStart = index;
+         while (index < count && index - literalStart < 128)
+         {
+            if (index + 2 < count && pData[index] == pData[index + 1] && pData[index] == pData[index + 2])
+            {
+               break;
+            }
+
+            ++index;
+         }
+
+         output.push_back(static_cast<unsigned char>(index - literalStart - 1));
+         output.insert(output.end(), pData + literalStart, pData + index);
+      }
+   }
+
+   template<typename T>
+   void horizontalDifference(unsigned char* pRow, unsigned int samples, unsigned int samplesPerPixel)
+   {
+      T* pSamples = reinterpret_cast<T*>(pRow);
+      for (unsigned int index = samples - 1; index >= samplesPerPixel; --index)
+      {
+         pSamples[index] = static_cast<T>(pSamples[index] - pSamples[index - samplesPerPixel]);
+      }
+   }
+
+   void floatingPointDifference(unsigned char* pRow, unsigned int samples, unsigned int bytesPerSample,
+      unsigned int samplesPerPixel, bool littleEndian, vector<unsigned char>& scratch)
+   {
+      // Split the samples into planes of bytes ordered from the most significant byte, then difference the bytes
+      memcpy(&scratch[0], pRow, samples * bytesPerSample);
+      for (unsigned int sample = 0; sample < samples; ++sample)
+      {
+         for (unsigned int byte = 0; byte < bytesPerSample; ++byte)
+         {
+            unsigned int plane = (littleEndian ? bytesPerSample - byte - 1 : byte);
+            pRow[plane * samples + sample] = scratch[sample * bytesPerSample + byte];
+         }
+      }
+
+      for (unsigned int index = samples * bytesPerSample - 1; index >= samplesPerPixel; --index)
+      {
+         pRow[index] = static_cast<unsigned char>(pRow[index] - pRow[index - samplesPerPixel]);
+      }
+   }
+
+   struct BlockInput
+   {
+      const TiffBlockWriter* mpWriter;
+      unsigned int mBlocksAcross;
+      vector<vector<unsigned char> >* mpEncoded;
+   };
+
+   class BlockThread : public mta::AlgorithmThread
+   {
+   public:
+      BlockThread(const BlockInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter) :
+         mta::AlgorithmThread(threadIndex, reporter),
+         mInput(input),
+         mBlockRange(getThreadRange(threadCount, static_cast<int>(input.mpEncoded->size())))
+      {
+      }
+
+      void run()
+      {
+         vector<unsigned char> block(mInput.mpWriter->getBlockSize());
+         for (int index = mBlockRange.mFirst; index <= mBlockRange.mLast; ++index)
+         {
+            unsigned int blockRow = static_cast<unsigned int>(index) / mInput.mBlocksAcross;
+            unsigned int blockColumn = static_cast<unsigned int>(index) % mInput.mBlocksAcross;
+            unsigned int blockRows = mInput.mpWriter->extractBlock(blockRow, blockColumn, &block[0]);
+            mInput.mpWriter->encodeBlock(&block[0], blockRows, (*mInput.mpEncoded)[index]);
+         }
+      }
+
+   private:
+      BlockThread& operator=(const BlockThread& rhs);
+
+      const BlockInput& mInput;
+      mta::AlgorithmThread::Range mBlockRange;
+   };
+
+   struct BlockOutput
+   {
+      bool compileOverallResults(const vector<BlockThread*>& threads)
+      {
+         return true;
+      }
+   };
+}
+
+TiffBlockWriter::TiffBlockWriter(TIFF* pTiff, unsigned int columns, unsigned int rows,
+                                 unsigned int samplesPerPixel, unsigned int bytesPerSample,
+                                 unsigned short sampleFormat, unsigned short compression, bool predictor,
+                                 unsigned int tileSize, unsigned int rowsPerStrip) :
+   mpTiff(pTiff),
+   mColumns(columns),
+   mRows(rows),
+   mSamplesPerPixel(samplesPerPixel),
+   mBytesPerSample(bytesPerSample),
+   mFloatingPoint(sampleFormat == SAMPLEFORMAT_IEEEFP),
+   mCompression(compression),
+   mPredictor(predictor && (compression == COMPRESSION_LZW || compression == COMPRESSION_ADOBE_DEFLATE)),
+   mTiled(tileSize > 0),
+   mBlockWidth(columns),
+   mBlockLength(max(min(rowsPerStrip, rows), 1U)),
+   mBlocksAcross(1),
+   mRowSize(static_cast<size_t>(columns) * samplesPerPixel * bytesPerSample),
+   mBatchRows(0),
+   mBufferedRows(0),
+   mRowsWritten(0),
+   mFirstBlockRow(0),
+   mFailed(false)
+{
+   if (mTiled == true)
+   {
+      // The TIFF specification requires the tile dimensions to be multiples of 16
+      mBlockWidth = (tileSize + 15) / 16 * 16;
+      mBlockLength = mBlockWidth;
+      mBlocksAcross = (columns + mBlockWidth - 1) / mBlockWidth;
+   }
+
+   TIFFSetField(mpTiff, TIFFTAG_IMAGEWIDTH, columns);
+   TIFFSetField(mpTiff, TIFFTAG_IMAGELENGTH, rows);
+   TIFFSetField(mpTiff, TIFFTAG_SAMPLESPERPIXEL, static_cast<unsigned short>(samplesPerPixel));
+   TIFFSetField(mpTiff, TIFFTAG_BITSPERSAMPLE, static_cast<unsigned short>(bytesPerSample * 8));
+   TIFFSetField(mpTiff, TIFFTAG_SAMPLEFORMAT, sampleFormat);
+   TIFFSetField(mpTiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+   TIFFSetField(mpTiff, TIFFTAG_COMPRESSION, compression);
+   if (mPredictor == true)
+   {
+      TIFFSetField(mpTiff, TIFFTAG_PREDICTOR, static_cast<unsigned short>(mFloatingPoint ? 3 : 2));
+   }
+
+   if (mTiled == true)
+   {
+      TIFFSetField(mpTiff, TIFFTAG_TILEWIDTH, mBlockWidth);
+      TIFFSetField(mpTiff, TIFFTAG_TILELENGTH, mBlockLength);
+   }
+   else
+   {
+      TIFFSetField(mpTiff, TIFFTAG_ROWSPERSTRIP, mBlockLength);
+   }
+
+   // Collect enough block rows to give each thread a block and to amortize starting the threads
+   size_t blockRowSize = max(static_cast<size_t>(mBlockLength) * mRowSize, static_cast<size_t>(1));
+   unsigned int totalBlockRows = (rows + mBlockLength - 1) / mBlockLength;
+   unsigned int threadCount = mta::getNumRequiredThreads(mBlocksAcross * max(totalBlockRows, 1U));
+   unsigned int batchBlockRows = max((threadCount + mBlocksAcross - 1) / mBlocksAcross,
+      static_cast<unsigned int>((BATCH_MINIMUM_SIZE + blockRowSize - 1) / blockRowSize));
+   batchBlockRows = max(min(batchBlockRows, totalBlockRows), 1U);
+
+   mBatchRows = batchBlockRows * mBlockLength;
+   mBatch.resize(static_cast<size_t>(mBatchRows) * mRowSize);
+}
+
+bool TiffBlockWriter::writeRow(const void* pRow)
+{
+   if (mFailed == true || mRowsWritten + mBufferedRows >= mRows)
+   {
+      return false;
+   }
+
+   memcpy(&mBatch[static_cast<size_t>(mBufferedRows) * mRowSize], pRow, mRowSize);
+   ++mBufferedRows;
+   if (mBufferedRows == mBatchRows)
+   {
+      return writeBatch();
+   }
+
+   return true;
+}
+
+bool TiffBlockWriter::finish()
+{
+   if (mFailed == false && mBufferedRows > 0)
+   {
+      writeBatch();
+   }
+
+   return mFailed == false && mRowsWritten == mRows;
+}
+
+size_t TiffBlockWriter::getBlockSize() const
+{
+   return static_cast<size_t>(mBlockWidth) * mBlockLength * mSamplesPerPixel * mBytesPerSample;
+}
+
+unsigned int TiffBlockWriter::extractBlock(unsigned int blockRow, unsigned int blockColumn,
+                                           unsigned char* pBlock) const
+{
+   size_t pixelSize = static_cast<size_t>(mSamplesPerPixel) * mBytesPerSample;
+   size_t blockRowSize = mBlockWidth * pixelSize;
+   unsigned int firstRow = blockRow * mBlockLength;
+   unsigned int rows = min(mBlockLength, mBufferedRows - firstRow);
+   unsigned int firstColumn = blockColumn * mBlockWidth;
+   size_t copySize = min(mBlockWidth, mColumns - firstColumn) * pixelSize;
+
+   for (unsigned int row = 0; row < rows; ++row)
+   {
+      unsigned char* pDestination = pBlock + row * blockRowSize;
+      memcpy(pDestination, &mBatch[(firstRow + row) * mRowSize + firstColumn * pixelSize], copySize);
+      if (copySize < blockRowSize)
+      {
+         memset(pDestination + copySize, 0, blockRowSize - copySize);
+      }
+   }
+
+   if (mTiled == false)
+   {
+      return rows;
+   }
+
+   // Tiles always have the full number of rows
+   if (rows < mBlockLength)
+   {
+      memset(pBlock + rows * blockRowSize, 0, (mBlockLength - rows) * blockRowSize);
+   }
+
+   return mBlockLength;
+}
+
+void TiffBlockWriter::encodeBlock(unsigned char* pBlock, unsigned int blockRows,
+                                  vector<unsigned char>& encoded) const
+{
+   unsigned int rowSamples = mBlockWidth * mSamplesPerPixel;
+   size_t blockRowSize = static_cast<size_t>(rowSamples) * mBytesPerSample;
+   size_t blockSize = blockRows * blockRowSize;
+
+   // The predictor is applied to each row of the block, as libtiff reverses it when the rows are decoded
+   if (mPredictor == true)
+   {
+      vector<unsigned char> scratch;
+      if (mFloatingPoint == true)
+      {
+         scratch.resize(blockRowSize);
+      }
+
+      bool littleEndian = (Endian::getSystemEndian() == LITTLE_ENDIAN_ORDER);
+      for (unsigned int row = 0; row < blockRows; ++row)
+      {
+         unsigned char* pRow = pBlock + row * blockRowSize;
+         if (mFloatingPoint == true)
+         {
+            floatingPointDifference(pRow, rowSamples, mBytesPerSample, mSamplesPerPixel, littleEndian, scratch);
+            continue;
+         }
+
+         switch (mBytesPerSample)
+         {
+         case 1:
+            horizontalDifference<uint8_t>(pRow, rowSamples, mSamplesPerPixel);
+            break;
+         case 2:
+            horizontalDifference<uint16_t>(pRow, rowSamples, mSamplesPerPixel);
+            break;
+         case 4:
+            horizontalDifference<uint32_t>(pRow, rowSamples, mSamplesPerPixel);
+            break;
+         case 8:
+            horizontalDifference<uint64_t>(pRow, rowSamples, mSamplesPerPixel);
+            break;
+         default:
+            break;
+         }
+      }
+   }
+
+   switch (mCompression)
+   {
+   case COMPRESSION_PACKBITS:
+      // Each row is packed separately so that a run never crosses the end of a row
+      encoded.clear();
+      encoded.reserve(blockSize + blockSize / 128 + blockRows);
+      for (unsigned int row = 0; row < blockRows; ++row)
+      {
+         packBitsRow(pBlock + row * blockRowSize, blockRowSize, encoded);
+      }
+      break;
+
+   case COMPRESSION_LZW:
+   {
+      encoded.reserve(blockSize / 2);
+      LzwEncoder encoder(encoded);
+      encoder.encode(pBlock, blockSize);
+      break;
+   }
+
+   case COMPRESSION_ADOBE_DEFLATE:
+   {
+      uLongf encodedSize = compressBound(static_cast<uLong>(blockSize));
+      encoded.resize(encodedSize);
+      if (compress2(&encoded[0], &encodedSize, pBlock, static_cast<uLong>(blockSize),
+         Z_DEFAULT_COMPRESSION) != Z_OK)
+      {
+         encoded.clear();
+         break;
+      }
+
+      encoded.resize(encodedSize);
+      break;
+   }
+
+   default:
+      encoded.assign(pBlock, pBlock + blockSize);
+      break;
+   }
+}
+
+bool TiffBlockWriter::writeBatch()
+{
+   unsigned int blockRows = (mBufferedRows + mBlockLength - 1) / mBlockLength;
+   vector<vector<unsigned char> > encoded(blockRows * mBlocksAcross);
+
+   BlockInput input;
+   input.mpWriter = this;
+   input.mBlocksAcross = mBlocksAcross;
+   input.mpEncoded = &encoded;
+
+   BlockOutput output;
+   mta::MultiThreadedAlgorithm<BlockInput, BlockOutput, BlockThread>
+      algorithm(mta::getNumRequiredThreads(static_cast<unsigned int>(encoded.size())), input, output, NULL);
+   if (algorithm.run() != mta::SUCCESS)
+   {
+      mFailed = true;
+      return false;
+   }
+
+   // The blocks are written in the order of their indices so the file is laid out sequentially
+   for (size_t index = 0; index < encoded.size(); ++index)
+   {
+      vector<unsigned char>& block = encoded[index];
+      if (block.empty() == true)
+      {
+         mFailed = true;
+         return false;
+      }
+
+      unsigned int blockIndex = (mFirstBlockRow + static_cast<unsigned int>(index) / mBlocksAcross) *
+         mBlocksAcross + static_cast<unsigned int>(index) % mBlocksAcross;
+      tsize_t written = 0;
+      if (mTiled == true)
+      {
+         written = TIFFWriteRawTile(mpTiff, blockIndex, &block[0], static_cast<tsize_t>(block.size()));
+      }
+      else
+      {
+         written = TIFFWriteRawStrip(mpTiff, blockIndex, &block[0], static_cast<tsize_t>(block.size()));
+      }
+
+      if (written < 0)
+      {
+         mFailed = true;
+         return false;
+      }
+
+      vector<unsigned char>().swap(block);
+   }
+
+   mFirstBlockRow += blockRows;
+   mRowsWritten += mBufferedRows;
+   mBufferedRows = 0;
+   return true;
+}
@@ -0,0 +1,151 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef TIFFBLOCKWRITER_H
+#define TIFFBLOCKWRITER_H
+
+#include <xtiffio.h>
+
+#include <vector>
+
+/**
+ * Writes the image data of the current TIFF directory as tiles or strips.
+ *
+ * The rows of the image are passed to writeRow() in order.  Rows are
+ * collected until a batch of tiles or strips is complete, and the blocks of
+ * the batch are then predicted and compressed on worker threads.  The
+ * compressed blocks are written to the file in order with TIFFWriteRawTile()
+ * or TIFFWriteRawStrip(), so libtiff only stores the bytes and the offsets.
+ *
+ * The constructor sets the size, sample, layout, and compression tags of the
+ * current directory.  The caller sets any other tags, such as the photometric
+ * interpretation, before the first row is written.
+ */
+class TiffBlockWriter
+{
+public:
+   /**
+    * Creates a writer for the current directory of a file.
+    *
+    * @param pTiff
+    *        The file to write.
+    * @param columns
+    *        The number of columns in the image.
+    * @param rows
+    *        The number of rows in the image.
+    * @param samplesPerPixel
+    *        The number of interleaved samples in each pixel.
+    * @param bytesPerSample
+    *        The size of each sample, which must be 1, 2, 4, or 8 bytes.
+    * @param sampleFormat
+    *        The TIFF sample format, such as SAMPLEFORMAT_UINT or SAMPLEFORMAT_IEEEFP.
+    * @param compression
+    *        The TIFF compression scheme, which must be COMPRESSION_NONE,
+    *        COMPRESSION_PACKBITS, COMPRESSION_LZW, or COMPRESSION_ADOBE_DEFLATE.
+    * @param predictor
+    *        Whether to difference the samples before LZW or Deflate
+    *        compression.  Integer samples use the horizontal predictor and
+    *        floating point samples use the floating point predictor.
+    * @param tileSize
+    *        The width and height of each tile, which is rounded up to a
+    *        multiple of 16, or zero to write strips.
+    * @param rowsPerStrip
+    *        The number of rows in each strip when \em tileSize is zero.
+    */
+   TiffBlockWriter(TIFF* pTiff, unsigned int columns, unsigned int rows, unsigned int samplesPerPixel,
+      unsigned int bytesPerSample, unsigned short sampleFormat, unsigned short compression, bool predictor,
+      unsigned int tileSize, unsigned int rowsPerStrip);
+
+   /**
+    * Adds the next row of the image.
+    *
+    * @param pRow
+    *        The samples of the row in BIP order.
+    *
+    * @return Returns \c false if a block could not be written to the file.
+    */
+   bool writeRow(const void* pRow);
+
+   /**
+    * Writes any blocks which have not been written.
+    *
+    * @return Returns \c true if every row of the image has been added and
+    *         every block has been written.
+    */
+   bool finish();
+
+   /**
+    * Compresses a block of samples.
+    *
+    * This is an implementation detail of the writer which is called from
+    * the worker threads.
+    *
+    * @param pBlock
+    *        The samples of the block, which are modified by the predictor.
+    * @param blockRows
+    *        The number of rows in the block.
+    * @param encoded
+    *        Populated with the bytes to write to the file.
+    */
+   void encodeBlock(unsigned char* pBlock, unsigned int blockRows, std::vector<unsigned char>& encoded) const;
+
+   /**
+    * Copies a block out of the rows which have been collected.
+    *
+    * This is an implementation detail of the writer which is called from
+    * the worker threads.  Tiles which extend past the edge of the image are
+    * padded with zeros.
+    *
+    * @param blockRow
+    *        The row of the block within the current batch.
+    * @param blockColumn
+    *        The column of the block.
+    * @param pBlock
+    *        Populated with the samples of the block.
+    *
+    * @return The number of rows in the block.
+    */
+   unsigned int extractBlock(unsigned int blockRow, unsigned int blockColumn, unsigned char* pBlock) const;
+
+   /**
+    * Returns the size of an uncompressed block.
+    *
+    * @return The number of bytes in a full tile or strip.
+    */
+   size_t getBlockSize() const;
+
+private:
+   TiffBlockWriter(const TiffBlockWriter& rhs);
+   TiffBlockWriter& operator=(const TiffBlockWriter& rhs);
+
+   bool writeBatch();
+
+   TIFF* mpTiff;
+   unsigned int mColumns;
+   unsigned int mRows;
+   unsigned int mSamplesPerPixel;
+   unsigned int mBytesPerSample;
+   bool mFloatingPoint;
+   unsigned short mCompression;
+   bool mPredictor;
+   bool mTiled;
+   unsigned int mBlockWidth;
+   unsigned int mBlockLength;
+   unsigned int mBlocksAcross;
+   size_t mRowSize;
+
+   std::vector<unsigned char> mBatch;
+   unsigned int mBatchRows;
+   unsigned int mBufferedRows;
+   unsigned int mRowsWritten;
+   unsigned int mFirstBlockRow;
+   bool mFailed;
+};
+
+#endif
@@ -7,25 +7,37 @@
  * http://www.gnu.org/licenses/lgpl.html
  */
 
+#include "AppVerify.h"
 #include "AppVersion.h"
+#include "DataAccessor.h"
 #include "DataAccessorImpl.h"
+#include "DataRequest.h"
 #include "DesktopServices.h"
+#include "ObjectResource.h"
 #include "PlugInArgList.h"
 #include "PlugInRegistration.h"
 #include "ProgressTracker.h"
 #include "RasterDataDescriptor.h"
+#include "RasterElement.h"
 #include "RasterUtilities.h"
 #include "SpatialResampler.h"
 #include "SpatialResamplerOptions.h"
+#include "switchOnEncoding.h"
 
+#include <algorithm>
+#include <limits>
+#include <math.h>
 #include <string>
 
-#include <opencv2/imgproc/imgproc.hpp>
-
 REGISTER_PLUGIN_BASIC(OpticksSpatialResampler, SpatialResampler);
 
 namespace
 {
+   // The largest number of bytes of horizontally resampled rows buffered by each thread
+   const size_t BUFFER_BYTES = 16 * 1024 * 1024;
+
+   const double PI = 3.14159265358979323846;
+
    // Ensures output file can be created by removing an existing
    // one if necessary.
    void ensureOutput(const std::string& name)
@@ -38,69 +50,175 @@ namespace
       }
    }
 
-   template<typename T>
-   void getOriginalAsType(T *pSource, cv::Mat sData, int row, int col)
+   // The weights follow the conventions of cv::resize() so the results match the previous implementation
+   void computeCubicWeights(double x, double* pWeights)
    {
-      sData.at<T>(row , col) = *pSource;
+      const double a = -0.75;
+      pWeights[0] = ((a * (x + 1.0) - 5.0 * a) * (x + 1.0) + 8.0 * a) * (x + 1.0) - 4.0 * a;
+      pWeights[1] = ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+      pWeights[2] = ((a + 2.0) * (1.0 - x) - (a + 3.0)) * (1.0 - x) * (1.0 - x) + 1.0;
+      pWeights[3] = 1.0 - pWeights[0] - pWeights[1] - pWeights[2];
    }
 
-   template<typename T>
-   void putOriginalAsType(T *pSource, cv::Mat sData, int row, int col)
+   void computeLanczos4Weights(double x, double* pWeights)
    {
-      *pSource = sData.at<T>(row , col);
+      if (x < std::numeric_limits<float>::epsilon())
+      {
+         std::fill(pWeights, pWeights + 8, 0.0);
+         pWeights[3] = 1.0;
+         return;
+      }
+
+      double sum = 0.0;
+      for (int tap = 0; tap < 8; ++tap)
+      {
+         double distance = (x + 3.0 - tap) * PI;
+         pWeights[tap] = 4.0 * sin(distance) * sin(distance / 4.0) / (distance * distance);
+         sum += pWeights[tap];
+      }
+
+      for (int tap = 0; tap < 8; ++tap)
+      {
+         pWeights[tap] /= sum;
+      }
    }
 
-   int convertEncodingTypeOpenCV(EncodingType encodingType)
+   template<typename T>
+   inline T fromDouble(double value)
    {
-      switch (encodingType)
+      if (std::numeric_limits<T>::is_integer)
       {
-      case INT1SBYTE:
-         return CV_8S;
-      case INT1UBYTE:
-         return CV_8U;
-      case INT2SBYTES:
-         return CV_16S;
-      case INT2UBYTES:
-         return CV_16U;
-      case INT4SBYTES:
-         return CV_32S;
-      case INT4UBYTES:         // OpenCV doesn't have unsigned int as a type it can work with.
-         return CV_USRTYPE1;   // So substitute USERTYPE1.
-      case FLT4BYTES:
-         return CV_32F;
-      case FLT8BYTES:
-         return CV_64F;
-      case INT4SCOMPLEX:
-      case FLT8COMPLEX:        // OpenCV doesn't support complex data.
-      default:
-         return CV_USRTYPE1;   // So, substitute USRTYPE1.
+         // Round and saturate integer values as cv::resize() does
+         value = floor(value + 0.5);
+         value = std::max(value, static_cast<double>(std::numeric_limits<T>::min()));
+         value = std::min(value, static_cast<double>(std::numeric_limits<T>::max()));
       }
+
+      return static_cast<T>(value);
    }
+}
 
-   int convertInterpolationMethodOpenCV(InterpolationType interpolationMethod)
+void SpatialResampler::AxisWeights::compute(InterpolationType method, unsigned int sourceCount,
+                                            unsigned int destCount)
+{
+   double scale = static_cast<double>(sourceCount) / static_cast<double>(destCount);
+   bool areaAverage = (method == INTERP_AREA && scale > 1.0);
+   int firstTap = 0;
+   switch (method)
    {
-      int cvInterpMethod;
-      switch (interpolationMethod)
+   case INTERP_NEAREST_NEIGHBOR:
+      mTaps = 1;
+      break;
+   case INTERP_BILINEAR:
+      mTaps = 2;
+      break;
+   case INTERP_AREA:
+      mTaps = (areaAverage ? static_cast<unsigned int>(ceil(scale)) + 2 : 2);
+      break;
+   case INTERP_LANCZOS4:
+      mTaps = 8;
+      firstTap = -3;
+      break;
+   case INTERP_BICUBIC:
+   default:
+      method = INTERP_BICUBIC;
+      mTaps = 4;
+      firstTap = -1;
+      break;
+   }
+
+   mIndices.resize(destCount * mTaps);
+   mWeights.resize(destCount * mTaps);
+   int lastSource = static_cast<int>(sourceCount) - 1;
+   std::vector<int> indices(mTaps);
+   for (unsigned int dest = 0; dest < destCount; ++dest)
+   {
+      double* pWeights = &mWeights[dest * mTaps];
+      std::fill(pWeights, pWeights + mTaps, 0.0);
+      if (areaAverage)
       {
-      case INTERP_NEAREST_NEIGHBOR:
-         cvInterpMethod = cv::INTER_NEAREST;
-         break;
-      case INTERP_BILINEAR:
-         cvInterpMethod = cv::INTER_LINEAR;
-         break;
-      case INTERP_AREA:
-         cvInterpMethod = cv::INTER_AREA;
-         break;
-      case INTERP_BICUBIC:
-         cvInterpMethod = cv::INTER_CUBIC;
-         break;
-      case INTERP_LANCZOS4:
-         cvInterpMethod = cv::INTER_LANCZOS4;
-         break;
-      default:
-         cvInterpMethod = cv::INTER_CUBIC;
+         // Each output pixel is the average of the source pixels it covers, weighted by the area covered
+         double first = dest * scale;
+         double last = first + scale;
+         double cellWidth = std::min(scale, sourceCount - first);
+         int whole = std::min(static_cast<int>(ceil(first)), lastSource);
+         int wholeEnd = std::min(static_cast<int>(floor(last)), lastSource);
+         whole = std::min(whole, wholeEnd);
+
+         unsigned int count = 0;
+         if (whole - first > 1e-3)
+         {
+            indices[count] = whole - 1;
+            pWeights[count++] = (whole - first) / cellWidth;
+         }
+         for (int source = whole; source < wholeEnd; ++source)
+         {
+            indices[count] = source;
+            pWeights[count++] = 1.0 / cellWidth;
+         }
+         if (last - wholeEnd > 1e-3)
+         {
+            indices[count] = wholeEnd;
+            pWeights[count++] = std::min(std::min(last - wholeEnd, 1.0), cellWidth) / cellWidth;
+         }
+
+         // Unused taps repeat the last source pixel with no weight so the indices remain contiguous
+         for (unsigned int tap = count; tap < mTaps; ++tap)
+         {
+            indices[tap] = indices[count - 1];
+         }
+      }
+      else
+      {
+         int source = 0;
+         double fraction = 0.0;
+         if (method == INTERP_NEAREST_NEIGHBOR)
+         {
+            source = static_cast<int>(floor(dest * scale));
+         }
+         else if (method == INTERP_AREA)
+         {
+            // Upsampling with area interpolation only blends the pixels which straddle a source boundary
+            source = static_cast<int>(floor(dest * scale));
+            fraction = (dest + 1) - (source + 1) / scale;
+            fraction = (fraction <= 0.0 ? 0.0 : fraction - floor(fraction));
+         }
+         else
+         {
+            double position = (dest + 0.5) * scale - 0.5;
+            source = static_cast<int>(floor(position));
+            fraction = position - source;
+         }
+
+         switch (method)
+         {
+         case INTERP_NEAREST_NEIGHBOR:
+            pWeights[0] = 1.0;
+            break;
+         case INTERP_BILINEAR:
+         case INTERP_AREA:
+            pWeights[0] = 1.0 - fraction;
+            pWeights[1] = fraction;
+            break;
+         case INTERP_LANCZOS4:
+            computeLanczos4Weights(fraction, pWeights);
+            break;
+         default:
+            computeCubicWeights(fraction, pWeights);
+            break;
+         }
+
+         for (unsigned int tap = 0; tap < mTaps; ++tap)
+         {
+            indices[tap] = source + firstTap + static_cast<int>(tap);
+         }
+      }
+
+      // Pixels beyond the edges of the data replicate the edge pixels
+      for (unsigned int tap = 0; tap < mTaps; ++tap)
+      {
+         mIndices[dest * mTaps + tap] = static_cast<unsigned int>(std::min(std::max(indices[tap], 0), lastSource));
       }
-      return cvInterpMethod;
    }
 }
 
@@ -216,94 +334,264 @@ bool SpatialResampler::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArg
       progress.report("Spatial resampling cannot be performed on complex data.", 0, ERRORS, true);
       return false;
    }
-   else if (srcType == INT4SBYTES || srcType == INT4UBYTES)
+
+   unsigned int resultRows = static_cast<unsigned int>(yFactor * pSrcDesc->getRowCount());
+   unsigned int resultColumns = static_cast<unsigned int>(xFactor * pSrcDesc->getColumnCount());
+   if (resultRows == 0 || resultColumns == 0)
    {
-      progress.report("Spatial resampling cannot be performed on 4-byte integer data.", 0, ERRORS, true);
+      progress.report("The scale factors do not produce any output pixels.", 0, ERRORS, true);
       return false;
    }
 
-   FactoryResource<DataRequest> pRequest;
-   DataAccessor pSrcAcc = pRasterElement->getDataAccessor(pRequest.release());
-
-   ModelResource<RasterElement> pResultCube(RasterUtilities::createRasterElement(
-      outputName, yFactor * pSrcDesc->getRowCount(),
-      xFactor * pSrcDesc->getColumnCount(), pSrcDesc->getDataType()));
+   // The result is written through an accessor one strip of rows at a time, so it does not need to be in memory
+   ModelResource<RasterElement> pResultCube(RasterUtilities::createRasterElement(outputName, resultRows,
+      resultColumns, pSrcDesc->getBandCount(), srcType, pSrcDesc->getInterleaveFormat(),
+      pSrcDesc->getProcessingLocation() == IN_MEMORY));
    if (pResultCube.get() == NULL)
    {
       progress.report("Unable to create output raster element.", 0, ERRORS, true);
       return false;
    }
-   FactoryResource<DataRequest> pResultRequest;
-   pResultRequest->setWritable(true);
-   RasterDataDescriptor* pDestDesc = dynamic_cast<RasterDataDescriptor*>(pResultCube->getDataDescriptor());
-   DataAccessor pDestAcc = pResultCube->getDataAccessor(pResultRequest.release());
 
-   int matType;
-   if (srcType == INT1SBYTE)
+   ResamplerThreadInput input;
+   input.mpSource = pRasterElement;
+   input.mpResult = pResultCube.get();
+   input.mpAbortFlag = &mAborted;
+   input.mRowWeights.compute(interpolationMethod, pSrcDesc->getRowCount(), resultRows);
+   input.mColumnWeights.compute(interpolationMethod, pSrcDesc->getColumnCount(), resultColumns);
+
+   ResamplerThreadOutput output;
+   mta::ProgressObjectReporter reporter("Resampling data", progress.getCurrentProgress());
+   mta::MultiThreadedAlgorithm<ResamplerThreadInput, ResamplerThreadOutput, ResamplerThread>
+      alg(mta::getNumRequiredThreads(resultRows), input, output, &reporter);
+   switch (alg.run())
    {
-      // Since cv::resize() doesn't handle signed byte data,
-      // upconvert to signed short for processing.
-      matType = convertEncodingTypeOpenCV(INT2SBYTES);
+   case mta::SUCCESS:
+      if (isAborted() == false)
+      {
+         break;
+      }
+      // fall through
+   case mta::ABORT:
+      progress.report("Cancelled", 0, ABORT, true);
+      return false;
+   case mta::FAILURE:
+      progress.report("Unable to resample the data.", 0, ERRORS, true);
+      return false;
+   default:
+      VERIFY(false); // can't happen
    }
-   else
+
+   progress.report(getName() + " complete.", 100, NORMAL);
+   progress.upALevel();
+   pOutArgList->setPlugInArgValue(Executable::DataElementArg(), pResultCube.release());
+   return true;
+}
+
+SpatialResampler::ResamplerThread::ResamplerThread(const ResamplerThreadInput& input, int threadCount,
+                                                   int threadIndex, mta::ThreadReporter& reporter) :
+   mta::AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mRowRange(getThreadRange(threadCount, static_cast<const RasterDataDescriptor*>(
+      input.mpResult->getDataDescriptor())->getRowCount())),
+   mFailed(false)
+{}
+
+bool SpatialResampler::ResamplerThread::isFailed() const
+{
+   return mFailed;
+}
+
+void SpatialResampler::ResamplerThread::run()
+{
+   EncodingType encoding = static_cast<const RasterDataDescriptor*>(
+      mInput.mpSource->getDataDescriptor())->getDataType();
+   switchOnEncoding(encoding, resample, NULL);
+}
+
+template<typename T>
+void SpatialResampler::ResamplerThread::resample(T* pDummy)
+{
+   InterleaveFormatType interleave = static_cast<const RasterDataDescriptor*>(
+      mInput.mpSource->getDataDescriptor())->getInterleaveFormat();
+   switchOnInterleave(interleave, resample, pDummy);
+}
+
+template<typename T, InterleaveFormatTypeEnum Interleave>
+void SpatialResampler::ResamplerThread::resample(InterleaveTraits<Interleave>, T* pDummy)
+{
+   if (mRowRange.mLast < mRowRange.mFirst)
+   {
+      return;
+   }
+
+   const RasterDataDescriptor* pSourceDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpSource->getDataDescriptor());
+   const RasterDataDescriptor* pResultDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpResult->getDataDescriptor());
+   const AxisWeights& rowWeights = mInput.mRowWeights;
+   const AxisWeights& columnWeights = mInput.mColumnWeights;
+   unsigned int rowTaps = rowWeights.mTaps;
+   unsigned int columnTaps = columnWeights.mTaps;
+   unsigned int bandCount = pSourceDescriptor->getBandCount();
+   unsigned int sourceColumns = pSourceDescriptor->getColumnCount();
+   unsigned int resultColumns = pResultDescriptor->getColumnCount();
+
+   // The indices of each output row are sorted, so the first and last taps bound the source rows of this thread
+   unsigned int firstSourceRow = rowWeights.mIndices[mRowRange.mFirst * rowTaps];
+   unsigned int lastSourceRow = rowWeights.mIndices[(mRowRange.mLast + 1) * rowTaps - 1];
+
+   // Each source row is resampled horizontally once and kept until no output row needs it.  The source
+   // rows of an output row are contiguous, so a ring with one slot per tap holds all of them.  Bands are
+   // processed in groups small enough to keep the ring within a fixed size; a BSQ row holds a single band.
+   unsigned int bandsPerPass = 1;
+   if (Interleave != BSQ)
    {
-      matType = convertEncodingTypeOpenCV(srcType);
+      size_t passBytes = static_cast<size_t>(rowTaps) * resultColumns * sizeof(double);
+      bandsPerPass = static_cast<unsigned int>(std::max(static_cast<size_t>(1),
+         std::min(static_cast<size_t>(bandCount), BUFFER_BYTES / passBytes)));
    }
-   try
+
+   size_t slotSize = static_cast<size_t>(bandsPerPass) * resultColumns;
+   std::vector<double> ring(rowTaps * slotSize);
+   std::vector<int> ringRows(rowTaps);
+   std::vector<double> sourceValues(sourceColumns);
+   std::vector<double> results(resultColumns);
+
+   int rowCount = mRowRange.mLast - mRowRange.mFirst + 1;
+   int oldPercentDone = -1;
+   for (unsigned int firstBand = 0; firstBand < bandCount; firstBand += bandsPerPass)
    {
-      cv::Mat testMat(pSrcDesc->getRowCount(), pSrcDesc->getColumnCount(), matType);
-      int progressPercent = 0;
-      progress.report("Reading source data", progressPercent, NORMAL);
-      float totalRows = pSrcDesc->getRowCount();
+      unsigned int passBands = std::min(bandsPerPass, bandCount - firstBand);
+      unsigned int lastBand = firstBand + passBands - 1;
 
-      for (unsigned int row = 0; row < pSrcDesc->getRowCount(); ++row)
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setRows(pSourceDescriptor->getActiveRow(firstSourceRow),
+         pSourceDescriptor->getActiveRow(lastSourceRow));
+      pRequest->setBands(pSourceDescriptor->getActiveBand(firstBand), pSourceDescriptor->getActiveBand(lastBand));
+      DataAccessor accessor = mInput.mpSource->getDataAccessor(pRequest.release());
+
+      FactoryResource<DataRequest> pResultRequest;
+      pResultRequest->setRows(pResultDescriptor->getActiveRow(mRowRange.mFirst),
+         pResultDescriptor->getActiveRow(mRowRange.mLast));
+      pResultRequest->setBands(pResultDescriptor->getActiveBand(firstBand),
+         pResultDescriptor->getActiveBand(lastBand));
+      pResultRequest->setWritable(true);
+      DataAccessor resultAccessor = mInput.mpResult->getDataAccessor(pResultRequest.release());
+      if (accessor.isValid() == false || resultAccessor.isValid() == false)
       {
-         for (unsigned int col = 0; col < pSrcDesc->getColumnCount(); ++col)
+         mFailed = true;
+         return;
+      }
+
+      std::fill(ringRows.begin(), ringRows.end(), -1);
+      for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
+      {
+         int percentDone = 100 * (firstBand * rowCount + (row - mRowRange.mFirst) * passBands) /
+            (rowCount * bandCount);
+         if (percentDone > oldPercentDone)
          {
-            VERIFY(pSrcAcc.isValid());
-            switchOnEncoding(pSrcDesc->getDataType(), getOriginalAsType, pSrcAcc->getColumn(), testMat, row, col);
-            pSrcAcc->nextColumn();
+            oldPercentDone = percentDone;
+            getReporter().reportProgress(getThreadIndex(), percentDone);
          }
-         pSrcAcc->nextRow();
-         if (isAborted() == true)
+         if (mInput.mpAbortFlag != NULL && *mInput.mpAbortFlag)
          {
-            progress.report("Cancelled", 0, ABORT, true);
-            return false;
+            return;
          }
-         progressPercent = row / totalRows * 33;
-         progress.report("Reading source data", progressPercent, NORMAL);
-      }
 
-      int cvInterpMethod = convertInterpolationMethodOpenCV(interpolationMethod);
-      cv::Mat resultsMat(yFactor * pSrcDesc->getRowCount(), xFactor * pSrcDesc->getColumnCount(), matType);
-      cv::resize(testMat, resultsMat, resultsMat.size(), 0, 0, cvInterpMethod);
+         const unsigned int* pRowIndices = &rowWeights.mIndices[row * rowTaps];
+         for (unsigned int tap = 0; tap < rowTaps; ++tap)
+         {
+            unsigned int sourceRow = pRowIndices[tap];
+            unsigned int slot = sourceRow % rowTaps;
+            if (ringRows[slot] == static_cast<int>(sourceRow))
+            {
+               continue;
+            }
 
-      totalRows = resultsMat.rows;
-      for (int row = 0; row < resultsMat.rows; ++row)
-      {
-         for (int col = 0; col < resultsMat.cols; ++col)
+            accessor->toPixel(static_cast<int>(sourceRow), 0);
+            if (accessor.isValid() == false)
+            {
+               mFailed = true;
+               return;
+            }
+
+            for (unsigned int band = 0; band < passBands; ++band)
+            {
+               RowView<T, Interleave> view = accessor->getRowView<T, Interleave>(band);
+               const T* pData = view.getData();
+               size_t stride = view.getStride();
+               for (unsigned int column = 0; column < sourceColumns; ++column)
+               {
+                  sourceValues[column] = static_cast<double>(pData[column * stride]);
+               }
+
+               double* pResampled = &ring[slot * slotSize + band * resultColumns];
+               for (unsigned int column = 0; column < resultColumns; ++column)
+               {
+                  const unsigned int* pIndices = &columnWeights.mIndices[column * columnTaps];
+                  const double* pWeights = &columnWeights.mWeights[column * columnTaps];
+                  double value = 0.0;
+                  for (unsigned int columnTap = 0; columnTap < columnTaps; ++columnTap)
+                  {
+                     value += pWeights[columnTap] * sourceValues[pIndices[columnTap]];
+                  }
+                  pResampled[column] = value;
+               }
+            }
+
+            ringRows[slot] = static_cast<int>(sourceRow);
+         }
+
+         resultAccessor->toPixel(row, 0);
+         if (resultAccessor.isValid() == false)
          {
-            switchOnEncoding(pSrcDesc->getDataType(), putOriginalAsType, pDestAcc->getColumn(), resultsMat, row, col);
-            pDestAcc->nextColumn();
+            mFailed = true;
+            return;
          }
-         pDestAcc->nextRow();
-         if (isAborted())
+
+         const double* pRowWeights = &rowWeights.mWeights[row * rowTaps];
+         for (unsigned int band = 0; band < passBands; ++band)
          {
-            progress.report("Cancelled", 0, ABORT, true);
-            return false;
+            std::fill(results.begin(), results.end(), 0.0);
+            for (unsigned int tap = 0; tap < rowTaps; ++tap)
+            {
+               double weight = pRowWeights[tap];
+               if (weight == 0.0)
+               {
+                  continue;
+               }
+
+               const double* pResampled = &ring[(pRowIndices[tap] % rowTaps) * slotSize + band * resultColumns];
+               for (unsigned int column = 0; column < resultColumns; ++column)
+               {
+                  results[column] += weight * pResampled[column];
+               }
+            }
+
+            RowView<T, Interleave> view = resultAccessor->getRowView<T, Interleave>(band);
+            T* pData = view.getData();
+            size_t stride = view.getStride();
+            for (unsigned int column = 0; column < resultColumns; ++column)
+            {
+               pData[column * stride] = fromDouble<T>(results[column]);
+            }
          }
-         progressPercent = row / totalRows * 33 + 64;
-         progress.report("Writing result data", progressPercent, NORMAL);
       }
    }
-   catch (cv::Exception ev)
+
+   getReporter().reportProgress(getThreadIndex(), 100);
+}
+
+bool SpatialResampler::ResamplerThreadOutput::compileOverallResults(const std::vector<ResamplerThread*>& threads)
+{
+   for (std::vector<ResamplerThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
    {
-      progress.report(ev.msg, 0, ERRORS, true);
-      return false;
+      if ((*iter)->isFailed() == true)
+      {
+         return false;
+      }
    }
 
-   progress.report(getName() + " complete.", 100, NORMAL);
-   progress.upALevel();
-   pOutArgList->setPlugInArgValue(Executable::DataElementArg(), pResultCube.release());
    return true;
-}
\ No newline at end of file
+}
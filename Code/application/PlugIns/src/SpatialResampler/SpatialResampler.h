@@ -11,6 +11,13 @@
 #define SPATIALRESAMPLER_H
 
 #include "AlgorithmShell.h"
+#include "MultiThreadedAlgorithm.h"
+#include "RowView.h"
+#include "TypesFile.h"
+
+#include <vector>
+
+class RasterElement;
 
 class SpatialResampler : public AlgorithmShell
 {
@@ -23,6 +30,65 @@ public:
    virtual bool execute(PlugInArgList* pInArgList, PlugInArgList* pOutArgList);
 
    virtual bool setInteractive();
+
+private:
+   /**
+    * The source pixels and weights which produce each output pixel along one axis.
+    */
+   struct AxisWeights
+   {
+      AxisWeights() :
+         mTaps(0)
+      {}
+
+      void compute(InterpolationType method, unsigned int sourceCount, unsigned int destCount);
+
+      unsigned int mTaps;
+      std::vector<unsigned int> mIndices;
+      std::vector<double> mWeights;
+   };
+
+   struct ResamplerThreadInput
+   {
+      ResamplerThreadInput() :
+         mpSource(NULL),
+         mpResult(NULL),
+         mpAbortFlag(NULL)
+      {}
+
+      const RasterElement* mpSource;
+      RasterElement* mpResult;
+      const bool* mpAbortFlag;
+      AxisWeights mRowWeights;
+      AxisWeights mColumnWeights;
+   };
+
+   class ResamplerThread : public mta::AlgorithmThread
+   {
+   public:
+      ResamplerThread(const ResamplerThreadInput& input, int threadCount, int threadIndex,
+         mta::ThreadReporter& reporter);
+      virtual ~ResamplerThread() {}
+      void run();
+      bool isFailed() const;
+
+      template<typename T>
+      void resample(T* pDummy);
+      template<typename T, InterleaveFormatTypeEnum Interleave>
+      void resample(InterleaveTraits<Interleave>, T* pDummy);
+
+   private:
+      ResamplerThread& operator=(const ResamplerThread& rhs);
+
+      const ResamplerThreadInput& mInput;
+      mta::AlgorithmThread::Range mRowRange;
+      bool mFailed;
+   };
+
+   struct ResamplerThreadOutput
+   {
+      bool compileOverallResults(const std::vector<ResamplerThread*>& threads);
+   };
 };
 
-#endif
\ No newline at end of file
+#endif